@@ -4640,6 +4640,7 @@ aarch64_gdbarch_init (struct gdbarch_info info, struct gdbarch_list *arches)
   /* Information about registers, etc.  */
   set_gdbarch_sp_regnum (gdbarch, AARCH64_SP_REGNUM);
   set_gdbarch_pc_regnum (gdbarch, AARCH64_PC_REGNUM);
+  set_gdbarch_frame_pointer_regnum (gdbarch, AARCH64_FP_REGNUM);
   set_gdbarch_num_regs (gdbarch, num_regs);
 
   set_gdbarch_num_pseudo_regs (gdbarch, num_pseudo_regs);
@@ -48,6 +48,7 @@
 #include "gdbsupport/pathstuff.h"
 #include "gdbsupport/scoped_fd.h"
 #include "gdbsupport/x86-xstate.h"
+#include "gdbsupport/parallel-for.h"
 #include <unordered_map>
 #include <unordered_set>
 #include "cli/cli-cmds.h"
@@ -59,6 +60,13 @@
 #define O_LARGEFILE 0
 #endif
 
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#ifndef MAP_FAILED
+#define MAP_FAILED ((void *) -1)
+#endif
+#endif
+
 /* Forward declarations.  */
 
 static void core_target_open (const char *arg, int from_tty);
@@ -189,6 +197,7 @@ class core_target final : public process_stratum_target
 {
 public:
   core_target ();
+  ~core_target () override;
 
   const target_info &info () const override
   { return core_target_info; }
@@ -285,6 +294,29 @@ class core_target final : public process_stratum_target
   /* Get rid of the core inferior.  */
   void clear_core ();
 
+  /* Map the core file into GDB's address space, see m_core_contents.  */
+  void map_core_file ();
+
+  /* Read LEN bytes at OFFSET within SECTION, a section of the core
+     file, into BUF.  Return true on success.  */
+  bool read_core_section (asection *section, gdb_byte *buf,
+			  file_ptr offset, bfd_size_type len);
+
+  /* Find the section of m_core_section_table with contents containing
+     ADDR, using m_sorted_core_sections.  */
+  const target_section *find_core_section (CORE_ADDR addr) const;
+
+  /* Implement the file-backed mapping part of xfer_partial.  */
+  target_xfer_status xfer_file_mapping (gdb_byte *readbuf,
+					const gdb_byte *writebuf,
+					ULONGEST offset, ULONGEST len,
+					ULONGEST *xfered_len);
+
+  /* Open the file of file-backed mapping FILE and create the BFD
+     sections of its regions.  Return false if the file can no longer
+     be opened, in which case its regions are now unavailable.  */
+  bool open_file_mapping (size_t file);
+
   /* The core's section table.  Note that these target sections are
      *not* mapped in the current address spaces' set of target
      sections --- those should come only from pure executable or
@@ -293,9 +325,71 @@ class core_target final : public process_stratum_target
      targets.  */
   std::vector<target_section> m_core_section_table;
 
+  /* If the core file is a local file opened read-only, the whole file
+     mapped into GDB's address space, otherwise nullptr.  Memory and
+     register contents are copied from here instead of being read
+     through BFD, which matters for large core files.  */
+  const gdb_byte *m_core_contents = nullptr;
+
+  /* The size of the mapping at m_core_contents.  */
+  size_t m_core_contents_size = 0;
+
+  /* The sections of m_core_section_table that have contents, sorted by
+     address so memory accesses need not scan the whole table.  Empty
+     if some of these sections overlap, in which case the table is
+     searched in order, as the first matching section wins.  */
+  std::vector<const target_section *> m_sorted_core_sections;
+
+  /* A file named by the core file's file-backed mapping note.  Its BFD
+     and sections are only created when one of its regions is first
+     accessed: large processes map thousands of files, most of which
+     are never read through the core target.  */
+  struct file_mapping_file
+  {
+    explicit file_mapping_file (std::string &&filename_)
+      : filename (std::move (filename_))
+    { /* Nothing.  */ }
+
+    /* The file providing the mapped contents.  */
+    std::string filename;
+
+    /* True once open_file_mapping was called for this file.  */
+    bool opened = false;
+
+    /* True if opening the file failed.  */
+    bool failed = false;
+  };
+
+  /* One region of a file-backed mapping.  */
+  struct file_mapping_region
+  {
+    file_mapping_region (CORE_ADDR start_, CORE_ADDR end_,
+			 ULONGEST file_ofs_, size_t file_)
+      : start (start_), end (end_), file_ofs (file_ofs_), file (file_)
+    { /* Nothing.  */ }
+
+    /* The inferior address range of the region.  */
+    CORE_ADDR start;
+    CORE_ADDR end;
+
+    /* The offset of the region within its file.  */
+    ULONGEST file_ofs;
+
+    /* Index of the file in m_file_mapping_files.  */
+    size_t file;
+
+    /* The BFD section of the region, once its file is opened.  */
+    asection *section = nullptr;
+  };
+
   /* File-backed address space mappings: some core files include
      information about memory mapped files.  */
-  std::vector<target_section> m_core_file_mappings;
+  std::vector<file_mapping_file> m_file_mapping_files;
+  std::vector<file_mapping_region> m_file_mapping_regions;
+
+  /* Indices into m_file_mapping_regions sorted by address, or empty if
+     some regions overlap, like m_sorted_core_sections.  */
+  std::vector<size_t> m_sorted_file_mapping_regions;
 
   /* Unavailable mappings.  These correspond to pathnames which either
      weren't found or could not be opened.  Knowing these addresses can
@@ -307,8 +401,8 @@ class core_target final : public process_stratum_target
      to filename mapping.  */
   mapped_file_info m_mapped_file_info;
 
-  /* Build m_core_file_mappings and m_mapped_file_info.  Called from the
-     constructor.  */
+  /* Build the file-backed mapping tables and m_mapped_file_info.
+     Called from the constructor.  */
   void build_file_mappings ();
 
   /* FIXME: kettenis/20031023: Eventually this field should
@@ -347,9 +441,107 @@ core_target::core_target ()
   /* Find the data section */
   m_core_section_table = build_section_table (current_program_space->core_bfd ());
 
+  for (const target_section &p : m_core_section_table)
+    if ((p.the_bfd_section->flags & SEC_HAS_CONTENTS) != 0
+	&& p.endaddr > p.addr)
+      m_sorted_core_sections.push_back (&p);
+  std::sort (m_sorted_core_sections.begin (), m_sorted_core_sections.end (),
+	     [] (const target_section *a, const target_section *b)
+	     {
+	       return a->addr < b->addr;
+	     });
+  for (size_t i = 1; i < m_sorted_core_sections.size (); ++i)
+    if (m_sorted_core_sections[i]->addr < m_sorted_core_sections[i - 1]->endaddr)
+      {
+	m_sorted_core_sections.clear ();
+	break;
+      }
+
+  map_core_file ();
+
   build_file_mappings ();
 }
 
+core_target::~core_target ()
+{
+#ifdef HAVE_MMAP
+  if (m_core_contents != nullptr)
+    munmap ((void *) m_core_contents, m_core_contents_size);
+#endif
+}
+
+void
+core_target::map_core_file ()
+{
+#ifdef HAVE_MMAP
+  bfd *cbfd = current_program_space->core_bfd ();
+
+  /* When the core file is writable ("set write on"), writes go through
+     BFD's buffered I/O and would not be seen through a mapping.  */
+  if (write_files || is_target_filename (bfd_get_filename (cbfd)))
+    return;
+
+  scoped_fd fd = gdb_open_cloexec (bfd_get_filename (cbfd),
+				   O_RDONLY | O_BINARY, 0);
+  if (fd.get () < 0)
+    return;
+
+  /* Make sure this is still the file BFD opened.  */
+  struct stat st;
+  if (fstat (fd.get (), &st) < 0
+      || st.st_size == 0
+      || (ULONGEST) st.st_size != (ULONGEST) bfd_get_size (cbfd)
+      || (uintmax_t) st.st_size > SIZE_MAX)
+    return;
+
+  void *contents = mmap (nullptr, st.st_size, PROT_READ, MAP_PRIVATE,
+			 fd.get (), 0);
+  if (contents == MAP_FAILED)
+    return;
+
+  m_core_contents = (const gdb_byte *) contents;
+  m_core_contents_size = st.st_size;
+#endif
+}
+
+bool
+core_target::read_core_section (asection *section, gdb_byte *buf,
+				file_ptr offset, bfd_size_type len)
+{
+  if (m_core_contents != nullptr
+      && section->owner == current_program_space->core_bfd ()
+      && (section->flags & (SEC_HAS_CONTENTS | SEC_IN_MEMORY))
+	  == SEC_HAS_CONTENTS
+      && offset >= 0
+      && offset + len <= bfd_section_size (section)
+      && section->filepos >= 0
+      && (ULONGEST) section->filepos <= m_core_contents_size
+      && offset + len <= m_core_contents_size - section->filepos)
+    {
+      memcpy (buf, m_core_contents + section->filepos + offset, len);
+      return true;
+    }
+
+  return bfd_get_section_contents (section->owner, section, buf, offset, len);
+}
+
+const target_section *
+core_target::find_core_section (CORE_ADDR addr) const
+{
+  auto it = std::upper_bound (m_sorted_core_sections.begin (),
+			      m_sorted_core_sections.end (), addr,
+			      [] (CORE_ADDR a, const target_section *p)
+			      {
+				return a < p->addr;
+			      });
+  if (it == m_sorted_core_sections.begin ())
+    return nullptr;
+  --it;
+  if (addr >= (*it)->endaddr)
+    return nullptr;
+  return *it;
+}
+
 /* Construct the table for file-backed mappings if they exist.
 
    For each unique path in the note, we'll open a BFD with a bfd
@@ -452,37 +644,54 @@ core_target::build_file_mappings ()
   const bfd_build_id *core_build_id
     = build_id_bfd_get (current_program_space->core_bfd ());
 
+  /* The local file found for each mapped file, and what we learned by
+     opening it.  */
+  struct file_check
+  {
+    file_check (const std::string &filename_, const mapped_file &data_)
+      : filename (filename_), data (data_)
+    { /* Nothing.  */ }
+
+    const std::string &filename;
+    const mapped_file &data;
+    gdb::unique_xmalloc_ptr<char> expanded_fname;
+    bool build_id_mismatch = false;
+    bool readable = false;
+    gdb::unique_xmalloc_ptr<char> soname;
+  };
+
+  std::vector<file_check> checks;
+  checks.reserve (mapped_files.size ());
   for (const auto &iter : mapped_files)
     {
-      const std::string &filename = iter.first;
-      const mapped_file &file_data = iter.second;
-
-      /* If this mapped file has the same build-id as was discovered for
-	 the core-file itself, then we assume this is the main
-	 executable.  Record the filename as we can use this later.  */
-      if (file_data.build_id != nullptr
-	  && m_expected_exec_filename.empty ()
-	  && build_id_equal (file_data.build_id, core_build_id))
-	m_expected_exec_filename = filename;
+      file_check &check = checks.emplace_back (iter.first, iter.second);
 
       /* Use exec_file_find() to do sysroot expansion.  It'll
 	 also strip the potential sysroot "target:" prefix.  If
 	 there is no sysroot, an equivalent (possibly more
 	 canonical) pathname will be provided.  */
-      gdb::unique_xmalloc_ptr<char> expanded_fname
-	= exec_file_find (filename.c_str (), nullptr);
+      check.expanded_fname = exec_file_find (iter.first.c_str (), nullptr);
+    }
+
+  /* Open each mapped file, check its build-id against the one recorded
+     in the core file and read its DT_SONAME.  This is independent for
+     each file and dominated by I/O, so local files are done on the
+     worker threads.  Files accessed through the target can only be
+     opened from the main thread.  */
+  auto check_file = [] (file_check &check)
+    {
+      const char *fname = check.expanded_fname.get ();
+      if (fname == nullptr)
+	return;
 
-      bool build_id_mismatch = false;
-      if (expanded_fname != nullptr && file_data.build_id != nullptr)
+      if (check.data.build_id != nullptr)
 	{
 	  /* We temporarily open the bfd as a structured target, this
 	     allows us to read the build-id from the bfd if there is one.
 	     For this task it's OK if we reuse an already open bfd object,
-	     so we make this call through GDB's bfd cache.  Once we've
-	     checked the build-id (if there is one) we'll drop this
-	     reference and re-open the bfd using the "binary" target.  */
-	  gdb_bfd_ref_ptr tmp_bfd
-	    = gdb_bfd_open (expanded_fname.get (), gnutarget);
+	     so we make this call through GDB's bfd cache.  The regions are
+	     later read through a bfd opened using the "binary" target.  */
+	  gdb_bfd_ref_ptr tmp_bfd = gdb_bfd_open (fname, gnutarget);
 
 	  if (tmp_bfd != nullptr
 	      && bfd_check_format (tmp_bfd.get (), bfd_object)
@@ -493,39 +702,77 @@ core_target::build_file_mappings ()
 		 the build-id's match, and if not, reject TMP_BFD.  */
 	      const struct bfd_build_id *found
 		= build_id_bfd_get (tmp_bfd.get ());
-	      if (!build_id_equal (found, file_data.build_id))
-		build_id_mismatch = true;
+	      if (!build_id_equal (found, check.data.build_id))
+		check.build_id_mismatch = true;
 	    }
 	}
 
-      gdb_bfd_ref_ptr abfd;
-      if (expanded_fname != nullptr && !build_id_mismatch)
-	{
-	  struct bfd *b = bfd_openr (expanded_fname.get (), "binary");
-	  abfd = gdb_bfd_ref_ptr::new_reference (b);
-	}
+      if (check.build_id_mismatch)
+	return;
+
+      /* This is everything opening the file as a "binary" BFD needs,
+	 so that a file which is missing or unreadable is reported here,
+	 when the core file is opened, rather than when its memory is
+	 first accessed.  */
+      scoped_fd fd = gdb_open_cloexec (fname, O_RDONLY | O_BINARY, 0);
+      struct stat st;
+      check.readable = fd.get () >= 0 && fstat (fd.get (), &st) == 0;
+
+      if (check.readable && check.data.build_id != nullptr)
+	check.soname = gdb_bfd_read_elf_soname (fname);
+    };
 
-      if ((expanded_fname == nullptr
-	   || abfd == nullptr
-	   || !bfd_check_format (abfd.get (), bfd_object))
-	  && file_data.build_id != nullptr)
+  gdb::parallel_for_each (1, checks.begin (), checks.end (),
+			  [&] (std::vector<file_check>::iterator start,
+			       std::vector<file_check>::iterator end)
+    {
+      for (auto it = start; it != end; ++it)
+	if (it->expanded_fname != nullptr
+	    && !is_target_filename (it->expanded_fname.get ()))
+	  check_file (*it);
+    });
+
+  for (file_check &check : checks)
+    if (check.expanded_fname != nullptr
+	&& is_target_filename (check.expanded_fname.get ()))
+      check_file (check);
+
+  for (file_check &check : checks)
+    {
+      const std::string &filename = check.filename;
+      const mapped_file &file_data = check.data;
+      gdb::unique_xmalloc_ptr<char> &expanded_fname = check.expanded_fname;
+      bool build_id_mismatch = check.build_id_mismatch;
+
+      /* If this mapped file has the same build-id as was discovered for
+	 the core-file itself, then we assume this is the main
+	 executable.  Record the filename as we can use this later.  */
+      if (file_data.build_id != nullptr
+	  && m_expected_exec_filename.empty ()
+	  && build_id_equal (file_data.build_id, core_build_id))
+	m_expected_exec_filename = filename;
+
+      bool available = (expanded_fname != nullptr
+			&& !build_id_mismatch
+			&& check.readable);
+
+      if (!available && file_data.build_id != nullptr)
 	{
-	  abfd = find_objfile_by_build_id (current_program_space,
-					   file_data.build_id,
-					   filename.c_str ());
+	  gdb_bfd_ref_ptr abfd
+	    = find_objfile_by_build_id (current_program_space,
+					file_data.build_id,
+					filename.c_str ());
 
 	  if (abfd != nullptr)
 	    {
 	      /* The find_objfile_by_build_id will have opened ABFD using
-		 the GNUTARGET global bfd type, however, we need the bfd
-		 opened as the binary type (see the function's header
-		 comment), so now we reopen ABFD with the desired binary
-		 type.  */
+		 the GNUTARGET global bfd type, the regions are read through
+		 a bfd opened as the binary type (see the function's header
+		 comment) once they are accessed.  */
 	      expanded_fname
 		= make_unique_xstrdup (bfd_get_filename (abfd.get ()));
-	      struct bfd *b = bfd_openr (expanded_fname.get (), "binary");
-	      gdb_assert (b != nullptr);
-	      abfd = gdb_bfd_ref_ptr::new_reference (b);
+	      available = true;
+	      check.soname = gdb_bfd_read_elf_soname (expanded_fname.get ());
 	    }
 	}
 
@@ -533,13 +780,8 @@ core_target::build_file_mappings ()
       for (const mapped_file::region &region : file_data.regions)
 	ranges.emplace_back (region.start, region.end - region.start);
 
-      if (expanded_fname == nullptr
-	  || abfd == nullptr
-	  || !bfd_check_format (abfd.get (), bfd_object))
+      if (!available)
 	{
-	  /* If ABFD was opened, but the wrong format, close it now.  */
-	  abfd = nullptr;
-
 	  /* Record all regions for this file as unavailable.  */
 	  for (const mapped_file::region &region : file_data.regions)
 	    m_core_unavailable_mappings.emplace_back (region.start,
@@ -583,30 +825,13 @@ core_target::build_file_mappings ()
 	}
       else
 	{
-	  /* Ensure that the bfd will be closed when core_bfd is closed.
-	     This can be checked before/after a core file detach via "maint
-	     info bfds".  */
-	  gdb_bfd_record_inclusion (current_program_space->core_bfd (),
-				    abfd.get ());
-
-	  /* Create sections for each mapped region.  */
+	  /* Record the regions; the file itself is opened by
+	     open_file_mapping when one of them is first accessed.  */
+	  size_t file = m_file_mapping_files.size ();
+	  m_file_mapping_files.emplace_back (expanded_fname.get ());
 	  for (const mapped_file::region &region : file_data.regions)
-	    {
-	      /* Make new BFD section.  All sections have the same name,
-		 which is permitted by bfd_make_section_anyway().  */
-	      asection *sec = bfd_make_section_anyway (abfd.get (), "load");
-	      if (sec == nullptr)
-		error (_("Can't make section"));
-	      sec->filepos = region.file_ofs;
-	      bfd_set_section_flags (sec, SEC_READONLY | SEC_HAS_CONTENTS);
-	      bfd_set_section_size (sec, region.end - region.start);
-	      bfd_set_section_vma (sec, region.start);
-	      bfd_set_section_lma (sec, region.start);
-	      bfd_set_section_alignment (sec, 2);
-
-	      /* Set target_section fields.  */
-	      m_core_file_mappings.emplace_back (region.start, region.end, sec);
-	    }
+	    m_file_mapping_regions.emplace_back (region.start, region.end,
+						 region.file_ofs, file);
 	}
 
       /* If this is a bfd with a build-id then record the filename,
@@ -619,20 +844,156 @@ core_target::build_file_mappings ()
 	  normalize_mem_ranges (&ranges);
 
 	  const char *actual_filename = nullptr;
-	  gdb::unique_xmalloc_ptr<char> soname;
-	  if (abfd != nullptr)
-	    {
-	      actual_filename = bfd_get_filename (abfd.get ());
-	      soname = gdb_bfd_read_elf_soname (actual_filename);
-	    }
+	  if (available)
+	    actual_filename = expanded_fname.get ();
+	  else
+	    check.soname.reset ();
 
-	  m_mapped_file_info.add (soname.get (), filename.c_str (),
+	  m_mapped_file_info.add (check.soname.get (), filename.c_str (),
 				  actual_filename, std::move (ranges),
 				  file_data.build_id);
 	}
     }
 
   normalize_mem_ranges (&m_core_unavailable_mappings);
+
+  for (size_t i = 0; i < m_file_mapping_regions.size (); ++i)
+    if (m_file_mapping_regions[i].end > m_file_mapping_regions[i].start)
+      m_sorted_file_mapping_regions.push_back (i);
+  std::sort (m_sorted_file_mapping_regions.begin (),
+	     m_sorted_file_mapping_regions.end (),
+	     [this] (size_t a, size_t b)
+	     {
+	       return (m_file_mapping_regions[a].start
+		       < m_file_mapping_regions[b].start);
+	     });
+  for (size_t i = 1; i < m_sorted_file_mapping_regions.size (); ++i)
+    if (m_file_mapping_regions[m_sorted_file_mapping_regions[i]].start
+	< m_file_mapping_regions[m_sorted_file_mapping_regions[i - 1]].end)
+      {
+	m_sorted_file_mapping_regions.clear ();
+	break;
+      }
+}
+
+/* See class declaration.  */
+
+bool
+core_target::open_file_mapping (size_t file)
+{
+  file_mapping_file &f = m_file_mapping_files[file];
+
+  if (!f.opened)
+    {
+      f.opened = true;
+
+      gdb_bfd_ref_ptr abfd
+	= gdb_bfd_ref_ptr::new_reference (bfd_openr (f.filename.c_str (),
+						     "binary"));
+      if (abfd == nullptr || !bfd_check_format (abfd.get (), bfd_object))
+	{
+	  /* The file could be opened when the core file was; it must
+	     have been removed or replaced since.  */
+	  warning (_("Can't reopen file %ps to read file-backed mapping "
+		     "memory"),
+		   styled_string (file_name_style.style (),
+				  f.filename.c_str ()));
+	  f.failed = true;
+
+	  for (const file_mapping_region &region : m_file_mapping_regions)
+	    if (region.file == file)
+	      m_core_unavailable_mappings.emplace_back (region.start,
+							region.end
+							- region.start);
+	  normalize_mem_ranges (&m_core_unavailable_mappings);
+	  return false;
+	}
+
+      /* Ensure that the bfd will be closed when core_bfd is closed.
+	 This can be checked before/after a core file detach via "maint
+	 info bfds".  */
+      gdb_bfd_record_inclusion (current_program_space->core_bfd (),
+				abfd.get ());
+
+      /* Create sections for each mapped region.  */
+      for (file_mapping_region &region : m_file_mapping_regions)
+	{
+	  if (region.file != file)
+	    continue;
+
+	  /* Make new BFD section.  All sections have the same name,
+	     which is permitted by bfd_make_section_anyway().  */
+	  asection *sec = bfd_make_section_anyway (abfd.get (), "load");
+	  if (sec == nullptr)
+	    error (_("Can't make section"));
+	  sec->filepos = region.file_ofs;
+	  bfd_set_section_flags (sec, SEC_READONLY | SEC_HAS_CONTENTS);
+	  bfd_set_section_size (sec, region.end - region.start);
+	  bfd_set_section_vma (sec, region.start);
+	  bfd_set_section_lma (sec, region.start);
+	  bfd_set_section_alignment (sec, 2);
+
+	  region.section = sec;
+	}
+    }
+
+  return !f.failed;
+}
+
+/* See class declaration.  */
+
+target_xfer_status
+core_target::xfer_file_mapping (gdb_byte *readbuf, const gdb_byte *writebuf,
+				ULONGEST offset, ULONGEST len,
+				ULONGEST *xfered_len)
+{
+  /* Find the first region containing OFFSET.  */
+  file_mapping_region *region = nullptr;
+  if (!m_sorted_file_mapping_regions.empty ())
+    {
+      auto it = std::upper_bound (m_sorted_file_mapping_regions.begin (),
+				  m_sorted_file_mapping_regions.end (),
+				  offset,
+				  [this] (ULONGEST addr, size_t idx)
+				  {
+				    return (addr
+					    < m_file_mapping_regions[idx].start);
+				  });
+      if (it != m_sorted_file_mapping_regions.begin ())
+	{
+	  file_mapping_region &r = m_file_mapping_regions[*(it - 1)];
+	  if (offset < r.end)
+	    region = &r;
+	}
+    }
+  else
+    {
+      for (file_mapping_region &r : m_file_mapping_regions)
+	if (offset >= r.start && offset < r.end)
+	  {
+	    region = &r;
+	    break;
+	  }
+    }
+
+  if (region == nullptr || !open_file_mapping (region->file))
+    return TARGET_XFER_EOF;
+
+  asection *sec = region->section;
+  len = std::min (len, region->end - offset);
+
+  bool res;
+  if (writebuf != nullptr)
+    res = bfd_set_section_contents (sec->owner, sec, writebuf,
+				    offset - region->start, len);
+  else
+    res = bfd_get_section_contents (sec->owner, sec, readbuf,
+				    offset - region->start, len);
+  if (!res)
+    return TARGET_XFER_EOF;
+
+  *xfered_len = len;
+  return TARGET_XFER_OK;
 }
 
 /* An arbitrary identifier for the core inferior.  */
@@ -1183,8 +1544,7 @@ core_target::get_core_register_section (struct regcache *regcache,
     }
 
   gdb::byte_vector contents (size);
-  if (!bfd_get_section_contents (current_program_space->core_bfd (), section,
-				 contents.data (), (file_ptr) 0, size))
+  if (!read_core_section (section, contents.data (), (file_ptr) 0, size))
     {
       warning (_("Couldn't read %s registers from `%s' section in core file."),
 	       human_name, section_name.c_str ());
@@ -1289,22 +1649,38 @@ core_target::xfer_partial (enum target_object object, const char *annex,
 	  {
 	    return ((s->the_bfd_section->flags & SEC_HAS_CONTENTS) != 0);
 	  };
-	xfer_status = section_table_xfer_memory_partial
-			(readbuf, writebuf,
-			 offset, len, xfered_len,
-			 m_core_section_table,
-			 has_contents_cb);
-	if (xfer_status == TARGET_XFER_OK)
-	  return TARGET_XFER_OK;
+	if (readbuf != nullptr && !m_sorted_core_sections.empty ())
+	  {
+	    const target_section *p = find_core_section (offset);
+	    if (p != nullptr)
+	      {
+		len = std::min (len, p->endaddr - offset);
+		if (read_core_section (p->the_bfd_section, readbuf,
+				       offset - p->addr, len))
+		  {
+		    *xfered_len = len;
+		    return TARGET_XFER_OK;
+		  }
+	      }
+	  }
+	else
+	  {
+	    xfer_status = section_table_xfer_memory_partial
+			    (readbuf, writebuf,
+			     offset, len, xfered_len,
+			     m_core_section_table,
+			     has_contents_cb);
+	    if (xfer_status == TARGET_XFER_OK)
+	      return TARGET_XFER_OK;
+	  }
 
 	/* Check file backed mappings.  If they're available, use core file
 	   provided mappings (e.g. from .note.linuxcore.file or the like)
 	   as this should provide a more accurate result.  */
-	if (!m_core_file_mappings.empty ())
+	if (!m_file_mapping_regions.empty ())
 	  {
-	    xfer_status = section_table_xfer_memory_partial
-			    (readbuf, writebuf, offset, len, xfered_len,
-			     m_core_file_mappings);
+	    xfer_status = xfer_file_mapping (readbuf, writebuf, offset, len,
+					     xfered_len);
 	    if (xfer_status == TARGET_XFER_OK)
 	      return xfer_status;
 	  }
@@ -1353,7 +1729,7 @@ core_target::xfer_partial (enum target_object object, const char *annex,
 	   within the executable then this will return the executable data
 	   rather than the zero data.  Maybe we should just drop this
 	   block?  */
-	if (m_core_file_mappings.empty ()
+	if (m_file_mapping_regions.empty ()
 	    && m_core_unavailable_mappings.empty ())
 	  {
 	    xfer_status
@@ -1757,7 +2133,7 @@ get_current_core_target ()
 void
 core_target::info_proc_mappings (struct gdbarch *gdbarch)
 {
-  if (m_core_file_mappings.empty ())
+  if (m_file_mapping_regions.empty ())
     return;
 
   gdb_printf (_("Mapped address spaces:\n\n"));
@@ -1771,12 +2147,13 @@ core_target::info_proc_mappings (struct gdbarch *gdbarch)
   current_uiout->table_header (0, ui_left, "objfile", "File");
   current_uiout->table_body ();
 
-  for (const target_section &tsp : m_core_file_mappings)
+  for (const file_mapping_region &region : m_file_mapping_regions)
     {
-      ULONGEST start = tsp.addr;
-      ULONGEST end = tsp.endaddr;
-      ULONGEST file_ofs = tsp.the_bfd_section->filepos;
-      const char *filename = bfd_get_filename (tsp.the_bfd_section->owner);
+      ULONGEST start = region.start;
+      ULONGEST end = region.end;
+      ULONGEST file_ofs = region.file_ofs;
+      const char *filename
+	= m_file_mapping_files[region.file].filename.c_str ();
 
       ui_out_emit_tuple tuple_emitter (current_uiout, nullptr);
       current_uiout->field_core_addr ("start", gdbarch, start);
@@ -37,6 +37,11 @@
 #include "gdbsupport/gdb_unlinker.h"
 #include "gdbsupport/byte-vector.h"
 #include "gdbsupport/scope-exit.h"
+#include "gdbsupport/thread-pool.h"
+#include "gdbsupport/parallel-for.h"
+#include "breakpoint.h"
+#include "record.h"
+#include <optional>
 
 /* To generate sparse cores, we look at the data to write in chunks of
    this size when considering whether to skip the write.  Only if we
@@ -744,10 +749,236 @@ sparse_bfd_set_section_contents (bfd *obfd, asection *osec,
   return true;
 }
 
-static void
-gcore_copy_callback (bfd *obfd, asection *osec)
+/* The largest number of chunks of MAX_COPY_BYTES read from the
+   target at once when reading in parallel.  Two batches of this many
+   chunks are held in memory.  */
+#define MAX_COPY_CHUNKS 16
+
+/* Copies memory from the target to the core file.
+
+   The memory is read in batches of chunks, and each batch is written
+   on a worker thread, so that looking for all-zero blocks and writing
+   the data out overlaps with reading the next batch from the target.
+   Only one write is in flight at a time, so BFD sees the writes in the
+   same order as when they are done directly, and the main thread does
+   not use the output BFD while it is being written to.
+
+   Target memory can only be read through the target stack from the
+   main thread, one chunk at a time.  If the target provides a file
+   descriptor for the inferior's memory (see target_memory_fd), the
+   chunks of a batch are instead read from it on the worker threads at
+   once, and only chunks that cannot be read that way are read through
+   the target.  */
+
+class gcore_memory_writer
+{
+public:
+  gcore_memory_writer (bfd *obfd, int mem_fd);
+
+  ~gcore_memory_writer ()
+  {
+    /* The pending write refers to our buffers.  */
+    if (m_pending.has_value ())
+      m_pending->wait ();
+  }
+
+  DISABLE_COPY_AND_ASSIGN (gcore_memory_writer);
+
+  /* Copy the contents of OSEC from the target's memory.  */
+  void copy_section (asection *osec);
+
+  /* Wait for the pending write, if any.  Warn if it failed.  */
+  void finish ()
+  {
+    finish_for (nullptr);
+  }
+
+private:
+
+  /* A part of a section, of at most MAX_COPY_BYTES.  */
+  struct chunk
+  {
+    file_ptr offset;
+    size_t size;
+    gdb::byte_vector data;
+
+    /* Whether DATA was read from the target's memory file.  */
+    bool read_from_fd;
+  };
+
+  /* Read the first COUNT chunks of BATCH, from OSEC's memory.  Return
+     the number of chunks that could be read, warning about the first
+     one that could not.  */
+  size_t read_batch (asection *osec, std::vector<chunk> &batch,
+		     size_t count);
+
+  /* Queue writing the first COUNT chunks of BATCH to OSEC.  Return
+     false if a previous write to OSEC failed, in which case nothing is
+     queued.  */
+  bool write_batch (asection *osec, const std::vector<chunk> &batch,
+		    size_t count);
+
+  /* Wait for the pending write, if any.  Warn if it failed, and return
+     false if it was a write to OSEC.  */
+  bool finish_for (asection *osec);
+
+  /* The core file being written.  */
+  bfd *m_obfd;
+
+  /* The file descriptor to read the inferior's memory from, or -1.  */
+  int m_mem_fd;
+
+  /* How many chunks to read at once.  */
+  size_t m_batch_size;
+
+  /* The target is read into one of these while the other is being
+     written out.  */
+  std::vector<chunk> m_batches[2];
+
+  /* Index of the batch to read into next.  */
+  int m_current = 0;
+
+  /* The write in flight and the section it writes to.  */
+  std::optional<gdb::future<std::string>> m_pending;
+  asection *m_pending_section = nullptr;
+};
+
+gcore_memory_writer::gcore_memory_writer (bfd *obfd, int mem_fd)
+  : m_obfd (obfd),
+    m_mem_fd (mem_fd),
+    m_batch_size (1)
+{
+  size_t n_threads = gdb::thread_pool::g_thread_pool->thread_count ();
+
+  if (m_mem_fd >= 0 && n_threads > 1)
+    m_batch_size = std::min<size_t> (n_threads, MAX_COPY_CHUNKS);
+}
+
+/* Read SIZE bytes at ADDR from FD, a file whose offsets are addresses
+   in the inferior's memory, into BUF.  Return true if all of them
+   could be read.  */
+
+static bool
+gcore_read_memory_fd (int fd, CORE_ADDR addr, gdb_byte *buf, size_t size)
 {
-  bfd_size_type size, total_size = bfd_section_size (osec);
+#ifdef HAVE_PREAD
+  if ((off_t) addr < 0 || (off_t) (addr + size) < 0)
+    return false;
+
+  while (size > 0)
+    {
+      ssize_t n = pread (fd, buf, size, addr);
+
+      if (n == -1 && errno == EINTR)
+	continue;
+      if (n <= 0)
+	return false;
+
+      buf += n;
+      addr += n;
+      size -= n;
+    }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+size_t
+gcore_memory_writer::read_batch (asection *osec, std::vector<chunk> &batch,
+				 size_t count)
+{
+  CORE_ADDR vma = bfd_section_vma (osec);
+
+  if (count > 1)
+    {
+      int fd = m_mem_fd;
+
+      gdb::parallel_for_each (1, batch.begin (), batch.begin () + count,
+			      [=] (std::vector<chunk>::iterator start,
+				   std::vector<chunk>::iterator end)
+	{
+	  for (auto it = start; it != end; ++it)
+	    it->read_from_fd = gcore_read_memory_fd (fd, vma + it->offset,
+						     it->data.data (),
+						     it->size);
+	});
+    }
+  else
+    batch[0].read_from_fd = false;
+
+  for (size_t i = 0; i < count; i++)
+    {
+      chunk &c = batch[i];
+
+      if (c.read_from_fd)
+	{
+	  /* The memory file shows inserted breakpoints; put back what
+	     target_read_memory would have read.  */
+	  breakpoint_xfer_memory (c.data.data (), nullptr, nullptr,
+				  vma + c.offset, c.size);
+	}
+      else if (target_read_memory (vma + c.offset, c.data.data (),
+				   c.size) != 0)
+	{
+	  warning (_("Memory read failed for corefile "
+		     "section, %s bytes at %s."),
+		   plongest (c.size),
+		   paddress (current_inferior ()->arch (), vma));
+	  return i;
+	}
+    }
+
+  return count;
+}
+
+bool
+gcore_memory_writer::write_batch (asection *osec,
+				  const std::vector<chunk> &batch,
+				  size_t count)
+{
+  if (!finish_for (osec))
+    return false;
+
+  const chunk *chunks = batch.data ();
+  bfd *obfd = m_obfd;
+  m_pending_section = osec;
+  m_pending.emplace
+    (gdb::thread_pool::g_thread_pool->post_task<std::string>
+       ([=] () -> std::string
+	{
+	  for (size_t i = 0; i < count; i++)
+	    if (!sparse_bfd_set_section_contents (obfd, osec,
+						  chunks[i].data.data (),
+						  chunks[i].offset,
+						  chunks[i].size))
+	      return bfd_errmsg (bfd_get_error ());
+	  return {};
+	}));
+
+  return true;
+}
+
+bool
+gcore_memory_writer::finish_for (asection *osec)
+{
+  if (!m_pending.has_value ())
+    return true;
+
+  std::string error = m_pending->get ();
+  m_pending.reset ();
+  if (error.empty ())
+    return true;
+
+  warning (_("Failed to write corefile contents (%s)."), error.c_str ());
+  return m_pending_section != osec;
+}
+
+void
+gcore_memory_writer::copy_section (asection *osec)
+{
+  bfd_size_type total_size = bfd_section_size (osec);
   file_ptr offset = 0;
 
   /* Read-only sections are marked; we don't have to copy their contents.  */
@@ -758,35 +989,34 @@ gcore_copy_callback (bfd *obfd, asection *osec)
   if (!startswith (bfd_section_name (osec), "load"))
     return;
 
-  size = std::min (total_size, (bfd_size_type) MAX_COPY_BYTES);
-  gdb::byte_vector memhunk (size);
-
   while (total_size > 0)
     {
-      if (size > total_size)
-	size = total_size;
+      /* The pending write, if any, is from the other batch.  */
+      std::vector<chunk> &batch = m_batches[m_current];
+      size_t count = 0;
 
-      if (target_read_memory (bfd_section_vma (osec) + offset,
-			      memhunk.data (), size) != 0)
+      while (count < m_batch_size && total_size > 0)
 	{
-	  warning (_("Memory read failed for corefile "
-		     "section, %s bytes at %s."),
-		   plongest (size),
-		   paddress (current_inferior ()->arch (),
-			     bfd_section_vma (osec)));
-	  break;
-	}
+	  if (batch.size () == count)
+	    batch.emplace_back ();
 
-      if (!sparse_bfd_set_section_contents (obfd, osec, memhunk.data (),
-					    offset, size))
-	{
-	  warning (_("Failed to write corefile contents (%s)."),
-		   bfd_errmsg (bfd_get_error ()));
-	  break;
+	  chunk &c = batch[count++];
+	  c.offset = offset;
+	  c.size = std::min (total_size, (bfd_size_type) MAX_COPY_BYTES);
+	  if (c.data.size () < c.size)
+	    c.data.resize (c.size);
+
+	  total_size -= c.size;
+	  offset += c.size;
 	}
 
-      total_size -= size;
-      offset += size;
+      size_t n_read = read_batch (osec, batch, count);
+      if (n_read > 0 && !write_batch (osec, batch, n_read))
+	break;
+
+      m_current ^= 1;
+      if (n_read < count)
+	break;
     }
 }
 
@@ -830,12 +1060,23 @@ gcore_memory_sections (bfd *obfd)
   for (asection *sect : gdb_bfd_sections (obfd))
     make_output_phdrs (obfd, sect);
 
-  /* Copy memory region and memory tag contents.  */
+  /* Copy memory region and memory tag contents.  Record targets show
+     memory other than the inferior's, so only read the memory file of
+     the process target without one.  */
+  int mem_fd = find_record_target () == nullptr ? target_memory_fd () : -1;
+  gcore_memory_writer writer (obfd, mem_fd);
   for (asection *sect : gdb_bfd_sections (obfd))
     {
-      gcore_copy_callback (obfd, sect);
-      gcore_copy_memtag_section_callback (obfd, sect);
+      writer.copy_section (sect);
+
+      if (startswith (bfd_section_name (sect), "memtag"))
+	{
+	  /* Filling the section writes to OBFD.  */
+	  writer.finish ();
+	  gcore_copy_memtag_section_callback (obfd, sect);
+	}
     }
+  writer.finish ();
 
   return 1;
 }
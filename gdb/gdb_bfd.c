@@ -35,6 +35,10 @@
 #include "cli/cli-style.h"
 #include <unordered_map>
 #include "gdbsupport/unordered_set.h"
+#include "gdbsupport/pathstuff.h"
+#include "gdbsupport/scoped_fd.h"
+#include "gdbsupport/gdb_unlinker.h"
+#include "build-id.h"
 
 #if CXX_STD_THREAD
 
@@ -378,6 +382,13 @@ struct target_fileio_stream : public gdb_bfd_iovec_base
 
   int stat (struct bfd *abfd, struct stat *sb) override;
 
+  /* Serve all further reads from FD, a local copy of the target
+     file.  */
+  void use_local_copy (scoped_fd fd)
+  {
+    m_local_fd = std::move (fd);
+  }
+
 private:
 
   /* The BFD.  Saved for the destructor.  */
@@ -385,8 +396,18 @@ struct target_fileio_stream : public gdb_bfd_iovec_base
 
   /* The file descriptor.  */
   int m_fd;
+
+  /* If valid, a file descriptor for a local copy of the file, which
+     reads are served from instead of the target.  */
+  scoped_fd m_local_fd;
+
+  /* Whether the target file cache was looked up for this file.  */
+  bool m_cache_checked = false;
 };
 
+static void target_file_cache_lookup (bfd *abfd,
+				      target_fileio_stream *stream);
+
 /* Wrapper for target_fileio_open suitable for use as a helper
    function for gdb_bfd_openr_iovec.  */
 
@@ -422,6 +443,46 @@ target_fileio_stream::read (struct bfd *abfd, void *buf,
   fileio_error target_errno;
   file_ptr pos, bytes;
 
+  /* The build-id is only known once the caller has checked that the
+     file is an object file, which is not done for all files read from
+     the target.  So the cache is looked up on the first read after
+     that, rather than when the file is opened.  */
+  if (!m_cache_checked
+      && abfd->format == bfd_object
+      && abfd->build_id != nullptr)
+    {
+      m_cache_checked = true;
+      target_file_cache_lookup (abfd, this);
+    }
+
+  if (m_local_fd.get () != -1)
+    {
+      pos = 0;
+      while (nbytes > pos)
+	{
+#ifdef HAVE_PREAD
+	  bytes = pread (m_local_fd.get (), (gdb_byte *) buf + pos,
+			 nbytes - pos, offset + pos);
+#else
+	  bytes = lseek (m_local_fd.get (), offset + pos, SEEK_SET);
+	  if (bytes != -1)
+	    bytes = ::read (m_local_fd.get (), (gdb_byte *) buf + pos,
+			    nbytes - pos);
+#endif
+	  if (bytes == 0)
+	    break;
+	  if (bytes == -1)
+	    {
+	      bfd_set_error (bfd_error_system_call);
+	      return -1;
+	    }
+
+	  pos += bytes;
+	}
+
+      return pos;
+    }
+
   pos = 0;
   while (nbytes > pos)
     {
@@ -493,6 +554,114 @@ target_fileio_stream::stat (struct bfd *abfd, struct stat *sb)
   return result;
 }
 
+/* Whether to keep local copies of target files that have a
+   build-id.  */
+
+static bool target_file_cache_enabled = false;
+
+/* The directory holding local copies of target files, named after
+   their build-id.  */
+
+static std::string target_file_cache_directory;
+
+/* Copy the SIZE bytes of the target file read through STREAM for ABFD
+   into the target file cache as FILENAME.  The copy is written to a
+   temporary file first, so that FILENAME only ever holds complete
+   contents.  */
+
+static void
+target_file_cache_store (bfd *abfd, target_fileio_stream *stream,
+			 off_t size, const std::string &filename)
+{
+  if (!mkdir_recursive (target_file_cache_directory.c_str ()))
+    perror_with_name (target_file_cache_directory.c_str ());
+
+  gdb::char_vector filename_temp = make_temp_filename (filename);
+  scoped_fd out_fd = gdb_mkostemp_cloexec (filename_temp.data (), O_BINARY);
+  if (out_fd.get () == -1)
+    perror_with_name (filename_temp.data ());
+
+  gdb::unlinker unlink_file (filename_temp.data ());
+  gdb_file_up out_file = out_fd.to_file ("wb");
+  if (out_file == nullptr)
+    perror_with_name (filename_temp.data ());
+
+  /* Read in large blocks, so that the target can pipeline the
+     transfer.  */
+  gdb::byte_vector buf (1024 * 1024);
+  for (off_t offset = 0; offset < size; )
+    {
+      file_ptr want = std::min<off_t> (buf.size (), size - offset);
+      file_ptr got = stream->read (abfd, buf.data (), want, offset);
+      if (got <= 0)
+	error (_("could not read \"%s\""), bfd_get_filename (abfd));
+
+      if (fwrite (buf.data (), 1, got, out_file.get ()) != got)
+	perror_with_name (filename_temp.data ());
+      offset += got;
+    }
+
+  if (fclose (out_file.release ()) != 0)
+    perror_with_name (filename_temp.data ());
+
+  if (rename (filename_temp.data (), filename.c_str ()) != 0)
+    perror_with_name (("rename"));
+  unlink_file.keep ();
+}
+
+/* If the target file cache is enabled, redirect STREAM, through which
+   ABFD, an object file with a build-id, is read from the target, to
+   the cached copy of the file, creating the copy first if needed.  Any
+   failure just leaves ABFD reading from the target.  */
+
+static void
+target_file_cache_lookup (bfd *abfd, target_fileio_stream *stream)
+{
+  if (!target_file_cache_enabled || target_file_cache_directory.empty ())
+    return;
+
+  struct stat st;
+  if (stream->stat (abfd, &st) != 0)
+    return;
+
+  std::string filename = (target_file_cache_directory + SLASH_STRING
+			  + build_id_to_string (abfd->build_id));
+
+  /* A cached copy whose size does not match was left behind by
+     something other than us; replace it.  */
+  scoped_fd fd = gdb_open_cloexec (filename, O_RDONLY | O_BINARY, 0);
+  struct stat local_st;
+  if (fd.get () != -1
+      && (fstat (fd.get (), &local_st) != 0
+	  || local_st.st_size != st.st_size))
+    fd = scoped_fd ();
+
+  if (fd.get () == -1)
+    {
+      try
+	{
+	  bfd_cache_debug_printf ("Copying %s to %s",
+				  bfd_get_filename (abfd), filename.c_str ());
+	  target_file_cache_store (abfd, stream, st.st_size, filename);
+	}
+      catch (const gdb_exception_error &ex)
+	{
+	  warning (_("could not cache \"%s\": %s"),
+		   bfd_get_filename (abfd), ex.what ());
+	  return;
+	}
+
+      fd = gdb_open_cloexec (filename, O_RDONLY | O_BINARY, 0);
+      if (fd.get () == -1)
+	return;
+    }
+  else
+    bfd_cache_debug_printf ("Using cached copy %s of %s",
+			    filename.c_str (), bfd_get_filename (abfd));
+
+  stream->use_local_copy (std::move (fd));
+}
+
 /* A helper function to initialize the data that gdb attaches to each
    BFD.  */
 
@@ -1321,6 +1490,26 @@ When non-zero, bfd cache specific debugging is enabled."),
 			   &show_bfd_cache_debug,
 			   &setdebuglist, &showdebuglist);
 
+  std::string cache_dir = get_standard_cache_dir ();
+  if (!cache_dir.empty ())
+    target_file_cache_directory = cache_dir + SLASH_STRING + "target-files";
+
+  add_setshow_boolean_cmd ("target-file-cache", class_files,
+			   &target_file_cache_enabled, _("\
+Set whether gdb keeps local copies of files read from the target."), _("\
+Show whether gdb keeps local copies of files read from the target."), _("\
+When on, files read from a remote target's filesystem that have a\n\
+build-id are copied to the target file cache directory the first time\n\
+they are read.  Later sessions that find a file with the same build-id\n\
+on the target read the local copy instead of transferring it again."),
+			   NULL, NULL, &setlist, &showlist);
+
+  add_setshow_filename_cmd ("target-file-cache-directory", class_files,
+			    &target_file_cache_directory, _("\
+Set the directory of the target file cache."), _("\
+Show the directory of the target file cache."), NULL,
+			    NULL, NULL, &setlist, &showlist);
+
   /* Hook the BFD error/warning handler to limit amount of output.  */
   bfd_set_error_handler (gdb_bfd_error_handler);
 }
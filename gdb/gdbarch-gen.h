@@ -283,6 +283,15 @@ extern void set_gdbarch_ps_regnum (struct gdbarch *gdbarch, int ps_regnum);
 extern int gdbarch_fp0_regnum (struct gdbarch *gdbarch);
 extern void set_gdbarch_fp0_regnum (struct gdbarch *gdbarch, int fp0_regnum);
 
+/* The register that, in frames following the ABI's frame pointer
+   convention, holds the address where the caller's value of the same
+   register is saved, linking the frames into a chain; or -1.  This is
+   only used as a hint, to fetch the memory of a thread's frames ahead
+   of unwinding them. */
+
+extern int gdbarch_frame_pointer_regnum (struct gdbarch *gdbarch);
+extern void set_gdbarch_frame_pointer_regnum (struct gdbarch *gdbarch, int frame_pointer_regnum);
+
 /* Convert stab register number (from `r' declaration) to a gdb REGNUM. */
 
 typedef int (gdbarch_stab_reg_to_regnum_ftype) (struct gdbarch *gdbarch, int stab_regnr);
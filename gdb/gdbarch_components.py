@@ -544,6 +544,20 @@ Value(
     invalid=False,
 )
 
+Value(
+    comment="""
+The register that, in frames following the ABI's frame pointer
+convention, holds the address where the caller's value of the same
+register is saved, linking the frames into a chain; or -1.  This is
+only used as a hint, to fetch the memory of a thread's frames ahead
+of unwinding them.
+""",
+    type="int",
+    name="frame_pointer_regnum",
+    predefault="-1",
+    invalid=False,
+)
+
 Method(
     comment="""
 Convert stab register number (from `r' declaration) to a gdb REGNUM.
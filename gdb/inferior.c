@@ -91,6 +91,31 @@ inferior::inferior (int pid_)
 
 /* See inferior.h.  */
 
+void
+inferior::push_target (struct target_ops *t)
+{
+  /* If the process stratum target changes under existing threads, move
+     the threads over to the new target's ptid map.  Pushing replaces
+     any target already at the same stratum without going through
+     unpush_target below.  */
+  if (t->stratum () == process_stratum)
+    {
+      process_stratum_target *old_target = this->process_target ();
+      process_stratum_target *new_target = as_process_stratum_target (t);
+
+      for (thread_info *thread : this->non_exited_threads ())
+	{
+	  if (old_target != nullptr)
+	    old_target->remove_thread_from_map (thread);
+	  new_target->add_thread_to_map (thread);
+	}
+    }
+
+  m_target_stack.push (t);
+}
+
+/* See inferior.h.  */
+
 int
 inferior::unpush_target (struct target_ops *t)
 {
@@ -104,7 +129,10 @@ inferior::unpush_target (struct target_ops *t)
       process_stratum_target *proc_target = as_process_stratum_target (t);
 
       for (thread_info *thread : this->non_exited_threads ())
-	proc_target->maybe_remove_resumed_with_pending_wait_status (thread);
+	{
+	  proc_target->maybe_remove_resumed_with_pending_wait_status (thread);
+	  proc_target->remove_thread_from_map (thread);
+	}
     }
 
   return m_target_stack.unpush (t);
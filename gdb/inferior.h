@@ -63,7 +63,7 @@ struct thread_info;
 #include "process-stratum-target.h"
 #include "displaced-stepping.h"
 
-#include <unordered_map>
+#include "gdbsupport/unordered_map.h"
 
 struct infcall_suspend_state;
 struct infcall_control_state;
@@ -401,13 +401,12 @@ class inferior : public refcounted_object,
   bool deletable () const { return refcount () == 0; }
 
   /* Push T in this inferior's target stack.  */
-  void push_target (struct target_ops *t)
-  { m_target_stack.push (t); }
+  void push_target (struct target_ops *t);
 
   /* An overload that deletes the target on failure.  */
   void push_target (target_ops_up &&t)
   {
-    m_target_stack.push (t.get ());
+    push_target (t.get ());
     t.release ();
   }
 
@@ -459,7 +458,7 @@ class inferior : public refcounted_object,
 
   /* A map of ptid_t to thread_info*, for average O(1) ptid_t lookup.
      Exited threads do not appear in the map.  */
-  std::unordered_map<ptid_t, thread_info *> ptid_thread_map;
+  gdb::unordered_map<ptid_t, thread_info *> ptid_thread_map;
 
   /* Returns a range adapter covering the inferior's threads,
      including exited threads.  Used like this:
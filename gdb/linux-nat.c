@@ -4185,6 +4185,21 @@ linux_proc_xfer_memory_partial (int pid, gdb_byte *readbuf,
 					    len, xfered_len);
 }
 
+/* Implement the "memory_fd" target_ops method.  */
+
+int
+linux_nat_target::memory_fd ()
+{
+  if (inferior_ptid == null_ptid)
+    return -1;
+
+  auto iter = proc_mem_file_map.find (inferior_ptid.pid ());
+  if (iter == proc_mem_file_map.end ())
+    return -1;
+
+  return iter->second.fd ();
+}
+
 /* Check whether /proc/pid/mem is writable in the current kernel, and
    return true if so.  It wasn't writable before Linux 2.6.39, but
    there's no way to know whether the feature was backported to older
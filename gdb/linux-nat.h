@@ -57,6 +57,8 @@ class linux_nat_target : public inf_ptrace_target
 					ULONGEST offset, ULONGEST len,
 					ULONGEST *xfered_len) override;
 
+  int memory_fd () override;
+
   void kill () override;
 
   void mourn_inferior () override;
@@ -187,10 +187,29 @@ process_stratum_target::random_resumed_with_pending_wait_status
 thread_info *
 process_stratum_target::find_thread (ptid_t ptid)
 {
-  inferior *inf = find_inferior_ptid (this, ptid);
-  if (inf == NULL)
-    return NULL;
-  return inf->find_thread (ptid);
+  auto it = m_ptid_thread_map.find (ptid);
+  if (it == m_ptid_thread_map.end ())
+    return nullptr;
+  return it->second;
+}
+
+/* See process-stratum-target.h.  */
+
+void
+process_stratum_target::add_thread_to_map (thread_info *thr)
+{
+  gdb_assert (thr->state != THREAD_EXITED);
+  m_ptid_thread_map[thr->ptid] = thr;
+}
+
+/* See process-stratum-target.h.  */
+
+void
+process_stratum_target::remove_thread_from_map (thread_info *thr)
+{
+  auto it = m_ptid_thread_map.find (thr->ptid);
+  if (it != m_ptid_thread_map.end () && it->second == thr)
+    m_ptid_thread_map.erase (it);
 }
 
 /* See process-stratum-target.h.  */
@@ -25,6 +25,7 @@
 #include "gdbsupport/intrusive_list.h"
 #include "gdbsupport/gdb-checked-static-cast.h"
 #include "gdbthread.h"
+#include "gdbsupport/unordered_map.h"
 
 /* Abstract base class inherited by all process_stratum targets.  */
 
@@ -105,9 +106,19 @@ class process_stratum_target : public target_ops
   thread_info *random_resumed_with_pending_wait_status
     (inferior *inf, ptid_t filter_ptid);
 
-  /* Search function to lookup a (non-exited) thread by 'ptid'.  */
+  /* Search function to lookup a (non-exited) thread by 'ptid'.  This
+     is a single hash table lookup, regardless of how many inferiors
+     and threads this target has.  */
   thread_info *find_thread (ptid_t ptid);
 
+  /* Add THR, a non-exited thread of an inferior using this target, to
+     the target-wide ptid -> thread map.  */
+  void add_thread_to_map (thread_info *thr);
+
+  /* Remove THR from the target-wide ptid -> thread map, if it is
+     there.  */
+  void remove_thread_from_map (thread_info *thr);
+
   /* The connection number.  Visible in "info connections".  */
   int connection_number = 0;
 
@@ -153,6 +164,15 @@ class process_stratum_target : public target_ops
      avoids walking the thread lists repeatedly.  */
   thread_info_resumed_with_pending_wait_status_list
     m_resumed_with_pending_wait_status;
+
+  /* Map of ptid to non-exited thread, for all inferiors using this
+     target.  Like the list above, this could be computed by walking the
+     inferior list and then each inferior's ptid map, but find_thread is
+     called very frequently from infrun, and with many inferiors the
+     walk shows up.  Kept up to date by new_thread, set_thread_exited,
+     thread_change_ptid, and when this target is pushed on or unpushed
+     from an inferior that already has threads.  */
+  gdb::unordered_map<ptid_t, thread_info *> m_ptid_thread_map;
 };
 
 /* Downcast TARGET to process_stratum_target.  */
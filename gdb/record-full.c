@@ -40,12 +40,17 @@
 #include "infrun.h"
 #include "gdbsupport/gdb_unlinker.h"
 #include "gdbsupport/byte-vector.h"
+#include "leb128.h"
 #include "gdbsupport/scoped_signal_handler.h"
 #include "async-event.h"
 #include "top.h"
 #include "valprint.h"
 #include "interps.h"
+#include "gdbsupport/selftest.h"
+#include "gdbsupport/unordered_map.h"
 
+#include <bitset>
+#include <deque>
 #include <signal.h>
 
 /* This module implements "target record-full", also known as "process
@@ -71,20 +76,27 @@
 #define DEFAULT_RECORD_FULL_INSN_MAX_NUM	200000
 
 #define RECORD_FULL_IS_REPLAY \
-  (record_full_list->next || ::execution_direction == EXEC_REVERSE)
+  (!record_full_at_end (record_full_list) \
+   || ::execution_direction == EXEC_REVERSE)
 
 #define RECORD_FULL_FILE_MAGIC	netorder32(0x20091016)
 
+/* Default size of one chunk of the execution log.  Records larger than
+   this get a chunk of their own.  */
+
+#define RECORD_FULL_CHUNK_SIZE	(64 * 1024)
+
 /* These are the core structs of the process record functionality.
 
    A record_full_entry is a record of the value change of a register
    ("record_full_reg") or a part of memory ("record_full_mem").  And each
-   instruction must have a struct record_full_entry ("record_full_end")
-   that indicates that this is the last struct record_full_entry of this
+   instruction must have a record_full_entry ("record_full_end")
+   that indicates that this is the last record_full_entry of this
    instruction.
 
-   Each struct record_full_entry is linked to "record_full_list" by "prev"
-   and "next" pointers.  */
+   Entries are not allocated individually.  They are stored, encoded,
+   in the execution log (see record_full_log below), and a struct
+   record_full_entry is only a decoded view of one of them.  */
 
 struct record_full_mem_entry
 {
@@ -93,22 +105,12 @@ struct record_full_mem_entry
   /* Set this flag if target memory for this entry
      can no longer be accessed.  */
   int mem_entry_not_accessible;
-  union
-  {
-    gdb_byte *ptr;
-    gdb_byte buf[sizeof (gdb_byte *)];
-  } u;
 };
 
 struct record_full_reg_entry
 {
   unsigned short num;
   unsigned short len;
-  union 
-  {
-    gdb_byte *ptr;
-    gdb_byte buf[2 * sizeof (gdb_byte *)];
-  } u;
 };
 
 struct record_full_end_entry
@@ -124,34 +126,71 @@ enum record_full_type
   record_full_mem
 };
 
-/* This is the data structure that makes up the execution log.
+/* One block of the execution log.  Chunks are linked together in the
+   order in which their records were appended.  */
+
+struct record_full_chunk
+{
+  explicit record_full_chunk (size_t size_)
+    : size (size_), data (new gdb_byte[size_])
+  {}
+
+  record_full_chunk *prev = nullptr;
+  record_full_chunk *next = nullptr;
+
+  /* Offset of the first live record.  Only the oldest chunk of the log
+     can have a non-zero START, once its first records are released.  */
+  size_t start = 0;
+
+  /* Number of bytes in use, and the capacity of DATA.  */
+  size_t used = 0;
+  size_t size;
+
+  /* Memory entry addresses in this chunk are stored as deltas from
+     ADDR_BASE, which is the address of the first memory entry appended
+     to the chunk.  */
+  bool has_addr_base = false;
+  CORE_ADDR addr_base = 0;
+
+  std::unique_ptr<gdb_byte[]> data;
+};
+
+/* The position of an entry in the execution log.  */
 
-   The execution log consists of a single linked list of entries
-   of type "struct record_full_entry".  It is doubly linked so that it
-   can be traversed in either direction.
+struct record_full_pos
+{
+  record_full_chunk *chunk = nullptr;
+  size_t offset = 0;
 
-   The start of the list is anchored by a struct called
-   "record_full_first".  The pointer "record_full_list" either points
-   to the last entry that was added to the list (in record mode), or to
-   the next entry in the list that will be executed (in replay mode).
+  bool operator== (const record_full_pos &other) const
+  {
+    return chunk == other.chunk && offset == other.offset;
+  }
 
-   Each list element (struct record_full_entry), in addition to next
-   and prev pointers, consists of a union of three entry types: mem,
-   reg, and end.  A field called "type" determines which entry type is
-   represented by a given list element.
+  bool operator!= (const record_full_pos &other) const
+  {
+    return !(*this == other);
+  }
+};
+
+/* A decoded entry of the execution log.
 
    Each instruction that is added to the execution log is represented
-   by a variable number of list elements ('entries').  The instruction
-   will have one "reg" entry for each register that is changed by 
-   executing the instruction (including the PC in every case).  It 
-   will also have one "mem" entry for each memory change.  Finally,
-   each instruction will have an "end" entry that separates it from
-   the changes associated with the next instruction.  */
+   by a variable number of entries.  The instruction will have one "reg"
+   entry for each register that is changed by executing the instruction
+   (including the PC in every case).  It will also have one "mem" entry
+   for each memory change.  Finally, each instruction will have an "end"
+   entry that separates it from the changes associated with the next
+   instruction.  */
 
 struct record_full_entry
 {
-  struct record_full_entry *prev;
-  struct record_full_entry *next;
+  /* Where the entry lives in the log.  */
+  record_full_pos pos;
+
+  /* Size of the encoded entry, in bytes.  */
+  size_t size;
+
   enum record_full_type type;
   union
   {
@@ -162,8 +201,539 @@ struct record_full_entry
     /* end */
     struct record_full_end_entry end;
   } u;
+
+  /* The saved value of a reg or mem entry.  This points into the log,
+     and replaying the entry swaps it with the current value.  */
+  gdb_byte *loc;
+};
+
+/* This is the data structure that makes up the execution log.
+
+   The log is an append-only sequence of variable-length records,
+   stored back to back in a doubly linked list of large chunks.  Each
+   record is laid out as
+
+     header byte     the record_full_type, plus RECORD_FULL_MEM_NA
+     reg:            ULEB128 register number, ULEB128 length, value
+     mem:            SLEB128 address delta from the chunk's ADDR_BASE,
+		     ULEB128 length, contents
+     end:            2-byte signal number, ULEB128 instruction number
+     footer          length of the record without the footer, as
+		     ULEB128 stored back to front
+
+   The footer lets the log be walked backwards.  Records never span
+   two chunks.  The signal number of an end record and the header byte
+   of a memory record are the only parts that change once written.
+
+   The first record of the log is always an "end" record that anchors
+   the beginning of the log; it does not describe an instruction.  When
+   the oldest instruction is discarded, its own "end" record becomes the
+   new anchor.
+
+   Records for the instruction being recorded are appended after the
+   last committed record, but are invisible to the traversal functions
+   until commit is called; discard throws them away instead.  */
+
+class record_full_log
+{
+public:
+  record_full_log () = default;
+  ~record_full_log ()
+  { free_chunks (m_first); }
+
+  DISABLE_COPY_AND_ASSIGN (record_full_log);
+
+  /* Discard the whole log, leaving only an anchor "end" record.  */
+  void reset ();
+
+  /* The anchor entry.  */
+  record_full_pos begin () const
+  { return m_begin; }
+
+  /* The last committed entry.  */
+  record_full_pos last () const
+  { return m_last; }
+
+  /* Move POS to the following committed entry.  Return false, leaving
+     POS unchanged, if POS is the last entry.  */
+  bool next (record_full_pos &pos) const;
+
+  /* Move POS to the preceding entry.  Return false, leaving POS
+     unchanged, if POS is the anchor.  */
+  bool prev (record_full_pos &pos) const;
+
+  /* Decode the entry at POS.  */
+  record_full_entry decode (const record_full_pos &pos) const;
+
+  /* Append a staged "reg" or "mem" entry of LEN bytes, and return where
+     its value is to be stored.  */
+  gdb_byte *append_reg (int regnum, int len);
+  gdb_byte *append_mem (CORE_ADDR addr, int len);
+
+  /* Append a staged "end" entry.  */
+  void append_end (enum gdb_signal sigval, ULONGEST insn_num);
+
+  /* Make the staged entries part of the log, or throw them away.  */
+  void commit ();
+  void discard ();
+
+  /* Remove the most recently appended staged entry.  */
+  void drop_last ();
+
+  /* Release the oldest instruction of the log, whose "end" entry
+     becomes the new anchor.  */
+  void release_first ();
+
+  /* Release all the entries following POS.  Return the number of
+     instructions released.  */
+  unsigned int release_following (const record_full_pos &pos);
+
+  /* Update mutable fields of an already written entry.  */
+  void set_mem_not_accessible (const record_full_entry &entry);
+  void set_end_signal (const record_full_pos &pos, enum gdb_signal sigval);
+
+  /* Number of bytes used by the committed entries, and number of bytes
+     allocated for the log.  */
+  ULONGEST bytes_used () const
+  { return m_bytes_used; }
+  ULONGEST bytes_allocated () const
+  { return m_bytes_allocated; }
+
+private:
+  /* Reserve LEN bytes at the end of the log, and return where they
+     start.  */
+  gdb_byte *reserve (size_t len);
+
+  /* Append the footer of the record that starts at START.  */
+  void finish_record (gdb_byte *start);
+
+  /* Free CHUNK and all the chunks following it.  */
+  void free_chunks (record_full_chunk *chunk);
+
+  /* Truncate the log after POS, which is known to be a record.  */
+  void truncate_after (const record_full_pos &pos);
+
+  record_full_chunk *m_first = nullptr;
+  record_full_chunk *m_tail = nullptr;
+
+  record_full_pos m_begin;
+  record_full_pos m_last;
+
+  ULONGEST m_bytes_used = 0;
+  ULONGEST m_bytes_allocated = 0;
 };
 
+/* Flag in the header byte of a "mem" record, set when the memory can no
+   longer be accessed.  */
+
+#define RECORD_FULL_MEM_NA	0x80
+
+/* Maximum size of a ULEB128 or SLEB128 encoded 64-bit value.  */
+
+#define RECORD_FULL_LEB_MAX	10
+
+/* Encode VALUE as ULEB128 at BUF, and return the number of bytes
+   written.  */
+
+static size_t
+record_full_put_uleb128 (gdb_byte *buf, ULONGEST value)
+{
+  size_t n = 0;
+
+  do
+    {
+      gdb_byte byte = value & 0x7f;
+
+      value >>= 7;
+      if (value != 0)
+	byte |= 0x80;
+      buf[n++] = byte;
+    }
+  while (value != 0);
+
+  return n;
+}
+
+/* Encode VALUE as SLEB128 at BUF, and return the number of bytes
+   written.  */
+
+static size_t
+record_full_put_sleb128 (gdb_byte *buf, LONGEST value)
+{
+  size_t n = 0;
+  bool more = true;
+
+  while (more)
+    {
+      gdb_byte byte = value & 0x7f;
+
+      value >>= 7;
+      if ((value == 0 && (byte & 0x40) == 0)
+	  || (value == -1 && (byte & 0x40) != 0))
+	more = false;
+      else
+	byte |= 0x80;
+      buf[n++] = byte;
+    }
+
+  return n;
+}
+
+/* Return the number of bytes needed to encode VALUE as ULEB128.  */
+
+static size_t
+record_full_uleb128_size (ULONGEST value)
+{
+  size_t n = 1;
+
+  while ((value >>= 7) != 0)
+    n++;
+  return n;
+}
+
+void
+record_full_log::free_chunks (record_full_chunk *chunk)
+{
+  while (chunk != nullptr)
+    {
+      record_full_chunk *next = chunk->next;
+
+      m_bytes_allocated -= chunk->size;
+      delete chunk;
+      chunk = next;
+    }
+}
+
+void
+record_full_log::reset ()
+{
+  free_chunks (m_first);
+  m_first = m_tail = nullptr;
+  m_bytes_used = 0;
+
+  append_end (GDB_SIGNAL_0, 0);
+  m_begin.chunk = m_first;
+  m_begin.offset = 0;
+  m_last = m_begin;
+}
+
+gdb_byte *
+record_full_log::reserve (size_t len)
+{
+  if (m_tail == nullptr || m_tail->size - m_tail->used < len)
+    {
+      record_full_chunk *chunk
+	= new record_full_chunk (std::max<size_t> (len,
+						   RECORD_FULL_CHUNK_SIZE));
+
+      m_bytes_allocated += chunk->size;
+      chunk->prev = m_tail;
+      if (m_tail != nullptr)
+	m_tail->next = chunk;
+      else
+	m_first = chunk;
+      m_tail = chunk;
+    }
+
+  gdb_byte *ret = m_tail->data.get () + m_tail->used;
+  m_tail->used += len;
+  return ret;
+}
+
+void
+record_full_log::finish_record (gdb_byte *start)
+{
+  gdb_byte *end = m_tail->data.get () + m_tail->used;
+  size_t len = end - start;
+  gdb_byte buf[RECORD_FULL_LEB_MAX];
+  size_t n = record_full_put_uleb128 (buf, len);
+
+  /* The space for the footer was reserved with the record.  */
+  gdb_assert (m_tail->size - m_tail->used >= n);
+  for (size_t i = 0; i < n; i++)
+    end[i] = buf[n - 1 - i];
+  m_tail->used += n;
+  m_bytes_used += len + n;
+}
+
+gdb_byte *
+record_full_log::append_reg (int regnum, int len)
+{
+  size_t max = 1 + 2 * RECORD_FULL_LEB_MAX + len + RECORD_FULL_LEB_MAX;
+  gdb_byte *start = reserve (max);
+  gdb_byte *p = start;
+
+  *p++ = record_full_reg;
+  p += record_full_put_uleb128 (p, regnum);
+  p += record_full_put_uleb128 (p, len);
+  gdb_byte *loc = p;
+  p += len;
+
+  /* Give back the unused part of the reservation, keeping room for
+     the footer.  */
+  m_tail->used -= max - (p - start);
+  finish_record (start);
+  return loc;
+}
+
+gdb_byte *
+record_full_log::append_mem (CORE_ADDR addr, int len)
+{
+  size_t max = 1 + 2 * RECORD_FULL_LEB_MAX + len + RECORD_FULL_LEB_MAX;
+  gdb_byte *start = reserve (max);
+  gdb_byte *p = start;
+
+  if (!m_tail->has_addr_base)
+    {
+      m_tail->has_addr_base = true;
+      m_tail->addr_base = addr;
+    }
+
+  *p++ = record_full_mem;
+  p += record_full_put_sleb128 (p, (LONGEST) (addr - m_tail->addr_base));
+  p += record_full_put_uleb128 (p, len);
+  gdb_byte *loc = p;
+  p += len;
+
+  m_tail->used -= max - (p - start);
+  finish_record (start);
+  return loc;
+}
+
+void
+record_full_log::append_end (enum gdb_signal sigval, ULONGEST insn_num)
+{
+  size_t max = 1 + 2 + RECORD_FULL_LEB_MAX + RECORD_FULL_LEB_MAX;
+  gdb_byte *start = reserve (max);
+  gdb_byte *p = start;
+
+  *p++ = record_full_end;
+  store_unsigned_integer (p, 2, BFD_ENDIAN_LITTLE, sigval);
+  p += 2;
+  p += record_full_put_uleb128 (p, insn_num);
+
+  m_tail->used -= max - (p - start);
+  finish_record (start);
+}
+
+record_full_entry
+record_full_log::decode (const record_full_pos &pos) const
+{
+  const gdb_byte *start = pos.chunk->data.get () + pos.offset;
+  const gdb_byte *end = pos.chunk->data.get () + pos.chunk->used;
+  const gdb_byte *p = start;
+  record_full_entry entry;
+  uint64_t val = 0;
+  int64_t sval = 0;
+
+  entry.pos = pos;
+  entry.type = (enum record_full_type) (*p & ~RECORD_FULL_MEM_NA);
+  entry.loc = nullptr;
+  p++;
+
+  switch (entry.type)
+    {
+    case record_full_reg:
+      p += read_uleb128_to_uint64 (p, end, &val);
+      entry.u.reg.num = val;
+      p += read_uleb128_to_uint64 (p, end, &val);
+      entry.u.reg.len = val;
+      entry.loc = const_cast<gdb_byte *> (p);
+      p += entry.u.reg.len;
+      break;
+
+    case record_full_mem:
+      entry.u.mem.mem_entry_not_accessible
+	= (*start & RECORD_FULL_MEM_NA) != 0;
+      p += read_sleb128_to_int64 (p, end, &sval);
+      entry.u.mem.addr = pos.chunk->addr_base + (CORE_ADDR) sval;
+      p += read_uleb128_to_uint64 (p, end, &val);
+      entry.u.mem.len = val;
+      entry.loc = const_cast<gdb_byte *> (p);
+      p += entry.u.mem.len;
+      break;
+
+    case record_full_end:
+      entry.u.end.sigval
+	= (enum gdb_signal) extract_unsigned_integer (p, 2,
+						      BFD_ENDIAN_LITTLE);
+      p += 2;
+      p += read_uleb128_to_uint64 (p, end, &val);
+      entry.u.end.insn_num = val;
+      break;
+
+    default:
+      gdb_assert_not_reached ("unexpected record_full_entry type");
+    }
+
+  entry.size = (p - start) + record_full_uleb128_size (p - start);
+  return entry;
+}
+
+bool
+record_full_log::next (record_full_pos &pos) const
+{
+  if (pos == m_last)
+    return false;
+
+  pos.offset += decode (pos).size;
+  if (pos.offset == pos.chunk->used)
+    {
+      pos.chunk = pos.chunk->next;
+      pos.offset = pos.chunk->start;
+    }
+  return true;
+}
+
+bool
+record_full_log::prev (record_full_pos &pos) const
+{
+  if (pos == m_begin)
+    return false;
+
+  if (pos.offset == pos.chunk->start)
+    {
+      pos.chunk = pos.chunk->prev;
+      pos.offset = pos.chunk->used;
+    }
+
+  /* Read the footer of the previous record, back to front.  */
+  const gdb_byte *p = pos.chunk->data.get () + pos.offset;
+  size_t footer = 0;
+  ULONGEST len = 0;
+  gdb_byte byte;
+
+  do
+    {
+      byte = *--p;
+      len |= (ULONGEST) (byte & 0x7f) << (7 * footer);
+      footer++;
+    }
+  while ((byte & 0x80) != 0);
+
+  pos.offset -= footer + len;
+  return true;
+}
+
+void
+record_full_log::commit ()
+{
+  /* The last record in the log is the "end" of the new instruction.  */
+  record_full_pos pos;
+
+  pos.chunk = m_tail;
+  pos.offset = m_tail->used;
+  prev (pos);
+  gdb_assert (decode (pos).type == record_full_end);
+  m_last = pos;
+}
+
+void
+record_full_log::truncate_after (const record_full_pos &pos)
+{
+  size_t used = pos.offset + decode (pos).size;
+
+  for (record_full_chunk *c = pos.chunk->next; c != nullptr; c = c->next)
+    m_bytes_used -= c->used - c->start;
+  free_chunks (pos.chunk->next);
+  pos.chunk->next = nullptr;
+  m_bytes_used -= pos.chunk->used - used;
+  pos.chunk->used = used;
+  m_tail = pos.chunk;
+}
+
+void
+record_full_log::discard ()
+{
+  truncate_after (m_last);
+}
+
+void
+record_full_log::drop_last ()
+{
+  record_full_pos pos;
+
+  pos.chunk = m_tail;
+  pos.offset = m_tail->used;
+  prev (pos);
+  gdb_assert (pos != m_last);
+
+  m_bytes_used -= m_tail->used - pos.offset;
+  m_tail->used = pos.offset;
+  if (m_tail->used == 0)
+    {
+      record_full_chunk *chunk = m_tail;
+
+      m_tail = chunk->prev;
+      m_tail->next = nullptr;
+      m_bytes_allocated -= chunk->size;
+      delete chunk;
+    }
+}
+
+void
+record_full_log::release_first ()
+{
+  record_full_pos pos = m_begin;
+  size_t released = 0;
+
+  /* Find the "end" entry of the oldest instruction.  */
+  while (next (pos))
+    if (decode (pos).type == record_full_end)
+      break;
+  if (pos == m_begin)
+    return;
+
+  /* Free the chunks that only hold released entries.  */
+  while (m_first != pos.chunk)
+    {
+      record_full_chunk *chunk = m_first;
+
+      released += chunk->used - chunk->start;
+      m_first = chunk->next;
+      m_first->prev = nullptr;
+      m_bytes_allocated -= chunk->size;
+      delete chunk;
+    }
+
+  released += pos.offset - m_first->start;
+  m_first->start = pos.offset;
+  m_begin = pos;
+  m_bytes_used -= released;
+}
+
+unsigned int
+record_full_log::release_following (const record_full_pos &pos)
+{
+  record_full_pos p = pos;
+  unsigned int count = 0;
+
+  while (next (p))
+    if (decode (p).type == record_full_end)
+      count++;
+
+  truncate_after (pos);
+  m_last = pos;
+  return count;
+}
+
+void
+record_full_log::set_mem_not_accessible (const record_full_entry &entry)
+{
+  gdb_assert (entry.type == record_full_mem);
+  entry.pos.chunk->data[entry.pos.offset] |= RECORD_FULL_MEM_NA;
+}
+
+void
+record_full_log::set_end_signal (const record_full_pos &pos,
+				 enum gdb_signal sigval)
+{
+  gdb_byte *p = pos.chunk->data.get () + pos.offset;
+
+  gdb_assert (*p == record_full_end);
+  store_unsigned_integer (p + 1, 2, BFD_ENDIAN_LITTLE, sigval);
+}
+
 /* If true, query if PREC cannot record memory
    change of next instruction.  */
 bool record_full_memory_query = false;
@@ -180,27 +750,44 @@ static detached_regcache *record_full_core_regbuf = NULL;
 static std::vector<target_section> record_full_core_sections;
 static struct record_full_core_buf_entry *record_full_core_buf_list = NULL;
 
-/* The following variables are used for managing the linked list that
-   represents the execution log.
+/* The following variables are used for managing the execution log.
 
-   record_full_first is the anchor that holds down the beginning of
-   the list.
+   record_full_log_data holds all the entries.
 
    record_full_list serves two functions:
-     1) In record mode, it anchors the end of the list.
-     2) In replay mode, it traverses the list and points to
+     1) In record mode, it is the last entry of the log.
+     2) In replay mode, it traverses the log and points to
 	the next instruction that must be emulated.
 
-   record_full_arch_list_head and record_full_arch_list_tail are used
-   to manage a separate list, which is used to build up the change
-   elements of the currently executing instruction during record mode.
-   When this instruction has been completely annotated in the "arch
-   list", it will be appended to the main execution log.  */
+   The entries of the currently executing instruction are staged at
+   the end of the log during record mode.  When this instruction has
+   been completely annotated, it is committed to the execution log.  */
+
+static record_full_log record_full_log_data;
+static record_full_pos record_full_list;
 
-static struct record_full_entry record_full_first;
-static struct record_full_entry *record_full_list = &record_full_first;
-static struct record_full_entry *record_full_arch_list_head = NULL;
-static struct record_full_entry *record_full_arch_list_tail = NULL;
+/* Every RECORD_FULL_INDEX_INTERVAL instructions, the position of the
+   instruction's "end" entry is added to record_full_index, so that an
+   instruction can be found without walking the log from its
+   beginning.  The index is sorted by instruction number.  */
+
+#define RECORD_FULL_INDEX_INTERVAL	1024
+
+struct record_full_index_entry
+{
+  ULONGEST insn_num;
+  record_full_pos pos;
+};
+
+static std::deque<record_full_index_entry> record_full_index;
+
+/* Return true if POS is the last entry of the execution log.  */
+
+static inline bool
+record_full_at_end (const record_full_pos &pos)
+{
+  return pos == record_full_log_data.last ();
+}
 
 /* true ask user. false auto delete the last struct record_full_entry.  */
 static bool record_full_stop_at_limit = true;
@@ -389,156 +976,99 @@ static struct cmd_list_element *show_record_full_cmdlist;
 /* Command list for "record full".  */
 static struct cmd_list_element *record_full_cmdlist;
 
-static void record_full_goto_insn (struct record_full_entry *entry,
+static void record_full_goto_insn (const record_full_pos &entry,
 				   enum exec_direction_kind dir);
 
-/* Alloc and free functions for record_full_reg, record_full_mem, and
-   record_full_end entries.  */
-
-/* Alloc a record_full_reg record entry.  */
+/* Decode the entry of the execution log at POS.  */
 
-static inline struct record_full_entry *
-record_full_reg_alloc (struct regcache *regcache, int regnum)
+static inline record_full_entry
+record_full_decode (const record_full_pos &pos)
 {
-  struct record_full_entry *rec;
-  struct gdbarch *gdbarch = regcache->arch ();
-
-  rec = XCNEW (struct record_full_entry);
-  rec->type = record_full_reg;
-  rec->u.reg.num = regnum;
-  rec->u.reg.len = register_size (gdbarch, regnum);
-  if (rec->u.reg.len > sizeof (rec->u.reg.u.buf))
-    rec->u.reg.u.ptr = (gdb_byte *) xmalloc (rec->u.reg.len);
-
-  return rec;
+  return record_full_log_data.decode (pos);
 }
 
-/* Free a record_full_reg record entry.  */
+/* Discard the whole execution log.  */
 
-static inline void
-record_full_reg_release (struct record_full_entry *rec)
+static void
+record_full_list_reset ()
 {
-  gdb_assert (rec->type == record_full_reg);
-  if (rec->u.reg.len > sizeof (rec->u.reg.u.buf))
-    xfree (rec->u.reg.u.ptr);
-  xfree (rec);
+  record_full_log_data.reset ();
+  record_full_list = record_full_log_data.begin ();
+  record_full_index.clear ();
 }
 
-/* Alloc a record_full_mem record entry.  */
+/* Add the last entry of the log to record_full_index, if it is due.  */
 
-static inline struct record_full_entry *
-record_full_mem_alloc (CORE_ADDR addr, int len)
+static void
+record_full_index_add_last ()
 {
-  struct record_full_entry *rec;
-
-  rec = XCNEW (struct record_full_entry);
-  rec->type = record_full_mem;
-  rec->u.mem.addr = addr;
-  rec->u.mem.len = len;
-  if (rec->u.mem.len > sizeof (rec->u.mem.u.buf))
-    rec->u.mem.u.ptr = (gdb_byte *) xmalloc (len);
+  record_full_pos pos = record_full_log_data.last ();
+  ULONGEST insn_num = record_full_decode (pos).u.end.insn_num;
 
-  return rec;
+  if (insn_num % RECORD_FULL_INDEX_INTERVAL == 0
+      && (record_full_index.empty ()
+	  || record_full_index.back ().insn_num < insn_num))
+    record_full_index.push_back ({ insn_num, pos });
 }
 
-/* Free a record_full_mem record entry.  */
+/* Return the position of the "end" entry of instruction INSN_NUM, if
+   it is in the log.  */
 
-static inline void
-record_full_mem_release (struct record_full_entry *rec)
+static std::optional<record_full_pos>
+record_full_find_insn (ULONGEST insn_num)
 {
-  gdb_assert (rec->type == record_full_mem);
-  if (rec->u.mem.len > sizeof (rec->u.mem.u.buf))
-    xfree (rec->u.mem.u.ptr);
-  xfree (rec);
-}
+  record_full_pos p = record_full_log_data.begin ();
 
-/* Alloc a record_full_end record entry.  */
-
-static inline struct record_full_entry *
-record_full_end_alloc (void)
-{
-  struct record_full_entry *rec;
-
-  rec = XCNEW (struct record_full_entry);
-  rec->type = record_full_end;
-
-  return rec;
-}
-
-/* Free a record_full_end record entry.  */
-
-static inline void
-record_full_end_release (struct record_full_entry *rec)
-{
-  xfree (rec);
-}
+  /* Start from the closest indexed instruction.  */
+  auto it = std::upper_bound (record_full_index.begin (),
+			      record_full_index.end (), insn_num,
+			      [] (ULONGEST num,
+				  const record_full_index_entry &e)
+			      {
+				return num < e.insn_num;
+			      });
+  if (it != record_full_index.begin ())
+    p = std::prev (it)->pos;
 
-/* Free one record entry, any type.
-   Return entry->type, in case caller wants to know.  */
+  do
+    {
+      record_full_entry entry = record_full_decode (p);
 
-static inline enum record_full_type
-record_full_entry_release (struct record_full_entry *rec)
-{
-  enum record_full_type type = rec->type;
+      if (entry.type == record_full_end)
+	{
+	  if (entry.u.end.insn_num == insn_num)
+	    return p;
+	  if (entry.u.end.insn_num > insn_num
+	      && p != record_full_log_data.begin ())
+	    break;
+	}
+    }
+  while (record_full_log_data.next (p));
 
-  switch (type) {
-  case record_full_reg:
-    record_full_reg_release (rec);
-    break;
-  case record_full_mem:
-    record_full_mem_release (rec);
-    break;
-  case record_full_end:
-    record_full_end_release (rec);
-    break;
-  }
-  return type;
+  return {};
 }
 
-/* Free all record entries in list pointed to by REC.  */
+/* Discard the entries recorded so far for the current instruction.  */
 
 static void
-record_full_list_release (struct record_full_entry *rec)
+record_full_list_release_staged ()
 {
-  if (!rec)
-    return;
-
-  while (rec->next)
-    rec = rec->next;
-
-  while (rec->prev)
-    {
-      rec = rec->prev;
-      record_full_entry_release (rec->next);
-    }
-
-  if (rec == &record_full_first)
-    {
-      record_full_insn_num = 0;
-      record_full_first.next = NULL;
-    }
-  else
-    record_full_entry_release (rec);
+  record_full_log_data.discard ();
 }
 
 /* Free all record entries forward of the given list position.  */
 
 static void
-record_full_list_release_following (struct record_full_entry *rec)
+record_full_list_release_following (const record_full_pos &rec)
 {
-  struct record_full_entry *tmp = rec->next;
+  unsigned int count = record_full_log_data.release_following (rec);
 
-  rec->next = NULL;
-  while (tmp)
-    {
-      rec = tmp->next;
-      if (record_full_entry_release (tmp) == record_full_end)
-	{
-	  record_full_insn_num--;
-	  record_full_insn_count--;
-	}
-      tmp = rec;
-    }
+  record_full_insn_num -= count;
+  record_full_insn_count -= count;
+
+  while (!record_full_index.empty ()
+	 && record_full_index.back ().insn_num > record_full_insn_count)
+    record_full_index.pop_back ();
 }
 
 /* Delete the first instruction from the beginning of the log, to make
@@ -549,74 +1079,30 @@ record_full_list_release_following (struct record_full_entry *rec)
 static void
 record_full_list_release_first (void)
 {
-  struct record_full_entry *tmp;
+  bool at_begin = record_full_list == record_full_log_data.begin ();
 
-  if (!record_full_first.next)
-    return;
+  record_full_log_data.release_first ();
 
-  /* Loop until a record_full_end.  */
-  while (1)
-    {
-      /* Cut record_full_first.next out of the linked list.  */
-      tmp = record_full_first.next;
-      record_full_first.next = tmp->next;
-      tmp->next->prev = &record_full_first;
+  /* The anchor moved forward.  */
+  if (at_begin)
+    record_full_list = record_full_log_data.begin ();
 
-      /* tmp is now isolated, and can be deleted.  */
-      if (record_full_entry_release (tmp) == record_full_end)
-	break;	/* End loop at first record_full_end.  */
-
-      if (!record_full_first.next)
-	{
-	  gdb_assert (record_full_insn_num == 1);
-	  break;	/* End loop when list is empty.  */
-	}
-    }
+  ULONGEST first
+    = record_full_decode (record_full_log_data.begin ()).u.end.insn_num;
+  while (!record_full_index.empty ()
+	 && record_full_index.front ().insn_num < first)
+    record_full_index.pop_front ();
 }
 
-/* Add a struct record_full_entry to record_full_arch_list.  */
+/* Make the entries recorded for the current instruction part of the
+   execution log.  */
 
 static void
-record_full_arch_list_add (struct record_full_entry *rec)
+record_full_list_commit ()
 {
-  if (record_debug > 1)
-    gdb_printf (gdb_stdlog,
-		"Process record: record_full_arch_list_add %s.\n",
-		host_address_to_string (rec));
-
-  if (record_full_arch_list_tail)
-    {
-      record_full_arch_list_tail->next = rec;
-      rec->prev = record_full_arch_list_tail;
-      record_full_arch_list_tail = rec;
-    }
-  else
-    {
-      record_full_arch_list_head = rec;
-      record_full_arch_list_tail = rec;
-    }
-}
-
-/* Return the value storage location of a record entry.  */
-static inline gdb_byte *
-record_full_get_loc (struct record_full_entry *rec)
-{
-  switch (rec->type) {
-  case record_full_mem:
-    if (rec->u.mem.len > sizeof (rec->u.mem.u.buf))
-      return rec->u.mem.u.ptr;
-    else
-      return rec->u.mem.u.buf;
-  case record_full_reg:
-    if (rec->u.reg.len > sizeof (rec->u.reg.u.buf))
-      return rec->u.reg.u.ptr;
-    else
-      return rec->u.reg.u.buf;
-  case record_full_end:
-  default:
-    gdb_assert_not_reached ("unexpected record_full_entry type");
-    return NULL;
-  }
+  record_full_log_data.commit ();
+  record_full_list = record_full_log_data.last ();
+  record_full_index_add_last ();
 }
 
 /* Record the value of a register NUM to record_full_arch_list.  */
@@ -624,7 +1110,7 @@ record_full_get_loc (struct record_full_entry *rec)
 int
 record_full_arch_list_add_reg (struct regcache *regcache, int regnum)
 {
-  struct record_full_entry *rec;
+  gdb_byte *loc;
 
   if (record_debug > 1)
     gdb_printf (gdb_stdlog,
@@ -632,11 +1118,11 @@ record_full_arch_list_add_reg (struct regcache *regcache, int regnum)
 		"record list.\n",
 		regnum);
 
-  rec = record_full_reg_alloc (regcache, regnum);
+  loc = record_full_log_data.append_reg (regnum,
+					 register_size (regcache->arch (),
+							regnum));
 
-  regcache->cooked_read (regnum, record_full_get_loc (rec));
-
-  record_full_arch_list_add (rec);
+  regcache->cooked_read (regnum, loc);
 
   return 0;
 }
@@ -647,7 +1133,7 @@ record_full_arch_list_add_reg (struct regcache *regcache, int regnum)
 int
 record_full_arch_list_add_mem (CORE_ADDR addr, int len)
 {
-  struct record_full_entry *rec;
+  gdb_byte *loc;
 
   if (record_debug > 1)
     gdb_printf (gdb_stdlog,
@@ -658,17 +1144,14 @@ record_full_arch_list_add_mem (CORE_ADDR addr, int len)
   if (!addr)	/* FIXME: Why?  Some arch must permit it...  */
     return 0;
 
-  rec = record_full_mem_alloc (addr, len);
+  loc = record_full_log_data.append_mem (addr, len);
 
-  if (record_read_memory (current_inferior ()->arch (), addr,
-			  record_full_get_loc (rec), len))
+  if (record_read_memory (current_inferior ()->arch (), addr, loc, len))
     {
-      record_full_mem_release (rec);
+      record_full_log_data.drop_last ();
       return -1;
     }
 
-  record_full_arch_list_add (rec);
-
   return 0;
 }
 
@@ -678,17 +1161,11 @@ record_full_arch_list_add_mem (CORE_ADDR addr, int len)
 int
 record_full_arch_list_add_end (void)
 {
-  struct record_full_entry *rec;
-
   if (record_debug > 1)
     gdb_printf (gdb_stdlog,
 		"Process record: add end to arch list.\n");
 
-  rec = record_full_end_alloc ();
-  rec->u.end.sigval = GDB_SIGNAL_0;
-  rec->u.end.insn_num = ++record_full_insn_count;
-
-  record_full_arch_list_add (rec);
+  record_full_log_data.append_end (GDB_SIGNAL_0, ++record_full_insn_count);
 
   return 0;
 }
@@ -724,9 +1201,6 @@ record_full_message (struct regcache *regcache, enum gdb_signal signal)
 
   try
     {
-      record_full_arch_list_head = NULL;
-      record_full_arch_list_tail = NULL;
-
       /* Check record_full_insn_num.  */
       record_full_check_insn_num ();
 
@@ -753,12 +1227,8 @@ record_full_message (struct regcache *regcache, enum gdb_signal signal)
 	 if we delivered it during the recording.  Therefore we should
 	 record the signal during record_full_wait, not
 	 record_full_resume.  */
-      if (record_full_list != &record_full_first)  /* FIXME better way
-						      to check */
-	{
-	  gdb_assert (record_full_list->type == record_full_end);
-	  record_full_list->u.end.sigval = signal;
-	}
+      if (record_full_list != record_full_log_data.begin ())
+	record_full_log_data.set_end_signal (record_full_list, signal);
 
       if (signal == GDB_SIGNAL_0
 	  || !gdbarch_process_record_signal_p (gdbarch))
@@ -777,13 +1247,11 @@ record_full_message (struct regcache *regcache, enum gdb_signal signal)
     }
   catch (const gdb_exception &ex)
     {
-      record_full_list_release (record_full_arch_list_tail);
+      record_full_list_release_staged ();
       throw;
     }
 
-  record_full_list->next = record_full_arch_list_head;
-  record_full_arch_list_head->prev = record_full_list;
-  record_full_list = record_full_arch_list_tail;
+  record_full_list_commit ();
 
   if (record_full_insn_num == record_full_insn_max_num)
     record_full_list_release_first ();
@@ -830,63 +1298,65 @@ static enum target_stop_reason record_full_stop_reason
 static inline void
 record_full_exec_insn (struct regcache *regcache,
 		       struct gdbarch *gdbarch,
-		       struct record_full_entry *entry)
+		       const record_full_pos &pos)
 {
-  switch (entry->type)
+  record_full_entry entry = record_full_decode (pos);
+
+  switch (entry.type)
     {
     case record_full_reg: /* reg */
       {
-	gdb::byte_vector reg (entry->u.reg.len);
+	gdb::byte_vector reg (entry.u.reg.len);
 
 	if (record_debug > 1)
 	  gdb_printf (gdb_stdlog,
 		      "Process record: record_full_reg %s to "
 		      "inferior num = %d.\n",
-		      host_address_to_string (entry),
-		      entry->u.reg.num);
+		      host_address_to_string (entry.loc),
+		      entry.u.reg.num);
 
-	regcache->cooked_read (entry->u.reg.num, reg.data ());
-	regcache->cooked_write (entry->u.reg.num, record_full_get_loc (entry));
-	memcpy (record_full_get_loc (entry), reg.data (), entry->u.reg.len);
+	regcache->cooked_read (entry.u.reg.num, reg.data ());
+	regcache->cooked_write (entry.u.reg.num, entry.loc);
+	memcpy (entry.loc, reg.data (), entry.u.reg.len);
       }
       break;
 
     case record_full_mem: /* mem */
       {
 	/* Nothing to do if the entry is flagged not_accessible.  */
-	if (!entry->u.mem.mem_entry_not_accessible)
+	if (!entry.u.mem.mem_entry_not_accessible)
 	  {
-	    gdb::byte_vector mem (entry->u.mem.len);
+	    gdb::byte_vector mem (entry.u.mem.len);
 
 	    if (record_debug > 1)
 	      gdb_printf (gdb_stdlog,
 			  "Process record: record_full_mem %s to "
 			  "inferior addr = %s len = %d.\n",
-			  host_address_to_string (entry),
-			  paddress (gdbarch, entry->u.mem.addr),
-			  entry->u.mem.len);
+			  host_address_to_string (entry.loc),
+			  paddress (gdbarch, entry.u.mem.addr),
+			  entry.u.mem.len);
 
 	    if (record_read_memory (gdbarch,
-				    entry->u.mem.addr, mem.data (),
-				    entry->u.mem.len))
-	      entry->u.mem.mem_entry_not_accessible = 1;
+				    entry.u.mem.addr, mem.data (),
+				    entry.u.mem.len))
+	      record_full_log_data.set_mem_not_accessible (entry);
 	    else
 	      {
-		if (target_write_memory (entry->u.mem.addr, 
-					 record_full_get_loc (entry),
-					 entry->u.mem.len))
+		if (target_write_memory (entry.u.mem.addr, 
+					 entry.loc,
+					 entry.u.mem.len))
 		  {
-		    entry->u.mem.mem_entry_not_accessible = 1;
+		    record_full_log_data.set_mem_not_accessible (entry);
 		    if (record_debug)
 		      warning (_("Process record: error writing memory at "
 				 "addr = %s len = %d."),
-			       paddress (gdbarch, entry->u.mem.addr),
-			       entry->u.mem.len);
+			       paddress (gdbarch, entry.u.mem.addr),
+			       entry.u.mem.len);
 		  }
 		else
 		  {
-		    memcpy (record_full_get_loc (entry), mem.data (),
-			    entry->u.mem.len);
+		    memcpy (entry.loc, mem.data (),
+			    entry.u.mem.len);
 
 		    /* We've changed memory --- check if a hardware
 		       watchpoint should trap.  Note that this
@@ -898,7 +1368,7 @@ record_full_exec_insn (struct regcache *regcache,
 		       traps.  */
 		    if (hardware_watchpoint_inserted_in_range
 			(current_inferior ()->aspace.get (),
-			 entry->u.mem.addr, entry->u.mem.len))
+			 entry.u.mem.addr, entry.u.mem.len))
 		      record_full_stop_reason = TARGET_STOPPED_BY_WATCHPOINT;
 		  }
 	      }
@@ -908,6 +1378,279 @@ record_full_exec_insn (struct regcache *regcache,
     }
 }
 
+/* Size of the memory pages tracked by record_full_replay_state.  */
+
+#define RECORD_FULL_PAGE_SIZE	4096
+
+/* The state of the inferior while replaying a run of entries of the
+   execution log.
+
+   Replaying entries one by one with record_full_exec_insn costs a few
+   target accesses per entry.  Instead, the registers are copied once
+   into a detached regcache, and each memory page touched by the
+   entries is read once from the target; the entries are then swapped
+   against this copy, and flush writes back the registers and bytes
+   that changed.  This makes long jumps through the log, e.g. with
+   "record goto" or "reverse-continue", independent of the target's
+   access latency.
+
+   Architectures that compute the PC with gdbarch_read_pc, and entries
+   for pseudo registers, fall back to record_full_exec_insn.  */
+
+class record_full_replay_state
+{
+public:
+  explicit record_full_replay_state (struct regcache *regcache);
+
+  DISABLE_COPY_AND_ASSIGN (record_full_replay_state);
+
+  /* Replay the entry at POS.  */
+  void exec_entry (const record_full_pos &pos);
+
+  /* Return the current PC.  */
+  CORE_ADDR pc ();
+
+  /* Write the registers and memory changed so far back to the
+     target.  */
+  void flush ();
+
+private:
+  struct page
+  {
+    /* Contents of the page, which bytes were read from the target,
+       and which bytes were changed.  */
+    gdb_byte data[RECORD_FULL_PAGE_SIZE];
+    std::bitset<RECORD_FULL_PAGE_SIZE> valid;
+    std::bitset<RECORD_FULL_PAGE_SIZE> dirty;
+  };
+
+  /* Return the page containing ADDR, reading it from the target if
+     needed.  If the page cannot be read as a whole, none of its bytes
+     are valid yet; see read_range.  */
+  page &get_page (CORE_ADDR addr);
+
+  /* Make the LEN bytes at OFFSET in page P, at address ADDR, valid by
+     reading them from the target.  Return false if they cannot be
+     read.  */
+  bool read_range (page &p, CORE_ADDR addr, size_t offset, int len);
+
+  /* Swap LEN bytes of memory at ADDR with BUF.  Return false if the
+     memory cannot be accessed.  */
+  bool swap_memory (CORE_ADDR addr, gdb_byte *buf, int len);
+
+  struct regcache *m_regcache;
+  struct gdbarch *m_gdbarch;
+
+  /* Whether registers and memory are cached at all.  */
+  bool m_batch;
+
+  std::unique_ptr<detached_regcache> m_regs;
+  std::vector<bool> m_dirty_regs;
+
+  gdb::unordered_map<CORE_ADDR, std::unique_ptr<page>> m_pages;
+};
+
+record_full_replay_state::record_full_replay_state (struct regcache *regcache)
+  : m_regcache (regcache),
+    m_gdbarch (regcache->arch ())
+{
+  int num_regs = gdbarch_num_regs (m_gdbarch);
+  int pc_regnum = gdbarch_pc_regnum (m_gdbarch);
+
+  m_batch = (!gdbarch_read_pc_p (m_gdbarch)
+	     && pc_regnum >= 0 && pc_regnum < num_regs);
+  if (!m_batch)
+    return;
+
+  m_regs.reset (new detached_regcache (m_gdbarch, false));
+  for (int i = 0; i < num_regs; i++)
+    m_regs->raw_supply (i, *regcache);
+  m_dirty_regs.resize (num_regs);
+}
+
+record_full_replay_state::page &
+record_full_replay_state::get_page (CORE_ADDR addr)
+{
+  CORE_ADDR base = addr & ~(CORE_ADDR) (RECORD_FULL_PAGE_SIZE - 1);
+  std::unique_ptr<page> &p = m_pages[base];
+
+  if (p == nullptr)
+    {
+      p.reset (new page);
+      if (record_read_memory (m_gdbarch, base, p->data,
+			      RECORD_FULL_PAGE_SIZE) == 0)
+	p->valid.set ();
+    }
+
+  return *p;
+}
+
+bool
+record_full_replay_state::read_range (page &p, CORE_ADDR addr,
+				      size_t offset, int len)
+{
+  int i;
+
+  for (i = 0; i < len; i++)
+    if (!p.valid.test (offset + i))
+      break;
+  if (i == len)
+    return true;
+
+  /* Part of the page is not accessible, e.g. a guard page or the end
+     of a mapping that does not fill the page.  Read just this range,
+     and keep the bytes that are already valid since they may have
+     been changed.  */
+  gdb::byte_vector buf (len);
+
+  if (record_read_memory (m_gdbarch, addr, buf.data (), len) != 0)
+    return false;
+
+  for (i = 0; i < len; i++)
+    if (!p.valid.test (offset + i))
+      {
+	p.data[offset + i] = buf[i];
+	p.valid.set (offset + i);
+      }
+
+  return true;
+}
+
+bool
+record_full_replay_state::swap_memory (CORE_ADDR addr, gdb_byte *buf,
+				       int len)
+{
+  /* Check that the whole range is accessible first, so that the
+     memory is left untouched otherwise.  */
+  for (int i = 0; i < len; )
+    {
+      page &p = get_page (addr + i);
+      size_t offset = (addr + i) & (RECORD_FULL_PAGE_SIZE - 1);
+      int n = std::min<int> (len - i, RECORD_FULL_PAGE_SIZE - offset);
+
+      if (!read_range (p, addr + i, offset, n))
+	return false;
+      i += n;
+    }
+
+  for (int i = 0; i < len; )
+    {
+      page &p = get_page (addr + i);
+      size_t offset = (addr + i) & (RECORD_FULL_PAGE_SIZE - 1);
+      int n = std::min<int> (len - i, RECORD_FULL_PAGE_SIZE - offset);
+
+      for (int j = 0; j < n; j++)
+	{
+	  std::swap (p.data[offset + j], buf[i + j]);
+	  p.dirty.set (offset + j);
+	}
+      i += n;
+    }
+
+  return true;
+}
+
+void
+record_full_replay_state::exec_entry (const record_full_pos &pos)
+{
+  record_full_entry entry = record_full_decode (pos);
+
+  if (!m_batch
+      || (entry.type == record_full_reg
+	  && entry.u.reg.num >= gdbarch_num_regs (m_gdbarch)))
+    {
+      flush ();
+      record_full_exec_insn (m_regcache, m_gdbarch, pos);
+      if (m_batch)
+	for (int i = 0; i < gdbarch_num_regs (m_gdbarch); i++)
+	  m_regs->raw_supply (i, *m_regcache);
+      return;
+    }
+
+  switch (entry.type)
+    {
+    case record_full_reg:
+      {
+	gdb::byte_vector reg (entry.u.reg.len);
+
+	m_regs->raw_collect (entry.u.reg.num, reg.data ());
+	m_regs->raw_supply (entry.u.reg.num, entry.loc);
+	memcpy (entry.loc, reg.data (), entry.u.reg.len);
+	m_dirty_regs[entry.u.reg.num] = true;
+      }
+      break;
+
+    case record_full_mem:
+      if (entry.u.mem.mem_entry_not_accessible)
+	break;
+
+      if (!swap_memory (entry.u.mem.addr, entry.loc, entry.u.mem.len))
+	record_full_log_data.set_mem_not_accessible (entry);
+      else if (hardware_watchpoint_inserted_in_range
+		 (current_inferior ()->aspace.get (),
+		  entry.u.mem.addr, entry.u.mem.len))
+	record_full_stop_reason = TARGET_STOPPED_BY_WATCHPOINT;
+      break;
+    }
+}
+
+CORE_ADDR
+record_full_replay_state::pc ()
+{
+  if (!m_batch)
+    return regcache_read_pc (m_regcache);
+
+  ULONGEST pc;
+
+  m_regs->cooked_read (gdbarch_pc_regnum (m_gdbarch), &pc);
+  return gdbarch_addr_bits_remove (m_gdbarch, pc);
+}
+
+void
+record_full_replay_state::flush ()
+{
+  if (!m_batch)
+    return;
+
+  for (int i = 0; i < m_dirty_regs.size (); i++)
+    if (m_dirty_regs[i])
+      {
+	gdb::byte_vector reg (register_size (m_gdbarch, i));
+
+	m_regs->raw_collect (i, reg.data ());
+	m_regcache->raw_write (i, reg);
+	m_dirty_regs[i] = false;
+      }
+
+  for (auto &it : m_pages)
+    {
+      page &p = *it.second;
+
+      /* Write each run of changed bytes.  */
+      for (size_t i = 0; i < RECORD_FULL_PAGE_SIZE; )
+	{
+	  if (!p.dirty.test (i))
+	    {
+	      i++;
+	      continue;
+	    }
+
+	  size_t start = i;
+	  while (i < RECORD_FULL_PAGE_SIZE && p.dirty.test (i))
+	    i++;
+
+	  if (target_write_memory (it.first + start, p.data + start,
+				   i - start)
+	      && record_debug)
+	    warning (_("Process record: error writing memory at "
+		       "addr = %s len = %d."),
+		     paddress (m_gdbarch, it.first + start),
+		     (int) (i - start));
+	}
+      p.dirty.reset ();
+    }
+}
+
 static void record_full_restore (void);
 
 /* Asynchronous signal handle registered as event loop source for when
@@ -984,8 +1727,7 @@ record_full_open (const char *args, int from_tty)
   /* Reset */
   record_full_insn_num = 0;
   record_full_insn_count = 0;
-  record_full_list = &record_full_first;
-  record_full_list->next = NULL;
+  record_full_list_reset ();
 
   if (current_program_space->core_bfd ())
     record_full_core_open_1 ();
@@ -1012,7 +1754,7 @@ record_full_base_target::close ()
   if (record_debug)
     gdb_printf (gdb_stdlog, "Process record: record_full_close\n");
 
-  record_full_list_release (record_full_list);
+  record_full_list_reset ();
 
   /* Release record_full_core_regbuf.  */
   if (record_full_core_regbuf)
@@ -1309,6 +2051,7 @@ record_full_wait_1 (struct target_ops *ops,
       const address_space *aspace = current_inferior ()->aspace.get ();
       int continue_flag = 1;
       int first_record_full_end = 1;
+      record_full_replay_state state (regcache);
 
       try
 	{
@@ -1341,8 +2084,8 @@ record_full_wait_1 (struct target_ops *ops,
 
 	  /* In EXEC_FORWARD mode, record_full_list points to the tail of prev
 	     instruction.  */
-	  if (execution_direction == EXEC_FORWARD && record_full_list->next)
-	    record_full_list = record_full_list->next;
+	  if (execution_direction == EXEC_FORWARD)
+	    record_full_log_data.next (record_full_list);
 
 	  /* Loop over the record_full_list, looking for the next place to
 	     stop.  */
@@ -1350,30 +2093,31 @@ record_full_wait_1 (struct target_ops *ops,
 	    {
 	      /* Check for beginning and end of log.  */
 	      if (execution_direction == EXEC_REVERSE
-		  && record_full_list == &record_full_first)
+		  && record_full_list == record_full_log_data.begin ())
 		{
 		  /* Hit beginning of record log in reverse.  */
 		  status->set_no_history ();
 		  break;
 		}
 	      if (execution_direction != EXEC_REVERSE
-		  && !record_full_list->next)
+		  && record_full_at_end (record_full_list))
 		{
 		  /* Hit end of record log going forward.  */
 		  status->set_no_history ();
 		  break;
 		}
 
-	      record_full_exec_insn (regcache, gdbarch, record_full_list);
+	      state.exec_entry (record_full_list);
 
-	      if (record_full_list->type == record_full_end)
+	      record_full_entry entry = record_full_decode (record_full_list);
+	      if (entry.type == record_full_end)
 		{
 		  if (record_debug > 1)
 		    gdb_printf
 		      (gdb_stdlog,
 		       "Process record: record_full_end %s to "
 		       "inferior.\n",
-		       host_address_to_string (record_full_list));
+		       pulongest (entry.u.end.insn_num));
 
 		  if (first_record_full_end
 		      && execution_direction == EXEC_REVERSE)
@@ -1399,7 +2143,7 @@ record_full_wait_1 (struct target_ops *ops,
 			}
 
 		      /* check breakpoint */
-		      tmp_pc = regcache_read_pc (regcache);
+		      tmp_pc = state.pc ();
 		      if (record_check_stopped_by_breakpoint
 			  (aspace, tmp_pc, &record_full_stop_reason))
 			{
@@ -1422,7 +2166,7 @@ record_full_wait_1 (struct target_ops *ops,
 			  continue_flag = 0;
 			}
 		      /* Check target signal */
-		      if (record_full_list->u.end.sigval != GDB_SIGNAL_0)
+		      if (entry.u.end.sigval != GDB_SIGNAL_0)
 			/* FIXME: better way to check */
 			continue_flag = 0;
 		    }
@@ -1431,40 +2175,38 @@ record_full_wait_1 (struct target_ops *ops,
 	      if (continue_flag)
 		{
 		  if (execution_direction == EXEC_REVERSE)
-		    {
-		      if (record_full_list->prev)
-			record_full_list = record_full_list->prev;
-		    }
+		    record_full_log_data.prev (record_full_list);
 		  else
-		    {
-		      if (record_full_list->next)
-			record_full_list = record_full_list->next;
-		    }
+		    record_full_log_data.next (record_full_list);
 		}
 	    }
 	  while (continue_flag);
 
+	  state.flush ();
+
 	replay_out:
 	  if (status->kind () == TARGET_WAITKIND_STOPPED)
 	    {
 	      if (record_full_get_sig)
 		status->set_stopped (GDB_SIGNAL_INT);
-	      else if (record_full_list->u.end.sigval != GDB_SIGNAL_0)
+	      else if (record_full_decode (record_full_list).u.end.sigval
+		       != GDB_SIGNAL_0)
 		/* FIXME: better way to check */
-		status->set_stopped (record_full_list->u.end.sigval);
+		status->set_stopped
+		  (record_full_decode (record_full_list).u.end.sigval);
 	      else
 		status->set_stopped (GDB_SIGNAL_TRAP);
 	    }
 	}
       catch (const gdb_exception &ex)
 	{
+	  /* Keep the inferior in sync with the log.  */
+	  state.flush ();
+
 	  if (execution_direction == EXEC_REVERSE)
-	    {
-	      if (record_full_list->next)
-		record_full_list = record_full_list->next;
-	    }
+	    record_full_log_data.next (record_full_list);
 	  else
-	    record_full_list = record_full_list->prev;
+	    record_full_log_data.prev (record_full_list);
 
 	  throw;
 	}
@@ -1552,9 +2294,6 @@ record_full_registers_change (struct regcache *regcache, int regnum)
   /* Check record_full_insn_num.  */
   record_full_check_insn_num ();
 
-  record_full_arch_list_head = NULL;
-  record_full_arch_list_tail = NULL;
-
   if (regnum < 0)
     {
       int i;
@@ -1563,7 +2302,7 @@ record_full_registers_change (struct regcache *regcache, int regnum)
 	{
 	  if (record_full_arch_list_add_reg (regcache, i))
 	    {
-	      record_full_list_release (record_full_arch_list_tail);
+	      record_full_list_release_staged ();
 	      error (_("Process record: failed to record execution log."));
 	    }
 	}
@@ -1572,18 +2311,16 @@ record_full_registers_change (struct regcache *regcache, int regnum)
     {
       if (record_full_arch_list_add_reg (regcache, regnum))
 	{
-	  record_full_list_release (record_full_arch_list_tail);
+	  record_full_list_release_staged ();
 	  error (_("Process record: failed to record execution log."));
 	}
     }
   if (record_full_arch_list_add_end ())
     {
-      record_full_list_release (record_full_arch_list_tail);
+      record_full_list_release_staged ();
       error (_("Process record: failed to record execution log."));
     }
-  record_full_list->next = record_full_arch_list_head;
-  record_full_arch_list_head->prev = record_full_list;
-  record_full_list = record_full_arch_list_tail;
+  record_full_list_commit ();
 
   if (record_full_insn_num == record_full_insn_max_num)
     record_full_list_release_first ();
@@ -1677,11 +2414,9 @@ record_full_target::xfer_partial (enum target_object object,
       record_full_check_insn_num ();
 
       /* Record registers change to list as an instruction.  */
-      record_full_arch_list_head = NULL;
-      record_full_arch_list_tail = NULL;
       if (record_full_arch_list_add_mem (offset, len))
 	{
-	  record_full_list_release (record_full_arch_list_tail);
+	  record_full_list_release_staged ();
 	  if (record_debug)
 	    gdb_printf (gdb_stdlog,
 			"Process record: failed to record "
@@ -1690,16 +2425,14 @@ record_full_target::xfer_partial (enum target_object object,
 	}
       if (record_full_arch_list_add_end ())
 	{
-	  record_full_list_release (record_full_arch_list_tail);
+	  record_full_list_release_staged ();
 	  if (record_debug)
 	    gdb_printf (gdb_stdlog,
 			"Process record: failed to record "
 			"execution log.");
 	  return TARGET_XFER_E_IO;
 	}
-      record_full_list->next = record_full_arch_list_head;
-      record_full_arch_list_head->prev = record_full_list;
-      record_full_list = record_full_arch_list_tail;
+      record_full_list_commit ();
 
       if (record_full_insn_num == record_full_insn_max_num)
 	record_full_list_release_first ();
@@ -1861,8 +2594,13 @@ record_full_base_target::get_bookmark (const char *args, int from_tty)
   char *ret = NULL;
 
   /* Return stringified form of instruction count.  */
-  if (record_full_list && record_full_list->type == record_full_end)
-    ret = xstrdup (pulongest (record_full_list->u.end.insn_num));
+  if (record_full_list.chunk != nullptr)
+    {
+      record_full_entry entry = record_full_decode (record_full_list);
+
+      if (entry.type == record_full_end)
+	ret = xstrdup (pulongest (entry.u.end.insn_num));
+    }
 
   if (record_debug)
     {
@@ -1918,7 +2656,8 @@ record_full_base_target::record_method (ptid_t ptid)
 void
 record_full_base_target::info_record ()
 {
-  struct record_full_entry *p;
+  record_full_pos p = record_full_log_data.begin ();
+  bool found = false;
 
   if (RECORD_FULL_IS_REPLAY)
     gdb_printf (_("Replay mode:\n"));
@@ -1926,22 +2665,25 @@ record_full_base_target::info_record ()
     gdb_printf (_("Record mode:\n"));
 
   /* Find entry for first actual instruction in the log.  */
-  for (p = record_full_first.next;
-       p != NULL && p->type != record_full_end;
-       p = p->next)
-    ;
+  while (record_full_log_data.next (p))
+    if (record_full_decode (p).type == record_full_end)
+      {
+	found = true;
+	break;
+      }
 
   /* Do we have a log at all?  */
-  if (p != NULL && p->type == record_full_end)
+  if (found)
     {
       /* Display instruction number for first instruction in the log.  */
       gdb_printf (_("Lowest recorded instruction number is %s.\n"),
-		  pulongest (p->u.end.insn_num));
+		  pulongest (record_full_decode (p).u.end.insn_num));
 
       /* If in replay mode, display where we are in the log.  */
       if (RECORD_FULL_IS_REPLAY)
 	gdb_printf (_("Current instruction number is %s.\n"),
-		    pulongest (record_full_list->u.end.insn_num));
+		    pulongest (record_full_decode (record_full_list)
+			       .u.end.insn_num));
 
       /* Display instruction number for last instruction in the log.  */
       gdb_printf (_("Highest recorded instruction number is %s.\n"),
@@ -1950,6 +2692,14 @@ record_full_base_target::info_record ()
       /* Display log count.  */
       gdb_printf (_("Log contains %u instructions.\n"),
 		  record_full_insn_num);
+
+      /* Display the memory used by the log.  */
+      gdb_printf (_("Log uses %s bytes (%s bytes per instruction), "
+		    "%s bytes allocated.\n"),
+		  pulongest (record_full_log_data.bytes_used ()),
+		  pulongest (record_full_log_data.bytes_used ()
+			     / std::max (record_full_insn_num, 1u)),
+		  pulongest (record_full_log_data.bytes_allocated ()));
     }
   else
     gdb_printf (_("No instructions have been logged.\n"));
@@ -1996,23 +2746,26 @@ record_full_base_target::record_will_replay (ptid_t ptid, int dir)
 /* Go to a specific entry.  */
 
 static void
-record_full_goto_entry (struct record_full_entry *p)
+record_full_goto_entry (const record_full_pos *p)
 {
   if (p == NULL)
     error (_("Target insn not found."));
-  else if (p == record_full_list)
+
+  ULONGEST insn_num = record_full_decode (*p).u.end.insn_num;
+
+  if (*p == record_full_list)
     error (_("Already at target insn."));
-  else if (p->u.end.insn_num > record_full_list->u.end.insn_num)
+  else if (insn_num > record_full_decode (record_full_list).u.end.insn_num)
     {
       gdb_printf (_("Go forward to insn number %s\n"),
-		  pulongest (p->u.end.insn_num));
-      record_full_goto_insn (p, EXEC_FORWARD);
+		  pulongest (insn_num));
+      record_full_goto_insn (*p, EXEC_FORWARD);
     }
   else
     {
       gdb_printf (_("Go backward to insn number %s\n"),
-		  pulongest (p->u.end.insn_num));
-      record_full_goto_insn (p, EXEC_REVERSE);
+		  pulongest (insn_num));
+      record_full_goto_insn (*p, EXEC_REVERSE);
     }
 
   registers_changed ();
@@ -2028,13 +2781,9 @@ record_full_goto_entry (struct record_full_entry *p)
 void
 record_full_base_target::goto_record_begin ()
 {
-  struct record_full_entry *p = NULL;
+  record_full_pos p = record_full_log_data.begin ();
 
-  for (p = &record_full_first; p != NULL; p = p->next)
-    if (p->type == record_full_end)
-      break;
-
-  record_full_goto_entry (p);
+  record_full_goto_entry (&p);
 }
 
 /* The "goto_record_end" target method.  */
@@ -2042,15 +2791,9 @@ record_full_base_target::goto_record_begin ()
 void
 record_full_base_target::goto_record_end ()
 {
-  struct record_full_entry *p = NULL;
-
-  for (p = record_full_list; p->next != NULL; p = p->next)
-    ;
-  for (; p!= NULL; p = p->prev)
-    if (p->type == record_full_end)
-      break;
+  record_full_pos p = record_full_log_data.last ();
 
-  record_full_goto_entry (p);
+  record_full_goto_entry (&p);
 }
 
 /* The "goto_record" target method.  */
@@ -2058,13 +2801,9 @@ record_full_base_target::goto_record_end ()
 void
 record_full_base_target::goto_record (ULONGEST target_insn)
 {
-  struct record_full_entry *p = NULL;
-
-  for (p = &record_full_first; p != NULL; p = p->next)
-    if (p->type == record_full_end && p->u.end.insn_num == target_insn)
-      break;
+  std::optional<record_full_pos> p = record_full_find_insn (target_insn);
 
-  record_full_goto_entry (p);
+  record_full_goto_entry (p.has_value () ? &*p : nullptr);
 }
 
 /* The "record_stop_replaying" target method.  */
@@ -2337,7 +3076,6 @@ static void
 record_full_restore (void)
 {
   uint32_t magic;
-  struct record_full_entry *rec;
   asection *osec;
   uint32_t osec_size;
   int bfd_offset = 0;
@@ -2348,7 +3086,7 @@ record_full_restore (void)
     return;
 
   /* "record_full_restore" can only be called when record list is empty.  */
-  gdb_assert (record_full_first.next == NULL);
+  gdb_assert (record_full_at_end (record_full_log_data.begin ()));
  
   if (record_debug)
     gdb_printf (gdb_stdlog, "Restoring recording from core file.\n");
@@ -2376,10 +3114,7 @@ record_full_restore (void)
 		"RECORD_FULL_FILE_MAGIC (0x%s)\n",
 		phex_nz (netorder32 (magic), 4));
 
-  /* Restore the entries in recfd into record_full_arch_list_head and
-     record_full_arch_list_tail.  */
-  record_full_arch_list_head = NULL;
-  record_full_arch_list_tail = NULL;
+  /* Restore the entries in recfd into the execution log.  */
   record_full_insn_num = 0;
 
   try
@@ -2391,6 +3126,7 @@ record_full_restore (void)
 	  uint8_t rectype;
 	  uint32_t regnum, len, signal, count;
 	  uint64_t addr;
+	  gdb_byte *loc;
 
 	  /* We are finished when offset reaches osec_size.  */
 	  if (bfd_offset >= osec_size)
@@ -2406,20 +3142,20 @@ record_full_restore (void)
 			    sizeof (regnum), &bfd_offset);
 	      regnum = netorder32 (regnum);
 
-	      rec = record_full_reg_alloc (regcache, regnum);
+	      len = register_size (regcache->arch (), regnum);
+	      loc = record_full_log_data.append_reg (regnum, len);
 
 	      /* Get val.  */
 	      bfdcore_read (current_program_space->core_bfd (), osec,
-			    record_full_get_loc (rec), rec->u.reg.len,
-			    &bfd_offset);
+			    loc, len, &bfd_offset);
 
 	      if (record_debug)
 		gdb_printf (gdb_stdlog,
 			    "  Reading register %d (1 "
 			    "plus %lu plus %d bytes)\n",
-			    rec->u.reg.num,
+			    regnum,
 			    (unsigned long) sizeof (regnum),
-			    rec->u.reg.len);
+			    len);
 	      break;
 
 	    case record_full_mem: /* mem */
@@ -2433,39 +3169,37 @@ record_full_restore (void)
 			    sizeof (addr), &bfd_offset);
 	      addr = netorder64 (addr);
 
-	      rec = record_full_mem_alloc (addr, len);
+	      loc = record_full_log_data.append_mem (addr, len);
 
 	      /* Get val.  */
 	      bfdcore_read (current_program_space->core_bfd (), osec,
-			    record_full_get_loc (rec), rec->u.mem.len,
-			    &bfd_offset);
+			    loc, len, &bfd_offset);
 
 	      if (record_debug)
 		gdb_printf (gdb_stdlog,
 			    "  Reading memory %s (1 plus "
 			    "%lu plus %lu plus %d bytes)\n",
-			    paddress (get_current_arch (),
-				      rec->u.mem.addr),
+			    paddress (get_current_arch (), addr),
 			    (unsigned long) sizeof (addr),
 			    (unsigned long) sizeof (len),
-			    rec->u.mem.len);
+			    len);
 	      break;
 
 	    case record_full_end: /* end */
-	      rec = record_full_end_alloc ();
 	      record_full_insn_num ++;
 
 	      /* Get signal value.  */
 	      bfdcore_read (current_program_space->core_bfd (), osec, &signal,
 			    sizeof (signal), &bfd_offset);
 	      signal = netorder32 (signal);
-	      rec->u.end.sigval = (enum gdb_signal) signal;
 
 	      /* Get insn count.  */
 	      bfdcore_read (current_program_space->core_bfd (), osec, &count,
 			    sizeof (count), &bfd_offset);
 	      count = netorder32 (count);
-	      rec->u.end.insn_num = count;
+	      record_full_log_data.append_end ((enum gdb_signal) signal, count);
+	      record_full_log_data.commit ();
+	      record_full_index_add_last ();
 	      record_full_insn_count = count + 1;
 	      if (record_debug)
 		gdb_printf (gdb_stdlog,
@@ -2482,22 +3216,18 @@ record_full_restore (void)
 		     bfd_get_filename (current_program_space->core_bfd ()));
 	      break;
 	    }
-
-	  /* Add rec to record arch list.  */
-	  record_full_arch_list_add (rec);
 	}
     }
   catch (const gdb_exception &ex)
     {
-      record_full_list_release (record_full_arch_list_tail);
+      record_full_list_reset ();
+      record_full_insn_num = 0;
       throw;
     }
 
-  /* Add record_full_arch_list_head to the end of record list.  */
-  record_full_first.next = record_full_arch_list_head;
-  record_full_arch_list_head->prev = &record_full_first;
-  record_full_arch_list_tail->next = NULL;
-  record_full_list = &record_full_first;
+  /* Drop a trailing incomplete instruction, if any.  */
+  record_full_list_release_staged ();
+  record_full_list = record_full_log_data.begin ();
 
   /* Update record_full_insn_max_num.  */
   if (record_full_insn_num > record_full_insn_max_num)
@@ -2545,7 +3275,7 @@ cmd_record_full_restore (const char *args, int from_tty)
 void
 record_full_base_target::save_record (const char *recfilename)
 {
-  struct record_full_entry *cur_record_full_list;
+  record_full_pos cur_record_full_list;
   uint32_t magic;
   struct gdbarch *gdbarch;
   int save_size = 0;
@@ -2574,35 +3304,42 @@ record_full_base_target::save_record (const char *recfilename)
   scoped_restore restore_operation_disable
     = record_full_gdb_operation_disable_set ();
 
+  /* Replay the log in GDB's memory, the inferior is only updated
+     before the core file is written and once the log has been
+     saved.  */
+  record_full_replay_state state (regcache);
+
   /* Reverse execute to the begin of record list.  */
   while (1)
     {
       /* Check for beginning and end of log.  */
-      if (record_full_list == &record_full_first)
+      if (record_full_list == record_full_log_data.begin ())
 	break;
 
-      record_full_exec_insn (regcache, gdbarch, record_full_list);
+      state.exec_entry (record_full_list);
 
-      if (record_full_list->prev)
-	record_full_list = record_full_list->prev;
+      record_full_log_data.prev (record_full_list);
     }
 
   /* Compute the size needed for the extra bfd section.  */
   save_size = 4;	/* magic cookie */
-  for (record_full_list = record_full_first.next; record_full_list;
-       record_full_list = record_full_list->next)
-    switch (record_full_list->type)
-      {
-      case record_full_end:
-	save_size += 1 + 4 + 4;
-	break;
-      case record_full_reg:
-	save_size += 1 + 4 + record_full_list->u.reg.len;
-	break;
-      case record_full_mem:
-	save_size += 1 + 4 + 8 + record_full_list->u.mem.len;
-	break;
-      }
+  while (record_full_log_data.next (record_full_list))
+    {
+      record_full_entry entry = record_full_decode (record_full_list);
+
+      switch (entry.type)
+	{
+	case record_full_end:
+	  save_size += 1 + 4 + 4;
+	  break;
+	case record_full_reg:
+	  save_size += 1 + 4 + entry.u.reg.len;
+	  break;
+	case record_full_mem:
+	  save_size += 1 + 4 + 8 + entry.u.mem.len;
+	  break;
+	}
+    }
 
   /* Make the new bfd section.  */
   osec = bfd_make_section_anyway_with_flags (obfd.get (), "precord",
@@ -2617,6 +3354,7 @@ record_full_base_target::save_record (const char *recfilename)
   bfd_set_section_alignment (osec, 0);
 
   /* Save corefile state.  */
+  state.flush ();
   write_gcore_file (obfd.get ());
 
   /* Write out the record log.  */
@@ -2631,39 +3369,40 @@ record_full_base_target::save_record (const char *recfilename)
 
   /* Save the entries to recfd and forward execute to the end of
      record list.  */
-  record_full_list = &record_full_first;
+  record_full_list = record_full_log_data.begin ();
   while (1)
     {
       /* Save entry.  */
-      if (record_full_list != &record_full_first)
+      if (record_full_list != record_full_log_data.begin ())
 	{
+	  record_full_entry entry = record_full_decode (record_full_list);
 	  uint8_t type;
 	  uint32_t regnum, len, signal, count;
 	  uint64_t addr;
 
-	  type = record_full_list->type;
+	  type = entry.type;
 	  bfdcore_write (obfd.get (), osec, &type, sizeof (type), &bfd_offset);
 
-	  switch (record_full_list->type)
+	  switch (entry.type)
 	    {
 	    case record_full_reg: /* reg */
 	      if (record_debug)
 		gdb_printf (gdb_stdlog,
 			    "  Writing register %d (1 "
 			    "plus %lu plus %d bytes)\n",
-			    record_full_list->u.reg.num,
+			    entry.u.reg.num,
 			    (unsigned long) sizeof (regnum),
-			    record_full_list->u.reg.len);
+			    entry.u.reg.len);
 
 	      /* Write regnum.  */
-	      regnum = netorder32 (record_full_list->u.reg.num);
+	      regnum = netorder32 (entry.u.reg.num);
 	      bfdcore_write (obfd.get (), osec, &regnum,
 			     sizeof (regnum), &bfd_offset);
 
 	      /* Write regval.  */
 	      bfdcore_write (obfd.get (), osec,
-			     record_full_get_loc (record_full_list),
-			     record_full_list->u.reg.len, &bfd_offset);
+			     entry.loc,
+			     entry.u.reg.len, &bfd_offset);
 	      break;
 
 	    case record_full_mem: /* mem */
@@ -2672,25 +3411,25 @@ record_full_base_target::save_record (const char *recfilename)
 			    "  Writing memory %s (1 plus "
 			    "%lu plus %lu plus %d bytes)\n",
 			    paddress (gdbarch,
-				      record_full_list->u.mem.addr),
+				      entry.u.mem.addr),
 			    (unsigned long) sizeof (addr),
 			    (unsigned long) sizeof (len),
-			    record_full_list->u.mem.len);
+			    entry.u.mem.len);
 
 	      /* Write memlen.  */
-	      len = netorder32 (record_full_list->u.mem.len);
+	      len = netorder32 (entry.u.mem.len);
 	      bfdcore_write (obfd.get (), osec, &len, sizeof (len),
 			     &bfd_offset);
 
 	      /* Write memaddr.  */
-	      addr = netorder64 (record_full_list->u.mem.addr);
+	      addr = netorder64 (entry.u.mem.addr);
 	      bfdcore_write (obfd.get (), osec, &addr, 
 			     sizeof (addr), &bfd_offset);
 
 	      /* Write memval.  */
 	      bfdcore_write (obfd.get (), osec,
-			     record_full_get_loc (record_full_list),
-			     record_full_list->u.mem.len, &bfd_offset);
+			     entry.loc,
+			     entry.u.mem.len, &bfd_offset);
 	      break;
 
 	      case record_full_end:
@@ -2701,12 +3440,12 @@ record_full_base_target::save_record (const char *recfilename)
 			      (unsigned long) sizeof (signal),
 			      (unsigned long) sizeof (count));
 		/* Write signal value.  */
-		signal = netorder32 (record_full_list->u.end.sigval);
+		signal = netorder32 (entry.u.end.sigval);
 		bfdcore_write (obfd.get (), osec, &signal,
 			       sizeof (signal), &bfd_offset);
 
 		/* Write insn count.  */
-		count = netorder32 (record_full_list->u.end.insn_num);
+		count = netorder32 (entry.u.end.insn_num);
 		bfdcore_write (obfd.get (), osec, &count,
 			       sizeof (count), &bfd_offset);
 		break;
@@ -2714,11 +3453,9 @@ record_full_base_target::save_record (const char *recfilename)
 	}
 
       /* Execute entry.  */
-      record_full_exec_insn (regcache, gdbarch, record_full_list);
+      state.exec_entry (record_full_list);
 
-      if (record_full_list->next)
-	record_full_list = record_full_list->next;
-      else
+      if (!record_full_log_data.next (record_full_list))
 	break;
     }
 
@@ -2729,12 +3466,13 @@ record_full_base_target::save_record (const char *recfilename)
       if (record_full_list == cur_record_full_list)
 	break;
 
-      record_full_exec_insn (regcache, gdbarch, record_full_list);
+      state.exec_entry (record_full_list);
 
-      if (record_full_list->prev)
-	record_full_list = record_full_list->prev;
+      record_full_log_data.prev (record_full_list);
     }
 
+  state.flush ();
+
   unlink_file.keep ();
 
   /* Succeeded.  */
@@ -2747,28 +3485,31 @@ record_full_base_target::save_record (const char *recfilename)
    correspondingly.  */
 
 static void
-record_full_goto_insn (struct record_full_entry *entry,
+record_full_goto_insn (const record_full_pos &entry,
 		       enum exec_direction_kind dir)
 {
   scoped_restore restore_operation_disable
     = record_full_gdb_operation_disable_set ();
   regcache *regcache = get_thread_regcache (inferior_thread ());
-  struct gdbarch *gdbarch = regcache->arch ();
 
   /* Assume everything is valid: we will hit the entry,
      and we will not hit the end of the recording.  */
 
+  record_full_replay_state state (regcache);
+
   if (dir == EXEC_FORWARD)
-    record_full_list = record_full_list->next;
+    record_full_log_data.next (record_full_list);
 
   do
     {
-      record_full_exec_insn (regcache, gdbarch, record_full_list);
+      state.exec_entry (record_full_list);
       if (dir == EXEC_REVERSE)
-	record_full_list = record_full_list->prev;
+	record_full_log_data.prev (record_full_list);
       else
-	record_full_list = record_full_list->next;
+	record_full_log_data.next (record_full_list);
     } while (record_full_list != entry);
+
+  state.flush ();
 }
 
 /* Alias for "target record-full".  */
@@ -2799,7 +3540,7 @@ set_record_full_insn_max_num (const char *args, int from_tty,
 static void
 maintenance_print_record_instruction (const char *args, int from_tty)
 {
-  struct record_full_entry *to_print = record_full_list;
+  record_full_pos to_print = record_full_list;
 
   if (args != nullptr)
     {
@@ -2808,10 +3549,9 @@ maintenance_print_record_instruction (const char *args, int from_tty)
 	{
 	  /* Move forward OFFSET instructions.  We know we found the
 	     end of an instruction when to_print->type is record_full_end.  */
-	  while (to_print->next != nullptr && offset > 0)
+	  while (offset > 0 && record_full_log_data.next (to_print))
 	    {
-	      to_print = to_print->next;
-	      if (to_print->type == record_full_end)
+	      if (record_full_decode (to_print).type == record_full_end)
 		offset--;
 	    }
 	  if (offset != 0)
@@ -2819,41 +3559,43 @@ maintenance_print_record_instruction (const char *args, int from_tty)
 	}
       else
 	{
-	  while (to_print->prev != nullptr && offset < 0)
+	  while (offset < 0 && record_full_log_data.prev (to_print))
 	    {
-	      to_print = to_print->prev;
-	      if (to_print->type == record_full_end)
+	      if (record_full_decode (to_print).type == record_full_end)
 		offset++;
 	    }
 	  if (offset != 0)
 	    error (_("Not enough recorded history"));
 	}
     }
-  gdb_assert (to_print != nullptr);
+  gdb_assert (to_print.chunk != nullptr);
 
   gdbarch *arch = current_inferior ()->arch ();
 
   /* Go back to the start of the instruction.  */
-  while (to_print->prev != nullptr && to_print->prev->type != record_full_end)
-    to_print = to_print->prev;
+  for (record_full_pos p = to_print;
+       record_full_log_data.prev (p)
+	 && record_full_decode (p).type != record_full_end;
+       to_print = p)
+    ;
 
   /* if we're in the first record, there are no actual instructions
      recorded.  Warn the user and leave.  */
-  if (to_print == &record_full_first)
+  if (to_print == record_full_log_data.begin ())
     error (_("Not enough recorded history"));
 
-  while (to_print->type != record_full_end)
+  for (record_full_entry entry = record_full_decode (to_print);
+       entry.type != record_full_end;
+       entry = record_full_decode (to_print))
     {
-      switch (to_print->type)
+      switch (entry.type)
 	{
 	  case record_full_reg:
 	    {
-	      type *regtype = gdbarch_register_type (arch, to_print->u.reg.num);
-	      value *val
-		  = value_from_contents (regtype,
-					 record_full_get_loc (to_print));
+	      type *regtype = gdbarch_register_type (arch, entry.u.reg.num);
+	      value *val = value_from_contents (regtype, entry.loc);
 	      gdb_printf ("Register %s changed: ",
-			  gdbarch_register_name (arch, to_print->u.reg.num));
+			  gdbarch_register_name (arch, entry.u.reg.num));
 	      struct value_print_options opts;
 	      get_user_print_options (&opts);
 	      opts.raw = true;
@@ -2863,30 +3605,136 @@ maintenance_print_record_instruction (const char *args, int from_tty)
 	    }
 	  case record_full_mem:
 	    {
-	      gdb_byte *b = record_full_get_loc (to_print);
+	      gdb_byte *b = entry.loc;
 	      gdb_printf ("%d bytes of memory at address %s changed from:",
-			  to_print->u.mem.len,
-			  print_core_address (arch, to_print->u.mem.addr));
-	      for (int i = 0; i < to_print->u.mem.len; i++)
+			  entry.u.mem.len,
+			  print_core_address (arch, entry.u.mem.addr));
+	      for (int i = 0; i < entry.u.mem.len; i++)
 		gdb_printf (" %02x", b[i]);
 	      gdb_printf ("\n");
 	      break;
 	    }
 	}
-      to_print = to_print->next;
+      record_full_log_data.next (to_print);
     }
 }
 
+#if GDB_SELF_TEST
+namespace selftests {
+
+/* Check the encoding and traversal of record_full_log.  */
+
+static void
+test_record_full_log ()
+{
+  record_full_log log;
+  gdb_byte *loc;
+
+  log.reset ();
+  SELF_CHECK (log.begin () == log.last ());
+  SELF_CHECK (log.bytes_used () > 0);
+
+  /* Record a few instructions, one of them big enough to need a chunk
+     of its own.  */
+  const int big = RECORD_FULL_CHUNK_SIZE + 100;
+  for (int i = 1; i <= 3; i++)
+    {
+      loc = log.append_reg (i, 8);
+      memset (loc, i, 8);
+      loc = log.append_mem (0x7ffff000 - i * 16, i == 2 ? big : 4);
+      memset (loc, 0x80 + i, i == 2 ? big : 4);
+      log.append_end (GDB_SIGNAL_0, i);
+      log.commit ();
+    }
+
+  /* Staged entries are not visible until committed.  */
+  log.append_reg (42, 4);
+  log.append_mem (0x1000, 4);
+  log.drop_last ();
+  record_full_pos last = log.last ();
+  SELF_CHECK (!log.next (last));
+  log.discard ();
+
+  /* Walk forward.  */
+  record_full_pos pos = log.begin ();
+  int n = 0;
+  while (log.next (pos))
+    {
+      record_full_entry entry = log.decode (pos);
+      int insn = n / 3 + 1;
+
+      switch (n % 3)
+	{
+	case 0:
+	  SELF_CHECK (entry.type == record_full_reg);
+	  SELF_CHECK (entry.u.reg.num == insn);
+	  SELF_CHECK (entry.u.reg.len == 8);
+	  SELF_CHECK (entry.loc[7] == insn);
+	  break;
+	case 1:
+	  SELF_CHECK (entry.type == record_full_mem);
+	  SELF_CHECK (entry.u.mem.addr == 0x7ffff000 - insn * 16);
+	  SELF_CHECK (entry.u.mem.len == (insn == 2 ? big : 4));
+	  SELF_CHECK (entry.loc[entry.u.mem.len - 1] == 0x80 + insn);
+	  SELF_CHECK (!entry.u.mem.mem_entry_not_accessible);
+	  break;
+	case 2:
+	  SELF_CHECK (entry.type == record_full_end);
+	  SELF_CHECK (entry.u.end.insn_num == insn);
+	  break;
+	}
+      n++;
+    }
+  SELF_CHECK (n == 9);
+  SELF_CHECK (pos == log.last ());
+
+  /* Mutate entries in place, and walk backward.  */
+  log.set_end_signal (pos, GDB_SIGNAL_INT);
+  while (log.prev (pos))
+    {
+      record_full_entry entry = log.decode (pos);
+
+      n--;
+      if (entry.type == record_full_mem)
+	log.set_mem_not_accessible (entry);
+    }
+  SELF_CHECK (n == 0);
+  SELF_CHECK (pos == log.begin ());
+  SELF_CHECK (log.decode (log.last ()).u.end.sigval == GDB_SIGNAL_INT);
+
+  /* Release the oldest instruction, its end becomes the anchor.  */
+  log.release_first ();
+  record_full_entry anchor = log.decode (log.begin ());
+  SELF_CHECK (anchor.type == record_full_end);
+  SELF_CHECK (anchor.u.end.insn_num == 1);
+
+  pos = log.begin ();
+  log.next (pos);
+  record_full_entry entry = log.decode (pos);
+  SELF_CHECK (entry.type == record_full_reg && entry.u.reg.num == 2);
+  log.next (pos);
+  entry = log.decode (pos);
+  SELF_CHECK (entry.type == record_full_mem);
+  SELF_CHECK (entry.u.mem.mem_entry_not_accessible);
+
+  /* Release everything after instruction 2.  */
+  log.next (pos);
+  SELF_CHECK (log.release_following (pos) == 1);
+  SELF_CHECK (log.last () == pos);
+  SELF_CHECK (log.decode (log.last ()).u.end.insn_num == 2);
+}
+
+} /* namespace selftests */
+#endif /* GDB_SELF_TEST */
+
 void _initialize_record_full ();
 void
 _initialize_record_full ()
 {
   struct cmd_list_element *c;
 
-  /* Init record_full_first.  */
-  record_full_first.prev = NULL;
-  record_full_first.next = NULL;
-  record_full_first.type = record_full_end;
+  /* Init the execution log.  */
+  record_full_list_reset ();
 
   add_target (record_full_target_info, record_full_open);
   add_deprecated_target_alias (record_full_target_info, "record");
@@ -2991,4 +3839,9 @@ If a negative argument is given, prints how the nth previous\n\
 instruction will be undone.\n\
 If a positive argument is given, prints\n\
 how the nth following instruction will be redone."), &maintenanceprintlist);
+
+#if GDB_SELF_TEST
+  selftests::register_test ("record-full-log",
+			    selftests::test_record_full_log);
+#endif /* GDB_SELF_TEST */
 }
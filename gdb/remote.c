@@ -34,6 +34,7 @@
 #include "remote.h"
 #include "remote-notif.h"
 #include "regcache.h"
+#include "reggroups.h"
 #include "value.h"
 #include "observable.h"
 #include "solib.h"
@@ -77,10 +78,13 @@
 #include "gdbsupport/search.h"
 #include <algorithm>
 #include <iterator>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include "async-event.h"
 #include "gdbsupport/selftest.h"
 #include "cli/cli-style.h"
+#include "gdbsupport/rsp-compress.h"
 
 /* The remote target.  */
 
@@ -259,6 +263,7 @@ enum {
   PACKET_qXfer_memory_map,
   PACKET_qXfer_osdata,
   PACKET_qXfer_threads,
+  PACKET_qXfer_threads_delta,
   PACKET_qXfer_statictrace_read,
   PACKET_qXfer_traceframe_info,
   PACKET_qXfer_uib,
@@ -388,6 +393,21 @@ enum {
   /* Support for the qIsAddressTagged packet.  */
   PACKET_qIsAddressTagged,
 
+  /* Support for several outstanding vFile:pread requests.  */
+  PACKET_vFile_pread_pipelined,
+
+  /* Support for compressed packets.  */
+  PACKET_compression,
+
+  /* Support for several outstanding independent requests.  */
+  PACKET_QPipelining,
+
+  /* Support for choosing what stop replies expedite.  */
+  PACKET_QExpedite,
+
+  /* Support for prefetching the frames of a thread.  */
+  PACKET_qFramePrefetch,
+
   /* Support for accepting error message in a E.errtext format.
      This allows every remote packet to return E.errtext.
 
@@ -405,6 +425,22 @@ enum {
 
 struct threads_listing_context;
 
+/* A thread in the list maintained with qXfer:threads-delta:read.  */
+
+struct remote_delta_thread
+{
+  ptid_t ptid;
+
+  /* The core the thread was last seen running on.  -1 if not known.  */
+  int core;
+
+  /* The thread's name.  */
+  std::string name;
+
+  /* The thread handle associated with the thread.  */
+  gdb::byte_vector thread_handle;
+};
+
 /* Stub vCont actions support.
 
    Each field is a boolean flag indicating whether the stub reports
@@ -579,6 +615,19 @@ class remote_state
      reliable.  */
   bool noack_mode = false;
 
+  /* The zlib streams used to compress outgoing packets and decompress
+     incoming ones, if compression was negotiated.  */
+  std::unique_ptr<rsp_compressor> compressor;
+  std::unique_ptr<rsp_decompressor> decompressor;
+
+  /* Bytes of packets sent and received, before compression ("raw")
+     and as they went over the connection ("wire"), including the
+     framing characters.  */
+  ULONGEST raw_bytes_sent = 0;
+  ULONGEST wire_bytes_sent = 0;
+  ULONGEST raw_bytes_received = 0;
+  ULONGEST wire_bytes_received = 0;
+
   /* True if we're connected in extended remote mode.  */
   bool extended = false;
 
@@ -642,6 +691,29 @@ class remote_state
   char *finished_annex = nullptr;
   ULONGEST finished_offset = 0;
 
+  /* The thread list built from qXfer:threads-delta:read replies, in
+     the order the remote target reported the threads, and its
+     generation number.  0 means GDB has no list yet, and asks for the
+     whole of it.  */
+  std::vector<remote_delta_thread> delta_threads;
+  ULONGEST delta_threads_generation = 0;
+
+  /* The last QExpedite packet the stub accepted, so that it is only
+     sent again when what GDB wants changes.  */
+  std::string last_expedite_packet;
+
+  /* Stack memory that the stub sent before GDB asked for it, with the
+     last stop reply or in reply to qFramePrefetch, all of process
+     STACK_BLOCKS_PID, by start address.  The blocks never overlap.
+     They are only kept in all-stop mode, and are valid until the
+     target is resumed.  */
+  int stack_blocks_pid = 0;
+  std::map<CORE_ADDR, gdb::byte_vector> stack_blocks;
+
+  /* The threads whose frames were fetched with qFramePrefetch since
+     the target was last resumed.  */
+  std::unordered_set<ptid_t> frames_prefetched;
+
   /* Should we try the 'ThreadInfo' query packet?
 
      This variable (NOT available to the user: auto-detect only!)
@@ -867,6 +939,10 @@ class remote_target : public process_stratum_target
   void disconnect (const char *, int) override;
 
   void commit_requested_thread_options ();
+  void commit_expedite_profile ();
+  bool prefetch_frames (CORE_ADDR memaddr);
+  bool read_stack_blocks (CORE_ADDR memaddr, gdb_byte *myaddr,
+			     ULONGEST len, ULONGEST *xfered_len);
 
   void commit_resumed () override;
   void resume (ptid_t, int, enum gdb_signal) override;
@@ -1095,6 +1171,8 @@ class remote_target : public process_stratum_target
 
   void set_circular_trace_buffer (int val) override;
 
+  void set_compact_trace_buffer (int val) override;
+
   void set_trace_buffer_size (LONGEST val) override;
 
   bool set_trace_notes (const char *user, const char *notes,
@@ -1173,10 +1251,16 @@ class remote_target : public process_stratum_target
 			    ULONGEST offset, fileio_error *remote_errno);
   int remote_hostio_pread_vFile (int fd, gdb_byte *read_buf, int len,
 				 ULONGEST offset, fileio_error *remote_errno);
+  int remote_hostio_pread_pipelined (int fd, gdb::byte_vector &buf, int len,
+				     ULONGEST offset,
+				     fileio_error *remote_errno);
 
   int remote_hostio_send_command (int command_bytes, int which_packet,
 				  fileio_error *remote_errno, const char **attachment,
 				  int *attachment_len);
+  int remote_hostio_parse_reply (int bytes_read, int which_packet,
+				 fileio_error *remote_errno,
+				 const char **attachment, int *attachment_len);
   int remote_hostio_set_filesystem (struct inferior *inf,
 				    fileio_error *remote_errno);
   /* We should get rid of this and use fileio_open directly.  */
@@ -1283,6 +1367,7 @@ class remote_target : public process_stratum_target
 
   int remote_get_threads_with_ql (threads_listing_context *context);
   int remote_get_threads_with_qxfer (threads_listing_context *context);
+  int remote_get_threads_with_qxfer_delta (threads_listing_context *context);
   int remote_get_threads_with_qthreadinfo (threads_listing_context *context);
 
   void extended_remote_restart ();
@@ -1302,6 +1387,9 @@ class remote_target : public process_stratum_target
   void remote_supported_thread_options (const protocol_feature *feature,
 					enum packet_support support,
 					const char *value);
+  void remote_supported_compression (const protocol_feature *feature,
+				     enum packet_support support,
+				     const char *value);
 
   void remote_serial_quit_handler ();
 
@@ -1347,6 +1435,14 @@ class remote_target : public process_stratum_target
 					  ULONGEST len_units,
 					  int unit_size, ULONGEST *xfered_len_units);
 
+  target_xfer_status remote_read_bytes_pipelined (CORE_ADDR memaddr,
+						  gdb_byte *myaddr,
+						  ULONGEST len_units,
+						  ULONGEST chunk_units,
+						  int unit_size,
+						  char packet_format,
+						  ULONGEST *xfered_len_units);
+
   target_xfer_status remote_xfer_live_readonly_partial (gdb_byte *readbuf,
 							ULONGEST memaddr,
 							ULONGEST len,
@@ -1378,8 +1474,14 @@ class remote_target : public process_stratum_target
     return putpkt (buf.data ());
   }
 
+  bool can_pipeline_requests ();
+  void pipeline_requests (gdb::array_view<const std::string> requests,
+			  unsigned int depth,
+			  gdb::function_view<bool (int, int)> handle_reply);
+
   void skip_frame ();
   long read_frame (gdb::char_vector *buf_p);
+  long decompress_frame (gdb::char_vector *buf_p, long bc);
   int getpkt (gdb::char_vector *buf, bool forever = false,
 	      bool *is_notif = nullptr);
   int remote_vkill (int pid);
@@ -1409,6 +1511,14 @@ class remote_target : public process_stratum_target
 					ULONGEST *xfered_len,
 					const unsigned int which_packet);
 
+  target_xfer_status remote_read_qxfer_pipelined (const char *object_name,
+						  const char *annex,
+						  gdb_byte *readbuf,
+						  ULONGEST offset,
+						  LONGEST len, LONGEST chunk,
+						  ULONGEST *xfered_len,
+						  const unsigned int which_packet);
+
   void push_stop_reply (stop_reply_up new_event);
 
   bool vcont_r_supported ();
@@ -1481,6 +1591,10 @@ struct stop_reply : public notif_event
   CORE_ADDR watch_data_address;
 
   int core;
+
+  /* Memory at the stack pointer, expedited with the stop reply.  */
+  CORE_ADDR stack_addr;
+  gdb::byte_vector stack;
 };
 
 /* Return TARGET as a remote_target if it is one, else nullptr.  */
@@ -2299,6 +2413,39 @@ set_memory_write_packet_size (const char *args, int from_tty)
     }
 }
 
+/* Display the compression statistics of the currently selected
+   target.  */
+
+static void
+show_remote_compression_stats (const char *args, int from_tty)
+{
+  remote_target *remote = get_current_remote_target ();
+  if (remote == nullptr)
+    {
+      gdb_printf (_("No remote target is selected.\n"));
+      return;
+    }
+
+  remote_state *rs = remote->get_remote_state ();
+
+  if (remote->m_features.packet_support (PACKET_compression) == PACKET_ENABLE)
+    gdb_printf (_("Packets are compressed with zlib.\n"));
+  else
+    gdb_printf (_("Packets are not compressed.\n"));
+
+  auto show = [] (const char *what, ULONGEST raw, ULONGEST wire)
+    {
+      gdb_printf (_("  Bytes %s: %s, %s on the wire"), what,
+		  pulongest (raw), pulongest (wire));
+      if (raw != 0)
+	gdb_printf (_(" (%.1f%%)"), 100.0 * wire / raw);
+      gdb_printf ("\n");
+    };
+
+  show (_("sent"), rs->raw_bytes_sent, rs->wire_bytes_sent);
+  show (_("received"), rs->raw_bytes_received, rs->wire_bytes_received);
+}
+
 /* Display the memory-write-packet size of the currently selected target.  If
    no target is available, the default configuration for future remote targets
    is shown.  */
@@ -2352,6 +2499,44 @@ show_hardware_breakpoint_limit (struct ui_file *file, int from_tty,
 
 static int remote_packet_max_chars = 512;
 
+/* The maximum number of vFile:pread requests that may be outstanding
+   at once.  */
+
+static unsigned int remote_hostio_pread_window = 16;
+
+/* The maximum number of independent requests that may be outstanding
+   at once when the remote stub supports QPipelining.  */
+
+static unsigned int remote_pipeline_depth = 8;
+
+/* The maximum number of requests a single memory or qXfer read is
+   split into, so that a large transfer still returns to its caller,
+   which checks for interrupts, every so often.  */
+
+static const int remote_pipeline_max_requests = 64;
+
+/* Which registers to ask the remote stub to include in stop replies,
+   with QExpedite.  "default" leaves the choice to the stub, which
+   usually sends just the PC, SP and FP.  */
+
+static const char expedite_registers_default[] = "default";
+static const char expedite_registers_general[] = "general";
+static const char expedite_registers_all[] = "all";
+
+static const char *const expedite_registers_modes[] =
+  {
+    expedite_registers_default,
+    expedite_registers_general,
+    expedite_registers_all,
+    NULL
+  };
+static const char *remote_expedite_registers = expedite_registers_general;
+
+/* How many bytes of memory at the stack pointer to ask the remote
+   stub to include in stop replies, with QExpedite.  */
+
+static unsigned int remote_expedite_stack_bytes = 256;
+
 /* Show the maximum number of characters to display for each remote packet
    when remote debugging is enabled.  */
 
@@ -4224,6 +4409,156 @@ remote_target::remote_get_threads_with_qxfer (threads_listing_context *context)
   return 0;
 }
 
+/* Apply TEXT, a qXfer:threads-delta:read reply, to THREADS, and set
+   *GENERATION to the generation number of the resulting list.  TEXT
+   is a header line, "F" followed by the generation number if the
+   records that follow describe the whole list, or "D" if they only
+   describe the changes since the previous generation.  Each record is
+   a line, either "+PTID;CORE;NAME;HANDLE" for a thread that is new or
+   changed, or "-PTID" for a thread that exited.  CORE is in hex and
+   may be empty if unknown, NAME and HANDLE are hex-encoded.  Return
+   false if TEXT is malformed, in which case THREADS and *GENERATION
+   are left in an unspecified state.  */
+
+static bool
+apply_threads_delta (const char *text,
+		     std::vector<remote_delta_thread> *threads,
+		     ULONGEST *generation)
+{
+  const char *p = text;
+
+  if (*p != 'F' && *p != 'D')
+    return false;
+  if (*p == 'F')
+    threads->clear ();
+
+  p = unpack_varlen_hex (p + 1, generation);
+  if (*p++ != '\n')
+    return false;
+
+  /* Index the existing threads, so that a delta with few records
+     does not cost a walk of the whole list for each of them.  */
+  std::unordered_map<ptid_t, size_t> index;
+  for (size_t i = 0; i < threads->size (); i++)
+    index[(*threads)[i].ptid] = i;
+
+  std::unordered_set<ptid_t> exited;
+
+  /* Return the hex-encoded field at P, up to DELIM, advancing P past
+     DELIM.  */
+  auto read_field = [&] (char delim) -> std::optional<std::string>
+    {
+      const char *end = strchr (p, delim);
+      if (end == nullptr)
+	return {};
+      std::string field (p, end - p);
+      p = end + 1;
+      return field;
+    };
+
+  while (*p != '\0')
+    {
+      char kind = *p++;
+      ptid_t ptid = read_ptid (p, &p);
+
+      if (ptid == null_ptid)
+	return false;
+
+      if (kind == '-')
+	{
+	  if (*p++ != '\n')
+	    return false;
+	  exited.insert (ptid);
+	  continue;
+	}
+      else if (kind != '+' || *p++ != ';')
+	return false;
+
+      std::optional<std::string> core_s = read_field (';');
+      std::optional<std::string> name_s = read_field (';');
+      std::optional<std::string> handle_s = read_field ('\n');
+      if (!core_s || !name_s || !handle_s
+	  || name_s->size () % 2 != 0 || handle_s->size () % 2 != 0)
+	return false;
+
+      remote_delta_thread *thread;
+      auto it = index.find (ptid);
+      if (it != index.end ())
+	thread = &(*threads)[it->second];
+      else
+	{
+	  index[ptid] = threads->size ();
+	  thread = &threads->emplace_back ();
+	  thread->ptid = ptid;
+	}
+
+      thread->core = -1;
+      if (!core_s->empty ())
+	{
+	  ULONGEST core;
+	  if (*unpack_varlen_hex (core_s->c_str (), &core) != '\0')
+	    return false;
+	  thread->core = core;
+	}
+      thread->name = hex2str (name_s->c_str ());
+      thread->thread_handle = hex2bin (handle_s->c_str ());
+    }
+
+  if (!exited.empty ())
+    {
+      auto it = std::remove_if (threads->begin (), threads->end (),
+				[&] (const remote_delta_thread &thread)
+				{
+				  return exited.count (thread.ptid) != 0;
+				});
+      threads->erase (it, threads->end ());
+    }
+
+  return true;
+}
+
+/* List remote threads using qXfer:threads-delta:read, which only
+   transfers the changes since the previous read.  */
+
+int
+remote_target::remote_get_threads_with_qxfer_delta
+  (threads_listing_context *context)
+{
+  struct remote_state *rs = get_remote_state ();
+
+  if (m_features.packet_support (PACKET_qXfer_threads_delta)
+      != PACKET_ENABLE)
+    return 0;
+
+  std::string annex = phex_nz (rs->delta_threads_generation,
+			       sizeof (rs->delta_threads_generation));
+  std::optional<gdb::char_vector> text
+    = target_read_stralloc (this, TARGET_OBJECT_THREADS_DELTA,
+			    annex.c_str ());
+
+  if (!text
+      || !apply_threads_delta (text->data (), &rs->delta_threads,
+			       &rs->delta_threads_generation))
+    {
+      /* Start again with the whole list next time, and use another
+	 method for now.  */
+      rs->delta_threads.clear ();
+      rs->delta_threads_generation = 0;
+      return 0;
+    }
+
+  for (const remote_delta_thread &thread : rs->delta_threads)
+    {
+      thread_item &item = context->items.emplace_back (thread.ptid);
+
+      item.core = thread.core;
+      item.name = thread.name;
+      item.thread_handle = thread.thread_handle;
+    }
+
+  return 1;
+}
+
 /* List remote threads using qfThreadInfo/qsThreadInfo.  */
 
 int
@@ -4288,7 +4623,8 @@ remote_target::update_thread_list ()
   /* We have a few different mechanisms to fetch the thread list.  Try
      them all, starting with the most preferred one first, falling
      back to older methods.  */
-  if (remote_get_threads_with_qxfer (&context)
+  if (remote_get_threads_with_qxfer_delta (&context)
+      || remote_get_threads_with_qxfer (&context)
       || remote_get_threads_with_qthreadinfo (&context)
       || remote_get_threads_with_ql (&context))
     {
@@ -4408,11 +4744,14 @@ remote_target::extra_thread_info (thread_info *tp)
   if (!extra.empty ())
     return extra.c_str ();
 
-  if (m_features.packet_support (PACKET_qXfer_threads) == PACKET_ENABLE)
+  if (m_features.packet_support (PACKET_qXfer_threads) == PACKET_ENABLE
+      || (m_features.packet_support (PACKET_qXfer_threads_delta)
+	  == PACKET_ENABLE))
     {
       /* If we're using qXfer:threads:read, then the extra info is
 	 included in the XML.  So if we didn't have anything cached,
-	 it's because there's really no extra info.  */
+	 it's because there's really no extra info.  The delta format
+	 has no extra info at all.  */
       return NULL;
     }
 
@@ -5734,6 +6073,44 @@ remote_supported_thread_options (remote_target *remote,
   remote->remote_supported_thread_options (feature, support, value);
 }
 
+void
+remote_target::remote_supported_compression (const protocol_feature *feature,
+					     enum packet_support support,
+					     const char *value)
+{
+  struct remote_state *rs = get_remote_state ();
+
+  if (support != PACKET_ENABLE)
+    {
+      m_features.m_protocol_packets[feature->packet].support = support;
+      return;
+    }
+
+  if (value == nullptr || strcmp (value, "zlib") != 0)
+    {
+      warning (_("Remote target reported \"%s\" with an unknown "
+		 "method: \"%s\"."),
+	       feature->name, value == nullptr ? "" : value);
+      m_features.m_protocol_packets[feature->packet].support = PACKET_DISABLE;
+      return;
+    }
+
+  /* The stub compresses packets it sends after its qSupported reply,
+     and accepts compressed packets from now on.  */
+  m_features.m_protocol_packets[feature->packet].support = PACKET_ENABLE;
+  rs->compressor = std::make_unique<rsp_compressor> ();
+  rs->decompressor = std::make_unique<rsp_decompressor> ();
+}
+
+static void
+remote_supported_compression (remote_target *remote,
+			      const protocol_feature *feature,
+			      enum packet_support support,
+			      const char *value)
+{
+  remote->remote_supported_compression (feature, support, value);
+}
+
 static const struct protocol_feature remote_protocol_features[] = {
   { "PacketSize", PACKET_DISABLE, remote_packet_size, -1 },
   { "qXfer:auxv:read", PACKET_DISABLE, remote_supported_packet,
@@ -5754,6 +6131,8 @@ static const struct protocol_feature remote_protocol_features[] = {
     PACKET_qXfer_osdata },
   { "qXfer:threads:read", PACKET_DISABLE, remote_supported_packet,
     PACKET_qXfer_threads },
+  { "qXfer:threads-delta:read", PACKET_DISABLE, remote_supported_packet,
+    PACKET_qXfer_threads_delta },
   { "qXfer:traceframe-info:read", PACKET_DISABLE, remote_supported_packet,
     PACKET_qXfer_traceframe_info },
   { "QPassSignals", PACKET_DISABLE, remote_supported_packet,
@@ -5845,6 +6224,16 @@ static const struct protocol_feature remote_protocol_features[] = {
   { "no-resumed", PACKET_DISABLE, remote_supported_packet, PACKET_no_resumed },
   { "memory-tagging", PACKET_DISABLE, remote_supported_packet,
     PACKET_memory_tagging_feature },
+  { "vFile:pread-pipelined", PACKET_DISABLE, remote_supported_packet,
+    PACKET_vFile_pread_pipelined },
+  { "compression", PACKET_DISABLE, remote_supported_compression,
+    PACKET_compression },
+  { "QPipelining", PACKET_DISABLE, remote_supported_packet,
+    PACKET_QPipelining },
+  { "QExpedite", PACKET_DISABLE, remote_supported_packet,
+    PACKET_QExpedite },
+  { "qFramePrefetch", PACKET_DISABLE, remote_supported_packet,
+    PACKET_qFramePrefetch },
   { "error-message", PACKET_ENABLE, remote_supported_packet,
     PACKET_accept_error_message },
 };
@@ -5958,6 +6347,14 @@ remote_target::remote_query_supported ()
 	  != AUTO_BOOLEAN_FALSE)
 	remote_query_supported_append (&q, "memory-tagging+");
 
+      if (m_features.packet_set_cmd_state (PACKET_compression)
+	  != AUTO_BOOLEAN_FALSE)
+	remote_query_supported_append (&q, "compression=zlib");
+
+      if (m_features.packet_set_cmd_state (PACKET_QPipelining)
+	  != AUTO_BOOLEAN_FALSE)
+	remote_query_supported_append (&q, "QPipelining+");
+
       /* Keep this one last to work around a gdbserver <= 7.10 bug in
 	 the qSupported:xmlRegisters=i386 handling.  */
       if (remote_support_xml != NULL
@@ -7054,6 +7451,12 @@ remote_target::resume (ptid_t scope_ptid, int step, enum gdb_signal siggnal)
     }
 
   commit_requested_thread_options ();
+  commit_expedite_profile ();
+
+  /* Memory read before this point may change once the target
+     runs.  */
+  rs->stack_blocks.clear ();
+  rs->frames_prefetched.clear ();
 
   /* In all-stop, we can't mark REMOTE_ASYNC_GET_PENDING_EVENTS_TOKEN
      (explained in remote-notif.c:handle_notification) so
@@ -7218,6 +7621,7 @@ remote_target::commit_resumed ()
     return;
 
   commit_requested_thread_options ();
+  commit_expedite_profile ();
 
   /* Try to send wildcard actions ("vCont;c" or "vCont;c:pPID.-1")
      instead of resuming all threads of each process individually.
@@ -8010,6 +8414,7 @@ remote_target::remote_parse_stop_reply (const char *buf, stop_reply *event)
   event->stop_reason = TARGET_STOPPED_BY_NO_REASON;
   event->regcache.clear ();
   event->core = -1;
+  event->stack.clear ();
 
   switch (buf[0])
     {
@@ -8155,6 +8560,19 @@ Packet: '%s'\n"),
 	      event->ws.set_thread_created ();
 	      p = strchrnul (p1 + 1, ';');
 	    }
+	  else if (strprefix (p, p1, "stack"))
+	    {
+	      ULONGEST stack_addr;
+
+	      p = unpack_varlen_hex (++p1, &stack_addr);
+	      if (*p != ',')
+		error (_("Malformed stack in stop reply: %s"), buf);
+	      p1 = ++p;
+	      p = strchrnul (p, ';');
+	      event->stack_addr = stack_addr;
+	      event->stack.resize ((p - p1) / 2);
+	      hex2bin (p1, event->stack.data (), event->stack.size ());
+	    }
 	  else
 	    {
 	      ULONGEST pnum;
@@ -8531,6 +8949,46 @@ remote_target::select_thread_for_ambiguous_stop_reply
     return first_resumed_thread->ptid;
 }
 
+/* Add the memory BYTES at ADDR to BLOCKS, merging it with the blocks
+   it overlaps or touches.  All the blocks are read at the same time,
+   so where they overlap their contents are the same.  */
+
+static void
+add_stack_block (std::map<CORE_ADDR, gdb::byte_vector> *blocks,
+		 CORE_ADDR addr, gdb::byte_vector &&bytes)
+{
+  CORE_ADDR end = addr + bytes.size ();
+
+  auto it = blocks->upper_bound (addr);
+  if (it != blocks->begin ())
+    {
+      auto prev = std::prev (it);
+      if (prev->first + prev->second.size () >= addr)
+	it = prev;
+    }
+
+  while (it != blocks->end () && it->first <= end)
+    {
+      CORE_ADDR block_end = it->first + it->second.size ();
+
+      if (it->first < addr)
+	{
+	  bytes.insert (bytes.begin (), it->second.begin (),
+			it->second.begin () + (addr - it->first));
+	  addr = it->first;
+	}
+      if (block_end > end)
+	{
+	  bytes.insert (bytes.end (), it->second.end () - (block_end - end),
+			it->second.end ());
+	  end = block_end;
+	}
+      it = blocks->erase (it);
+    }
+
+  blocks->emplace (addr, std::move (bytes));
+}
+
 /* Called when it is decided that STOP_REPLY holds the info of the
    event that is to be returned to the core.  This function always
    destroys STOP_REPLY.  */
@@ -8546,6 +9004,17 @@ remote_target::process_stop_reply (stop_reply_up stop_reply,
   /* Forget about last reply's expedited registers.  */
   rs->last_seen_expedited_registers.clear ();
 
+  /* Likewise for the expedited stack memory.  In non-stop mode, other
+     threads may still be changing memory, so it is not kept.  */
+  rs->stack_blocks.clear ();
+  rs->frames_prefetched.clear ();
+  if (!stop_reply->stack.empty () && !target_is_non_stop_p ())
+    {
+      rs->stack_blocks_pid = stop_reply->ptid.pid ();
+      add_stack_block (&rs->stack_blocks, stop_reply->stack_addr,
+		       std::move (stop_reply->stack));
+    }
+
   /* If no thread/process was reported by the stub then select a suitable
      thread/process.  */
   if (ptid == null_ptid)
@@ -9704,6 +10173,15 @@ remote_target::remote_read_bytes_1 (CORE_ADDR memaddr, gdb_byte *myaddr,
   else
     packet_format = 'x';
 
+  /* Once the packet format is known, reads that need several packets
+     can be pipelined.  */
+  if (len_units > todo_units
+      && m_features.packet_support (PACKET_x) != PACKET_SUPPORT_UNKNOWN
+      && can_pipeline_requests ())
+    return remote_read_bytes_pipelined (memaddr, myaddr, len_units,
+					todo_units, unit_size, packet_format,
+					xfered_len_units);
+
   send_request (packet_format);
   int packet_len = getpkt (&rs->buf);
   if (packet_len < 0)
@@ -9759,6 +10237,71 @@ remote_target::remote_read_bytes_1 (CORE_ADDR memaddr, gdb_byte *myaddr,
   return (*xfered_len_units != 0) ? TARGET_XFER_OK : TARGET_XFER_EOF;
 }
 
+/* Read LEN_UNITS addressable memory units at MEMADDR into MYADDR
+   with several PACKET_FORMAT requests of CHUNK_UNITS units each, sent
+   with pipeline_requests.  Only the data up to the first short or
+   failed reply is kept, as with remote_read_bytes_1, higher layers
+   handle the partial read.  MEMADDR must already be masked.  */
+
+target_xfer_status
+remote_target::remote_read_bytes_pipelined (CORE_ADDR memaddr,
+					    gdb_byte *myaddr,
+					    ULONGEST len_units,
+					    ULONGEST chunk_units,
+					    int unit_size,
+					    char packet_format,
+					    ULONGEST *xfered_len_units)
+{
+  struct remote_state *rs = get_remote_state ();
+  ULONGEST count = std::min<ULONGEST> ((len_units + chunk_units - 1)
+				       / chunk_units,
+				       remote_pipeline_max_requests);
+  std::vector<std::string> requests;
+
+  for (ULONGEST i = 0; i < count; i++)
+    {
+      ULONGEST todo = std::min (chunk_units, len_units - i * chunk_units);
+
+      ULONGEST addr = memaddr + i * chunk_units;
+
+      requests.push_back (string_printf ("%c%s,%s", packet_format,
+					 phex_nz (addr, sizeof (addr)),
+					 phex_nz (todo, sizeof (todo))));
+    }
+
+  ULONGEST total_units = 0;
+  pipeline_requests (requests, remote_pipeline_depth,
+		     [&] (int index, int packet_len)
+    {
+      ULONGEST todo = std::min (chunk_units,
+				len_units - (ULONGEST) index * chunk_units);
+      gdb_byte *dest = myaddr + total_units * unit_size;
+      int decoded_bytes;
+
+      if (packet_len < 0
+	  || packet_check_result (rs->buf).status () == PACKET_ERROR)
+	return false;
+
+      char *p = rs->buf.data ();
+      if (packet_format == 'x')
+	{
+	  if (*p != 'b')
+	    return false;
+	  decoded_bytes = remote_unescape_input ((const gdb_byte *) p + 1,
+						 packet_len - 1, dest,
+						 todo * unit_size);
+	}
+      else
+	decoded_bytes = hex2bin (p, dest, todo * unit_size);
+
+      total_units += decoded_bytes / unit_size;
+      return (ULONGEST) decoded_bytes == todo * unit_size;
+    });
+
+  *xfered_len_units = total_units;
+  return (total_units != 0) ? TARGET_XFER_OK : TARGET_XFER_EOF;
+}
+
 /* Using the set of read-only target sections of remote, read live
    read-only memory.
 
@@ -10107,7 +10650,22 @@ remote_target::putpkt_binary (const char *buf, int cnt)
   struct remote_state *rs = get_remote_state ();
   int i;
   unsigned char csum = 0;
-  gdb::def_vector<char> data (cnt + 6);
+  std::string compressed;
+  const char *payload = buf;
+  int payload_len = cnt;
+
+  /* Only compress in no-ack mode: a packet sent again after a NAK or
+     a lost ack would go through the stub's decompression stream
+     twice.  */
+  if (rs->compressor != nullptr && rs->noack_mode
+      && cnt >= RSP_COMPRESS_THRESHOLD)
+    {
+      compressed = rs->compressor->compress (buf, cnt);
+      payload = compressed.data ();
+      payload_len = compressed.size ();
+    }
+
+  gdb::def_vector<char> data (payload_len + 6);
   char *buf2 = data.data ();
 
   int ch;
@@ -10136,15 +10694,18 @@ remote_target::putpkt_binary (const char *buf, int cnt)
   p = buf2;
   *p++ = '$';
 
-  for (i = 0; i < cnt; i++)
+  for (i = 0; i < payload_len; i++)
     {
-      csum += buf[i];
-      *p++ = buf[i];
+      csum += payload[i];
+      *p++ = payload[i];
     }
   *p++ = '#';
   *p++ = tohex ((csum >> 4) & 0xf);
   *p++ = tohex (csum & 0xf);
 
+  rs->raw_bytes_sent += cnt + 4;
+  rs->wire_bytes_sent += p - buf2;
+
   /* Send it over and over until we get a positive ack.  */
 
   while (1)
@@ -10153,7 +10714,9 @@ remote_target::putpkt_binary (const char *buf, int cnt)
 	{
 	  *p = '\0';
 
-	  int len = (int) (p - buf2);
+	  /* Show compressed packets as they were before compression.  */
+	  const char *shown = compressed.empty () ? buf2 : buf;
+	  int len = compressed.empty () ? (int) (p - buf2) : cnt;
 	  int max_chars;
 
 	  if (remote_packet_max_chars < 0)
@@ -10162,7 +10725,10 @@ remote_target::putpkt_binary (const char *buf, int cnt)
 	    max_chars = remote_packet_max_chars;
 
 	  std::string str
-	    = escape_buffer (buf2, std::min (len, max_chars));
+	    = escape_buffer (shown, std::min (len, max_chars));
+	  if (!compressed.empty ())
+	    str += string_printf (" [compressed to %d bytes]",
+				  (int) (p - buf2));
 
 	  if (len > max_chars)
 	    remote_debug_printf_nofunc
@@ -10311,6 +10877,7 @@ remote_target::read_frame (gdb::char_vector *buf_p)
   int c;
   char *buf = buf_p->data ();
   struct remote_state *rs = get_remote_state ();
+  bool compressed = false;
 
   csum = 0;
   bc = 0;
@@ -10354,25 +10921,40 @@ remote_target::read_frame (gdb::char_vector *buf_p)
 	    /* Don't recompute the checksum; with no ack packets we
 	       don't have any way to indicate a packet retransmission
 	       is necessary.  */
-	    if (rs->noack_mode)
-	      return bc;
-
-	    pktcsum = (fromhex (check_0) << 4) | fromhex (check_1);
-	    if (csum == pktcsum)
-	      return bc;
+	    if (!rs->noack_mode)
+	      {
+		pktcsum = (fromhex (check_0) << 4) | fromhex (check_1);
+		if (csum != pktcsum)
+		  {
+		    remote_debug_printf
+		      ("Bad checksum, sentsum=0x%x, csum=0x%x, buf=%s",
+		       pktcsum, csum, escape_buffer (buf, bc).c_str ());
 
-	    remote_debug_printf
-	      ("Bad checksum, sentsum=0x%x, csum=0x%x, buf=%s",
-	       pktcsum, csum, escape_buffer (buf, bc).c_str ());
+		    /* Number of characters in buffer ignoring trailing
+		       NULL.  */
+		    return -1;
+		  }
+	      }
 
-	    /* Number of characters in buffer ignoring trailing
-	       NULL.  */
-	    return -1;
+	    rs->wire_bytes_received += bc + (compressed ? 5 : 4);
+	    if (compressed)
+	      bc = decompress_frame (buf_p, bc);
+	    rs->raw_bytes_received += bc + 4;
+	    return bc;
 	  }
 	case '*':		/* Run length encoding.  */
 	  {
 	    int repeat;
 
+	    /* A leading '*' cannot be a repeat count; it marks a
+	       compressed payload, which contains no further '*'.  */
+	    if (bc == 0 && !compressed && rs->decompressor != nullptr)
+	      {
+		compressed = true;
+		csum += c;
+		continue;
+	      }
+
 	    csum += c;
 	    c = readchar (remote_timeout);
 	    csum += c;
@@ -10413,6 +10995,33 @@ remote_target::read_frame (gdb::char_vector *buf_p)
     }
 }
 
+/* Replace the BC bytes of compressed payload in *BUF_P, which followed
+   RSP_COMPRESSED_PAYLOAD, with the decompressed payload, NUL
+   terminated.  Returns the length of the decompressed payload.  */
+
+long
+remote_target::decompress_frame (gdb::char_vector *buf_p, long bc)
+{
+  struct remote_state *rs = get_remote_state ();
+  std::string payload;
+
+  if (!rs->decompressor->decompress (buf_p->data (), bc, &payload))
+    {
+      /* Both ends' streams are now out of step, so nothing more can be
+	 received.  */
+      remote_unpush_target (this);
+      throw_error (TARGET_CLOSE_ERROR,
+		   _("Remote sent a corrupt compressed packet.  "
+		     "Target detached."));
+    }
+
+  if (payload.size () + 1 > buf_p->size ())
+    buf_p->resize (payload.size () + 1);
+  memcpy (buf_p->data (), payload.data (), payload.size ());
+  (*buf_p)[payload.size ()] = '\0';
+  return payload.size ();
+}
+
 /* Set this to the maximum number of seconds to wait instead of waiting forever
    in target_wait().  If this timer times out, then it generates an error and
    the command is aborted.  This replaces most of the need for timeouts in the
@@ -10577,6 +11186,75 @@ remote_target::getpkt (gdb::char_vector *buf, bool forever, bool *is_notif)
     }
 }
 
+/* Return true if independent requests may be sent with
+   pipeline_requests without waiting for each reply.  */
+
+bool
+remote_target::can_pipeline_requests ()
+{
+  struct remote_state *rs = get_remote_state ();
+
+  /* Pipelining relies on the stub not acknowledging each packet.  */
+  return (remote_pipeline_depth > 1
+	  && rs->noack_mode
+	  && m_features.packet_support (PACKET_QPipelining) == PACKET_ENABLE);
+}
+
+/* Send the independent REQUESTS to the remote stub, keeping up to
+   DEPTH of them outstanding, and call HANDLE_REPLY for each reply in
+   turn with the index of its request and the result of getpkt; the
+   reply itself is in the remote state's buffer.  The remote stub
+   replies to requests in the order it receives them, so replies are
+   matched to requests by their order.  If HANDLE_REPLY returns false,
+   no more requests are sent, and the replies to those already sent
+   are read and discarded so that later requests do not see them.
+   The same happens if HANDLE_REPLY throws, before the exception is
+   rethrown.  */
+
+void
+remote_target::pipeline_requests (gdb::array_view<const std::string> requests,
+				  unsigned int depth,
+				  gdb::function_view<bool (int, int)> handle_reply)
+{
+  struct remote_state *rs = get_remote_state ();
+  size_t sent = 0;
+  size_t received = 0;
+  bool stopped = false;
+  gdb_exception pending;
+
+  depth = std::max (depth, 1u);
+  for (;;)
+    {
+      while (!stopped && sent < requests.size () && sent - received < depth)
+	{
+	  putpkt_binary (requests[sent].data (), requests[sent].size ());
+	  sent++;
+	}
+
+      if (received == sent)
+	break;
+
+      int bytes_read = getpkt (&rs->buf);
+      if (!stopped)
+	{
+	  try
+	    {
+	      if (!handle_reply (received, bytes_read))
+		stopped = true;
+	    }
+	  catch (gdb_exception &ex)
+	    {
+	      pending = std::move (ex);
+	      stopped = true;
+	    }
+	}
+      received++;
+    }
+
+  if (pending.reason != 0)
+    throw_exception (std::move (pending));
+}
+
 /* Kill any new fork children of inferior INF that haven't been
    processed by follow_fork.  */
 
@@ -11698,6 +12376,10 @@ remote_target::remote_read_qxfer (const char *object_name,
      the target is free to respond with slightly less data.  We subtract
      five to account for the response type and the protocol frame.  */
   n = std::min<LONGEST> (get_remote_packet_size () - 5, len);
+  if (len > n && can_pipeline_requests ())
+    return remote_read_qxfer_pipelined (object_name, annex, readbuf, offset,
+					len, n, xfered_len, which_packet);
+
   snprintf (rs->buf.data (), get_remote_packet_size () - 4,
 	    "qXfer:%s:read:%s:%s,%s",
 	    object_name, annex ? annex : "",
@@ -11745,6 +12427,76 @@ remote_target::remote_read_qxfer (const char *object_name,
     }
 }
 
+/* Like remote_read_qxfer, but read up to LEN bytes with several
+   requests of CHUNK bytes each, sent with pipeline_requests.  Only the
+   data up to the first short, failed or final reply is kept.  */
+
+target_xfer_status
+remote_target::remote_read_qxfer_pipelined (const char *object_name,
+					    const char *annex,
+					    gdb_byte *readbuf,
+					    ULONGEST offset,
+					    LONGEST len, LONGEST chunk,
+					    ULONGEST *xfered_len,
+					    const unsigned int which_packet)
+{
+  struct remote_state *rs = get_remote_state ();
+  LONGEST count = std::min<LONGEST> ((len + chunk - 1) / chunk,
+				     remote_pipeline_max_requests);
+  std::vector<std::string> requests;
+
+  for (LONGEST i = 0; i < count; i++)
+    {
+      ULONGEST chunk_offset = offset + i * chunk;
+      LONGEST todo = std::min (chunk, len - i * chunk);
+
+      requests.push_back (string_printf ("qXfer:%s:read:%s:%s,%s",
+					 object_name, annex ? annex : "",
+					 phex_nz (chunk_offset,
+						  sizeof (chunk_offset)),
+					 phex_nz (todo, sizeof (todo))));
+    }
+
+  LONGEST total = 0;
+  bool eof = false;
+  pipeline_requests (requests, remote_pipeline_depth,
+		     [&] (int index, int packet_len)
+    {
+      if (packet_len < 0
+	  || (m_features.packet_ok (rs->buf, which_packet).status ()
+	      != PACKET_OK)
+	  || (rs->buf[0] != 'l' && rs->buf[0] != 'm'))
+	return false;
+
+      LONGEST todo = std::min (chunk, len - index * chunk);
+      LONGEST got = remote_unescape_input ((gdb_byte *) rs->buf.data () + 1,
+					   packet_len - 1, readbuf + total,
+					   todo);
+      total += got;
+      if (rs->buf[0] == 'l')
+	{
+	  eof = true;
+	  return false;
+	}
+      return got == todo;
+    });
+
+  /* Record the end of the object to bypass a subsequent partial read,
+     as remote_read_qxfer does.  */
+  if (eof && offset + total > 0)
+    {
+      rs->finished_object = xstrdup (object_name);
+      rs->finished_annex = xstrdup (annex ? annex : "");
+      rs->finished_offset = offset + total;
+    }
+
+  if (total == 0)
+    return eof ? TARGET_XFER_EOF : TARGET_XFER_E_IO;
+
+  *xfered_len = total;
+  return TARGET_XFER_OK;
+}
+
 enum target_xfer_status
 remote_target::xfer_partial (enum target_object object,
 			     const char *annex, gdb_byte *readbuf,
@@ -11773,8 +12525,28 @@ remote_target::xfer_partial (enum target_object object,
 	return TARGET_XFER_EOF;
 
       if (writebuf != NULL)
-	return remote_write_bytes (offset, writebuf, len, unit_size,
-				   xfered_len);
+	{
+	  /* Don't bother updating the cached stack memory, this is
+	     rare enough.  */
+	  for (auto it = rs->stack_blocks.begin ();
+	       it != rs->stack_blocks.end ();)
+	    {
+	      if (offset < it->first + it->second.size ()
+		  && it->first < offset + len * unit_size)
+		it = rs->stack_blocks.erase (it);
+	      else
+		++it;
+	    }
+
+	  return remote_write_bytes (offset, writebuf, len, unit_size,
+				     xfered_len);
+	}
+      else if (unit_size == 1
+	       && (read_stack_blocks (offset, readbuf, len, xfered_len)
+		   || (prefetch_frames (offset)
+		       && read_stack_blocks (offset, readbuf, len,
+					     xfered_len))))
+	return TARGET_XFER_OK;
       else
 	return remote_read_bytes (offset, readbuf, len, unit_size,
 				  xfered_len);
@@ -11862,6 +12634,11 @@ remote_target::xfer_partial (enum target_object object,
 	("threads", annex, readbuf, offset, len, xfered_len,
 	 PACKET_qXfer_threads);
 
+    case TARGET_OBJECT_THREADS_DELTA:
+      return remote_read_qxfer
+	("threads-delta", annex, readbuf, offset, len, xfered_len,
+	 PACKET_qXfer_threads_delta);
+
     case TARGET_OBJECT_TRACEFRAME_INFO:
       gdb_assert (annex == NULL);
       return remote_read_qxfer
@@ -12717,8 +13494,7 @@ remote_target::remote_hostio_send_command (int command_bytes, int which_packet,
 					   int *attachment_len)
 {
   struct remote_state *rs = get_remote_state ();
-  int ret, bytes_read;
-  const char *attachment_tmp;
+  int bytes_read;
 
   if (m_features.packet_support (which_packet) == PACKET_DISABLE)
     {
@@ -12729,6 +13505,25 @@ remote_target::remote_hostio_send_command (int command_bytes, int which_packet,
   putpkt_binary (rs->buf.data (), command_bytes);
   bytes_read = getpkt (&rs->buf);
 
+  return remote_hostio_parse_reply (bytes_read, which_packet, remote_errno,
+				    attachment, attachment_len);
+}
+
+/* Parse the reply to a vFile request, which getpkt has just stored in
+   the packet buffer.  BYTES_READ is getpkt's return value.  The other
+   arguments and the return value are as for
+   remote_hostio_send_command.  */
+
+int
+remote_target::remote_hostio_parse_reply (int bytes_read, int which_packet,
+					  fileio_error *remote_errno,
+					  const char **attachment,
+					  int *attachment_len)
+{
+  struct remote_state *rs = get_remote_state ();
+  int ret;
+  const char *attachment_tmp;
+
   /* If it timed out, something is wrong.  Don't try to parse the
      buffer.  */
   if (bytes_read < 0)
@@ -12965,6 +13760,94 @@ remote_target::remote_hostio_pread_vFile (int fd, gdb_byte *read_buf, int len,
   return ret;
 }
 
+/* Read up to LEN bytes at OFFSET from FD into BUF, which is resized
+   to the number of bytes read, using several vFile:pread requests
+   that are all sent with pipeline_requests before waiting for the
+   first reply.  The read stops at the first reply
+   that is short, either because of end of file or because the stub
+   could not fit the data in its reply; the caller simply sees a short
+   read.  Returns the number of bytes read, or -1 on error, setting
+   *REMOTE_ERRNO.  */
+
+int
+remote_target::remote_hostio_pread_pipelined (int fd, gdb::byte_vector &buf,
+					      int len, ULONGEST offset,
+					      fileio_error *remote_errno)
+{
+  /* Leave room for the reply header, and for some escaped bytes, so
+     that replies are rarely short.  */
+  int chunk = get_remote_packet_size () - 32;
+  chunk -= chunk / 16;
+  if (chunk <= 0)
+    {
+      /* The packet is too small for that; just do a single read.  */
+      buf.resize (get_remote_packet_size ());
+      return remote_hostio_pread_vFile (fd, buf.data (), buf.size (),
+					offset, remote_errno);
+    }
+
+  int count = std::min<ULONGEST> ((len + chunk - 1) / chunk,
+				  remote_hostio_pread_window);
+
+  buf.resize ((size_t) count * chunk);
+
+  std::vector<std::string> requests;
+  for (int i = 0; i < count; i++)
+    {
+      char request[64];
+      char *p = request;
+      int left = sizeof (request);
+
+      remote_buffer_add_string (&p, &left, "vFile:pread:");
+      remote_buffer_add_int (&p, &left, fd);
+      remote_buffer_add_string (&p, &left, ",");
+      remote_buffer_add_int (&p, &left, chunk);
+      remote_buffer_add_string (&p, &left, ",");
+      remote_buffer_add_int (&p, &left, offset + (ULONGEST) i * chunk);
+
+      requests.emplace_back (request, p - request);
+    }
+
+  int total = 0;
+  fileio_error first_errno = FILEIO_SUCCESS;
+  pipeline_requests (requests, count, [&] (int index, int bytes_read)
+    {
+      const char *attachment;
+      int attachment_len;
+      fileio_error reply_errno;
+
+      int ret = remote_hostio_parse_reply (bytes_read, PACKET_vFile_pread,
+					   &reply_errno, &attachment,
+					   &attachment_len);
+      if (ret < 0)
+	{
+	  first_errno = reply_errno;
+	  return false;
+	}
+
+      int read_len = remote_unescape_input ((gdb_byte *) attachment,
+					    attachment_len,
+					    buf.data () + total, chunk);
+      if (read_len != ret)
+	{
+	  first_errno = FILEIO_EINVAL;
+	  return false;
+	}
+
+      total += ret;
+      return ret == chunk;
+    });
+
+  if (total == 0 && first_errno != FILEIO_SUCCESS)
+    {
+      *remote_errno = first_errno;
+      return -1;
+    }
+
+  buf.resize (total);
+  return total;
+}
+
 /* See declaration.h.  */
 
 int
@@ -13014,11 +13897,26 @@ remote_target::remote_hostio_pread (int fd, gdb_byte *read_buf, int len,
 
   cache->fd = fd;
   cache->offset = offset;
-  cache->buf.resize (get_remote_packet_size ());
 
-  ret = remote_hostio_pread_vFile (cache->fd, &cache->buf[0],
-				   cache->buf.size (),
-				   cache->offset, remote_errno);
+  /* Only pipeline reads that need more than one packet.  Pipelining
+     relies on the stub not acknowledging each packet.  A stub that
+     supports QPipelining accepts pipelined vFile:pread requests too.  */
+  if (len > get_remote_packet_size ()
+      && remote_hostio_pread_window > 1
+      && rs->noack_mode
+      && ((m_features.packet_support (PACKET_vFile_pread_pipelined)
+	   == PACKET_ENABLE)
+	  || m_features.packet_support (PACKET_QPipelining) == PACKET_ENABLE)
+      && m_features.packet_support (PACKET_vFile_pread) != PACKET_DISABLE)
+    ret = remote_hostio_pread_pipelined (cache->fd, cache->buf, len,
+					 cache->offset, remote_errno);
+  else
+    {
+      cache->buf.resize (get_remote_packet_size ());
+      ret = remote_hostio_pread_vFile (cache->fd, &cache->buf[0],
+				       cache->buf.size (),
+				       cache->offset, remote_errno);
+    }
   if (ret <= 0)
     {
       cache->invalidate_fd (fd);
@@ -13492,9 +14390,11 @@ remote_target::remote_file_get (const char *remote_file, const char *local_file,
   if (file == NULL)
     perror_with_name (local_file);
 
-  /* Send up to this many bytes at once.  They won't all fit in the
-     remote packet limit, so we'll transfer slightly fewer.  */
-  io_size = get_remote_packet_size ();
+  /* Ask for up to this many bytes at once.  They won't all fit in the
+     remote packet limit, so we'll transfer slightly fewer, possibly
+     spread over several pipelined requests.  */
+  io_size = (get_remote_packet_size ()
+	     * std::max (1u, remote_hostio_pread_window));
   gdb::byte_vector buffer (io_size);
 
   offset = 0;
@@ -14430,6 +15330,28 @@ remote_target::set_circular_trace_buffer (int val)
     error (_("Bogus reply from target: %s"), reply);
 }
 
+void
+remote_target::set_compact_trace_buffer (int val)
+{
+  struct remote_state *rs = get_remote_state ();
+  char *reply;
+
+  xsnprintf (rs->buf.data (), get_remote_packet_size (),
+	     "QTBuffer:compact:%x", val);
+  putpkt (rs->buf);
+  reply = remote_get_noisy_reply ();
+  if (*reply == '\0')
+    {
+      /* Targets that do not know about compact trace buffers store
+	 traceframes as they are, which is what VAL 0 asks for.  */
+      if (val != 0)
+	error (_("Target does not support compact trace buffers."));
+      return;
+    }
+  if (strcmp (reply, "OK") != 0)
+    error (_("Bogus reply from target: %s"), reply);
+}
+
 traceframe_info_up
 remote_target::traceframe_info ()
 {
@@ -15475,6 +16397,207 @@ remote_target::supports_set_thread_options (gdb_thread_options options)
 	  && (rs->supported_thread_options & options) == options);
 }
 
+/* Tell the remote stub, with QExpedite, which registers and how much
+   stack memory GDB wants in stop replies, if that changed since the
+   last time.  */
+
+void
+remote_target::commit_expedite_profile ()
+{
+  struct remote_state *rs = get_remote_state ();
+
+  if (m_features.packet_support (PACKET_QExpedite) != PACKET_ENABLE)
+    return;
+
+  gdbarch *gdbarch = current_inferior ()->arch ();
+  remote_arch_state *rsa = rs->get_remote_arch_state (gdbarch);
+  std::string packet = "QExpedite:";
+
+  if (remote_expedite_registers != expedite_registers_default)
+    {
+      const char *sep = "";
+
+      for (int regnum = 0; regnum < gdbarch_num_regs (gdbarch); regnum++)
+	{
+	  if (rsa->regs[regnum].pnum == -1)
+	    continue;
+
+	  if (remote_expedite_registers == expedite_registers_general
+	      && !gdbarch_register_reggroup_p (gdbarch, regnum,
+					       general_reggroup))
+	    continue;
+
+	  packet += string_printf ("%s%x", sep,
+				   (int) rsa->regs[regnum].pnum);
+	  sep = ",";
+	}
+    }
+
+  int sp_regnum = gdbarch_sp_regnum (gdbarch);
+  if (remote_expedite_stack_bytes > 0
+      && sp_regnum >= 0
+      && sp_regnum < gdbarch_num_regs (gdbarch)
+      && rsa->regs[sp_regnum].pnum != -1)
+    packet += string_printf (";stack:%x,%x",
+			     (int) rsa->regs[sp_regnum].pnum,
+			     remote_expedite_stack_bytes);
+
+  if (packet == rs->last_expedite_packet)
+    return;
+
+  putpkt (packet.c_str ());
+  getpkt (&rs->buf);
+
+  packet_result result = m_features.packet_ok (rs->buf, PACKET_QExpedite);
+  if (result.status () == PACKET_OK)
+    rs->last_expedite_packet = std::move (packet);
+  else if (result.status () == PACKET_ERROR)
+    warning (_("Remote failure reply to QExpedite: %s"), result.err_msg ());
+}
+
+/* Read LEN bytes at MEMADDR into MYADDR from the stack memory the stub
+   sent before GDB asked for it, if it has the first byte.  Set
+   *XFERED_LEN to the number of bytes read, which may be less than LEN,
+   and return true.  Return false if the memory must be read from the
+   target.  */
+
+bool
+remote_target::read_stack_blocks (CORE_ADDR memaddr, gdb_byte *myaddr,
+				  ULONGEST len, ULONGEST *xfered_len)
+{
+  struct remote_state *rs = get_remote_state ();
+
+  if (rs->stack_blocks.empty ()
+      || rs->stack_blocks_pid != inferior_ptid.pid ()
+      || get_traceframe_number () != -1)
+    return false;
+
+  auto it = rs->stack_blocks.upper_bound (memaddr);
+  if (it == rs->stack_blocks.begin ())
+    return false;
+  --it;
+
+  const gdb::byte_vector &block = it->second;
+  if (memaddr >= it->first + block.size ())
+    return false;
+
+  ULONGEST offset = memaddr - it->first;
+  *xfered_len = std::min<ULONGEST> (len, block.size () - offset);
+  memcpy (myaddr, block.data () + offset, *xfered_len);
+  return true;
+}
+
+/* How much memory qFramePrefetch asks for below and above each frame
+   pointer, which covers the registers most functions save, and the
+   return address.  The blocks are aligned like the lines of GDB's
+   stack cache, so that the lines it reads are wholly in them.  */
+static const int remote_frame_prefetch_before = 64;
+static const int remote_frame_prefetch_after = 128;
+static const int remote_frame_prefetch_align = 64;
+
+/* The most frames qFramePrefetch asks the stub to walk.  */
+static const int remote_frame_prefetch_count = 64;
+
+/* If MEMADDR is in the stack of the current thread, ask the stub with
+   qFramePrefetch for the memory of the thread's frames, found by
+   walking its frame pointer chain, once per thread each time the
+   target stops.  GDB's own unwinders then read the frames from that
+   memory, so a stub walking a chain that isn't there only costs a
+   round trip.  Return true if anything was added to the cached stack
+   memory.  */
+
+bool
+remote_target::prefetch_frames (CORE_ADDR memaddr)
+{
+  struct remote_state *rs = get_remote_state ();
+
+  if (m_features.packet_support (PACKET_qFramePrefetch) == PACKET_DISABLE
+      || target_is_non_stop_p ()
+      || inferior_ptid == null_ptid
+      || get_traceframe_number () != -1
+      || rs->frames_prefetched.count (inferior_ptid) != 0)
+    return false;
+
+  thread_info *thr = this->find_thread (inferior_ptid);
+  if (thr == nullptr || thr->executing ())
+    return false;
+
+  regcache *regcache = get_thread_regcache (thr);
+  gdbarch *gdbarch = regcache->arch ();
+  remote_arch_state *rsa = rs->get_remote_arch_state (gdbarch);
+  int fp_regnum = gdbarch_frame_pointer_regnum (gdbarch);
+  int sp_regnum = gdbarch_sp_regnum (gdbarch);
+
+  /* Unwinding starts with reading the registers, so don't fetch them
+     here just to find out whether MEMADDR is in the stack.  */
+  if (fp_regnum < 0 || fp_regnum >= gdbarch_num_regs (gdbarch)
+      || rsa->regs[fp_regnum].pnum == -1
+      || sp_regnum < 0 || sp_regnum >= gdbarch_num_regs (gdbarch)
+      || regcache->get_register_status (sp_regnum) != REG_VALID)
+    return false;
+
+  ULONGEST sp;
+  regcache_cooked_read_unsigned (regcache, sp_regnum, &sp);
+  if (gdbarch_inner_than (gdbarch, memaddr, sp))
+    return false;
+
+  rs->frames_prefetched.insert (inferior_ptid);
+
+  char *p = rs->buf.data ();
+  char *endp = p + get_remote_packet_size ();
+
+  strcpy (p, "qFramePrefetch:");
+  p += strlen (p);
+  p = write_ptid (p, endp, inferior_ptid);
+  xsnprintf (p, endp - p, ",%x,%x,%x,%x,%x",
+	     (int) rsa->regs[fp_regnum].pnum,
+	     remote_frame_prefetch_before, remote_frame_prefetch_after,
+	     remote_frame_prefetch_align, remote_frame_prefetch_count);
+
+  putpkt (rs->buf);
+  getpkt (&rs->buf);
+
+  /* This is only a hint, so errors are ignored.  */
+  packet_result result = m_features.packet_ok (rs->buf,
+					       PACKET_qFramePrefetch);
+  if (result.status () != PACKET_OK
+      || strcmp (rs->buf.data (), "OK") == 0)
+    return false;
+
+  if (rs->stack_blocks_pid != inferior_ptid.pid ())
+    {
+      rs->stack_blocks.clear ();
+      rs->stack_blocks_pid = inferior_ptid.pid ();
+    }
+
+  bool added = false;
+  const char *q = rs->buf.data ();
+  while (*q != '\0')
+    {
+      ULONGEST addr;
+
+      q = unpack_varlen_hex (q, &addr);
+      if (*q != ':')
+	break;
+      q++;
+
+      const char *end = strchrnul (q, ';');
+      gdb::byte_vector bytes ((end - q) / 2);
+      if (bytes.empty ()
+	  || hex2bin (q, bytes.data (), bytes.size ()) != (int) bytes.size ())
+	break;
+
+      add_stack_block (&rs->stack_blocks, addr, std::move (bytes));
+      added = true;
+
+      q = end;
+      if (*q == ';')
+	q++;
+    }
+
+  return added;
+}
+
 /* For coalescing reasons, actually sending the options to the target
    happens at resume time, via this function.  See target_resume for
    all-stop, and target_commit_resumed for non-stop.  */
@@ -16136,6 +17259,93 @@ test_packet_check_result ()
 
   SELF_CHECK (packet_check_result ("").status () == PACKET_UNKNOWN);
 }
+
+static void
+test_apply_threads_delta ()
+{
+  std::vector<remote_delta_thread> threads;
+  ULONGEST generation = 0;
+
+  /* The whole list.  "6d61696e" is "main".  */
+  SELF_CHECK (apply_threads_delta ("F1\n"
+				   "+p10.10;3;6d61696e;\n"
+				   "+p10.11;;;0102\n"
+				   "+p10.12;1;;\n",
+				   &threads, &generation));
+  SELF_CHECK (generation == 1);
+  SELF_CHECK (threads.size () == 3);
+  SELF_CHECK (threads[0].ptid == ptid_t (0x10, 0x10));
+  SELF_CHECK (threads[0].core == 3);
+  SELF_CHECK (threads[0].name == "main");
+  SELF_CHECK (threads[1].core == -1);
+  SELF_CHECK (threads[1].thread_handle.size () == 2);
+  SELF_CHECK (threads[1].thread_handle[1] == 2);
+
+  /* A thread exits, another one moves, and a new one appears at the
+     end.  */
+  SELF_CHECK (apply_threads_delta ("D2\n"
+				   "+p10.12;2;;\n"
+				   "+p10.13;;;\n"
+				   "-p10.11\n",
+				   &threads, &generation));
+  SELF_CHECK (generation == 2);
+  SELF_CHECK (threads.size () == 3);
+  SELF_CHECK (threads[0].ptid == ptid_t (0x10, 0x10));
+  SELF_CHECK (threads[0].name == "main");
+  SELF_CHECK (threads[1].ptid == ptid_t (0x10, 0x12));
+  SELF_CHECK (threads[1].core == 2);
+  SELF_CHECK (threads[2].ptid == ptid_t (0x10, 0x13));
+
+  /* An empty delta.  */
+  SELF_CHECK (apply_threads_delta ("D3\n", &threads, &generation));
+  SELF_CHECK (generation == 3);
+  SELF_CHECK (threads.size () == 3);
+
+  /* The whole list again replaces everything.  */
+  SELF_CHECK (apply_threads_delta ("F4\n+p10.10;;;\n",
+				   &threads, &generation));
+  SELF_CHECK (threads.size () == 1);
+
+  /* Malformed replies.  */
+  SELF_CHECK (!apply_threads_delta ("", &threads, &generation));
+  SELF_CHECK (!apply_threads_delta ("X1\n", &threads, &generation));
+  SELF_CHECK (!apply_threads_delta ("D5\n+p10.10\n",
+				    &threads, &generation));
+  SELF_CHECK (!apply_threads_delta ("D5\n+p10.10;;6;\n",
+				    &threads, &generation));
+  SELF_CHECK (!apply_threads_delta ("D5\n*p10.10\n",
+				    &threads, &generation));
+}
+
+static void
+test_add_stack_block ()
+{
+  std::map<CORE_ADDR, gdb::byte_vector> blocks;
+
+  add_stack_block (&blocks, 0x100, gdb::byte_vector {1, 2, 3, 4});
+  add_stack_block (&blocks, 0x200, gdb::byte_vector {9});
+  SELF_CHECK (blocks.size () == 2);
+
+  /* Overlapping the end of a block, and touching the next one.  */
+  add_stack_block (&blocks, 0x102, gdb::byte_vector {3, 4, 5});
+  SELF_CHECK (blocks.size () == 2);
+  SELF_CHECK (blocks[0x100] == (gdb::byte_vector {1, 2, 3, 4, 5}));
+
+  /* Touching the start of a block.  */
+  add_stack_block (&blocks, 0x1fe, gdb::byte_vector {7, 8});
+  SELF_CHECK (blocks.size () == 2);
+  SELF_CHECK (blocks[0x1fe] == (gdb::byte_vector {7, 8, 9}));
+
+  /* Within a block.  */
+  add_stack_block (&blocks, 0x101, gdb::byte_vector {2});
+  SELF_CHECK (blocks.size () == 2);
+  SELF_CHECK (blocks[0x100].size () == 5);
+
+  /* Covering both blocks and the gap between them.  */
+  add_stack_block (&blocks, 0xff, gdb::byte_vector (0x103, 0));
+  SELF_CHECK (blocks.size () == 1);
+  SELF_CHECK (blocks[0xff].size () == 0x103);
+}
 } // namespace selftests
 #endif /* GDB_SELF_TEST */
 
@@ -16245,6 +17455,12 @@ further restriction and \"limit\" to enable that restriction."),
 	   show_memory_read_packet_size,
 	   _("Show the maximum number of bytes per memory-read packet."),
 	   &remote_show_cmdlist);
+  add_cmd ("compression-stats", no_class,
+	   show_remote_compression_stats,
+	   _("Show compression statistics for the remote connection.\n\
+Shows how many bytes were sent and received over the current remote\n\
+connection, before and after compression."),
+	   &remote_show_cmdlist);
 
   add_setshow_zuinteger_unlimited_cmd ("hardware-watchpoint-limit", no_class,
 			    &remote_hw_watchpoint_limit, _("\
@@ -16270,6 +17486,52 @@ Specify \"unlimited\" for unlimited hardware breakpoints."),
 			    NULL, show_hardware_breakpoint_limit,
 			    &remote_set_cmdlist, &remote_show_cmdlist);
 
+  add_setshow_zuinteger_cmd ("hostio-pread-window", class_obscure,
+			     &remote_hostio_pread_window, _("\
+Set the maximum number of outstanding vFile:pread requests."), _("\
+Show the maximum number of outstanding vFile:pread requests."), _("\
+When the remote stub supports it, large reads of remote files are split\n\
+into this many vFile:pread requests that are sent without waiting for\n\
+each reply.  A value of 0 or 1 disables pipelining."),
+			     NULL, NULL,
+			     &remote_set_cmdlist, &remote_show_cmdlist);
+
+  add_setshow_zuinteger_cmd ("pipeline-depth", class_obscure,
+			     &remote_pipeline_depth, _("\
+Set the maximum number of outstanding independent remote requests."), _("\
+Show the maximum number of outstanding independent remote requests."), _("\
+When the remote stub supports QPipelining, reads of memory and of qXfer\n\
+objects that need several packets send up to this many requests without\n\
+waiting for each reply.  A value of 0 or 1 disables pipelining."),
+			     NULL, NULL,
+			     &remote_set_cmdlist, &remote_show_cmdlist);
+
+  add_setshow_enum_cmd ("expedite-registers", class_obscure,
+			expedite_registers_modes, &remote_expedite_registers,
+			_("\
+Set which registers the remote stub includes in stop replies."), _("\
+Show which registers the remote stub includes in stop replies."), _("\
+When the remote stub supports QExpedite, GDB asks it to include these\n\
+registers of the thread that stopped in each stop reply, which saves\n\
+fetching them separately afterwards.\n\
+  general  - The registers in the \"general\" register group.\n\
+  all      - All the registers.\n\
+  default  - Only those the stub includes by default, usually the\n\
+	     program counter, stack pointer and frame pointer."),
+			NULL, NULL,
+			&remote_set_cmdlist, &remote_show_cmdlist);
+
+  add_setshow_zuinteger_cmd ("expedite-stack-bytes", class_obscure,
+			     &remote_expedite_stack_bytes, _("\
+Set how much stack memory the remote stub includes in stop replies."), _("\
+Show how much stack memory the remote stub includes in stop replies."), _("\
+When the remote stub supports QExpedite, GDB asks it to include this\n\
+many bytes of memory at the stack pointer of the thread that stopped\n\
+in each stop reply, and reads them from there instead of from the\n\
+target until the target is resumed.  Zero means none."),
+			     NULL, NULL,
+			     &remote_set_cmdlist, &remote_show_cmdlist);
+
   add_setshow_zuinteger_cmd ("remoteaddresssize", class_obscure,
 			     &remote_address_size, _("\
 Set the maximum size of the address (in bits) in a memory packet."), _("\
@@ -16349,6 +17611,9 @@ Show the maximum size of the address (in bits) in a memory packet."), NULL,
   add_packet_config_cmd (PACKET_qXfer_threads, "qXfer:threads:read", "threads",
 			 0);
 
+  add_packet_config_cmd (PACKET_qXfer_threads_delta,
+			 "qXfer:threads-delta:read", "threads-delta", 0);
+
   add_packet_config_cmd (PACKET_qXfer_siginfo_read, "qXfer:siginfo:read",
 			 "read-siginfo-object", 0);
 
@@ -16514,6 +17779,17 @@ Show the maximum size of the address (in bits) in a memory packet."), NULL,
   add_packet_config_cmd (PACKET_qIsAddressTagged,
 			 "qIsAddressTagged", "memory-tagging-address-check", 0);
 
+  add_packet_config_cmd (PACKET_vFile_pread_pipelined,
+			 "vFile:pread-pipelined", "hostio-pread-pipelined", 0);
+
+  add_packet_config_cmd (PACKET_compression, "compression", "compression", 0);
+
+  add_packet_config_cmd (PACKET_QPipelining, "QPipelining", "pipelining", 0);
+
+  add_packet_config_cmd (PACKET_QExpedite, "QExpedite", "expedite", 0);
+  add_packet_config_cmd (PACKET_qFramePrefetch, "qFramePrefetch",
+			 "frame-prefetch", 0);
+
   add_packet_config_cmd (PACKET_accept_error_message,
 			 "error-message", "error-message", 0);
 
@@ -16652,6 +17928,10 @@ from the target."),
 #if GDB_SELF_TEST
   selftests::register_test ("remote_memory_tagging",
 			    selftests::test_memory_tagging_functions);
+  selftests::register_test ("apply_threads_delta",
+			    selftests::test_apply_threads_delta);
+  selftests::register_test ("add_stack_block",
+			    selftests::test_add_stack_block);
   selftests::register_test ("packet_check_result",
 			    selftests::test_packet_check_result);
 #endif
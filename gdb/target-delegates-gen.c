@@ -111,6 +111,7 @@ struct dummy_target : public target_ops
   bool always_non_stop_p () override;
   int find_memory_regions (find_memory_region_ftype arg0, void *arg1) override;
   gdb::unique_xmalloc_ptr<char> make_corefile_notes (bfd *arg0, int *arg1) override;
+  int memory_fd () override;
   gdb_byte *get_bookmark (const char *arg0, int arg1) override;
   void goto_bookmark (const gdb_byte *arg0, int arg1) override;
   CORE_ADDR get_thread_local_address (ptid_t arg0, CORE_ADDR arg1, CORE_ADDR arg2) override;
@@ -155,6 +156,7 @@ struct dummy_target : public target_ops
   int get_min_fast_tracepoint_insn_len () override;
   void set_disconnected_tracing (int arg0) override;
   void set_circular_trace_buffer (int arg0) override;
+  void set_compact_trace_buffer (int arg0) override;
   void set_trace_buffer_size (LONGEST arg0) override;
   bool set_trace_notes (const char *arg0, const char *arg1, const char *arg2) override;
   int core_of_thread (ptid_t arg0) override;
@@ -288,6 +290,7 @@ struct debug_target : public target_ops
   bool always_non_stop_p () override;
   int find_memory_regions (find_memory_region_ftype arg0, void *arg1) override;
   gdb::unique_xmalloc_ptr<char> make_corefile_notes (bfd *arg0, int *arg1) override;
+  int memory_fd () override;
   gdb_byte *get_bookmark (const char *arg0, int arg1) override;
   void goto_bookmark (const gdb_byte *arg0, int arg1) override;
   CORE_ADDR get_thread_local_address (ptid_t arg0, CORE_ADDR arg1, CORE_ADDR arg2) override;
@@ -332,6 +335,7 @@ struct debug_target : public target_ops
   int get_min_fast_tracepoint_insn_len () override;
   void set_disconnected_tracing (int arg0) override;
   void set_circular_trace_buffer (int arg0) override;
+  void set_compact_trace_buffer (int arg0) override;
   void set_trace_buffer_size (LONGEST arg0) override;
   bool set_trace_notes (const char *arg0, const char *arg1, const char *arg2) override;
   int core_of_thread (ptid_t arg0) override;
@@ -2310,6 +2314,30 @@ debug_target::make_corefile_notes (bfd *arg0, int *arg1)
   return result;
 }
 
+int
+target_ops::memory_fd ()
+{
+  return this->beneath ()->memory_fd ();
+}
+
+int
+dummy_target::memory_fd ()
+{
+  return -1;
+}
+
+int
+debug_target::memory_fd ()
+{
+  target_debug_printf_nofunc ("-> %s->memory_fd (...)", this->beneath ()->shortname ());
+  int result
+    = this->beneath ()->memory_fd ();
+  target_debug_printf_nofunc ("<- %s->memory_fd () = %s",
+	      this->beneath ()->shortname (),
+	      target_debug_print_int (result).c_str ());
+  return result;
+}
+
 gdb_byte *
 target_ops::get_bookmark (const char *arg0, int arg1)
 {
@@ -3369,6 +3397,27 @@ debug_target::set_circular_trace_buffer (int arg0)
 	      target_debug_print_int (arg0).c_str ());
 }
 
+void
+target_ops::set_compact_trace_buffer (int arg0)
+{
+  this->beneath ()->set_compact_trace_buffer (arg0);
+}
+
+void
+dummy_target::set_compact_trace_buffer (int arg0)
+{
+}
+
+void
+debug_target::set_compact_trace_buffer (int arg0)
+{
+  target_debug_printf_nofunc ("-> %s->set_compact_trace_buffer (...)", this->beneath ()->shortname ());
+  this->beneath ()->set_compact_trace_buffer (arg0);
+  target_debug_printf_nofunc ("<- %s->set_compact_trace_buffer (%s)",
+	      this->beneath ()->shortname (),
+	      target_debug_print_int (arg0).c_str ());
+}
+
 void
 target_ops::set_trace_buffer_size (LONGEST arg0)
 {
@@ -429,6 +429,14 @@ target_make_corefile_notes (bfd *bfd, int *size_p)
   return current_inferior ()->top_target ()->make_corefile_notes (bfd, size_p);
 }
 
+/* See target.h.  */
+
+int
+target_memory_fd ()
+{
+  return current_inferior ()->top_target ()->memory_fd ();
+}
+
 gdb_byte *
 target_get_bookmark (const char *args, int from_tty)
 {
@@ -720,6 +728,12 @@ target_set_circular_trace_buffer (int val)
   return current_inferior ()->top_target ()->set_circular_trace_buffer (val);
 }
 
+void
+target_set_compact_trace_buffer (int val)
+{
+  return current_inferior ()->top_target ()->set_compact_trace_buffer (val);
+}
+
 void
 target_set_trace_buffer_size (LONGEST val)
 {
@@ -185,6 +185,11 @@ enum target_object
   TARGET_OBJECT_SIGNAL_INFO,
   /* The list of threads that are being debugged.  */
   TARGET_OBJECT_THREADS,
+  /* The changes to the list of threads since a previous read of this
+     object, in the compact format of qXfer:threads-delta.  ANNEX is
+     the generation number returned by that read, in hexadecimal, or
+     "0" for the whole list.  */
+  TARGET_OBJECT_THREADS_DELTA,
   /* Collected static trace data.  */
   TARGET_OBJECT_STATIC_TRACE_DATA,
   /* Traceframe info, in XML format.  */
@@ -775,6 +780,13 @@ struct target_ops
     /* make_corefile_notes support method for gcore */
     virtual gdb::unique_xmalloc_ptr<char> make_corefile_notes (bfd *, int *)
       TARGET_DEFAULT_FUNC (dummy_make_corefile_notes);
+    /* Return a file descriptor from which the memory of the current
+       inferior can be read with pread, using addresses as offsets, or
+       -1.  The descriptor remains owned by the target.  It may be read
+       from several threads at once, while the inferior is stopped;
+       gcore uses it to read memory in parallel.  */
+    virtual int memory_fd ()
+      TARGET_DEFAULT_RETURN (-1);
     /* get_bookmark support method for bookmarks */
     virtual gdb_byte *get_bookmark (const char *, int)
       TARGET_DEFAULT_NORETURN (tcomplain ());
@@ -1134,6 +1146,11 @@ struct target_ops
       TARGET_DEFAULT_IGNORE ();
     virtual void set_circular_trace_buffer (int val)
       TARGET_DEFAULT_IGNORE ();
+    /* Set whether the target stores traceframes compactly - set VAL
+       to 1 to deduplicate and delta-encode the data it collects, 0 to
+       store it as it is.  */
+    virtual void set_compact_trace_buffer (int val)
+      TARGET_DEFAULT_IGNORE ();
     /* Set the size of trace buffer in the target.  */
     virtual void set_trace_buffer_size (LONGEST val)
       TARGET_DEFAULT_IGNORE ();
@@ -2017,6 +2034,10 @@ extern int target_find_memory_regions (find_memory_region_ftype func,
 extern gdb::unique_xmalloc_ptr<char> target_make_corefile_notes (bfd *bfd,
 								 int *size_p);
 
+/* See target_ops::memory_fd.  */
+
+extern int target_memory_fd ();
+
 /* Bookmark interfaces.  */
 extern gdb_byte *target_get_bookmark (const char *args, int from_tty);
 
@@ -2333,6 +2354,8 @@ extern void target_set_disconnected_tracing (int val);
 
 extern void target_set_circular_trace_buffer (int val);
 
+extern void target_set_compact_trace_buffer (int val);
+
 extern void target_set_trace_buffer_size (LONGEST val);
 
 extern bool target_set_trace_notes (const char *user, const char *notes,
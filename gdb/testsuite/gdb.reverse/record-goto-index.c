@@ -0,0 +1,44 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2026 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#define N 64
+
+int array[N];
+volatile int sink;
+
+void
+checkpoint (int i)
+{
+  sink = i;
+}
+
+int
+main (void)
+{
+  int i, j;
+
+  /* Each pass of the outer loop runs more than 1024 instructions, the
+     interval between positions in the record-full index.  */
+  for (i = 0; i < 40; i++)
+    {
+      for (j = 0; j < N; j++)
+	array[j] += i + j;
+      checkpoint (i);
+    }
+
+  return 0;
+}
@@ -0,0 +1,41 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2026 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+/* Fill a stack array in each of several frames, so that the values
+   GDB shows come from stack memory.  */
+
+static int
+callee (int depth, int seed)
+{
+  volatile int local[16];
+  int i;
+
+  for (i = 0; i < 16; i++)
+    local[i] = seed + i;
+
+  if (depth > 0)
+    return callee (depth - 1, seed + 100) + local[3];
+
+  return local[5]; /* Break here.  */
+}
+
+int
+main (void)
+{
+  return callee (3, 0) == 305 + 203 + 103 + 3 ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2026 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#define DEPTH 40
+
+/* Recurse DEPTH frames deep, with a stack variable in each frame.  */
+
+static int __attribute__ ((noinline))
+recurse (int depth, int seed)
+{
+  volatile int local = seed + depth;
+
+  if (depth > 0)
+    return recurse (depth - 1, seed) + local;
+
+  return local; /* Break here.  */
+}
+
+int
+main (void)
+{
+  int a = recurse (DEPTH, 1000);
+  int b = recurse (DEPTH, 2000);
+
+  return a + b == 0;
+}
@@ -0,0 +1,86 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2026 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define NUM_THREADS 4
+
+static pthread_barrier_t barrier;
+
+static void *
+thread_function (void *arg)
+{
+  char name[16];
+
+  pthread_barrier_wait (&barrier);
+
+  /* Only change the name once the main thread has been stopped in
+     all_started.  */
+  pthread_barrier_wait (&barrier);
+  snprintf (name, sizeof (name), "worker-%d", (int) (long) arg);
+  pthread_setname_np (pthread_self (), name);
+  pthread_barrier_wait (&barrier);
+
+  pthread_barrier_wait (&barrier);
+  return NULL;
+}
+
+static void
+all_started (void)
+{
+}
+
+static void
+all_named (void)
+{
+}
+
+static void
+all_exited (void)
+{
+}
+
+int
+main (void)
+{
+  pthread_t threads[NUM_THREADS];
+  long i;
+
+  alarm (300);
+
+  pthread_barrier_init (&barrier, NULL, NUM_THREADS + 1);
+
+  for (i = 0; i < NUM_THREADS; i++)
+    pthread_create (&threads[i], NULL, thread_function, (void *) i);
+
+  pthread_barrier_wait (&barrier);
+  all_started ();
+
+  pthread_barrier_wait (&barrier);
+  pthread_barrier_wait (&barrier);
+  all_named ();
+
+  pthread_barrier_wait (&barrier);
+  for (i = 0; i < NUM_THREADS; i++)
+    pthread_join (threads[i], NULL);
+  all_exited ();
+
+  return 0;
+}
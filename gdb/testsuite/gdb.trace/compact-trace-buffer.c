@@ -0,0 +1,43 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2026 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#define NUM_HITS 20
+
+/* Collected on every hit; only COUNTER changes between hits.  */
+int counter;
+unsigned char buf[256];
+
+static void __attribute__ ((noinline))
+test_function (int i)
+{
+  counter += i;
+}
+
+int
+main (void)
+{
+  int i;
+
+  for (i = 0; i < sizeof (buf); i++)
+    buf[i] = i;
+
+  for (i = 0; i < NUM_HITS; i++)
+    test_function (i);
+
+  return 0; /* Break here.  */
+}
@@ -51,6 +51,11 @@
 #include "stack.h"
 #include "interps.h"
 #include "record-full.h"
+#include "gdbsupport/unordered_map.h"
+#include "gdbsupport/selftest.h"
+#include "scoped-mock-context.h"
+#include "test-target.h"
+#include <chrono>
 
 /* See gdbthread.h.  */
 
@@ -71,6 +76,18 @@ show_debug_threads (struct ui_file *file, int from_tty,
 
 static int highest_thread_num;
 
+/* Map of global thread number to thread, for all thread objects
+   alive.  Threads that are no longer in their inferior's thread list
+   (but not deleted yet because something still holds a reference)
+   are filtered out at lookup time.  */
+
+static gdb::unordered_map<int, thread_info *> global_thread_map;
+
+/* Number of thread objects alive that are not in THREAD_EXITED
+   state.  Avoids walking all thread lists to count live threads.  */
+
+static int live_thread_count;
+
 /* The current/selected thread.  */
 static thread_info *current_thread_;
 
@@ -240,6 +257,7 @@ set_thread_exited (thread_info *tp, std::optional<ULONGEST> exit_code,
 
       /* Tag it as exited.  */
       tp->state = THREAD_EXITED;
+      --live_thread_count;
 
       /* Clear breakpoints, etc. associated with this thread.  */
       clear_thread_inferior_resources (tp);
@@ -251,6 +269,8 @@ set_thread_exited (thread_info *tp, std::optional<ULONGEST> exit_code,
 	 would overwrite the exited thread's ptid entry.  */
       size_t nr_deleted = tp->inf->ptid_thread_map.erase (tp->ptid);
       gdb_assert (nr_deleted == 1);
+      if (proc_target != nullptr)
+	proc_target->remove_thread_from_map (tp);
     }
 }
 
@@ -281,6 +301,10 @@ new_thread (struct inferior *inf, ptid_t ptid)
 
   inf->ptid_thread_map[ptid] = tp;
 
+  process_stratum_target *proc_target = inf->process_target ();
+  if (proc_target != nullptr)
+    proc_target->add_thread_to_map (tp);
+
   return tp;
 }
 
@@ -349,6 +373,9 @@ thread_info::thread_info (struct inferior *inf_, ptid_t ptid_)
   this->global_num = ++highest_thread_num;
   this->per_inf_num = ++inf_->highest_thread_num;
 
+  global_thread_map[this->global_num] = this;
+  ++live_thread_count;
+
   /* Nothing to follow yet.  */
   this->pending_follow.set_spurious ();
 }
@@ -358,6 +385,10 @@ thread_info::thread_info (struct inferior *inf_, ptid_t ptid_)
 thread_info::~thread_info ()
 {
   threads_debug_printf ("thread %s", this->ptid.to_string ().c_str ());
+
+  global_thread_map.erase (this->global_num);
+  if (this->state != THREAD_EXITED)
+    --live_thread_count;
 }
 
 /* See gdbthread.h.  */
@@ -559,9 +590,12 @@ delete_thread_silent (thread_info *thread)
 struct thread_info *
 find_thread_global_id (int global_id)
 {
-  for (thread_info *tp : all_threads ())
-    if (tp->global_num == global_id)
-      return tp;
+  auto it = global_thread_map.find (global_id);
+
+  /* A thread removed from its inferior's thread list, but kept alive
+     by a reference, is no longer visible.  */
+  if (it != global_thread_map.end () && it->second->is_linked ())
+    return it->second;
 
   return NULL;
 }
@@ -634,18 +668,13 @@ thread_count (process_stratum_target *proc_target)
 static int
 live_threads_count (void)
 {
-  auto rng = all_non_exited_threads ();
-  return std::distance (rng.begin (), rng.end ());
+  return live_thread_count;
 }
 
 int
 valid_global_thread_id (int global_id)
 {
-  for (thread_info *tp : all_threads ())
-    if (tp->global_num == global_id)
-      return 1;
-
-  return 0;
+  return find_thread_global_id (global_id) != nullptr;
 }
 
 bool
@@ -846,9 +875,11 @@ thread_change_ptid (process_stratum_target *targ,
 
   int num_erased = inf->ptid_thread_map.erase (old_ptid);
   gdb_assert (num_erased == 1);
+  targ->remove_thread_from_map (tp);
 
   tp->ptid = new_ptid;
   inf->ptid_thread_map[new_ptid] = tp;
+  targ->add_thread_to_map (tp);
 
   gdb::observers::thread_ptid_changed.notify (targ, old_ptid, new_ptid);
 }
@@ -2288,6 +2319,133 @@ static const struct internalvar_funcs inferior_thread_count_funcs =
   NULL,
 };
 
+/* Implement "maintenance time-thread-lookups".  */
+
+static void
+maintenance_time_thread_lookups (const char *args, int from_tty)
+{
+  LONGEST iterations = 1000;
+  if (args != nullptr && *args != '\0')
+    iterations = parse_and_eval_long (args);
+  if (iterations <= 0)
+    error (_("Iteration count must be positive."));
+
+  /* Snapshot the lookup keys first, so that only the lookups
+     themselves are timed.  */
+  std::vector<std::pair<process_stratum_target *, ptid_t>> ptids;
+  std::vector<int> global_ids;
+  for (thread_info *tp : all_non_exited_threads ())
+    {
+      ptids.emplace_back (tp->inf->process_target (), tp->ptid);
+      global_ids.push_back (tp->global_num);
+    }
+
+  if (ptids.empty ())
+    error (_("No threads."));
+
+  using namespace std::chrono;
+
+  size_t found = 0;
+  steady_clock::time_point start = steady_clock::now ();
+  for (LONGEST i = 0; i < iterations; ++i)
+    for (const auto &[targ, ptid] : ptids)
+      found += targ->find_thread (ptid) != nullptr;
+  steady_clock::duration ptid_time = steady_clock::now () - start;
+
+  start = steady_clock::now ();
+  for (LONGEST i = 0; i < iterations; ++i)
+    for (int id : global_ids)
+      found += find_thread_global_id (id) != nullptr;
+  steady_clock::duration global_id_time = steady_clock::now () - start;
+
+  start = steady_clock::now ();
+  for (LONGEST i = 0; i < iterations; ++i)
+    for (thread_info *tp ATTRIBUTE_UNUSED : all_non_exited_threads ())
+      ++found;
+  steady_clock::duration walk_time = steady_clock::now () - start;
+
+  if (found != 3 * iterations * ptids.size ())
+    error (_("Thread lookups found %s threads instead of %s."),
+	   pulongest (found), pulongest (3 * iterations * ptids.size ()));
+
+  double lookups = (double) iterations * ptids.size ();
+  gdb_printf (_("%s threads, %s iterations.\n"),
+	      pulongest (ptids.size ()), plongest (iterations));
+  gdb_printf (_("Lookup by target and ptid: %.1f ns per lookup.\n"),
+	      duration<double, std::nano> (ptid_time).count () / lookups);
+  gdb_printf (_("Lookup by global thread number: %.1f ns per lookup.\n"),
+	      duration<double, std::nano> (global_id_time).count () / lookups);
+  gdb_printf (_("Walk of all non-exited threads: %.1f ns per thread.\n"),
+	      duration<double, std::nano> (walk_time).count () / lookups);
+}
+
+#if GDB_SELF_TEST
+namespace selftests {
+
+/* Check that the target-wide ptid map, the global thread number map
+   and the live thread count follow threads as they are added, change
+   ptid and exit, and as the process stratum target is unpushed,
+   pushed and replaced.  */
+
+static void
+thread_lookup_maps ()
+{
+  gdbarch *arch = current_inferior ()->arch ();
+
+  scoped_restore_current_pspace_and_thread restore;
+
+  test_target_ops other_target;
+  scoped_mock_context<test_target_ops> ctx (arch);
+  process_stratum_target *target = &ctx.mock_target;
+
+  /* The mock thread was in the inferior when the target was
+     pushed.  */
+  gdb_assert (target->find_thread (ctx.mock_ptid) == &ctx.mock_thread);
+  gdb_assert (find_thread_global_id (ctx.mock_thread.global_num)
+	      == &ctx.mock_thread);
+
+  int live = live_threads_count ();
+  ptid_t old_ptid (ctx.mock_ptid.pid (), 2);
+  ptid_t new_ptid (ctx.mock_ptid.pid (), 3);
+
+  thread_info *tp = add_thread_silent (target, old_ptid);
+  int global_num = tp->global_num;
+  gdb_assert (target->find_thread (old_ptid) == tp);
+  gdb_assert (find_thread_global_id (global_num) == tp);
+  gdb_assert (valid_global_thread_id (global_num));
+  gdb_assert (live_threads_count () == live + 1);
+
+  thread_change_ptid (target, old_ptid, new_ptid);
+  gdb_assert (target->find_thread (old_ptid) == nullptr);
+  gdb_assert (target->find_thread (new_ptid) == tp);
+  gdb_assert (find_thread_global_id (global_num) == tp);
+
+  delete_thread_silent (tp);
+  gdb_assert (target->find_thread (new_ptid) == nullptr);
+  gdb_assert (find_thread_global_id (global_num) == nullptr);
+  gdb_assert (!valid_global_thread_id (global_num));
+  gdb_assert (live_threads_count () == live);
+
+  /* Unpushing the target takes the inferior's threads out of its map,
+     and pushing it back puts them in again.  */
+  ctx.mock_inferior.unpush_target (target);
+  gdb_assert (target->find_thread (ctx.mock_ptid) == nullptr);
+  ctx.mock_inferior.push_target (target);
+  gdb_assert (target->find_thread (ctx.mock_ptid) == &ctx.mock_thread);
+
+  /* Pushing another target at the same stratum replaces the first one
+     without unpushing it, and must move the threads over.  */
+  ctx.mock_inferior.push_target (&other_target);
+  gdb_assert (target->find_thread (ctx.mock_ptid) == nullptr);
+  gdb_assert (other_target.find_thread (ctx.mock_ptid) == &ctx.mock_thread);
+  ctx.mock_inferior.push_target (target);
+  gdb_assert (other_target.find_thread (ctx.mock_ptid) == nullptr);
+  gdb_assert (target->find_thread (ctx.mock_ptid) == &ctx.mock_thread);
+}
+
+} /* namespace selftests */
+#endif /* GDB_SELF_TEST */
+
 void _initialize_thread ();
 void
 _initialize_thread ()
@@ -2402,8 +2560,22 @@ When on messages about thread creation and deletion are printed."),
 			   show_debug_threads,
 			   &setdebuglist, &showdebuglist);
 
+  add_cmd ("time-thread-lookups", class_maintenance,
+	   maintenance_time_thread_lookups, _("\
+Time the thread lookup and iteration primitives used by infrun.\n\
+Usage: maintenance time-thread-lookups [ITERATIONS]\n\
+Looks up every non-exited thread by target and ptid and by global\n\
+thread number, and walks the list of non-exited threads, ITERATIONS\n\
+times each (default 1000), then prints the average time per operation."),
+	   &maintenancelist);
+
   create_internalvar_type_lazy ("_thread", &thread_funcs, NULL);
   create_internalvar_type_lazy ("_gthread", &gthread_funcs, NULL);
   create_internalvar_type_lazy ("_inferior_thread_count",
 				&inferior_thread_count_funcs, NULL);
+
+#if GDB_SELF_TEST
+  selftests::register_test ("thread_lookup_maps",
+			    selftests::thread_lookup_maps);
+#endif
 }
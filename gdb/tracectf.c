@@ -959,6 +959,8 @@ ctf_read_status (struct bt_ctf_event *event, struct trace_status *ts)
   SET_INT32_FIELD (event, scope, ts, buffer_size);
   SET_INT32_FIELD (event, scope, ts, disconnected_tracing);
   SET_INT32_FIELD (event, scope, ts, circular_buffer);
+  ts->compact_buffer = 0;
+  ts->bytes_collected = ts->bytes_stored = -1;
 
   bt_iter_next (bt_ctf_get_iter (ctf_iter));
 }
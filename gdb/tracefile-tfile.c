@@ -507,6 +507,8 @@ tfile_target_open (const char *arg, int from_tty)
   ts->buffer_free = 0;
   ts->disconnected_tracing = 0;
   ts->circular_buffer = 0;
+  ts->compact_buffer = 0;
+  ts->bytes_collected = ts->bytes_stored = -1;
 
   try
     {
@@ -136,6 +136,11 @@ static bool disconnected_tracing;
 
 static bool circular_trace_buffer;
 
+/* This variable controls whether the target stores traceframes
+   compactly, deduplicating memory and delta-encoding registers.  */
+
+static bool compact_trace_buffer;
+
 /* This variable is the requested trace buffer size, or -1 to indicate
    that we don't care and leave it up to the target to set a size.  */
 
@@ -1644,6 +1649,7 @@ start_tracing (const char *notes)
   /* Set some mode flags.  */
   target_set_disconnected_tracing (disconnected_tracing);
   target_set_circular_trace_buffer (circular_trace_buffer);
+  target_set_compact_trace_buffer (compact_trace_buffer);
   target_set_trace_buffer_size (trace_buffer_size);
 
   if (!notes)
@@ -1844,6 +1850,18 @@ tstatus_command (const char *args, int from_tty)
   if (ts->circular_buffer)
     gdb_printf (_("Trace buffer is circular.\n"));
 
+  if (ts->compact_buffer)
+    {
+      gdb_printf (_("Traceframes are stored compactly"));
+      if (ts->bytes_collected > 0 && ts->bytes_stored > 0)
+	gdb_printf (_(", %s bytes of collected data take %s bytes"
+		      " (%.1fx)"),
+		    plongest (ts->bytes_collected),
+		    plongest (ts->bytes_stored),
+		    (double) ts->bytes_collected / ts->bytes_stored);
+      gdb_printf (_(".\n"));
+    }
+
   if (ts->user_name && strlen (ts->user_name) > 0)
     gdb_printf (_("Trace user is %s.\n"), ts->user_name);
 
@@ -1988,6 +2006,14 @@ trace_status_mi (int on_stop)
 
   uiout->field_signed ("disconnected",  ts->disconnected_tracing);
   uiout->field_signed ("circular",  ts->circular_buffer);
+  if (ts->compact_buffer)
+    {
+      uiout->field_signed ("compact", ts->compact_buffer);
+      if (ts->bytes_collected != -1)
+	uiout->field_signed ("bytes-collected", ts->bytes_collected);
+      if (ts->bytes_stored != -1)
+	uiout->field_signed ("bytes-stored", ts->bytes_stored);
+    }
 
   uiout->field_string ("user-name", ts->user_name);
   uiout->field_string ("notes", ts->notes);
@@ -2843,6 +2869,13 @@ set_circular_trace_buffer (const char *args, int from_tty,
   target_set_circular_trace_buffer (circular_trace_buffer);
 }
 
+static void
+set_compact_trace_buffer (const char *args, int from_tty,
+			  struct cmd_list_element *c)
+{
+  target_set_compact_trace_buffer (compact_trace_buffer);
+}
+
 static void
 set_trace_buffer_size (const char *args, int from_tty,
 			   struct cmd_list_element *c)
@@ -3229,6 +3262,8 @@ parse_trace_status (const char *line, struct trace_status *ts)
   ts->buffer_size = -1;
   ts->disconnected_tracing = 0;
   ts->circular_buffer = 0;
+  ts->compact_buffer = 0;
+  ts->bytes_collected = ts->bytes_stored = -1;
   xfree (ts->user_name);
   ts->user_name = NULL;
   xfree (ts->notes);
@@ -3332,6 +3367,21 @@ Status line: '%s'\n"), p, line);
 	  p = unpack_varlen_hex (++p1, &val);
 	  ts->circular_buffer = val;
 	}
+      else if (strncmp (p, "compact", p1 - p) == 0)
+	{
+	  p = unpack_varlen_hex (++p1, &val);
+	  ts->compact_buffer = val;
+	}
+      else if (strncmp (p, "tcollected", p1 - p) == 0)
+	{
+	  p = unpack_varlen_hex (++p1, &val);
+	  ts->bytes_collected = val;
+	}
+      else if (strncmp (p, "tstored", p1 - p) == 0)
+	{
+	  p = unpack_varlen_hex (++p1, &val);
+	  ts->bytes_stored = val;
+	}
       else if (strncmp (p, "starttime", p1 - p) == 0)
 	{
 	  p = unpack_varlen_hex (++p1, &val);
@@ -4094,6 +4144,19 @@ up and stopping the trace run."),
 			   &setlist,
 			   &showlist);
 
+  add_setshow_boolean_cmd ("compact-trace-buffer", no_class,
+			   &compact_trace_buffer, _("\
+Set target's use of a compact trace buffer."), _("\
+Show target's use of a compact trace buffer."), _("\
+Use this to make the target store traceframes compactly, recording\n\
+memory it already holds as a reference to it, and registers as their\n\
+changes since an earlier traceframe of the same tracepoint.  This lets\n\
+the trace buffer hold more traceframes."),
+			   set_compact_trace_buffer,
+			   NULL,
+			   &setlist,
+			   &showlist);
+
   add_setshow_zuinteger_unlimited_cmd ("trace-buffer-size", no_class,
 				       &trace_buffer_size, _("\
 Set requested size of trace buffer."), _("\
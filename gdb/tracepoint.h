@@ -139,6 +139,18 @@ struct trace_status
 
   int circular_buffer;
 
+  /* 1 if the target stores traceframes compactly, else 0.  If the
+     target does not report a value, assume 0.  */
+
+  int compact_buffer;
+
+  /* The number of bytes of data the traceframes of the run hold, and
+     the number of bytes they take in the trace buffer, or -1 if the
+     target does not report them.  */
+
+  LONGEST bytes_collected;
+  LONGEST bytes_stored;
+
   /* The "name" of the person running the trace.  This is an
      arbitrary string.  */
 
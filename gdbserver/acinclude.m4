@@ -36,6 +36,9 @@ m4_include(../gdb/ax_cxx_compile_stdcxx.m4)
 dnl For GDB_AC_SELFTEST.
 m4_include(../gdbsupport/selftest.m4)
 
+dnl For AM_ZLIB.
+m4_include([../config/zlib.m4])
+
 dnl Check for existence of a type $1 in libthread_db.h
 dnl Based on BFD_HAVE_SYS_PROCFS_TYPE in bfd/bfd.m4.
 
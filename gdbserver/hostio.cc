@@ -123,6 +123,44 @@ require_int (char **pp, int *value)
   return 0;
 }
 
+/* Like require_int, but for a non-negative file offset, which may be
+   larger than an int.  */
+
+static int
+require_offset (char **pp, off_t *value)
+{
+  char *p;
+  int count, firstdigit;
+
+  p = *pp;
+  *value = 0;
+  count = 0;
+  firstdigit = -1;
+
+  while (*p && *p != ',')
+    {
+      int nib;
+
+      if (safe_fromhex (p[0], &nib))
+	return -1;
+
+      if (firstdigit == -1)
+	firstdigit = nib;
+
+      /* Don't allow overflow.  */
+      if (count >= (int) sizeof (off_t) * 2
+	  || (count == (int) sizeof (off_t) * 2 - 1 && firstdigit >= 0x8))
+	return -1;
+
+      *value = *value * 16 + nib;
+      p++;
+      count++;
+    }
+
+  *pp = p;
+  return 0;
+}
+
 static int
 require_data (char *p, int p_len, char **data, int *data_len)
 {
@@ -340,10 +378,15 @@ handle_open (char *own_buf)
   hostio_reply (own_buf, fd);
 }
 
+/* Handle a vFile:pread request.  GDB may send several of these
+   without waiting for the replies; each is answered in turn, in the
+   order received, which is how GDB matches replies to requests.  */
+
 static void
 handle_pread (char *own_buf, int *new_packet_len)
 {
-  int fd, ret, len, offset, bytes_sent;
+  int fd, ret, len, bytes_sent;
+  off_t offset;
   char *p, *data;
   static int max_reply_size = -1;
 
@@ -354,7 +397,7 @@ handle_pread (char *own_buf, int *new_packet_len)
       || require_valid_fd (fd)
       || require_int (&p, &len)
       || require_comma (&p)
-      || require_int (&p, &offset)
+      || require_offset (&p, &offset)
       || require_end (p))
     {
       hostio_packet_error (own_buf);
@@ -381,8 +424,7 @@ handle_pread (char *own_buf, int *new_packet_len)
   /* If we have no pread or it failed for this file, use lseek/read.  */
   if (ret == -1)
     {
-      ret = lseek (fd, offset, SEEK_SET);
-      if (ret != -1)
+      if (lseek (fd, offset, SEEK_SET) != -1)
 	ret = read (fd, data, len);
     }
 
@@ -436,10 +436,9 @@ linux_process_target::add_linux_process_no_mem_file (int pid, int attached)
   struct process_info *proc;
 
   proc = add_process (pid, attached);
-  proc->priv = XCNEW (struct process_info_private);
+  proc->priv = new process_info_private;
 
   proc->priv->arch_private = low_new_process ();
-  proc->priv->mem_fd = -1;
 
   return proc;
 }
@@ -461,7 +460,7 @@ linux_process_target::remove_linux_process (process_info *proc)
 
   this->low_delete_process (proc->priv->arch_private);
 
-  xfree (proc->priv);
+  delete proc->priv;
   proc->priv = nullptr;
 
   remove_process (proc);
@@ -6157,6 +6156,12 @@ linux_process_target::low_supports_catch_syscall ()
   return false;
 }
 
+bool
+linux_process_target::supports_pipelining ()
+{
+  return true;
+}
+
 CORE_ADDR
 linux_process_target::read_pc (regcache *regcache)
 {
@@ -6559,27 +6564,78 @@ static const link_map_offsets lmo_64bit_offsets =
     32     /* l_prev offset in link_map.  */
   };
 
-/* Get the loaded shared libraries from one namespace.  */
+/* Return the pointer of PTR_SIZE bytes at BUF, read from the
+   inferior.  */
+
+static CORE_ADDR
+extract_one_ptr (const unsigned char *buf, int ptr_size)
+{
+  /* Like read_one_ptr.  */
+  union
+  {
+    CORE_ADDR core_addr;
+    unsigned int ui;
+    unsigned char uc[sizeof (CORE_ADDR)];
+  } addr;
+
+  memcpy (addr.uc, buf, ptr_size);
+  if (ptr_size == sizeof (CORE_ADDR))
+    return addr.core_addr;
+  else if (ptr_size == sizeof (unsigned int))
+    return addr.ui;
+  else
+    gdb_assert_not_reached ("unhandled pointer size");
+}
+
+/* Read the NUL-terminated string at MEMADDR in the inferior, of at most
+   PATH_MAX bytes, a piece at a time, since library names are usually
+   much shorter than that.  */
+
+static std::string
+read_library_name (CORE_ADDR memaddr)
+{
+  std::string name;
+  unsigned char piece[256];
+
+  while (name.size () < PATH_MAX - 1)
+    {
+      /* Not checking for error because reading may stop before the
+	 end of the piece.  */
+      memset (piece, 0, sizeof (piece));
+      linux_read_memory (memaddr + name.size (), piece, sizeof (piece));
+
+      size_t len = strnlen ((char *) piece, sizeof (piece));
+      name.append ((char *) piece, len);
+      if (len < sizeof (piece))
+	break;
+    }
+
+  if (name.size () > PATH_MAX - 1)
+    name.resize (PATH_MAX - 1);
+  return name;
+}
+
+/* Get the loaded shared libraries from one namespace.  Each link map
+   entry is read at once, and the names of the libraries come from
+   CACHE when their entry did not change.  */
 
 static void
 read_link_map (std::string &document, CORE_ADDR lmid, CORE_ADDR lm_addr,
-	       CORE_ADDR lm_prev, int ptr_size, const link_map_offsets *lmo)
+	       CORE_ADDR lm_prev, int ptr_size, const link_map_offsets *lmo,
+	       svr4_library_cache *cache)
 {
-  CORE_ADDR l_name, l_addr, l_ld, l_next, l_prev;
+  int lm_size = std::max ({ lmo->l_addr_offset, lmo->l_name_offset,
+			    lmo->l_ld_offset, lmo->l_next_offset,
+			    lmo->l_prev_offset }) + ptr_size;
+  gdb::byte_vector lm (lm_size);
 
-  while (lm_addr
-	 && read_one_ptr (lm_addr + lmo->l_name_offset,
-			  &l_name, ptr_size) == 0
-	 && read_one_ptr (lm_addr + lmo->l_addr_offset,
-			  &l_addr, ptr_size) == 0
-	 && read_one_ptr (lm_addr + lmo->l_ld_offset,
-			  &l_ld, ptr_size) == 0
-	 && read_one_ptr (lm_addr + lmo->l_prev_offset,
-			  &l_prev, ptr_size) == 0
-	 && read_one_ptr (lm_addr + lmo->l_next_offset,
-			  &l_next, ptr_size) == 0)
+  while (lm_addr && linux_read_memory (lm_addr, lm.data (), lm_size) == 0)
     {
-      unsigned char libname[PATH_MAX];
+      CORE_ADDR l_name = extract_one_ptr (&lm[lmo->l_name_offset], ptr_size);
+      CORE_ADDR l_addr = extract_one_ptr (&lm[lmo->l_addr_offset], ptr_size);
+      CORE_ADDR l_ld = extract_one_ptr (&lm[lmo->l_ld_offset], ptr_size);
+      CORE_ADDR l_next = extract_one_ptr (&lm[lmo->l_next_offset], ptr_size);
+      CORE_ADDR l_prev = extract_one_ptr (&lm[lmo->l_prev_offset], ptr_size);
 
       if (lm_prev != l_prev)
 	{
@@ -6588,15 +6644,23 @@ read_link_map (std::string &document, CORE_ADDR lmid, CORE_ADDR lm_addr,
 	  break;
 	}
 
-      /* Not checking for error because reading may stop before we've got
-	 PATH_MAX worth of characters.  */
-      libname[0] = '\0';
-      linux_read_memory (l_name, libname, sizeof (libname) - 1);
-      libname[sizeof (libname) - 1] = '\0';
-      if (libname[0] != '\0')
+      svr4_library_name &entry = cache->names[lm_addr];
+      if (entry.name.empty ()
+	  || entry.l_name != l_name
+	  || entry.l_addr != l_addr
+	  || entry.l_ld != l_ld)
+	{
+	  entry.l_name = l_name;
+	  entry.l_addr = l_addr;
+	  entry.l_ld = l_ld;
+	  entry.name = read_library_name (l_name);
+	}
+      entry.generation = cache->generation;
+
+      if (!entry.name.empty ())
 	{
 	  string_appendf (document, "<library name=\"");
-	  xml_escape_text_append (document, (char *) libname);
+	  xml_escape_text_append (document, entry.name.c_str ());
 	  string_appendf (document, "\" lm=\"0x%s\" l_addr=\"0x%s\" "
 			  "l_ld=\"0x%s\" lmid=\"0x%s\"/>",
 			  paddress (lm_addr), paddress (l_addr),
@@ -6608,6 +6672,26 @@ read_link_map (std::string &document, CORE_ADDR lmid, CORE_ADDR lm_addr,
     }
 }
 
+/* Copy at most LEN bytes at OFFSET in DOCUMENT to READBUF, and return
+   how many were copied.  */
+
+static int
+copy_xfer_reply (const std::string &document, unsigned char *readbuf,
+		 CORE_ADDR offset, int len)
+{
+  int document_len = document.length ();
+  if (offset < document_len)
+    document_len -= offset;
+  else
+    document_len = 0;
+  if (len > document_len)
+    len = document_len;
+
+  memcpy (readbuf, document.data () + offset, len);
+
+  return len;
+}
+
 /* Construct qXfer:libraries-svr4:read reply.  */
 
 int
@@ -6627,6 +6711,21 @@ linux_process_target::qxfer_libraries_svr4 (const char *annex,
   if (readbuf == NULL)
     return -1;
 
+  /* GDB reads the reply a packet at a time, all while the inferior is
+     stopped, so only build it for the first one.  Each client has its
+     own copy, since an observer session may be reading another.  */
+  client_state &cs = get_client_state ();
+  svr4_library_cache *cache = &priv->libraries;
+  if (offset != 0
+      && cs.qxfer_libraries_svr4_pid == current_process ()->pid
+      && cs.qxfer_libraries_svr4_annex == annex)
+    return copy_xfer_reply (cs.qxfer_libraries_svr4_result, readbuf,
+			    offset, len);
+
+  cs.qxfer_libraries_svr4_pid = current_process ()->pid;
+  cs.qxfer_libraries_svr4_annex = annex;
+  cs.qxfer_libraries_svr4_result.clear ();
+
   int pid = current_thread->id.lwp ();
   xsnprintf (filename, sizeof filename, "/proc/%d/exe", pid);
   is_elf64 = elf_64_file_p (filename, &machine);
@@ -6681,7 +6780,8 @@ linux_process_target::qxfer_libraries_svr4 (const char *annex,
   if (lm_addr != 0)
     {
       document += ">";
-      read_link_map (document, lmid, lm_addr, lm_prev, ptr_size, lmo);
+      read_link_map (document, lmid, lm_addr, lm_prev, ptr_size, lmo,
+		     cache);
     }
   else
     {
@@ -6708,6 +6808,9 @@ linux_process_target::qxfer_libraries_svr4 (const char *annex,
       if (r_debug == 0)
 	document += ">";
 
+      /* This walk finds all the libraries.  */
+      cache->generation++;
+
       while (r_debug != 0)
 	{
 	  int r_version = 0;
@@ -6759,7 +6862,8 @@ linux_process_target::qxfer_libraries_svr4 (const char *annex,
 		}
 	    }
 
-	  read_link_map (document, r_debug, lm_addr, lm_prev, ptr_size, lmo);
+	  read_link_map (document, r_debug, lm_addr, lm_prev, ptr_size, lmo,
+			 cache);
 
 	  if (r_version < 2)
 	    break;
@@ -6772,21 +6876,20 @@ linux_process_target::qxfer_libraries_svr4 (const char *annex,
 	      break;
 	    }
 	}
+
+      /* Forget the libraries that were unloaded.  */
+      for (auto it = cache->names.begin (); it != cache->names.end ();)
+	if (it->second.generation != cache->generation)
+	  it = cache->names.erase (it);
+	else
+	  ++it;
     }
 
   document += "</library-list-svr4>";
 
-  int document_len = document.length ();
-  if (offset < document_len)
-    document_len -= offset;
-  else
-    document_len = 0;
-  if (len > document_len)
-    len = document_len;
-
-  memcpy (readbuf, document.data () + offset, len);
-
-  return len;
+  cs.qxfer_libraries_svr4_result = std::move (document);
+  return copy_xfer_reply (cs.qxfer_libraries_svr4_result, readbuf, offset,
+			  len);
 }
 
 #ifdef HAVE_LINUX_BTRACE
@@ -32,6 +32,7 @@
 #include "tracepoint.h"
 
 #include <list>
+#include <unordered_map>
 
 #define PTRACE_XFER_TYPE long
 
@@ -116,20 +117,57 @@ struct regs_info
 #endif
 };
 
+/* A library name read from the link map of a process, see
+   svr4_library_cache.  */
+
+struct svr4_library_name
+{
+  /* The fields of the link map entry it was read for.  */
+  CORE_ADDR l_name;
+  CORE_ADDR l_addr;
+  CORE_ADDR l_ld;
+
+  std::string name;
+
+  /* The last walk of the whole link map that found it.  */
+  unsigned int generation;
+};
+
+/* What qXfer:libraries-svr4:read found in the link map of a process,
+   so that each request does not read it all again.  The chain of link
+   map entries is still walked for each reply: the dynamic linker keeps
+   no count of its changes that would tell which parts of it are
+   new.  */
+
+struct svr4_library_cache
+{
+  /* The library names, by the address of their link map entry.
+     Reading the name is most of the cost of reading an entry, so it is
+     only read again if the entry changed.  */
+  std::unordered_map<CORE_ADDR, svr4_library_name> names;
+
+  /* Incremented by each walk of the whole link map, after which the
+     names it did not find are forgotten.  */
+  unsigned int generation = 0;
+};
+
 struct process_info_private
 {
   /* Arch-specific additions.  */
-  struct arch_process_info *arch_private;
+  struct arch_process_info *arch_private = nullptr;
 
   /* libthread_db-specific additions.  Not NULL if this process has loaded
      thread_db, and it is active.  */
-  struct thread_db *thread_db;
+  struct thread_db *thread_db = nullptr;
 
   /* &_r_debug.  0 if not yet determined.  -1 if no PT_DYNAMIC in Phdrs.  */
-  CORE_ADDR r_debug;
+  CORE_ADDR r_debug = 0;
 
   /* The /proc/pid/mem file used for reading/writing memory.  */
-  int mem_fd;
+  int mem_fd = -1;
+
+  /* What qXfer:libraries-svr4:read last found.  */
+  svr4_library_cache libraries;
 };
 
 struct lwp_info;
@@ -322,6 +360,8 @@ class linux_process_target : public process_stratum_target
 
   bool supports_catch_syscall () override;
 
+  bool supports_pipelining () override;
+
   /* Return the information to access registers.  This has public
      visibility because proc-service uses it.  */
   virtual const regs_info *get_regs_info () = 0;
@@ -1138,17 +1138,24 @@ amd64_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
   i += push_opcode (&buf[i], "48 89 44 24 08"); /* mov %rax,0x8(%rsp) */
   append_insns (&buildaddr, i, buf);
 
-  /* spin-lock.  */
+  /* spin-lock.  While another thread holds the lock, wait for it to
+     be released with plain loads, like the AArch64 jump pad does with
+     WFE, instead of retrying the locked cmpxchg, which would keep
+     stealing the lock's cache line from the thread that holds it.  */
   i = 0;
   i += push_opcode (&buf[i], "48 be");		/* movl <lockaddr>,%rsi */
   memcpy (&buf[i], (void *) &lockaddr, 8);
   i += 8;
   i += push_opcode (&buf[i], "48 89 e1");       /* mov %rsp,%rcx */
-  i += push_opcode (&buf[i], "31 c0");		/* xor %eax,%eax */
+  i += push_opcode (&buf[i], "31 c0");		/* again: xor %eax,%eax */
   i += push_opcode (&buf[i], "f0 48 0f b1 0e"); /* lock cmpxchg %rcx,(%rsi) */
   i += push_opcode (&buf[i], "48 85 c0");	/* test %rax,%rax */
-  i += push_opcode (&buf[i], "75 f4");		/* jne <again> */
-  append_insns (&buildaddr, i, buf);
+  i += push_opcode (&buf[i], "74 0a");		/* je <locked> */
+  i += push_opcode (&buf[i], "f3 90");		/* wait: pause */
+  i += push_opcode (&buf[i], "48 83 3e 00");	/* cmpq $0x0,(%rsi) */
+  i += push_opcode (&buf[i], "75 f8");		/* jne <wait> */
+  i += push_opcode (&buf[i], "eb ea");		/* jmp <again> */
+  append_insns (&buildaddr, i, buf);		/* locked: */
 
   /* Set up the gdb_collect call.  */
   /* At this point, (stack pointer + 0x18) is the base of our saved
@@ -1318,17 +1325,26 @@ i386_install_fast_tracepoint_jump_pad (CORE_ADDR tpoint, CORE_ADDR tpaddr,
   append_insns (&buildaddr, i, buf);
 
   /* spin-lock.  Note this is using cmpxchg, which leaves i386 behind.
-     If we cared for it, this could be using xchg alternatively.  */
+     If we cared for it, this could be using xchg alternatively.  As
+     in the amd64 jump pad, wait for the lock to be released with
+     plain loads.  */
 
   i = 0;
-  i += push_opcode (&buf[i], "31 c0");		/* xor %eax,%eax */
+  i += push_opcode (&buf[i], "31 c0");		/* again: xor %eax,%eax */
   i += push_opcode (&buf[i], "f0 0f b1 25");    /* lock cmpxchg
 						   %esp,<lockaddr> */
   memcpy (&buf[i], (void *) &lockaddr, 4);
   i += 4;
   i += push_opcode (&buf[i], "85 c0");		/* test %eax,%eax */
-  i += push_opcode (&buf[i], "75 f2");		/* jne <again> */
-  append_insns (&buildaddr, i, buf);
+  i += push_opcode (&buf[i], "74 0d");		/* je <locked> */
+  i += push_opcode (&buf[i], "f3 90");		/* wait: pause */
+  i += push_opcode (&buf[i], "83 3d");		/* cmpl $0x0,<lockaddr> */
+  memcpy (&buf[i], (void *) &lockaddr, 4);
+  i += 4;
+  buf[i++] = 0x00;
+  i += push_opcode (&buf[i], "75 f5");		/* jne <wait> */
+  i += push_opcode (&buf[i], "eb e5");		/* jmp <again> */
+  append_insns (&buildaddr, i, buf);		/* locked: */
 
 
   /* Set up arguments to the gdb_collect call.  */
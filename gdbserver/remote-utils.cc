@@ -30,6 +30,10 @@
 #include "gdbsupport/netstuff.h"
 #include "gdbsupport/filestuff.h"
 #include "gdbsupport/gdb-sigmask.h"
+#if defined HAVE_ZLIB && !defined IN_PROCESS_AGENT
+#include "gdbsupport/rsp-compress.h"
+#endif
+#include <list>
 #include <ctype.h>
 #if HAVE_SYS_IOCTL_H
 #include <sys/ioctl.h>
@@ -102,6 +106,61 @@ static int remote_is_stdio = 0;
 static int remote_desc = -1;
 static int listen_desc = -1;
 
+#if defined HAVE_ZLIB && !defined IN_PROCESS_AGENT
+/* The zlib streams used to compress packets sent to GDB and to
+   decompress packets received from it, once compression is in
+   effect.  */
+static std::unique_ptr<rsp_compressor> compressor;
+static std::unique_ptr<rsp_decompressor> decompressor;
+
+/* True if compression starts after the next packet is sent.  */
+static bool compression_pending;
+#endif
+
+/* A read-only observer session, accepted on the listening socket
+   while a client is already connected; see --observers.  Each has its
+   own protocol state, but its packets are never compressed, it gets
+   no notifications, and its replies are not sent again when it does
+   not acknowledge them.  Its socket does not block: what cannot be
+   written at once is queued in OUTPUT, and the session is ended when
+   the queue outgrows OBSERVER_OUTPUT_MAX, rather than letting a slow
+   observer hold up the controlling client.  No reply is ever dropped
+   from a session that goes on.  */
+
+#define OBSERVER_OUTPUT_MAX (4 * PBUFSIZ)
+
+/* How often to retry writing queued output, in milliseconds.  */
+
+#define OBSERVER_FLUSH_INTERVAL 10
+
+struct observer_connection
+{
+  observer_connection () = default;
+  ~observer_connection ()
+  {
+    xfree (cs.own_buf);
+  }
+
+  DISABLE_COPY_AND_ASSIGN (observer_connection);
+
+  int desc = -1;
+
+  /* What was received and is not handled yet.  */
+  std::string input;
+
+  /* What is still to be written.  */
+  std::string output;
+
+  /* The timer that retries writing OUTPUT, or -1.  */
+  int flush_timer = -1;
+
+  client_state cs;
+};
+
+static std::list<observer_connection> observers;
+
+static void handle_observer_event (int err, gdb_client_data client_data);
+
 #ifdef USE_WIN32API
 /* gnulib wraps these as macros, undo them.  */
 # undef read
@@ -139,6 +198,241 @@ enable_async_notification (int fd)
 #endif
 }
 
+/* Accept a connection on the listening socket as an observer
+   session.  */
+
+static void
+accept_observer (void)
+{
+  int desc = accept (listen_desc, nullptr, nullptr);
+  if (desc == -1)
+    {
+      perror ("Accept failed");
+      return;
+    }
+
+  socklen_t tmp = 1;
+  setsockopt (desc, IPPROTO_TCP, TCP_NODELAY, (char *) &tmp, sizeof (tmp));
+
+#ifdef USE_WIN32API
+  u_long nonblocking = 1;
+  ioctlsocket (desc, FIONBIO, &nonblocking);
+#else
+  fcntl (desc, F_SETFL, fcntl (desc, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+  observer_connection &observer = observers.emplace_back ();
+  observer.desc = desc;
+  observer.cs.transport_is_reliable = 1;
+
+  fprintf (stderr, _("Observer session started\n"));
+
+  add_file_handler (desc, handle_observer_event, &observer,
+		    "remote-observer");
+}
+
+/* End the observer session OBSERVER.  */
+
+static void
+close_observer (observer_connection *observer)
+{
+  if (observer->flush_timer != -1)
+    delete_timer (observer->flush_timer);
+  delete_file_handler (observer->desc);
+#ifdef USE_WIN32API
+  closesocket (observer->desc);
+#else
+  close (observer->desc);
+#endif
+
+  fprintf (stderr, _("Observer session ended\n"));
+
+  observers.remove_if ([=] (const observer_connection &o)
+    {
+      return &o == observer;
+    });
+}
+
+static void observer_flush_timer (gdb_client_data client_data);
+
+/* Whether the last read or write on an observer connection failed
+   only because it would have blocked.  */
+
+static bool
+observer_would_block ()
+{
+#ifdef USE_WIN32API
+  return WSAGetLastError () == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+/* Write as much of OBSERVER's queued output as the connection takes
+   without blocking, and arrange to retry the rest later.  Returns
+   false if the connection failed.  */
+
+static bool
+flush_observer (observer_connection *observer)
+{
+  std::string &output = observer->output;
+
+  size_t done = 0;
+  while (done < output.size ())
+    {
+      int n = write (observer->desc, output.data () + done,
+		     output.size () - done);
+      if (n > 0)
+	done += n;
+      else if (n < 0 && observer_would_block ())
+	break;
+      else
+	return false;
+    }
+  output.erase (0, done);
+
+  if (!output.empty () && observer->flush_timer == -1)
+    observer->flush_timer = create_timer (OBSERVER_FLUSH_INTERVAL,
+					  observer_flush_timer, observer);
+  return true;
+}
+
+/* Timer callback retrying to write the output queued for the observer
+   session CLIENT_DATA.  */
+
+static void
+observer_flush_timer (gdb_client_data client_data)
+{
+  observer_connection *observer = (observer_connection *) client_data;
+
+  observer->flush_timer = -1;
+  if (!flush_observer (observer))
+    close_observer (observer);
+}
+
+/* Queue the LEN bytes at BUF to be written to OBSERVER, and write what
+   can be.  Returns false if the connection failed, or if the observer
+   is too far behind in reading what it was sent.  */
+
+static bool
+observer_write (observer_connection *observer, const char *buf, int len)
+{
+  if (observer->output.size () + len > OBSERVER_OUTPUT_MAX)
+    {
+      fprintf (stderr, _("Observer session is not reading its replies\n"));
+      return false;
+    }
+
+  observer->output.append (buf, len);
+  return flush_observer (observer);
+}
+
+/* Send the packet of LEN bytes at BUF to OBSERVER.  Returns false if
+   the connection failed.  */
+
+static bool
+observer_putpkt (observer_connection *observer, const char *buf, int len)
+{
+  std::string packet = "$";
+  unsigned char csum = 0;
+
+  for (int i = 0; i < len; i++)
+    csum += buf[i];
+
+  packet.append (buf, len);
+  packet += '#';
+  packet += tohex ((csum >> 4) & 0xf);
+  packet += tohex (csum & 0xf);
+
+  remote_debug_printf ("observer putpkt (\"%s\");",
+		       suppressed_remote_debug ? "..." : packet.c_str ());
+  suppressed_remote_debug = false;
+
+  return observer_write (observer, packet.data (), packet.size ());
+}
+
+/* Event-loop callback for data from an observer session.  Handle each
+   complete packet received so far.  Acknowledgments of our replies,
+   and interrupt requests, are ignored.  */
+
+static void
+handle_observer_event (int err, gdb_client_data client_data)
+{
+  observer_connection *observer = (observer_connection *) client_data;
+  char buf[BUFSIZ];
+
+  int n = read (observer->desc, buf, sizeof (buf));
+  if (n < 0 && observer_would_block ())
+    return;
+  if (n <= 0)
+    {
+      close_observer (observer);
+      return;
+    }
+  observer->input.append (buf, n);
+
+  while (true)
+    {
+      std::string &input = observer->input;
+      size_t start = input.find ('$');
+      if (start == std::string::npos)
+	{
+	  input.clear ();
+	  return;
+	}
+
+      size_t end = input.find ('#', start);
+      if (end == std::string::npos || end + 2 >= input.size ())
+	{
+	  input.erase (0, start);
+	  return;
+	}
+
+      unsigned char csum = 0;
+      for (size_t i = start + 1; i < end; i++)
+	csum += input[i];
+
+      int len = end - start - 1;
+      bool valid = (len <= PBUFSIZ
+		    && csum == ((fromhex (input[end + 1]) << 4)
+				+ fromhex (input[end + 2])));
+      if (valid)
+	{
+	  memcpy (observer->cs.own_buf, input.data () + start + 1, len);
+	  observer->cs.own_buf[len] = '\0';
+	}
+      input.erase (0, end + 3);
+
+      if (!observer->cs.noack_mode
+	  && !observer_write (observer, valid ? "+" : "-", 1))
+	{
+	  close_observer (observer);
+	  return;
+	}
+
+      if (!valid)
+	continue;
+
+      remote_debug_printf ("observer getpkt (\"%s\");",
+			   observer->cs.own_buf);
+
+      int new_packet_len;
+      bool close_session;
+      if (handle_observer_packet (observer->cs, len, &new_packet_len,
+				  &close_session)
+	  && !observer_putpkt (observer, observer->cs.own_buf,
+			       (new_packet_len != -1 ? new_packet_len
+				: strlen (observer->cs.own_buf))))
+	close_session = true;
+
+      if (close_session)
+	{
+	  close_observer (observer);
+	  return;
+	}
+    }
+}
+
 static void
 handle_accept_event (int err, gdb_client_data client_data)
 {
@@ -147,6 +441,12 @@ handle_accept_event (int err, gdb_client_data client_data)
 
   threads_debug_printf ("handling possible accept event");
 
+  if (remote_desc != -1)
+    {
+      accept_observer ();
+      return;
+    }
+
   remote_desc = accept (listen_desc, (struct sockaddr *) &sockaddr, &len);
   if (remote_desc == -1)
     perror_with_name ("Accept failed");
@@ -167,7 +467,7 @@ handle_accept_event (int err, gdb_client_data client_data)
 				   exits when the remote side dies.  */
 #endif
 
-  if (run_once)
+  if (run_once && !allow_observers)
     {
 #ifndef USE_WIN32API
       close (listen_desc);		/* No longer need this */
@@ -176,9 +476,11 @@ handle_accept_event (int err, gdb_client_data client_data)
 #endif
     }
 
-  /* Even if !RUN_ONCE no longer notice new connections.  Still keep the
-     descriptor open for add_file_handler to wait for a new connection.  */
-  delete_file_handler (listen_desc);
+  /* Even if !RUN_ONCE no longer notice new connections, unless they
+     are to be observer sessions.  Still keep the descriptor open for
+     add_file_handler to wait for a new connection.  */
+  if (!allow_observers)
+    delete_file_handler (listen_desc);
 
   /* Convert IP address to string.  */
   char orig_host[GDB_NI_MAX_ADDR], orig_port[GDB_NI_MAX_PORT];
@@ -423,10 +725,29 @@ remote_close (void)
   remote_desc = -1;
 
   reset_readchar ();
+
+#ifdef HAVE_ZLIB
+  compressor.reset ();
+  decompressor.reset ();
+  compression_pending = false;
+#endif
+}
+
+#ifdef HAVE_ZLIB
+
+/* Compress packets once the current reply, which tells GDB that we
+   will, has been sent.  */
+
+void
+remote_start_compression (void)
+{
+  compression_pending = true;
 }
 
 #endif
 
+#endif
+
 #ifndef IN_PROCESS_AGENT
 
 void
@@ -638,10 +959,23 @@ putpkt_binary_1 (char *buf, int cnt, int is_notif)
   char *buf2;
   char *p;
   int cc;
+  std::string compressed;
 
   SCOPE_EXIT { suppressed_remote_debug = false; };
 
-  buf2 = (char *) xmalloc (strlen ("$") + cnt + strlen ("#nn") + 1);
+#ifdef HAVE_ZLIB
+  /* Notifications are never compressed, so that GDB can always tell
+     them apart.  Packets are only compressed in no-ack mode: a packet
+     sent again after a NAK or lost ack would go through GDB's
+     decompression stream twice.  */
+  if (compressor != nullptr && cs.noack_mode && !is_notif
+      && cnt >= RSP_COMPRESS_THRESHOLD)
+    compressed = compressor->compress (buf, cnt);
+#endif
+
+  buf2 = (char *) xmalloc (strlen ("$") + std::max<size_t> (cnt,
+							     compressed.size ())
+			   + strlen ("#nn") + 1);
 
   /* Copy the packet into buffer BUF2, encapsulating it
      and giving it a checksum.  */
@@ -652,8 +986,19 @@ putpkt_binary_1 (char *buf, int cnt, int is_notif)
   else
     *p++ = '$';
 
-  for (i = 0; i < cnt;)
-    i += try_rle (buf + i, cnt - i, &csum, &p);
+  if (!compressed.empty ())
+    {
+      /* The compressed data contains no '*', so run-length encoding
+	 must not add any.  */
+      for (char ch : compressed)
+	{
+	  csum += ch;
+	  *p++ = ch;
+	}
+    }
+  else
+    for (i = 0; i < cnt;)
+      i += try_rle (buf + i, cnt - i, &csum, &p);
 
   *p++ = '#';
   *p++ = tohex ((csum >> 4) & 0xf);
@@ -676,14 +1021,18 @@ putpkt_binary_1 (char *buf, int cnt, int is_notif)
 	{
 	  /* Don't expect an ack then.  */
 	  remote_debug_printf ("putpkt (\"%s\"); [%s]",
-			       (suppressed_remote_debug ? "..." : buf2),
+			       (suppressed_remote_debug ? "..."
+				: !compressed.empty () ? "<compressed>"
+				: buf2),
 			       (is_notif ? "notif" : "noack mode"));
 
 	  break;
 	}
 
       remote_debug_printf ("putpkt (\"%s\"); [looking for ack]",
-			   (suppressed_remote_debug ? "..." : buf2));
+			   (suppressed_remote_debug ? "..."
+			    : !compressed.empty () ? "<compressed>"
+			    : buf2));
 
       cc = readchar ();
 
@@ -702,6 +1051,16 @@ putpkt_binary_1 (char *buf, int cnt, int is_notif)
   while (cc != '+');
 
   free (buf2);
+
+#ifdef HAVE_ZLIB
+  if (compression_pending && !is_notif)
+    {
+      compressor = std::make_unique<rsp_compressor> ();
+      decompressor = std::make_unique<rsp_decompressor> ();
+      compression_pending = false;
+    }
+#endif
+
   return 1;			/* Success! */
 }
 
@@ -924,6 +1283,8 @@ getpkt (char *buf)
   char *bp;
   unsigned char csum, c1, c2;
   int c;
+  bool compressed;
+  std::string compressed_frame;
 
   while (1)
     {
@@ -951,6 +1312,8 @@ getpkt (char *buf)
 	}
 
       bp = buf;
+      compressed = false;
+      compressed_frame.clear ();
       while (1)
 	{
 	  c = readchar ();
@@ -958,7 +1321,18 @@ getpkt (char *buf)
 	    return -1;
 	  if (c == '#')
 	    break;
-	  *bp++ = c;
+#ifdef HAVE_ZLIB
+	  /* A compressed payload may be longer than BUF, so collect it
+	     separately.  */
+	  if (bp == buf && !compressed && c == RSP_COMPRESSED_PAYLOAD
+	      && decompressor != nullptr)
+	    compressed = true;
+	  else
+#endif
+	  if (compressed)
+	    compressed_frame += c;
+	  else
+	    *bp++ = c;
 	  csum += c;
 	}
       *bp = 0;
@@ -985,6 +1359,25 @@ getpkt (char *buf)
 	return -1;
     }
 
+#ifdef HAVE_ZLIB
+  if (compressed)
+    {
+      std::string payload;
+
+      if (!decompressor->decompress (compressed_frame.data (),
+				     compressed_frame.size (), &payload)
+	  || payload.size () >= PBUFSIZ)
+	{
+	  fprintf (stderr, "Bad compressed packet from GDB\n");
+	  return -1;
+	}
+
+      memcpy (buf, payload.data (), payload.size ());
+      bp = buf + payload.size ();
+      *bp = 0;
+    }
+#endif
+
   if (!cs.noack_mode)
     {
       remote_debug_printf ("getpkt (\"%s\");  [sending ack]", buf);
@@ -1210,10 +1603,56 @@ prepare_resume_reply (char *buf, ptid_t ptid, const target_waitstatus &status)
 	  }
 
 	/* Handle the expedited registers.  */
+	std::vector<int> expedited;
 	for (const std::string &expedited_reg :
 	     current_target_desc ()->expedite_regs)
-	  buf = outreg (regcache, find_regno (regcache->tdesc,
-					      expedited_reg.c_str ()), buf);
+	  {
+	    int regno = find_regno (regcache->tdesc, expedited_reg.c_str ());
+
+	    buf = outreg (regcache, regno, buf);
+	    expedited.push_back (regno);
+	  }
+
+	/* Then those GDB asked for with QExpedite, as long as they fit,
+	   leaving room for the rest of the reply.  */
+	int num_regs = regcache->tdesc->reg_defs.size ();
+	char *buf_end = buf_start + PBUFSIZ - 256 - 2 * cs.expedite_stack_len;
+	for (int regno : cs.expedite_regs)
+	  {
+	    if (regno < 0 || regno >= num_regs
+		|| (std::find (expedited.begin (), expedited.end (), regno)
+		    != expedited.end ()))
+	      continue;
+
+	    if (buf + 16 + 2 * register_size (regcache->tdesc, regno)
+		> buf_end)
+	      break;
+
+	    buf = outreg (regcache, regno, buf);
+	  }
+
+	/* And the memory at the stack pointer.  A short read just sends
+	   fewer bytes.  */
+	int sp_regno = cs.expedite_sp_regno;
+	if (cs.expedite_stack_len > 0
+	    && sp_regno >= 0 && sp_regno < num_regs
+	    && regcache->get_register_status (sp_regno) == REG_VALID)
+	  {
+	    CORE_ADDR sp = regcache_raw_get_unsigned (regcache, sp_regno);
+	    gdb::byte_vector stack (cs.expedite_stack_len);
+	    int len = stack.size ();
+
+	    while (len > 0 && read_inferior_memory (sp, stack.data (), len) != 0)
+	      len /= 2;
+
+	    if (len > 0)
+	      {
+		sprintf (buf, "stack:%s,", paddress (sp));
+		buf += strlen (buf);
+		buf += 2 * bin2hex (stack.data (), buf, len);
+		*buf++ = ';';
+	      }
+	  }
 	*buf = '\0';
 
 	/* Formerly, if the debugger had not used any thread features
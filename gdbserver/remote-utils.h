@@ -34,6 +34,9 @@ int getpkt (char *buf);
 void remote_prepare (const char *name);
 void remote_open (const char *name);
 void remote_close (void);
+#ifdef HAVE_ZLIB
+void remote_start_compression (void);
+#endif
 void write_ok (char *buf);
 void write_enn (char *buf);
 void initialize_async_io (void);
@@ -83,6 +83,10 @@ static bool exit_requested;
 /* --once: Exit after the first connection has closed.  */
 bool run_once;
 
+/* --observers: Accept more connections while a client is connected,
+   as read-only observer sessions.  */
+bool allow_observers;
+
 /* Whether to report TARGET_WAITKIND_NO_RESUMED events.  */
 static bool report_no_resumed;
 
@@ -163,10 +167,15 @@ static struct btrace_config current_btrace_conf;
 
 static client_state g_client_state;
 
+/* The client whose packet is being handled: the controlling client,
+   or an observer session.  */
+
+static client_state *current_client_state = &g_client_state;
+
 client_state &
 get_client_state ()
 {
-  client_state &cs = g_client_state;
+  client_state &cs = *current_client_state;
   return cs;
 }
 
@@ -700,6 +709,54 @@ handle_general_set (char *own_buf)
       return;
     }
 
+  if (startswith (own_buf, "QExpedite:"))
+    {
+      const char *p = own_buf + strlen ("QExpedite:");
+      std::vector<int> regs;
+      ULONGEST sp_regno = -1;
+      ULONGEST stack_len = 0;
+
+      while (*p != '\0' && *p != ';')
+	{
+	  ULONGEST regno;
+	  const char *end = unpack_varlen_hex (p, &regno);
+
+	  if (end == p || (*end != ',' && *end != ';' && *end != '\0'))
+	    {
+	      write_enn (own_buf);
+	      return;
+	    }
+	  regs.push_back (regno);
+	  p = *end == ',' ? end + 1 : end;
+	}
+
+      if (startswith (p, ";stack:"))
+	{
+	  p = unpack_varlen_hex (p + strlen (";stack:"), &sp_regno);
+	  if (*p++ != ',')
+	    {
+	      write_enn (own_buf);
+	      return;
+	    }
+	  p = unpack_varlen_hex (p, &stack_len);
+	}
+
+      if (*p != '\0')
+	{
+	  write_enn (own_buf);
+	  return;
+	}
+
+      /* The stack bytes must fit in a stop reply, next to the
+	 registers.  */
+      cs.expedite_regs = std::move (regs);
+      cs.expedite_sp_regno = sp_regno;
+      cs.expedite_stack_len = std::min<ULONGEST> (stack_len, PBUFSIZ / 8);
+
+      write_ok (own_buf);
+      return;
+    }
+
   if (startswith (own_buf, "QCatchSyscalls:"))
     {
       const char *p = own_buf + sizeof ("QCatchSyscalls:") - 1;
@@ -2070,7 +2127,7 @@ handle_qxfer_threads (const char *annex,
 		      gdb_byte *readbuf, const gdb_byte *writebuf,
 		      ULONGEST offset, LONGEST len)
 {
-  static std::string result;
+  std::string &result = get_client_state ().qxfer_threads_result;
 
   if (writebuf != NULL)
     return -2;
@@ -2105,6 +2162,165 @@ handle_qxfer_threads (const char *annex,
   return len;
 }
 
+/* Helper for handle_qxfer_threads_delta.  Describe THREAD in the
+   entry for it in CS's threads_delta_list, and append a "+" record to
+   BUFFER if that is new or changed.  If FULL, the record is always
+   appended.  */
+
+static void
+handle_qxfer_threads_delta_worker (client_state &cs, thread_info *thread,
+				   std::string *buffer, bool full)
+{
+  ptid_t ptid = thread->id;
+
+  /* Like handle_qxfer_threads_worker, hide (v)fork/clone children
+     until GDB has seen the event that created them.  */
+  if (target_thread_pending_parent (thread) != nullptr)
+    return;
+
+  int core = target_core_of_thread (ptid);
+  const char *name = target_thread_name (ptid);
+  int handle_len;
+  gdb_byte *handle;
+  std::string handle_s;
+  if (target_thread_handle (ptid, &handle, &handle_len))
+    handle_s = bin2hex (handle, handle_len);
+  std::string name_s;
+  if (name != nullptr)
+    name_s = bin2hex ((const gdb_byte *) name, strlen (name));
+
+  auto it = cs.threads_delta_list.find (ptid);
+  if (it != cs.threads_delta_list.end ())
+    {
+      threads_delta_entry &entry = it->second;
+
+      entry.seen = true;
+      if (!full
+	  && entry.core == core
+	  && entry.name == name_s
+	  && entry.handle == handle_s)
+	return;
+
+      entry.core = core;
+      entry.name = name_s;
+      entry.handle = handle_s;
+    }
+  else
+    cs.threads_delta_list.emplace (ptid, threads_delta_entry { core, name_s,
+								 handle_s,
+								 true });
+
+  char ptid_s[100];
+  write_ptid (ptid_s, ptid);
+  *buffer += '+';
+  *buffer += ptid_s;
+  *buffer += ';';
+  if (core != -1)
+    *buffer += phex_nz (core, sizeof (core));
+  *buffer += ';';
+  *buffer += name_s;
+  *buffer += ';';
+  *buffer += handle_s;
+  *buffer += '\n';
+}
+
+/* Helper for handle_qxfer_threads_delta.  Describe the changes to
+   the thread list since generation GENERATION in BUFFER, or the whole
+   list if GDB does not have that generation.  */
+
+static void
+handle_qxfer_threads_delta_proper (ULONGEST generation, std::string *buffer)
+{
+  client_state &cs = get_client_state ();
+  bool full = (generation == 0 || generation != cs.threads_delta_generation);
+
+  if (full)
+    cs.threads_delta_list.clear ();
+
+  cs.threads_delta_generation++;
+  if (cs.threads_delta_generation == 0)
+    cs.threads_delta_generation++;
+
+  *buffer += string_printf ("%c%s\n", full ? 'F' : 'D',
+			    phex_nz (cs.threads_delta_generation,
+				     sizeof (cs.threads_delta_generation)));
+
+  for (auto &entry : cs.threads_delta_list)
+    entry.second.seen = false;
+
+  /* See handle_qxfer_threads_proper.  */
+  if (non_stop)
+    target_pause_all (true);
+
+  for_each_thread ([&] (thread_info *thread)
+    {
+      handle_qxfer_threads_delta_worker (cs, thread, buffer, full);
+    });
+
+  if (non_stop)
+    target_unpause_all (true);
+
+  for (auto it = cs.threads_delta_list.begin ();
+       it != cs.threads_delta_list.end ();)
+    {
+      if (it->second.seen)
+	{
+	  ++it;
+	  continue;
+	}
+
+      char ptid_s[100];
+      write_ptid (ptid_s, it->first);
+      *buffer += '-';
+      *buffer += ptid_s;
+      *buffer += '\n';
+      it = cs.threads_delta_list.erase (it);
+    }
+}
+
+/* Handle qXfer:threads-delta:read.  The annex is the generation of
+   the thread list GDB already has, in hex.  */
+
+static int
+handle_qxfer_threads_delta (const char *annex,
+			    gdb_byte *readbuf, const gdb_byte *writebuf,
+			    ULONGEST offset, LONGEST len)
+{
+  std::string &result = get_client_state ().qxfer_threads_delta_result;
+
+  if (writebuf != NULL)
+    return -2;
+
+  if (offset == 0)
+    {
+      ULONGEST generation = 0;
+      const char *end = unpack_varlen_hex (annex, &generation);
+
+      if (*end != '\0')
+	return -1;
+
+      /* When asked for data at offset 0, generate everything and store
+	 into 'result'.  Successive reads will be served off
+	 'result'.  */
+      result.clear ();
+      handle_qxfer_threads_delta_proper (generation, &result);
+    }
+
+  if (offset >= result.length ())
+    {
+      /* We're out of data.  */
+      result.clear ();
+      return 0;
+    }
+
+  if (len > result.length () - offset)
+    len = result.length () - offset;
+
+  memcpy (readbuf, result.c_str () + offset, len);
+
+  return len;
+}
+
 /* Handle qXfer:traceframe-info:read.  */
 
 static int
@@ -2326,6 +2542,7 @@ static const struct qxfer qxfer_packets[] =
     { "siginfo", handle_qxfer_siginfo },
     { "statictrace", handle_qxfer_statictrace },
     { "threads", handle_qxfer_threads },
+    { "threads-delta", handle_qxfer_threads_delta },
     { "traceframe-info", handle_qxfer_traceframe_info },
   };
 
@@ -2491,6 +2708,166 @@ parse_fetch_memtags_request (char *request, CORE_ADDR *addr, size_t *len,
   *type = (int) tag_type;
 }
 
+/* Whether THREAD is running, as far as the target can tell.  Its
+   registers must not be read then: they would be out of date at once,
+   yet its regcache would stay marked as fetched for the controlling
+   client.  Targets that cannot tell only support all-stop mode, where
+   no packet is handled while the program runs.  */
+
+static bool
+thread_running_p (thread_info *thread)
+{
+  return (the_target->supports_thread_stopped ()
+	  && !target_thread_stopped (thread));
+}
+
+/* Handle a qFramePrefetch packet, of the form:
+
+     qFramePrefetch:THREAD-ID,REGNO,BEFORE,AFTER,ALIGN,COUNT
+
+   Walk the frame pointer chain of thread THREAD-ID, starting from
+   register REGNO, for at most COUNT frames, and reply with the memory
+   from BEFORE bytes below to AFTER bytes above each frame pointer,
+   rounded out to a multiple of ALIGN, as a list of ADDR:XX...
+   blocks separated by ';'.  GDB then unwinds the thread using that
+   memory instead of reading it piecemeal.  The walk stops early when
+   the saved frame pointer does not point further up the stack, when
+   memory cannot be read, or when the reply is full.  */
+
+static void
+handle_frame_prefetch (char *own_buf)
+{
+  client_state &cs = get_client_state ();
+  const char *p = own_buf + strlen ("qFramePrefetch:");
+  ULONGEST params[5];
+
+  ptid_t ptid = read_ptid (p, &p);
+  for (ULONGEST &param : params)
+    {
+      if (*p++ != ',')
+	{
+	  write_enn (own_buf);
+	  return;
+	}
+      p = unpack_varlen_hex (p, &param);
+    }
+
+  ULONGEST regno = params[0];
+  ULONGEST before = params[1];
+  ULONGEST after = params[2];
+  ULONGEST align = params[3];
+  ULONGEST count = params[4];
+
+  thread_info *thread = find_thread_ptid (ptid);
+  if (*p != '\0' || thread == nullptr || thread_running_p (thread)
+      || cs.current_traceframe >= 0
+      || align == 0 || (align & (align - 1)) != 0
+      || before > PBUFSIZ || after > PBUFSIZ)
+    {
+      write_enn (own_buf);
+      return;
+    }
+
+  scoped_restore_current_thread restore_thread;
+  switch_to_thread (thread);
+
+  regcache *regcache = get_thread_regcache (thread);
+  if (regno >= regcache->tdesc->reg_defs.size ()
+      || regcache->get_register_status (regno) != REG_VALID)
+    {
+      write_enn (own_buf);
+      return;
+    }
+
+  int ptr_size = register_size (regcache->tdesc, regno);
+  CORE_ADDR fp = regcache_raw_get_unsigned (regcache, regno);
+
+  /* Frames are usually closer together than the memory GDB wants
+     around each of them, so merge the windows as they are read.  */
+  CORE_ADDR block_start = 0;
+  gdb::byte_vector block;
+  char *buf = own_buf;
+  char *buf_end = own_buf + PBUFSIZ - 64;
+
+  auto flush_block = [&] ()
+    {
+      if (block.empty ())
+	return;
+
+      sprintf (buf, "%s%s:", buf == own_buf ? "" : ";",
+	       paddress (block_start));
+      buf += strlen (buf);
+      buf += 2 * bin2hex (block.data (), buf, block.size ());
+      block.clear ();
+    };
+
+  for (ULONGEST i = 0; i < count && fp != 0; i++)
+    {
+      CORE_ADDR start = align_down (fp < before ? 0 : fp - before, align);
+      CORE_ADDR end = align_up (fp + after, align);
+
+      if (block.empty () || start > block_start + block.size ())
+	{
+	  flush_block ();
+	  block_start = start;
+	}
+
+      CORE_ADDR read_from = block_start + block.size ();
+      if (end > read_from)
+	{
+	  size_t old_size = block.size ();
+	  size_t new_size = old_size + (end - read_from);
+
+	  if (buf + 2 * new_size + 32 > buf_end)
+	    break;
+
+	  block.resize (new_size);
+	  if (read_inferior_memory (read_from, block.data () + old_size,
+				    end - read_from) != 0)
+	    {
+	      block.resize (old_size);
+	      break;
+	    }
+	}
+
+      /* The caller's frame pointer is saved where this one points.
+	 The stub runs on the target, so it is in host byte order.  */
+      if (fp < block_start || fp + ptr_size > block_start + block.size ())
+	break;
+
+      const gdb_byte *saved_fp = block.data () + (fp - block_start);
+      CORE_ADDR next;
+      if (ptr_size == 8)
+	{
+	  uint64_t val;
+	  memcpy (&val, saved_fp, sizeof (val));
+	  next = val;
+	}
+      else if (ptr_size == 4)
+	{
+	  uint32_t val;
+	  memcpy (&val, saved_fp, sizeof (val));
+	  next = val;
+	}
+      else
+	break;
+
+      /* Stacks grow down, so callers' frames are at higher
+	 addresses.  Anything else means there is no frame pointer
+	 chain past this frame.  */
+      if (next <= fp)
+	break;
+      fp = next;
+    }
+
+  flush_block ();
+
+  if (buf == own_buf)
+    write_ok (own_buf);
+  else
+    *buf = '\0';
+}
+
 /* Add supported btrace packets to BUF.  */
 
 static void
@@ -2677,6 +3054,9 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
     {
       char *p = &own_buf[10];
       int gdb_supports_qRelocInsn = 0;
+#ifdef HAVE_ZLIB
+      bool gdb_supports_compression = false;
+#endif
 
       /* Process each feature being provided by GDB.  The first
 	 feature will follow a ':', and latter features will follow
@@ -2761,6 +3141,10 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 		}
 	      else if (feature == "error-message+")
 		cs.error_message_supported = true;
+#ifdef HAVE_ZLIB
+	      else if (feature == "compression=zlib")
+		gdb_supports_compression = true;
+#endif
 	      else
 		{
 		  /* Move the unknown features all together.  */
@@ -2833,6 +3217,7 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 	strcat (own_buf, ";QDisableRandomization+");
 
       strcat (own_buf, ";qXfer:threads:read+");
+      strcat (own_buf, ";qXfer:threads-delta:read+");
 
       if (target_supports_tracepoints ())
 	{
@@ -2890,6 +3275,26 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
       if (target_supports_memory_tagging ())
 	strcat (own_buf, ";memory-tagging+");
 
+      /* Packets are read from the connection and handled one at a
+	 time, so replies always come back in the order GDB sent the
+	 requests, provided the target keeps nothing between them.  */
+      if (target_supports_pipelining ())
+	{
+	  strcat (own_buf, ";vFile:pread-pipelined+");
+	  strcat (own_buf, ";QPipelining+");
+	}
+
+      strcat (own_buf, ";QExpedite+");
+      strcat (own_buf, ";qFramePrefetch+");
+
+#ifdef HAVE_ZLIB
+      if (gdb_supports_compression)
+	{
+	  strcat (own_buf, ";compression=zlib");
+	  remote_start_compression ();
+	}
+#endif
+
       /* Reinitialize components as needed for the new connection.  */
       hostio_handle_new_gdb_connection ();
       target_handle_new_gdb_connection ();
@@ -2985,6 +3390,13 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
       return;
     }
 
+  if (startswith (own_buf, "qFramePrefetch:"))
+    {
+      require_running_or_return (own_buf);
+      handle_frame_prefetch (own_buf);
+      return;
+    }
+
   /* Handle "monitor" commands.  */
   if (startswith (own_buf, "qRcmd,"))
     {
@@ -3859,6 +4271,8 @@ gdbserver_usage (FILE *stream)
 	   "  --multi               Start server without a specific program, and\n"
 	   "                        only quit when explicitly commanded.\n"
 	   "  --once                Exit after the first connection has closed.\n"
+	   "  --observers           Accept further connections while a client is\n"
+	   "                        connected, as read-only observer sessions.\n"
 	   "  --help                Print this message and then exit.\n"
 	   "  --version             Display version information and exit.\n"
 	   "\n"
@@ -4272,6 +4686,8 @@ captured_main (int argc, char *argv[])
 	startup_with_shell = false;
       else if (strcmp (*next_arg, "--once") == 0)
 	run_once = true;
+      else if (strcmp (*next_arg, "--observers") == 0)
+	allow_observers = true;
       else if (strcmp (*next_arg, "--selftest") == 0)
 	selftest = true;
       else if (startswith (*next_arg, "--selftest="))
@@ -4431,6 +4847,9 @@ captured_main (int argc, char *argv[])
       cs.vCont_supported = 0;
       cs.memory_tagging_feature = false;
       cs.error_message_supported = false;
+      cs.expedite_regs.clear ();
+      cs.expedite_sp_regno = -1;
+      cs.expedite_stack_len = 0;
 
       remote_open (port);
 
@@ -4591,34 +5010,21 @@ process_point_options (struct gdb_breakpoint *bp, const char **packet)
   *packet = dataptr;
 }
 
-/* Event loop callback that handles a serial event.  The first byte in
-   the serial buffer gets us here.  We expect characters to arrive at
-   a brisk pace, so we read the rest of the packet with a blocking
-   getpkt call.  */
+/* Handle the packet of PACKET_LEN bytes in the current client's
+   OWN_BUF, and leave the reply there.  If the reply is binary, set
+   *NEW_PACKET_LEN_P to its length.  Return false if no reply must be
+   sent.  */
 
-static int
-process_serial_event (void)
+static bool
+dispatch_packet (int packet_len, int *new_packet_len_p)
 {
   client_state &cs = get_client_state ();
   int signal;
   unsigned int len;
   CORE_ADDR mem_addr;
   unsigned char sig;
-  int packet_len;
   int new_packet_len = -1;
 
-  disable_async_io ();
-
-  response_needed = false;
-  packet_len = getpkt (cs.own_buf);
-  if (packet_len <= 0)
-    {
-      remote_close ();
-      /* Force an event loop break.  */
-      return -1;
-    }
-  response_needed = true;
-
   char ch = cs.own_buf[0];
   switch (ch)
     {
@@ -4880,7 +5286,7 @@ process_serial_event (void)
       if (!target_running ())
 	/* The packet we received doesn't make sense - but we can't
 	   reply to it, either.  */
-	return 0;
+	return false;
 
       fprintf (stderr, "Killing all inferiors\n");
 
@@ -4891,7 +5297,7 @@ process_serial_event (void)
       if (extended_protocol)
 	{
 	  cs.last_status.set_exited (GDB_SIGNAL_KILL);
-	  return 0;
+	  return false;
 	}
       else
 	exit (0);
@@ -4946,7 +5352,7 @@ process_serial_event (void)
 	    {
 	      cs.last_status.set_exited (GDB_SIGNAL_KILL);
 	    }
-	  return 0;
+	  return false;
 	}
       else
 	{
@@ -4969,6 +5375,37 @@ process_serial_event (void)
       break;
     }
 
+  *new_packet_len_p = new_packet_len;
+  return true;
+}
+
+/* Event loop callback that handles a serial event.  The first byte in
+   the serial buffer gets us here.  We expect characters to arrive at
+   a brisk pace, so we read the rest of the packet with a blocking
+   getpkt call.  */
+
+static int
+process_serial_event (void)
+{
+  client_state &cs = get_client_state ();
+  int packet_len;
+  int new_packet_len = -1;
+
+  disable_async_io ();
+
+  response_needed = false;
+  packet_len = getpkt (cs.own_buf);
+  if (packet_len <= 0)
+    {
+      remote_close ();
+      /* Force an event loop break.  */
+      return -1;
+    }
+  response_needed = true;
+
+  if (!dispatch_packet (packet_len, &new_packet_len))
+    return 0;
+
   if (new_packet_len != -1)
     putpkt_binary (cs.own_buf, new_packet_len);
   else
@@ -4982,6 +5419,211 @@ process_serial_event (void)
   return 0;
 }
 
+/* Reply to the qSupported packet in OWN_BUF from an observer session,
+   only offering what such a session may use.  */
+
+static void
+handle_observer_qsupported (char *own_buf)
+{
+  client_state &cs = get_client_state ();
+
+  if (own_buf[10] == ':')
+    {
+      char *saveptr;
+      for (char *p = strtok_r (own_buf + 11, ";", &saveptr);
+	   p != nullptr;
+	   p = strtok_r (nullptr, ";", &saveptr))
+	{
+	  if (strcmp (p, "multiprocess+") == 0)
+	    cs.multi_process = target_supports_multi_process ();
+	  else if (strcmp (p, "error-message+") == 0)
+	    cs.error_message_supported = true;
+	}
+    }
+
+  sprintf (own_buf, "PacketSize=%x;QStartNoAckMode+;qXfer:features:read+;"
+	   "qXfer:threads:read+;qXfer:exec-file:read+;QExpedite+;"
+	   "qFramePrefetch+", PBUFSIZ - 1);
+
+  if (the_target->supports_qxfer_libraries_svr4 ())
+    strcat (own_buf, ";qXfer:libraries-svr4:read+");
+  else
+    strcat (own_buf, ";qXfer:libraries:read+");
+
+  if (the_target->supports_read_auxv ())
+    strcat (own_buf, ";qXfer:auxv:read+");
+
+  if (the_target->supports_qxfer_siginfo ())
+    strcat (own_buf, ";qXfer:siginfo:read+");
+
+  if (target_supports_multi_process ())
+    strcat (own_buf, ";multiprocess+");
+
+  strcat (own_buf, ";error-message+");
+}
+
+/* Reply to the '?' packet from an observer session with the last stop
+   the controlling client was told about, without changing what will be
+   reported to that client.  Reply with an error if that thread is
+   running, since the stop reply includes its registers.  */
+
+static void
+handle_observer_status (char *own_buf)
+{
+  thread_info *thread = find_thread_ptid (g_client_state.last_ptid);
+  if (thread == nullptr)
+    thread = get_first_thread ();
+
+  if (thread == nullptr)
+    {
+      strcpy (own_buf, "W00");
+      return;
+    }
+
+  if (thread_running_p (thread))
+    {
+      write_enn (own_buf);
+      return;
+    }
+
+  target_waitstatus status;
+  if (thread->id == g_client_state.last_ptid
+      && g_client_state.last_status.kind () == TARGET_WAITKIND_STOPPED)
+    status = g_client_state.last_status;
+  else
+    status.set_stopped (GDB_SIGNAL_0);
+
+  switch_to_thread (thread);
+  process_info *process = thread->process ();
+  bool dlls_changed = process->dlls_changed;
+  prepare_resume_reply (own_buf, thread->id, status);
+  process->dlls_changed = dlls_changed;
+}
+
+/* Whether an observer session may send the 'q' packet in OWN_BUF.
+   Queries whose replies are built across several packets from state
+   shared with the controlling client, like qfThreadInfo, are left
+   out.  */
+
+static bool
+observer_query_allowed_p (const char *own_buf)
+{
+  static const char *const allowed[] = {
+    "qC", "qAttached", "qOffsets", "qCRC:", "qSearch:memory:",
+    "qThreadExtraInfo,", "qGetTLSAddr:", "qFramePrefetch:",
+    "qXfer:features:read:", "qXfer:threads:read:", "qXfer:auxv:read:",
+    "qXfer:exec-file:read:", "qXfer:libraries:read:",
+    "qXfer:libraries-svr4:read:", "qXfer:siginfo:read:",
+    "qXfer:threads-delta:read:",
+  };
+
+  for (const char *prefix : allowed)
+    if (startswith (own_buf, prefix))
+      return true;
+
+  return false;
+}
+
+/* See server.h.  */
+
+bool
+handle_observer_packet (client_state &observer, int packet_len,
+			int *new_packet_len_p, bool *close_p)
+{
+  scoped_restore restore_client
+    = make_scoped_restore (&current_client_state, &observer);
+  scoped_restore_current_thread restore_thread;
+  char *own_buf = observer.own_buf;
+
+  *new_packet_len_p = -1;
+  *close_p = false;
+
+  try
+    {
+      switch (own_buf[0])
+	{
+	case 'q':
+	  if (startswith (own_buf, "qSupported")
+	      && (own_buf[10] == ':' || own_buf[10] == '\0'))
+	    handle_observer_qsupported (own_buf);
+	  else if (observer_query_allowed_p (own_buf))
+	    return dispatch_packet (packet_len, new_packet_len_p);
+	  else
+	    own_buf[0] = '\0';
+	  return true;
+
+	case 'Q':
+	  if (startswith (own_buf, "QStartNoAckMode")
+	      || startswith (own_buf, "QExpedite:"))
+	    return dispatch_packet (packet_len, new_packet_len_p);
+	  own_buf[0] = '\0';
+	  return true;
+
+	case '?':
+	  handle_observer_status (own_buf);
+	  return true;
+
+	case '!':
+	  write_ok (own_buf);
+	  return true;
+
+	case 'g':
+	  if (set_desired_thread () && thread_running_p (current_thread))
+	    {
+	      write_enn (own_buf);
+	      return true;
+	    }
+	  return dispatch_packet (packet_len, new_packet_len_p);
+
+	case 'H':
+	case 'm':
+	case 'x':
+	case 'T':
+	  return dispatch_packet (packet_len, new_packet_len_p);
+
+	case 'D':
+	  /* Leave the program alone, and end the session.  */
+	  write_ok (own_buf);
+	  *close_p = true;
+	  return true;
+
+	case 'k':
+	  *close_p = true;
+	  return false;
+
+	case 'v':
+	  /* Observers can neither resume nor run programs, nor access
+	     files, whose handles the controlling client owns.  */
+	  if (startswith (own_buf, "vKill"))
+	    {
+	      write_ok (own_buf);
+	      *close_p = true;
+	    }
+	  else
+	    own_buf[0] = '\0';
+	  return true;
+
+	default:
+	  /* Anything else would change the program, or what the
+	     controlling client knows of it.  */
+	  if (observer.error_message_supported)
+	    strcpy (own_buf, "E.Observer sessions are read-only.");
+	  else
+	    write_enn (own_buf);
+	  return true;
+	}
+    }
+  catch (const gdb_exception_error &exception)
+    {
+      if (observer.error_message_supported)
+	sprintf (own_buf, "E.%s", exception.what ());
+      else
+	write_enn (own_buf);
+      *new_packet_len_p = -1;
+      return true;
+    }
+}
+
 /* Event-loop callback for serial events.  */
 
 void
@@ -74,6 +74,7 @@ extern bool disable_packet_qfThreadInfo;
 extern bool disable_packet_T;
 
 extern bool run_once;
+extern bool allow_observers;
 extern bool non_stop;
 
 #include "gdbsupport/event-loop.h"
@@ -126,6 +127,19 @@ extern unsigned long signal_pid;
 /* Description of the client remote protocol state for the currently
    connected client.  */
 
+/* What GDB was last told about a thread through
+   qXfer:threads-delta:read.  */
+
+struct threads_delta_entry
+{
+  int core;
+  std::string name;
+  std::string handle;
+
+  /* Set while computing a delta, for the threads that still exist.  */
+  bool seen;
+};
+
 struct client_state
 {
   client_state ():
@@ -196,10 +210,50 @@ struct client_state
      are not supported with qRcmd and m packets, but are still supported
      everywhere else.  This is for backward compatibility reasons.  */
   bool error_message_supported = false;
+
+  /* Registers GDB asked to have included in stop replies with the
+     QExpedite packet, in addition to the expedited registers of the
+     target description.  */
+  std::vector<int> expedite_regs;
+
+  /* The register holding the stack pointer, and how many bytes of
+     memory at the address it holds to include in stop replies, also
+     set with QExpedite.  */
+  int expedite_sp_regno = -1;
+  int expedite_stack_len = 0;
+
+  /* The qXfer:threads:read document being transferred, built when
+     offset 0 is requested.  */
+  std::string qxfer_threads_result;
+
+  /* Likewise for qXfer:threads-delta:read.  */
+  std::string qxfer_threads_delta_result;
+
+  /* The thread list as last sent to GDB with qXfer:threads-delta:read,
+     and its generation number.  A generation number of 0 is never
+     used, so that GDB can ask for the full list with it.  */
+  std::unordered_map<ptid_t, threads_delta_entry> threads_delta_list;
+  ULONGEST threads_delta_generation = 0;
+
+  /* Likewise for qXfer:libraries-svr4:read, with the process and the
+     annex it was built for.  */
+  int qxfer_libraries_svr4_pid = 0;
+  std::string qxfer_libraries_svr4_annex;
+  std::string qxfer_libraries_svr4_result;
 };
 
 client_state &get_client_state ();
 
+/* Handle the packet of PACKET_LEN bytes in the OWN_BUF of OBSERVER, a
+   read-only observer session, and leave the reply there.  Requests
+   that would resume or change the program are refused.  If the reply
+   is binary, set *NEW_PACKET_LEN_P to its length.  Set *CLOSE_P if the
+   session must end after the reply.  Return false if no reply must be
+   sent.  */
+
+extern bool handle_observer_packet (client_state &observer, int packet_len,
+				    int *new_packet_len_p, bool *close_p);
+
 #include "gdbthread.h"
 #include "inferiors.h"
 
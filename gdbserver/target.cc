@@ -839,6 +839,12 @@ process_stratum_target::supports_catch_syscall ()
   return false;
 }
 
+bool
+process_stratum_target::supports_pipelining ()
+{
+  return false;
+}
+
 int
 process_stratum_target::get_ipa_tdesc_idx ()
 {
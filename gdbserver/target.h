@@ -497,6 +497,12 @@ class process_stratum_target
   /* Return true if the target supports catch syscall.  */
   virtual bool supports_catch_syscall ();
 
+  /* Return true if GDB may send several requests to this target
+     without waiting for each reply.  The requests then queue up in
+     the connection, and are read, handled and answered one at a time,
+     in the order they were sent.  */
+  virtual bool supports_pipelining ();
+
   /* Return tdesc index for IPA.  */
   virtual int get_ipa_tdesc_idx ();
 
@@ -578,6 +584,9 @@ int kill_inferior (process_info *proc);
 #define target_supports_catch_syscall()              	\
   the_target->supports_catch_syscall ()
 
+#define target_supports_pipelining() \
+  the_target->supports_pipelining ()
+
 #define target_get_ipa_tdesc_idx()			\
   the_target->get_ipa_tdesc_idx ()
 
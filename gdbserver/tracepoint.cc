@@ -25,6 +25,8 @@
 #include <unistd.h>
 #include <chrono>
 #include <inttypes.h>
+#include <string_view>
+#include <unordered_map>
 #include "ax.h"
 #include "tdesc.h"
 
@@ -975,6 +977,72 @@ struct traceframe
 
 #ifndef IN_PROCESS_AGENT
 static int circular_trace_buffer;
+
+/* This flag is true if the traceframes GDBserver collects are stored
+   compactly.  Memory whose contents are already in the trace buffer
+   is recorded as a 'D' block referring to those contents instead of
+   as an 'M' block, and registers are recorded as an 'r' block
+   holding their differences with the last 'R' block of the same
+   tracepoint, when that is smaller.  Traceframes uploaded from the
+   in-process agent are stored as they are.
+
+   A 'D' block holds the address and length of the memory, like an
+   'M' block, followed by the number of the traceframe holding the
+   contents, counted from the start of the run like
+   traceframes_created, and the offset of the contents from
+   trace_buffer_lo, both as unsigned ints.  An 'r' block holds the
+   traceframe number and offset of the contents of the 'R' block it
+   is based on, then the length of the rest of the block as an
+   unsigned short, then runs of changed bytes, each an unsigned short
+   offset in the registers, an unsigned short length and the bytes
+   themselves.
+
+   In a circular trace buffer, a traceframe may be discarded while
+   later traceframes still refer to its contents, which then become
+   unavailable.  To limit that, blocks only refer to contents stored
+   in the last 1/COMPACT_TRACEFRAME_WINDOW of the trace buffer in that
+   case, so that only the oldest traceframes lose data.  */
+
+static int compact_trace_buffer;
+
+#define COMPACT_TRACEFRAME_WINDOW 8
+
+/* Where the contents of an 'M' or 'R' block that later blocks may
+   refer to are.  */
+
+struct compact_block_ref
+{
+  /* The number of the traceframe holding the contents, as in a 'D'
+     or 'r' block.  */
+  unsigned int frame;
+
+  /* The offset of the contents from trace_buffer_lo.  */
+  unsigned int offset;
+
+  /* The length of the contents.  */
+  unsigned short length;
+
+  /* The value of traceframe_bytes_stored when the contents were
+     stored.  */
+  ULONGEST stored;
+};
+
+/* The contents of the 'M' blocks of the run, by hash.  When two
+   blocks have the same hash, only the last one is kept.  */
+
+static std::unordered_map<size_t, compact_block_ref> compact_memory_blocks;
+
+/* The last 'R' block of each tracepoint.  */
+
+static std::unordered_map<const struct tracepoint *, compact_block_ref>
+  compact_register_blocks;
+
+/* The number of bytes the blocks of the traceframes of the run would
+   take if they were all stored as they are, and the number of bytes
+   they do take.  */
+
+static ULONGEST traceframe_bytes_collected;
+static ULONGEST traceframe_bytes_stored;
 #endif
 
 /* Size of the trace buffer.  */
@@ -1342,6 +1410,7 @@ struct trap_tracepoint_ctx
 #ifndef IN_PROCESS_AGENT
 static CORE_ADDR traceframe_get_pc (struct traceframe *tframe);
 static int traceframe_read_tsv (int num, LONGEST *val);
+static void expand_trace_buffer (gdb::byte_vector *out);
 #endif
 
 static int condition_true_at_tracepoint (struct tracepoint_hit_ctx *ctx,
@@ -1429,6 +1498,11 @@ clear_trace_buffer (void)
   ((struct traceframe *) trace_buffer_free)->data_size = 0;
   traceframe_read_count = traceframe_write_count = 0;
   traceframes_created = 0;
+#ifndef IN_PROCESS_AGENT
+  compact_memory_blocks.clear ();
+  compact_register_blocks.clear ();
+  traceframe_bytes_collected = traceframe_bytes_stored = 0;
+#endif
 }
 
 #ifndef IN_PROCESS_AGENT
@@ -2220,6 +2294,10 @@ add_traceframe_block (struct traceframe *tframe,
 
   tframe->data_size += amt;
   tpoint->traceframe_usage += amt;
+#ifndef IN_PROCESS_AGENT
+  traceframe_bytes_collected += amt;
+  traceframe_bytes_stored += amt;
+#endif
 
   return block;
 }
@@ -2235,6 +2313,216 @@ finish_traceframe (struct traceframe *tframe)
 
 #ifndef IN_PROCESS_AGENT
 
+/* Return true if AMT bytes can be allocated in the trace buffer
+   without discarding any traceframe.  This follows
+   trace_buffer_alloc.  */
+
+static bool
+trace_buffer_fits_p (size_t amt)
+{
+  amt += TRACEFRAME_EOB_MARKER_SIZE;
+
+  if (trace_buffer_end_free < trace_buffer_free)
+    return (trace_buffer_free + amt <= trace_buffer_hi
+	    || trace_buffer_lo + amt <= trace_buffer_end_free);
+
+  return trace_buffer_free + amt <= trace_buffer_end_free;
+}
+
+/* Return the contents of the block that REF refers to, or NULL if
+   the traceframe holding them was discarded.  */
+
+static unsigned char *
+compact_block_data (const compact_block_ref &ref)
+{
+  if (ref.frame < (unsigned int) traceframes_created - traceframe_count)
+    return NULL;
+
+  return trace_buffer_lo + ref.offset;
+}
+
+/* Return the contents of the block that REF refers to, if a block of
+   AMT bytes referring to them can be added to the current traceframe,
+   and NULL otherwise.  */
+
+static unsigned char *
+compact_block_usable (const compact_block_ref &ref, size_t amt)
+{
+  if (circular_trace_buffer
+      && (traceframe_bytes_stored - ref.stored
+	  >= (ULONGEST) trace_buffer_size / COMPACT_TRACEFRAME_WINDOW
+	  || !trace_buffer_fits_p (amt)))
+    return NULL;
+
+  return compact_block_data (ref);
+}
+
+/* Return a reference to the contents of LENGTH bytes at DATA, in the
+   traceframe being collected.  */
+
+static compact_block_ref
+make_compact_block_ref (const unsigned char *data, unsigned short length)
+{
+  compact_block_ref ref;
+
+  ref.frame = traceframes_created;
+  ref.offset = data - trace_buffer_lo;
+  ref.length = length;
+  ref.stored = traceframe_bytes_stored;
+  return ref;
+}
+
+/* Record the LEN bytes at BUF, read from FROM, in TFRAME, as a 'D'
+   block if the trace buffer holds the same contents already, and as
+   an 'M' block otherwise.  Return false if the trace buffer is
+   full.  */
+
+static bool
+add_compact_memory_block (struct traceframe *tframe,
+			  struct tracepoint *tpoint, CORE_ADDR from,
+			  const unsigned char *buf, unsigned short len)
+{
+  size_t raw_size = 1 + sizeof (from) + sizeof (len) + len;
+  size_t hash
+    = std::hash<std::string_view> () (std::string_view ((const char *) buf,
+							 len));
+  unsigned char *mspace;
+
+  auto it = compact_memory_blocks.find (hash);
+  if (it != compact_memory_blocks.end ())
+    {
+      const compact_block_ref &ref = it->second;
+      size_t sp = (1 + sizeof (from) + sizeof (len)
+		   + sizeof (ref.frame) + sizeof (ref.offset));
+      const unsigned char *data = compact_block_usable (ref, sp);
+
+      if (sp < raw_size && data != NULL
+	  && ref.length == len && memcmp (data, buf, len) == 0)
+	{
+	  /* Copy the reference, in case allocating invalidates IT.  */
+	  compact_block_ref found = ref;
+
+	  mspace = add_traceframe_block (tframe, tpoint, sp);
+	  if (mspace == NULL)
+	    return false;
+	  *mspace++ = 'D';
+	  memcpy (mspace, &from, sizeof (from));
+	  mspace += sizeof (from);
+	  memcpy (mspace, &len, sizeof (len));
+	  mspace += sizeof (len);
+	  memcpy (mspace, &found.frame, sizeof (found.frame));
+	  mspace += sizeof (found.frame);
+	  memcpy (mspace, &found.offset, sizeof (found.offset));
+
+	  traceframe_bytes_collected += raw_size - sp;
+	  trace_debug ("%d bytes recorded as a reference to traceframe %u",
+		       len, found.frame);
+	  return true;
+	}
+    }
+
+  mspace = add_traceframe_block (tframe, tpoint, raw_size);
+  if (mspace == NULL)
+    return false;
+  *mspace++ = 'M';
+  memcpy (mspace, &from, sizeof (from));
+  mspace += sizeof (from);
+  memcpy (mspace, &len, sizeof (len));
+  mspace += sizeof (len);
+  memcpy (mspace, buf, len);
+
+  compact_memory_blocks[hash] = make_compact_block_ref (mspace, len);
+  trace_debug ("%d bytes recorded", len);
+  return true;
+}
+
+/* Record the registers in REGS, of SIZE bytes, in TFRAME, as an 'r'
+   block if that is smaller than an 'R' block.  Return false if the
+   trace buffer is full.  */
+
+static bool
+add_compact_register_block (struct traceframe *tframe,
+			    struct tracepoint *tpoint,
+			    const unsigned char *regs, int size)
+{
+  size_t raw_size = 1 + size;
+  const unsigned char *base = NULL;
+  unsigned char *regspace;
+
+  auto it = compact_register_blocks.find (tpoint);
+  if (it != compact_register_blocks.end ())
+    base = compact_block_data (it->second);
+
+  if (base != NULL)
+    {
+      compact_block_ref ref = it->second;
+      std::vector<std::pair<int, int>> runs;
+      size_t runs_size = 0;
+
+      /* Find the runs of bytes that changed.  A run also covers
+	 unchanged bytes when they are fewer than a run header.  */
+      for (int i = 0; i < size; i++)
+	{
+	  if (regs[i] == base[i])
+	    continue;
+
+	  int end = i + 1;
+	  for (int j = end; j < size && j < end + 4; j++)
+	    if (regs[j] != base[j])
+	      end = j + 1;
+
+	  runs.emplace_back (i, end - i);
+	  runs_size += 2 * sizeof (unsigned short) + (end - i);
+	  i = end;
+	}
+
+      size_t sp = (1 + sizeof (ref.frame) + sizeof (ref.offset)
+		   + sizeof (unsigned short) + runs_size);
+      if (sp < raw_size
+	  && runs_size <= 65535
+	  && compact_block_usable (ref, sp) != NULL)
+	{
+	  unsigned short len = runs_size;
+
+	  regspace = add_traceframe_block (tframe, tpoint, sp);
+	  if (regspace == NULL)
+	    return false;
+	  *regspace++ = 'r';
+	  memcpy (regspace, &ref.frame, sizeof (ref.frame));
+	  regspace += sizeof (ref.frame);
+	  memcpy (regspace, &ref.offset, sizeof (ref.offset));
+	  regspace += sizeof (ref.offset);
+	  memcpy (regspace, &len, sizeof (len));
+	  regspace += sizeof (len);
+	  for (const auto &[start, length] : runs)
+	    {
+	      unsigned short rstart = start, rlen = length;
+
+	      memcpy (regspace, &rstart, sizeof (rstart));
+	      regspace += sizeof (rstart);
+	      memcpy (regspace, &rlen, sizeof (rlen));
+	      regspace += sizeof (rlen);
+	      memcpy (regspace, regs + start, length);
+	      regspace += length;
+	    }
+
+	  traceframe_bytes_collected += raw_size - sp;
+	  trace_debug ("Registers recorded as %d runs of changed bytes",
+		       (int) runs.size ());
+	  return true;
+	}
+    }
+
+  regspace = add_traceframe_block (tframe, tpoint, raw_size);
+  if (regspace == NULL)
+    return false;
+  *regspace++ = 'R';
+  memcpy (regspace, regs, size);
+
+  compact_register_blocks[tpoint] = make_compact_block_ref (regspace, size);
+  return true;
+}
+
 /* Given a traceframe number NUM, find the NUMth traceframe in the
    buffer.  */
 
@@ -3671,6 +3959,7 @@ cmd_qtstatus (char *packet)
 	   "tframes:%x;tcreated:%x;"
 	   "tfree:%x;tsize:%s;"
 	   "circular:%d;"
+	   "compact:%d;tcollected:%s;tstored:%s;"
 	   "disconn:%d;"
 	   "starttime:%s;stoptime:%s;"
 	   "username:%s;notes:%s:",
@@ -3679,6 +3968,9 @@ cmd_qtstatus (char *packet)
 	   traceframe_count, traceframes_created,
 	   free_space (), phex_nz (trace_buffer_hi - trace_buffer_lo, 0),
 	   circular_trace_buffer,
+	   compact_trace_buffer,
+	   phex_nz (traceframe_bytes_collected, sizeof (ULONGEST)),
+	   phex_nz (traceframe_bytes_stored, sizeof (ULONGEST)),
 	   disconnected_tracing,
 	   phex_nz (tracing_start_time, sizeof (tracing_start_time)),
 	   phex_nz (tracing_stop_time, sizeof (tracing_stop_time)),
@@ -3990,7 +4282,21 @@ cmd_qtbuffer (char *own_buf)
   trace_debug ("Want to get trace buffer, %d bytes at offset 0x%s",
 	       (int) num, phex_nz (offset, 0));
 
-  tot = (trace_buffer_hi - trace_buffer_lo) - free_space ();
+  /* Compact blocks refer to other parts of the trace buffer, which
+     GDB does not know about, so give it a copy of the trace buffer
+     where they are expanded.  The copy is made when GDB starts
+     reading, so that GDB sees a consistent snapshot.  */
+  static gdb::byte_vector expanded;
+  bool use_expanded = traceframe_bytes_collected != traceframe_bytes_stored;
+
+  if (use_expanded)
+    {
+      if (offset == 0)
+	expand_trace_buffer (&expanded);
+      tot = expanded.size ();
+    }
+  else
+    tot = (trace_buffer_hi - trace_buffer_lo) - free_space ();
 
   /* If we're right at the end, reply specially that we're done.  */
   if (offset == tot)
@@ -4008,9 +4314,14 @@ cmd_qtbuffer (char *own_buf)
 
   /* Compute the pointer corresponding to the given offset, accounting
      for wraparound.  */
-  tbp = trace_buffer_start + offset;
-  if (tbp >= trace_buffer_wrap)
-    tbp -= (trace_buffer_wrap - trace_buffer_lo);
+  if (use_expanded)
+    tbp = expanded.data () + offset;
+  else
+    {
+      tbp = trace_buffer_start + offset;
+      if (tbp >= trace_buffer_wrap)
+	tbp -= (trace_buffer_wrap - trace_buffer_lo);
+    }
 
   /* Trim to the remaining bytes if we're close to the end.  */
   if (num > tot - offset)
@@ -4038,6 +4349,21 @@ cmd_bigqtbuffer_circular (char *own_buf)
   write_ok (own_buf);
 }
 
+static void
+cmd_bigqtbuffer_compact (char *own_buf)
+{
+  ULONGEST val;
+  char *packet = own_buf;
+
+  packet += strlen ("QTBuffer:compact:");
+
+  unpack_varlen_hex (packet, &val);
+  compact_trace_buffer = val;
+  trace_debug ("Traceframes are now stored %s",
+	       compact_trace_buffer ? "compactly" : "as they are");
+  write_ok (own_buf);
+}
+
 static void
 cmd_bigqtbuffer_size (char *own_buf)
 {
@@ -4192,6 +4518,11 @@ handle_tracepoint_general_set (char *packet)
       cmd_bigqtbuffer_circular (packet);
       return 1;
     }
+  else if (startswith (packet, "QTBuffer:compact:"))
+    {
+      cmd_bigqtbuffer_compact (packet);
+      return 1;
+    }
   else if (startswith (packet, "QTBuffer:size:"))
     {
       cmd_bigqtbuffer_size (packet);
@@ -4781,6 +5112,24 @@ do_action_at_tracepoint (struct tracepoint_hit_ctx *ctx,
 	context_regcache = get_context_regcache (ctx);
 	regcache_size = register_cache_size (context_regcache->tdesc);
 
+#ifndef IN_PROCESS_AGENT
+	if (compact_trace_buffer && regcache_size <= 65535)
+	  {
+	    gdb::byte_vector regs (regcache_size);
+
+	    /* As below, but the registers go to a scratch buffer
+	       first, to compare them with earlier ones.  */
+	    init_register_cache (&tregcache, context_regcache->tdesc,
+				 regs.data ());
+	    tregcache.copy_from (context_regcache);
+	    regcache_write_pc (&tregcache, stop_pc);
+	    if (!add_compact_register_block (tframe, tpoint, regs.data (),
+					     regcache_size))
+	      trace_debug ("Trace buffer block allocation failed, skipping");
+	    break;
+	  }
+#endif
+
 	/* Collect all registers for now.  */
 	regspace = add_traceframe_block (tframe, tpoint, 1 + regcache_size);
 	if (regspace == NULL)
@@ -4928,6 +5277,20 @@ agent_mem_read (struct eval_agent_expr_context *ctx,
       size_t sp;
 
       blocklen = (remaining > 65535 ? 65535 : remaining);
+#ifndef IN_PROCESS_AGENT
+      if (compact_trace_buffer)
+	{
+	  gdb::byte_vector buf (blocklen);
+
+	  if (read_inferior_memory (from, buf.data (), blocklen) != 0
+	      || !add_compact_memory_block (ctx->tframe, ctx->tpoint, from,
+					    buf.data (), blocklen))
+	    return 1;
+	  remaining -= blocklen;
+	  from += blocklen;
+	  continue;
+	}
+#endif
       sp = 1 + sizeof (from) + sizeof (blocklen) + blocklen;
       mspace = add_traceframe_block (ctx->tframe, ctx->tpoint, sp);
       if (mspace == NULL)
@@ -5048,6 +5411,119 @@ match_blocktype (char blocktype, unsigned char *dataptr, void *data)
   return 0;
 }
 
+/* Callback for traceframe_walk_blocks, used to find register
+   blocks.  */
+
+static int
+match_regblock (char blocktype, unsigned char *dataptr, void *data)
+{
+  return blocktype == 'R' || blocktype == 'r';
+}
+
+/* Callback for traceframe_walk_blocks, used to find memory
+   blocks.  */
+
+static int
+match_memblock (char blocktype, unsigned char *dataptr, void *data)
+{
+  return blocktype == 'M' || blocktype == 'D';
+}
+
+/* Return the size of the block of type BLOCKTYPE whose data starts
+   at DATAPTR, not counting the type, or -1 if the type is
+   unknown.  */
+
+static int
+traceframe_block_size (char blocktype, const unsigned char *dataptr)
+{
+  unsigned short mlen;
+
+  switch (blocktype)
+    {
+    case 'R':
+      return current_target_desc ()->registers_size;
+    case 'M':
+      memcpy (&mlen, dataptr + sizeof (CORE_ADDR), sizeof (mlen));
+      return sizeof (CORE_ADDR) + sizeof (mlen) + mlen;
+    case 'V':
+      return sizeof (int) + sizeof (LONGEST);
+    case 'S':
+      memcpy (&mlen, dataptr, sizeof (mlen));
+      return sizeof (mlen) + mlen;
+    case 'D':
+      return (sizeof (CORE_ADDR) + sizeof (unsigned short)
+	      + 2 * sizeof (unsigned int));
+    case 'r':
+      memcpy (&mlen, dataptr + 2 * sizeof (unsigned int), sizeof (mlen));
+      return 2 * sizeof (unsigned int) + sizeof (mlen) + mlen;
+    default:
+      return -1;
+    }
+}
+
+/* Return the contents of the 'D' block whose data starts at DATAPTR,
+   and set *MADDR and *MLEN to its address and length.  Return NULL
+   if the traceframe holding the contents was discarded.  */
+
+static const unsigned char *
+traceframe_dedup_memblock (const unsigned char *dataptr, CORE_ADDR *maddr,
+			   unsigned short *mlen)
+{
+  compact_block_ref ref;
+
+  memcpy (maddr, dataptr, sizeof (*maddr));
+  dataptr += sizeof (*maddr);
+  memcpy (mlen, dataptr, sizeof (*mlen));
+  dataptr += sizeof (*mlen);
+  memcpy (&ref.frame, dataptr, sizeof (ref.frame));
+  dataptr += sizeof (ref.frame);
+  memcpy (&ref.offset, dataptr, sizeof (ref.offset));
+  ref.length = *mlen;
+
+  return compact_block_data (ref);
+}
+
+/* Return the registers of the 'r' block whose data starts at DATAPTR,
+   in a buffer that is valid until the next call.  Return NULL if the
+   traceframe holding the register block it is based on was
+   discarded.  */
+
+static unsigned char *
+traceframe_delta_regblock (const unsigned char *dataptr)
+{
+  static gdb::byte_vector regs;
+  int size = current_target_desc ()->registers_size;
+  compact_block_ref ref;
+  unsigned short runs_size;
+
+  memcpy (&ref.frame, dataptr, sizeof (ref.frame));
+  dataptr += sizeof (ref.frame);
+  memcpy (&ref.offset, dataptr, sizeof (ref.offset));
+  dataptr += sizeof (ref.offset);
+  memcpy (&runs_size, dataptr, sizeof (runs_size));
+  dataptr += sizeof (runs_size);
+  ref.length = size;
+
+  const unsigned char *base = compact_block_data (ref);
+  if (base == NULL)
+    return NULL;
+
+  regs.assign (base, base + size);
+  for (const unsigned char *end = dataptr + runs_size; dataptr < end; )
+    {
+      unsigned short start, len;
+
+      memcpy (&start, dataptr, sizeof (start));
+      dataptr += sizeof (start);
+      memcpy (&len, dataptr, sizeof (len));
+      dataptr += sizeof (len);
+      memcpy (regs.data () + start, dataptr, len);
+      dataptr += len;
+    }
+
+  return regs.data ();
+}
+
 /* Walk over all traceframe blocks of the traceframe buffer starting
    at DATABASE, of DATASIZE bytes long, and call CALLBACK for each
    block found, passing in DATA unmodified.  If CALLBACK returns true,
@@ -5078,7 +5554,6 @@ traceframe_walk_blocks (unsigned char *database, unsigned int datasize,
        /* nothing */)
     {
       char blocktype;
-      unsigned short mlen;
 
       if (dataptr == trace_buffer_wrap)
 	{
@@ -5093,32 +5568,15 @@ traceframe_walk_blocks (unsigned char *database, unsigned int datasize,
       if ((*callback) (blocktype, dataptr, data))
 	return dataptr;
 
-      switch (blocktype)
+      /* Skip over the block.  */
+      int size = traceframe_block_size (blocktype, dataptr);
+      if (size < 0)
 	{
-	case 'R':
-	  /* Skip over the registers block.  */
-	  dataptr += current_target_desc ()->registers_size;
-	  break;
-	case 'M':
-	  /* Skip over the memory block.  */
-	  dataptr += sizeof (CORE_ADDR);
-	  memcpy (&mlen, dataptr, sizeof (mlen));
-	  dataptr += (sizeof (mlen) + mlen);
-	  break;
-	case 'V':
-	  /* Skip over the TSV block.  */
-	  dataptr += (sizeof (int) + sizeof (LONGEST));
-	  break;
-	case 'S':
-	  /* Skip over the static trace data block.  */
-	  memcpy (&mlen, dataptr, sizeof (mlen));
-	  dataptr += (sizeof (mlen) + mlen);
-	  break;
-	default:
 	  trace_debug ("traceframe %d has unknown block type 0x%x",
 		       tfnum, blocktype);
 	  return NULL;
 	}
+      dataptr += size;
     }
 
   return NULL;
@@ -5141,9 +5599,11 @@ traceframe_find_regblock (struct traceframe *tframe, int tfnum)
 {
   unsigned char *regblock;
 
-  regblock = traceframe_find_block_type (tframe->data,
-					 tframe->data_size,
-					 tfnum, 'R');
+  regblock = traceframe_walk_blocks (tframe->data, tframe->data_size,
+				     tfnum, match_regblock, NULL);
+
+  if (regblock != NULL && regblock[-1] == 'r')
+    regblock = traceframe_delta_regblock (regblock);
 
   if (regblock == NULL)
     trace_debug ("traceframe %d has no register data", tfnum);
@@ -5229,34 +5689,41 @@ traceframe_read_mem (int tfnum, CORE_ADDR addr,
   database = dataptr = &tframe->data[0];
 
   /* Iterate through a traceframe's blocks, looking for memory.  */
-  while ((dataptr = traceframe_find_block_type (dataptr,
-						datasize
-						- (dataptr - database),
-						tfnum, 'M')) != NULL)
+  while ((dataptr = traceframe_walk_blocks (dataptr,
+					    datasize - (dataptr - database),
+					    tfnum, match_memblock,
+					    NULL)) != NULL)
     {
-      memcpy (&maddr, dataptr, sizeof (maddr));
-      dataptr += sizeof (maddr);
-      memcpy (&mlen, dataptr, sizeof (mlen));
-      dataptr += sizeof (mlen);
+      const unsigned char *contents;
+      char blocktype = dataptr[-1];
+
+      if (blocktype == 'D')
+	contents = traceframe_dedup_memblock (dataptr, &maddr, &mlen);
+      else
+	{
+	  memcpy (&maddr, dataptr, sizeof (maddr));
+	  memcpy (&mlen, dataptr + sizeof (maddr), sizeof (mlen));
+	  contents = dataptr + sizeof (maddr) + sizeof (mlen);
+	}
       trace_debug ("traceframe %d has %d bytes at %s",
 		   tfnum, mlen, paddress (maddr));
 
       /* If the block includes the first part of the desired range,
 	 return as much it has; GDB will re-request the remainder,
 	 which might be in a different block of this trace frame.  */
-      if (maddr <= addr && addr < (maddr + mlen))
+      if (contents != NULL && maddr <= addr && addr < (maddr + mlen))
 	{
 	  ULONGEST amt = (maddr + mlen) - addr;
 	  if (amt > length)
 	    amt = length;
 
-	  memcpy (buf, dataptr + (addr - maddr), amt);
+	  memcpy (buf, contents + (addr - maddr), amt);
 	  *nbytes = amt;
 	  return 0;
 	}
 
       /* Skip over this block.  */
-      dataptr += mlen;
+      dataptr += traceframe_block_size (blocktype, dataptr);
     }
 
   trace_debug ("traceframe %d has no memory data for the desired region",
@@ -5405,6 +5872,17 @@ build_traceframe_info_xml (char blocktype, unsigned char *dataptr, void *data)
 			    paddress (maddr), phex_nz (mlen, sizeof (mlen)));
 	break;
       }
+    case 'D':
+      {
+	unsigned short mlen;
+	CORE_ADDR maddr;
+
+	if (traceframe_dedup_memblock (dataptr, &maddr, &mlen) != NULL)
+	  string_xml_appendf (*buffer,
+			      "<memory start=\"0x%s\" length=\"0x%s\"/>\n",
+			      paddress (maddr), phex_nz (mlen, sizeof (mlen)));
+	break;
+      }
     case 'V':
       {
 	int vnum;
@@ -5414,6 +5892,7 @@ build_traceframe_info_xml (char blocktype, unsigned char *dataptr, void *data)
 	break;
       }
     case 'R':
+    case 'r':
     case 'S':
       {
 	break;
@@ -5453,6 +5932,86 @@ traceframe_read_info (int tfnum, std::string *buffer)
   return 0;
 }
 
+/* Callback for traceframe_walk_blocks.  Appends the block to the
+   byte vector DATA, expanding compact blocks into the blocks they
+   stand for, and dropping them when their contents were
+   discarded.  */
+
+static int
+expand_traceframe_block (char blocktype, unsigned char *dataptr, void *data)
+{
+  gdb::byte_vector *out = (gdb::byte_vector *) data;
+  const unsigned char *contents;
+
+  switch (blocktype)
+    {
+    case 'D':
+      {
+	unsigned short mlen;
+	CORE_ADDR maddr;
+
+	contents = traceframe_dedup_memblock (dataptr, &maddr, &mlen);
+	if (contents != NULL)
+	  {
+	    out->push_back ('M');
+	    out->insert (out->end (), (gdb_byte *) &maddr,
+			 (gdb_byte *) (&maddr + 1));
+	    out->insert (out->end (), (gdb_byte *) &mlen,
+			 (gdb_byte *) (&mlen + 1));
+	    out->insert (out->end (), contents, contents + mlen);
+	  }
+	break;
+      }
+    case 'r':
+      contents = traceframe_delta_regblock (dataptr);
+      if (contents != NULL)
+	{
+	  out->push_back ('R');
+	  out->insert (out->end (), contents,
+		       contents + current_target_desc ()->registers_size);
+	}
+      break;
+    default:
+      {
+	int size = traceframe_block_size (blocktype, dataptr);
+
+	if (size >= 0)
+	  {
+	    out->push_back (blocktype);
+	    out->insert (out->end (), dataptr, dataptr + size);
+	  }
+	break;
+      }
+    }
+
+  return 0;
+}
+
+/* Store a copy of the traceframes of the trace buffer in OUT, in the
+   same format, but with compact blocks expanded.  */
+
+static void
+expand_trace_buffer (gdb::byte_vector *out)
+{
+  struct traceframe *tframe;
+  int tfnum = 0;
+
+  out->clear ();
+  for (tframe = FIRST_TRACEFRAME ();
+       tframe->tpnum != 0;
+       tframe = NEXT_TRACEFRAME (tframe), tfnum++)
+    {
+      struct traceframe header = *tframe;
+      size_t start = out->size ();
+
+      out->resize (start + sizeof (header));
+      traceframe_walk_blocks (tframe->data, tframe->data_size, tfnum,
+			      expand_traceframe_block, out);
+      header.data_size = out->size () - start - sizeof (header);
+      memcpy (out->data () + start, &header, sizeof (header));
+    }
+}
+
 /* Return the first fast tracepoint whose jump pad contains PC.  */
 
 static struct tracepoint *
@@ -5505,7 +6064,16 @@ fast_tracepoint_from_ipa_tpoint_address (CORE_ADDR ipa_tpoint_obj)
 #endif
 
 /* The type of the object that is used to synchronize fast tracepoint
-   collection.  */
+   collection.  The jump pads take this lock around the whole call to
+   gdb_collect, so only one thread collects at a time.  The lock is
+   not only there for the trace buffer, which is why collection does
+   not instead reserve space in per-thread buffers without it:
+   fast_tracepoint_collecting reads it to find which thread is halfway
+   through collecting, so that the thread can be moved out of the jump
+   pad before it is stopped, and trace_buffer_alloc and the trace frame
+   blocks it hands out assume a single producer.  On x86, waiters spin
+   on plain loads until the lock is released; see the jump pads in
+   linux-x86-low.cc.  */
 
 typedef struct collecting_t
 {
@@ -0,0 +1,172 @@
+/* Compression of remote protocol packets for GDB, the GNU debugger.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef GDBSUPPORT_RSP_COMPRESS_H
+#define GDBSUPPORT_RSP_COMPRESS_H
+
+/* This file is only included by the remote protocol implementations
+   in GDB, which always links with zlib, and in GDBserver, only when
+   configure found zlib (HAVE_ZLIB); the rest of gdbsupport does not
+   use zlib.  */
+
+#include <zlib.h>
+
+/* Once "compression=zlib" has been negotiated in qSupported, either
+   side may send a packet whose payload is compressed.  Such a payload
+   starts with RSP_COMPRESSED_PAYLOAD, which can never start an
+   ordinary payload, since run-length encoding needs a preceding
+   character.  The rest of the payload is the output of a zlib stream,
+   flushed at the end of each packet, and escaped like binary data so
+   that it contains no '$', '#', '}' or '*'.  Each direction uses a
+   single stream for the whole connection, so later packets benefit
+   from what earlier ones contained.  */
+
+#define RSP_COMPRESSED_PAYLOAD '*'
+
+/* Payloads shorter than this are never worth compressing.  */
+
+#define RSP_COMPRESS_THRESHOLD 64
+
+/* The compressing end of a connection.  */
+
+class rsp_compressor
+{
+public:
+
+  rsp_compressor ()
+  {
+    memset (&m_stream, 0, sizeof (m_stream));
+    if (deflateInit (&m_stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+      error (_("could not initialize zlib compression"));
+  }
+
+  ~rsp_compressor ()
+  {
+    deflateEnd (&m_stream);
+  }
+
+  DISABLE_COPY_AND_ASSIGN (rsp_compressor);
+
+  /* Return the compressed payload for the LEN bytes at BUF, starting
+     with RSP_COMPRESSED_PAYLOAD.  */
+
+  std::string compress (const char *buf, int len)
+  {
+    std::string result (1, RSP_COMPRESSED_PAYLOAD);
+    unsigned char out[4096];
+
+    m_stream.next_in = (Bytef *) buf;
+    m_stream.avail_in = len;
+    do
+      {
+	m_stream.next_out = out;
+	m_stream.avail_out = sizeof (out);
+	if (deflate (&m_stream, Z_SYNC_FLUSH) == Z_STREAM_ERROR)
+	  error (_("zlib compression failed"));
+
+	for (unsigned char *p = out; p < m_stream.next_out; p++)
+	  {
+	    if (*p == '$' || *p == '#' || *p == '}' || *p == '*')
+	      {
+		result += '}';
+		result += (char) (*p ^ 0x20);
+	      }
+	    else
+	      result += (char) *p;
+	  }
+      }
+    while (m_stream.avail_out == 0);
+
+    return result;
+  }
+
+private:
+
+  z_stream m_stream;
+};
+
+/* The decompressing end of a connection.  */
+
+class rsp_decompressor
+{
+public:
+
+  rsp_decompressor ()
+  {
+    memset (&m_stream, 0, sizeof (m_stream));
+    if (inflateInit (&m_stream) != Z_OK)
+      error (_("could not initialize zlib decompression"));
+  }
+
+  ~rsp_decompressor ()
+  {
+    inflateEnd (&m_stream);
+  }
+
+  DISABLE_COPY_AND_ASSIGN (rsp_decompressor);
+
+  /* Decompress the LEN bytes of payload at BUF, which follow
+     RSP_COMPRESSED_PAYLOAD, into *OUT.  Returns false if the data is
+     not valid, in which case the stream cannot be used any more.  */
+
+  bool decompress (const char *buf, int len, std::string *out)
+  {
+    std::string in;
+    in.reserve (len);
+    for (int i = 0; i < len; i++)
+      {
+	if (buf[i] == '}' && i + 1 < len)
+	  in += (char) (buf[++i] ^ 0x20);
+	else
+	  in += buf[i];
+      }
+
+    unsigned char chunk[4096];
+
+    out->clear ();
+    m_stream.next_in = (Bytef *) in.data ();
+    m_stream.avail_in = in.size ();
+    do
+      {
+	uInt avail_in = m_stream.avail_in;
+
+	m_stream.next_out = chunk;
+	m_stream.avail_out = sizeof (chunk);
+	int ret = inflate (&m_stream, Z_SYNC_FLUSH);
+	if (ret != Z_OK && ret != Z_BUF_ERROR)
+	  return false;
+
+	/* Give up if the data is truncated.  */
+	if (m_stream.next_out == chunk && m_stream.avail_in == avail_in
+	    && avail_in > 0)
+	  return false;
+
+	out->append ((char *) chunk, m_stream.next_out - chunk);
+      }
+    while (m_stream.avail_in > 0 || m_stream.avail_out == 0);
+
+    return true;
+  }
+
+private:
+
+  z_stream m_stream;
+};
+
+#endif /* GDBSUPPORT_RSP_COMPRESS_H */
@@ -27,11 +27,28 @@
 #endif
 #include "parameters.h"
 #include "options.h"
+#include "workqueue.h"
 #include "compressed_output.h"
 
 namespace gold
 {
 
+// Sections larger than this are compressed in chunks of this size,
+// which can be compressed in parallel.
+
+static const unsigned long compress_chunk_size = 1024 * 1024;
+
+// Return the zlib compression level to use.
+
+static int
+zlib_compress_level()
+{
+  if (parameters->options().optimize() >= 1)
+    return 9;
+  else
+    return 1;
+}
+
 // Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns true
 // if it successfully compressed, false if it failed for any reason
 // (including not having zlib support in the library).  If it returns
@@ -51,11 +68,7 @@ zlib_compress(int header_size,
   *compressed_size = uncompressed_size + uncompressed_size / 1000 + 128;
   *compressed_data = new unsigned char[*compressed_size + header_size];
 
-  int compress_level;
-  if (parameters->options().optimize() >= 1)
-    compress_level = 9;
-  else
-    compress_level = 1;
+  int compress_level = zlib_compress_level();
 
   int rc = compress2(reinterpret_cast<Bytef*>(*compressed_data) + header_size,
                      compressed_size,
@@ -75,6 +88,48 @@ zlib_compress(int header_size,
     }
 }
 
+// Compress one chunk of a section which is compressed in several
+// chunks.  The chunks are raw deflate data which together form a
+// single zlib stream: each chunk but the last ends with a full flush,
+// so that it does not depend on the chunks before it, and the last
+// chunk ends the stream.  The caller adds the zlib header and the
+// Adler-32 checksum.  Returns true on success, and allocates the
+// compressed data using new.
+
+static bool
+zlib_compress_chunk(const unsigned char* uncompressed_data,
+		    unsigned long uncompressed_size,
+		    bool is_last,
+		    unsigned char** compressed_data,
+		    unsigned long* compressed_size)
+{
+  z_stream strm;
+  memset(&strm, 0, sizeof strm);
+  if (deflateInit2(&strm, zlib_compress_level(), Z_DEFLATED, -MAX_WBITS, 8,
+		   Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+
+  // Allow for the empty block written by a full flush.
+  unsigned long size = deflateBound(&strm, uncompressed_size) + 16;
+  *compressed_data = new unsigned char[size];
+  strm.next_in = const_cast<Bytef*>(uncompressed_data);
+  strm.avail_in = uncompressed_size;
+  strm.next_out = *compressed_data;
+  strm.avail_out = size;
+  int rc = deflate(&strm, is_last ? Z_FINISH : Z_FULL_FLUSH);
+  bool ok = (is_last
+	     ? rc == Z_STREAM_END
+	     : rc == Z_OK && strm.avail_in == 0 && strm.avail_out != 0);
+  *compressed_size = strm.total_out;
+  deflateEnd(&strm);
+  if (!ok)
+    {
+      delete[] *compressed_data;
+      *compressed_data = NULL;
+    }
+  return ok;
+}
+
 #if HAVE_ZSTD
 static bool
 zstd_compress(int header_size, const unsigned char *uncompressed_data,
@@ -88,6 +143,7 @@ zstd_compress(int header_size, const unsigned char *uncompressed_data,
   if (ZSTD_isError(size))
     {
       delete[] *compressed_data;
+      *compressed_data = NULL;
       return false;
     }
   *compressed_size = header_size + size;
@@ -225,57 +281,239 @@ decompress_input_section(const unsigned char* compressed_data,
   return false;
 }
 
+// A Compress_chunk_task compresses one chunk of an
+// Output_compressed_section.
+
+class Compress_chunk_task : public Task
+{
+ public:
+  Compress_chunk_task(Output_compressed_section* os, unsigned int chunk,
+		      Task_token* blocker)
+    : os_(os), chunk_(chunk), blocker_(blocker)
+  { }
+
+  void
+  run(Workqueue*)
+  { this->os_->compress_chunk(this->chunk_); }
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  // Unblock BLOCKER_ when done.
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->blocker_); }
+
+  std::string
+  get_name() const
+  { return "Compress_chunk_task " + std::string(this->os_->name()); }
+
+ private:
+  Output_compressed_section* const os_;
+  const unsigned int chunk_;
+  Task_token* const blocker_;
+};
+
 // Class Output_compressed_section.
 
-// Set the final data size of a compressed section.  This is where
-// we actually compress the section data.
+// Copy anything which is not a regular input section into the
+// postprocessing buffer, work out the type of compression, and split
+// the contents into chunks.
 
 void
-Output_compressed_section::set_final_data_size()
+Output_compressed_section::prepare_chunks()
 {
-  off_t uncompressed_size = this->postprocessing_buffer_size();
-
-  // (Try to) compress the data.
-  unsigned long compressed_size;
-  unsigned char* uncompressed_data = this->postprocessing_buffer();
-
   // At this point the contents of all regular input sections will
   // have been copied into the postprocessing buffer, and relocations
   // will have been applied.  Now we need to copy in the contents of
   // anything other than a regular input section.
   this->write_to_postprocessing_buffer();
 
-  bool success = false;
-  enum { none, gnu_zlib, gabi_zlib, zstd } compress;
-  int compression_header_size = 12;
+  this->header_size_ = 12;
   const int size = parameters->target().get_size();
   if (strcmp(this->options_->compress_debug_sections(), "zlib-gnu") == 0)
-    compress = gnu_zlib;
+    this->compression_ = gnu_zlib;
   else if (strcmp(this->options_->compress_debug_sections(), "none") == 0)
-    compress = none;
+    this->compression_ = none;
   else
     {
       if (strcmp(this->options_->compress_debug_sections(), "zstd") == 0)
-	compress = zstd;
+	this->compression_ = zstd;
       else
-	compress = gabi_zlib;
+	this->compression_ = gabi_zlib;
       if (size == 32)
-	compression_header_size = elfcpp::Elf_sizes<32>::chdr_size;
+	this->header_size_ = elfcpp::Elf_sizes<32>::chdr_size;
       else if (size == 64)
-	compression_header_size = elfcpp::Elf_sizes<64>::chdr_size;
+	this->header_size_ = elfcpp::Elf_sizes<64>::chdr_size;
       else
 	gold_unreachable();
     }
-  if (compress == gnu_zlib || compress == gabi_zlib)
-    success = zlib_compress(compression_header_size, uncompressed_data,
-			    uncompressed_size, &this->data_,
-			    &compressed_size);
+
+  unsigned long uncompressed_size = this->postprocessing_buffer_size();
+  size_t count = 1;
+  if (uncompressed_size > compress_chunk_size)
+    count = (uncompressed_size + compress_chunk_size - 1) / compress_chunk_size;
+  Compressed_chunk empty = { NULL, 0, 0, false };
+  this->chunks_.assign(count, empty);
+}
+
+// Compress chunk I of the section contents.  A section which fits in
+// a single chunk is compressed exactly as it would be in one piece.
+
+void
+Output_compressed_section::compress_chunk(unsigned int i)
+{
+  Compressed_chunk* chunk = &this->chunks_[i];
+  const unsigned long uncompressed_size = this->postprocessing_buffer_size();
+  const unsigned char* uncompressed_data = this->postprocessing_buffer();
+
+  if (this->chunks_.size() == 1)
+    {
+      if (this->compression_ == gnu_zlib || this->compression_ == gabi_zlib)
+	chunk->ok = zlib_compress(this->header_size_, uncompressed_data,
+				  uncompressed_size, &chunk->data,
+				  &chunk->size);
+#if HAVE_ZSTD
+      else if (this->compression_ == zstd)
+	chunk->ok = zstd_compress(this->header_size_, uncompressed_data,
+				  uncompressed_size, &chunk->data,
+				  &chunk->size);
+#endif
+      return;
+    }
+
+  const unsigned long offset = i * compress_chunk_size;
+  const unsigned long size = std::min(compress_chunk_size,
+				      uncompressed_size - offset);
+  const bool is_last = i + 1 == this->chunks_.size();
+  if (this->compression_ == gnu_zlib || this->compression_ == gabi_zlib)
+    {
+      chunk->ok = zlib_compress_chunk(uncompressed_data + offset, size,
+				      is_last, &chunk->data, &chunk->size);
+      chunk->adler = adler32(adler32(0, NULL, 0), uncompressed_data + offset,
+			     size);
+    }
 #if HAVE_ZSTD
-  else if (compress == zstd)
-    success = zstd_compress(compression_header_size, uncompressed_data,
-			    uncompressed_size, &this->data_,
-			    &compressed_size);
+  else if (this->compression_ == zstd)
+    // Each chunk is a separate zstd frame.  A sequence of frames
+    // decompresses to the concatenation of their contents.
+    chunk->ok = zstd_compress(0, uncompressed_data + offset, size,
+			      &chunk->data, &chunk->size);
 #endif
+}
+
+// Return tasks to compress each chunk of the section.  This lets
+// several sections, and the chunks of a large section, be compressed
+// at the same time.
+
+void
+Output_compressed_section::do_postprocessing_tasks(Task_token* blocker,
+						   std::vector<Task*>* tasks)
+{
+  if (this->chunks_queued_)
+    return;
+  this->prepare_chunks();
+  for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+    tasks->push_back(new Compress_chunk_task(this, i, blocker));
+  this->chunks_queued_ = true;
+}
+
+// Put the compressed chunks together into data_, leaving room for the
+// compression header.  Returns false if any chunk failed to compress.
+
+bool
+Output_compressed_section::assemble_chunks(unsigned long* compressed_size)
+{
+  bool ok = true;
+  for (std::vector<Compressed_chunk>::const_iterator p = this->chunks_.begin();
+       p != this->chunks_.end();
+       ++p)
+    if (!p->ok)
+      ok = false;
+
+  if (ok && this->chunks_.size() == 1)
+    {
+      this->data_ = this->chunks_[0].data;
+      *compressed_size = this->chunks_[0].size;
+      this->chunks_.clear();
+      return true;
+    }
+
+  bool is_zlib = (this->compression_ == gnu_zlib
+		  || this->compression_ == gabi_zlib);
+  if (ok)
+    {
+      // A zlib stream starts with a two byte header, and ends with the
+      // Adler-32 checksum of the uncompressed data.
+      unsigned long size = this->header_size_;
+      if (is_zlib)
+	size += 2 + 4;
+      for (std::vector<Compressed_chunk>::const_iterator p =
+	     this->chunks_.begin();
+	   p != this->chunks_.end();
+	   ++p)
+	size += p->size;
+
+      this->data_ = new unsigned char[size];
+      unsigned char* pout = this->data_ + this->header_size_;
+      if (is_zlib)
+	{
+	  // The header which compress2 would write for the same level.
+	  *pout++ = 0x78;
+	  *pout++ = zlib_compress_level() == 9 ? 0xda : 0x01;
+	}
+
+      const unsigned long uncompressed_size =
+	this->postprocessing_buffer_size();
+      unsigned long adler = adler32(0, NULL, 0);
+      for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+	{
+	  const Compressed_chunk& chunk(this->chunks_[i]);
+	  memcpy(pout, chunk.data, chunk.size);
+	  pout += chunk.size;
+	  unsigned long offset = i * compress_chunk_size;
+	  adler = adler32_combine(adler, chunk.adler,
+				  std::min(compress_chunk_size,
+					   uncompressed_size - offset));
+	}
+
+      if (is_zlib)
+	{
+	  elfcpp::Swap_unaligned<32, true>::writeval(pout, adler);
+	  pout += 4;
+	}
+      gold_assert(pout == this->data_ + size);
+      *compressed_size = size;
+    }
+
+  for (std::vector<Compressed_chunk>::const_iterator p = this->chunks_.begin();
+       p != this->chunks_.end();
+       ++p)
+    delete[] p->data;
+  this->chunks_.clear();
+  return ok;
+}
+
+// Set the final data size of a compressed section.  This is where
+// we actually compress the section data, unless that was already done
+// by Compress_chunk_tasks.
+
+void
+Output_compressed_section::set_final_data_size()
+{
+  if (!this->chunks_queued_)
+    {
+      this->prepare_chunks();
+      for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+	this->compress_chunk(i);
+    }
+
+  off_t uncompressed_size = this->postprocessing_buffer_size();
+  unsigned long compressed_size;
+  bool success = this->assemble_chunks(&compressed_size);
+  const Compression compress = this->compression_;
+  const int size = parameters->target().get_size();
   if (success)
     {
       elfcpp::Elf_Xword flags = this->flags();
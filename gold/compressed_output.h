@@ -60,25 +60,79 @@ class Output_compressed_section : public Output_section
 			    const char* name, elfcpp::Elf_Word flags,
 			    elfcpp::Elf_Xword type)
     : Output_section(name, flags, type),
-      options_(options)
+      options_(options), data_(NULL), compression_(none),
+      header_size_(0), chunks_(), chunks_queued_(false)
   { this->set_requires_postprocessing(); }
 
+  // Compress chunk I of the section contents.  This is called by
+  // Compress_chunk_task.
+  void
+  compress_chunk(unsigned int i);
+
  protected:
   // Set the final data size.
   void
   set_final_data_size();
 
+  // Return the tasks to compress the section contents.
+  void
+  do_postprocessing_tasks(Task_token* blocker, std::vector<Task*>* tasks);
+
   // Write out the compressed contents.
   void
   do_write(Output_file*);
 
  private:
+  // The type of compression.
+  enum Compression
+  {
+    none,
+    gnu_zlib,
+    gabi_zlib,
+    zstd
+  };
+
+  // A chunk of the section contents after compression.  Large
+  // sections are split into chunks which are compressed
+  // independently, so that the work can be spread over several
+  // threads.
+  struct Compressed_chunk
+  {
+    // The compressed data.  For a section compressed as a single
+    // chunk, this starts with room for the compression header.
+    unsigned char* data;
+    // The size of the compressed data.
+    unsigned long size;
+    // The Adler-32 checksum of the uncompressed chunk, for zlib.
+    unsigned long adler;
+    // Whether compression succeeded.
+    bool ok;
+  };
+
+  // Copy everything into the postprocessing buffer, and split it
+  // into chunks.
+  void
+  prepare_chunks();
+
+  // Put the compressed chunks together and write the header.  Return
+  // false if compression failed.
+  bool
+  assemble_chunks(unsigned long* compressed_size);
+
   // The options--this includes the compression type.
   const General_options* options_;
   // The compressed data.
   unsigned char* data_;
   // The new section name if we do compress.
   std::string new_section_name_;
+  // The type of compression.
+  Compression compression_;
+  // The size of the compression header.
+  int header_size_;
+  // The chunks of the compressed data.
+  std::vector<Compressed_chunk> chunks_;
+  // Whether tasks have been queued to compress the chunks.
+  bool chunks_queued_;
 };
 
 } // End namespace gold.
@@ -30,19 +30,33 @@ namespace gold
 {
 
 // Garbage collection uses a worklist style algorithm to determine the 
-// transitive closure of all referenced sections.
+// transitive closure of all referenced sections.  A section is added
+// to the referenced list when it is first put on the work list, so
+// that each reference costs a single hash table lookup.  This runs in
+// a single thread, from queue_middle_tasks: marking in parallel would
+// need the referenced list and the work list to be shared between
+// workqueue tasks, and the middle tasks to wait for them.
 void 
 Garbage_collection::do_transitive_closure()
 {
-  while (!this->worklist().empty())
+  Worklist_type& worklist = this->worklist();
+  Sections_reachable& referenced = this->referenced_list();
+
+  // The sections put on the work list while processing symbols and
+  // relocs are not on the referenced list yet, and may be repeated.
+  Worklist_type::iterator out = worklist.begin();
+  for (Worklist_type::const_iterator p = worklist.begin();
+       p != worklist.end();
+       ++p)
+    if (referenced.insert(*p).second)
+      *out++ = *p;
+  worklist.erase(out, worklist.end());
+
+  while (!worklist.empty())
     {
-      // Add elements from the work list to the referenced list
-      // one by one.
-      Section_id entry = this->worklist().back();
-      this->worklist().pop_back();
-      if (!this->referenced_list().insert(entry).second)
-        continue;
-      Garbage_collection::Section_ref::iterator find_it = 
+      Section_id entry = worklist.back();
+      worklist.pop_back();
+      Garbage_collection::Section_ref::const_iterator find_it = 
                 this->section_reloc_map().find(entry);
       if (find_it == this->section_reloc_map().end()) 
           continue;
@@ -54,11 +68,8 @@ Garbage_collection::do_transitive_closure()
            ++it_v)
         {
           // Do not add already processed sections to the work_list. 
-          if (this->referenced_list().find(*it_v)
-              == this->referenced_list().end())
-            {
-              this->worklist().push_back(*it_v);
-            }
+          if (referenced.insert(*it_v).second)
+            worklist.push_back(*it_v);
         }
     }
   this->worklist_ready();
@@ -47,7 +47,8 @@ class Garbage_collection
  public:
 
   typedef Unordered_set<Section_id, Section_id_hash> Sections_reachable;
-  typedef std::map<Section_id, Sections_reachable> Section_ref;
+  typedef Unordered_map<Section_id, Sections_reachable,
+			Section_id_hash> Section_ref;
   typedef std::vector<Section_id> Worklist_type;
   // This maps the name of the section which can be represented as a C
   // identifier (cident) to the list of sections that have that name.
@@ -28,6 +28,7 @@
 #include "object.h"
 #include "output.h"
 #include "demangle.h"
+#include "workqueue.h"
 
 namespace gold
 {
@@ -171,6 +172,251 @@ mapped_index_string_hash(const unsigned char* str)
   return r;
 }
 
+class Gdb_index_info_reader;
+
+// This class holds the entries found by scanning the .debug_info and
+// .debug_types sections of a single input object.  The CU and TU
+// indexes are local to the object; Gdb_index::merge_scan translates
+// them when it adds the entries to the index.
+
+class Gdb_index_scan
+{
+ public:
+  // A symbol found in the debug info.  The hash codes are computed
+  // here so that they are not computed while merging.
+  struct Symbol
+  {
+    Symbol(const char* a_name, int a_cu_index, uint8_t a_flags)
+      : name(a_name),
+	hashval(mapped_index_string_hash(
+	    reinterpret_cast<const unsigned char*>(a_name))),
+	hash_code(string_hash<char>(this->name.data(), this->name.length())),
+	cu_index(a_cu_index), flags(a_flags)
+    { }
+
+    std::string name;
+    unsigned int hashval;
+    size_t hash_code;
+    int cu_index;
+    uint8_t flags;
+  };
+
+  Gdb_index_scan(Relobj* object)
+    : object_(object), pending_sections_(), comp_units_(), type_units_(),
+      ranges_(), symbols_(), cu_count_(0), cu_nopubnames_count_(0),
+      tu_count_(0), tu_nopubnames_count_(0), pubnames_table_(NULL),
+      pubtypes_table_(NULL), cu_pubname_map_(), cu_pubtype_map_(),
+      pubtables_mapped_(false), stmt_list_offset_(-1)
+  { }
+
+  ~Gdb_index_scan()
+  {
+    delete this->pubnames_table_;
+    delete this->pubtypes_table_;
+  }
+
+  // Return the object.
+  Relobj*
+  object() const
+  { return this->object_; }
+
+  // Record a .debug_info or .debug_types input section to scan later.
+  void
+  add_pending_section(bool is_type_unit, unsigned int shndx,
+		      unsigned int reloc_shndx, unsigned int reloc_type)
+  {
+    this->pending_sections_.push_back(Pending_section(is_type_unit, shndx,
+						      reloc_shndx,
+						      reloc_type));
+  }
+
+  // Scan the recorded sections.  The object must be locked.
+  void
+  scan_pending_sections();
+
+  // Scan a .debug_info or .debug_types input section.
+  void
+  scan_debug_info(bool is_type_unit,
+		  const unsigned char* symbols,
+		  off_t symbols_size,
+		  unsigned int shndx,
+		  unsigned int reloc_shndx,
+		  unsigned int reloc_type);
+
+  // Add a compilation unit.
+  int
+  add_comp_unit(off_t cu_offset, off_t cu_length)
+  {
+    ++this->cu_count_;
+    this->comp_units_.push_back(Gdb_index::Comp_unit(cu_offset, cu_length));
+    return this->comp_units_.size() - 1;
+  }
+
+  // Add a type unit.
+  int
+  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
+  {
+    ++this->tu_count_;
+    this->type_units_.push_back(Gdb_index::Type_unit(tu_offset, type_offset,
+						     signature));
+    return this->type_units_.size() - 1;
+  }
+
+  // Record that a CU or TU has no pubnames or pubtypes.
+  void
+  add_unit_without_pubnames(bool is_type_unit)
+  {
+    if (is_type_unit)
+      ++this->tu_nopubnames_count_;
+    else
+      ++this->cu_nopubnames_count_;
+  }
+
+  // Add an address range.
+  void
+  add_address_range_list(unsigned int cu_index, Dwarf_range_list* ranges)
+  {
+    this->ranges_.push_back(Gdb_index::Per_cu_range_list(this->object_,
+							 cu_index, ranges));
+  }
+
+  // Add a symbol.  FLAGS are the gdb_index version 7 flags to be
+  // stored in the high-byte of the cu_index field.
+  void
+  add_symbol(int cu_index, const char* sym_name, uint8_t flags)
+  { this->symbols_.push_back(Symbol(sym_name, cu_index, flags)); }
+
+  // Return the offset into the pubnames table for the cu at the given
+  // offset.
+  off_t
+  find_pubname_offset(off_t cu_offset);
+
+  // Return the offset into the pubtypes table for the cu at the
+  // given offset.
+  off_t
+  find_pubtype_offset(off_t cu_offset);
+
+  // Return TRUE if we have already processed the pubnames and types
+  // set of the CUs and TUs associated with the statement list at
+  // OFFSET.
+  bool
+  pubnames_read(off_t offset) const
+  { return this->stmt_list_offset_ == offset; }
+
+  // Record that we have already read the pubnames associated with
+  // OFFSET.
+  void
+  set_pubnames_read(off_t offset)
+  { this->stmt_list_offset_ = offset; }
+
+  // Return a pointer to the given table.
+  Dwarf_pubnames_table*
+  pubnames_table()
+  { return this->pubnames_table_; }
+
+  Dwarf_pubnames_table*
+  pubtypes_table()
+  { return this->pubtypes_table_; }
+
+  // Accessors for Gdb_index::merge_scan.
+
+  const std::vector<Gdb_index::Comp_unit>&
+  comp_units() const
+  { return this->comp_units_; }
+
+  const std::vector<Gdb_index::Type_unit>&
+  type_units() const
+  { return this->type_units_; }
+
+  const std::vector<Gdb_index::Per_cu_range_list>&
+  ranges() const
+  { return this->ranges_; }
+
+  const std::vector<Symbol>&
+  symbols() const
+  { return this->symbols_; }
+
+  unsigned int
+  cu_count() const
+  { return this->cu_count_; }
+
+  unsigned int
+  cu_nopubnames_count() const
+  { return this->cu_nopubnames_count_; }
+
+  unsigned int
+  tu_count() const
+  { return this->tu_count_; }
+
+  unsigned int
+  tu_nopubnames_count() const
+  { return this->tu_nopubnames_count_; }
+
+  // Discard the entries once they have been merged, keeping the
+  // pubnames state for any further sections of the same object.
+  void
+  clear_entries();
+
+ private:
+  // A section recorded by add_pending_section.
+  struct Pending_section
+  {
+    Pending_section(bool a_is_type_unit, unsigned int a_shndx,
+		    unsigned int a_reloc_shndx, unsigned int a_reloc_type)
+      : is_type_unit(a_is_type_unit), shndx(a_shndx),
+	reloc_shndx(a_reloc_shndx), reloc_type(a_reloc_type)
+    { }
+
+    bool is_type_unit;
+    unsigned int shndx;
+    unsigned int reloc_shndx;
+    unsigned int reloc_type;
+  };
+
+  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
+
+  // Create a map from dies to pubnames.
+  Dwarf_pubnames_table*
+  map_pubtable_to_dies(unsigned int attr,
+                       Gdb_index_info_reader* dwinfo,
+                       const unsigned char* symbols,
+                       off_t symbols_size);
+
+  // Wrapper for map_pubtable_to_dies
+  void
+  map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
+                                 const unsigned char* symbols,
+                                 off_t symbols_size);
+
+  // The object being scanned.
+  Relobj* object_;
+  // The sections to scan in scan_pending_sections.
+  std::vector<Pending_section> pending_sections_;
+  // The list of DWARF compilation units.
+  std::vector<Gdb_index::Comp_unit> comp_units_;
+  // The list of DWARF type units.
+  std::vector<Gdb_index::Type_unit> type_units_;
+  // The list of address ranges.
+  std::vector<Gdb_index::Per_cu_range_list> ranges_;
+  // The symbols, in the order they were found.
+  std::vector<Symbol> symbols_;
+  // Statistics.
+  unsigned int cu_count_;
+  unsigned int cu_nopubnames_count_;
+  unsigned int tu_count_;
+  unsigned int tu_nopubnames_count_;
+  // Tables to store the pubnames section of the object.
+  Dwarf_pubnames_table* pubnames_table_;
+  Dwarf_pubnames_table* pubtypes_table_;
+  Pubname_offset_map cu_pubname_map_;
+  Pubname_offset_map cu_pubtype_map_;
+  // Whether the pubnames and pubtypes tables have been read.
+  bool pubtables_mapped_;
+  // Stmt list offset of the CUs and TUs associated with the last
+  // read pubnames and pubtypes sections.
+  off_t stmt_list_offset_;
+};
+
 // A specialization of Dwarf_info_reader, for building the .gdb_index.
 
 class Gdb_index_info_reader : public Dwarf_info_reader
@@ -183,19 +429,15 @@ class Gdb_index_info_reader : public Dwarf_info_reader
 			unsigned int shndx,
 			unsigned int reloc_shndx,
 			unsigned int reloc_type,
-			Gdb_index* gdb_index)
+			Gdb_index_scan* scan)
     : Dwarf_info_reader(is_type_unit, object, symbols, symbols_size, shndx,
 			reloc_shndx, reloc_type),
-      gdb_index_(gdb_index), cu_index_(0), cu_language_(0)
+      scan_(scan), cu_index_(0), cu_language_(0)
   { }
 
   ~Gdb_index_info_reader()
   { this->clear_declarations(); }
 
-  // Print usage statistics.
-  static void
-  print_stats();
-
  protected:
   // Visit a compilation unit.
   virtual void
@@ -285,8 +527,8 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   void
   clear_declarations();
 
-  // The Gdb_index section.
-  Gdb_index* gdb_index_;
+  // The entries for the object being scanned.
+  Gdb_index_scan* scan_;
   // The current CU index (negative for a TU).
   int cu_index_;
   // The language of the current CU or TU.
@@ -294,35 +536,15 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   // Map from DIE offset to (parent offset, name) pair,
   // for DW_AT_specification.
   Declaration_map declarations_;
-
-  // Statistics.
-  // Total number of DWARF compilation units processed.
-  static unsigned int dwarf_cu_count;
-  // Number of DWARF compilation units with pubnames/pubtypes.
-  static unsigned int dwarf_cu_nopubnames_count;
-  // Total number of DWARF type units processed.
-  static unsigned int dwarf_tu_count;
-  // Number of DWARF type units with pubnames/pubtypes.
-  static unsigned int dwarf_tu_nopubnames_count;
 };
 
-// Total number of DWARF compilation units processed.
-unsigned int Gdb_index_info_reader::dwarf_cu_count = 0;
-// Number of DWARF compilation units without pubnames/pubtypes.
-unsigned int Gdb_index_info_reader::dwarf_cu_nopubnames_count = 0;
-// Total number of DWARF type units processed.
-unsigned int Gdb_index_info_reader::dwarf_tu_count = 0;
-// Number of DWARF type units without pubnames/pubtypes.
-unsigned int Gdb_index_info_reader::dwarf_tu_nopubnames_count = 0;
-
 // Process a compilation unit and parse its child DIE.
 
 void
 Gdb_index_info_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
 					      Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_cu_count;
-  this->cu_index_ = this->gdb_index_->add_comp_unit(cu_offset, cu_length);
+  this->cu_index_ = this->scan_->add_comp_unit(cu_offset, cu_length);
   this->visit_top_die(root_die);
 }
 
@@ -333,10 +555,9 @@ Gdb_index_info_reader::visit_type_unit(off_t tu_offset, off_t,
 				       off_t type_offset, uint64_t signature,
 				       Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_tu_count;
   // Use a negative index to flag this as a TU instead of a CU.
-  this->cu_index_ = -1 - this->gdb_index_->add_type_unit(tu_offset, type_offset,
-							 signature);
+  this->cu_index_ = -1 - this->scan_->add_type_unit(tu_offset, type_offset,
+						    signature);
   this->visit_top_die(root_die);
 }
 
@@ -397,10 +618,8 @@ Gdb_index_info_reader::visit_top_die(Dwarf_die* die)
 			     this->object()->name().c_str());
 		return;
 	      }
-	    if (die->tag() == elfcpp::DW_TAG_compile_unit)
-	      ++Gdb_index_info_reader::dwarf_cu_nopubnames_count;
-	    else
-	      ++Gdb_index_info_reader::dwarf_tu_nopubnames_count;
+	    this->scan_->add_unit_without_pubnames(
+		die->tag() != elfcpp::DW_TAG_compile_unit);
 	    this->visit_children(die, NULL);
 	  }
 	break;
@@ -454,8 +673,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	    // If the DIE is not a declaration, add it to the index.
 	    std::string full_name = this->get_qualified_name(die, context);
 	    if (!full_name.empty())
-	      this->gdb_index_->add_symbol(this->cu_index_,
-                                           full_name.c_str(), 0);
+	      this->scan_->add_symbol(this->cu_index_, full_name.c_str(), 0);
 	  }
 	break;
       case elfcpp::DW_TAG_typedef:
@@ -494,8 +712,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	      if (full_name.empty())
 		full_name = this->get_qualified_name(die, context);
 	      if (!full_name.empty())
-		this->gdb_index_->add_symbol(this->cu_index_,
-					     full_name.c_str(), 0);
+		this->scan_->add_symbol(this->cu_index_, full_name.c_str(), 0);
 	    }
 
 	  // We're interested in the children only for namespaces and
@@ -842,8 +1059,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
     {
       Dwarf_range_list* ranges = this->read_range_list(shndx, ranges_offset);
       if (ranges != NULL)
-	this->gdb_index_->add_address_range_list(this->object(),
-						 this->cu_index_, ranges);
+	this->scan_->add_address_range_list(this->cu_index_, ranges);
       return;
     }
 
@@ -868,8 +1084,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
         {
 	  Dwarf_range_list* ranges = new Dwarf_range_list();
 	  ranges->add(shndx, low_pc, high_pc);
-	  this->gdb_index_->add_address_range_list(this->object(),
-						   this->cu_index_, ranges);
+	  this->scan_->add_address_range_list(this->cu_index_, ranges);
         }
     }
 }
@@ -894,7 +1109,7 @@ Gdb_index_info_reader::read_pubtable(Dwarf_pubnames_table* table, off_t offset)
       if (name == NULL)
         break;
 
-      this->gdb_index_->add_symbol(this->cu_index_, name, flag_byte);
+      this->scan_->add_symbol(this->cu_index_, name, flag_byte);
     }
   return true;
 }
@@ -933,8 +1148,7 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
           // have read. If it does, then no need to read the pubnames.
           // If it doesn't, then the caller will have to parse the
           // dies manually to find the names.
-          return this->gdb_index_->pubnames_read(this->object(),
-                                                 stmt_list_off);
+          return this->scan_->pubnames_read(stmt_list_off);
         }
       else
         {
@@ -945,10 +1159,10 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
 
   // We found the attribute, so we can check if the corresponding
   // pubnames have been read.
-  if (this->gdb_index_->pubnames_read(this->object(), stmt_list_off))
+  if (this->scan_->pubnames_read(stmt_list_off))
     return true;
 
-  this->gdb_index_->set_pubnames_read(this->object(), stmt_list_off);
+  this->scan_->set_pubnames_read(stmt_list_off);
 
   // We have an attribute, and the pubnames haven't been read, so read
   // them.
@@ -956,12 +1170,12 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
   // In some of the cases, we could rely on the previous value of
   // offset here, but sorting out which cases complicates the logic
   // enough that it isn't worth it. So just look up the offset again.
-  offset = this->gdb_index_->find_pubname_offset(this->cu_offset());
-  names = this->read_pubtable(this->gdb_index_->pubnames_table(), offset);
+  offset = this->scan_->find_pubname_offset(this->cu_offset());
+  names = this->read_pubtable(this->scan_->pubnames_table(), offset);
 
   bool types = false;
-  offset = this->gdb_index_->find_pubtype_offset(this->cu_offset());
-  types = this->read_pubtable(this->gdb_index_->pubtypes_table(), offset);
+  offset = this->scan_->find_pubtype_offset(this->cu_offset());
+  types = this->read_pubtable(this->scan_->pubtypes_table(), offset);
   return names || types;
 }
 
@@ -981,55 +1195,7 @@ Gdb_index_info_reader::clear_declarations()
   this->declarations_.clear();
 }
 
-// Print usage statistics.
-void
-Gdb_index_info_reader::print_stats()
-{
-  fprintf(stderr, _("%s: DWARF CUs: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_cu_count);
-  fprintf(stderr, _("%s: DWARF CUs without pubnames/pubtypes: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_cu_nopubnames_count);
-  fprintf(stderr, _("%s: DWARF TUs: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_tu_count);
-  fprintf(stderr, _("%s: DWARF TUs without pubnames/pubtypes: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_tu_nopubnames_count);
-}
-
-// Class Gdb_index.
-
-// Construct the .gdb_index section.
-
-Gdb_index::Gdb_index(Output_section* gdb_index_section)
-  : Output_section_data(4),
-    pubnames_table_(NULL),
-    pubtypes_table_(NULL),
-    gdb_index_section_(gdb_index_section),
-    comp_units_(),
-    type_units_(),
-    ranges_(),
-    cu_vector_list_(),
-    cu_vector_offsets_(NULL),
-    stringpool_(),
-    tu_offset_(0),
-    addr_offset_(0),
-    symtab_offset_(0),
-    cu_pool_offset_(0),
-    stringpool_offset_(0),
-    pubnames_object_(NULL),
-    stmt_list_offset_(-1)
-{
-  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
-}
-
-Gdb_index::~Gdb_index()
-{
-  // Free the memory used by the symbol table.
-  delete this->gdb_symtab_;
-  // Free the memory used by the CU vectors.
-  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
-    delete this->cu_vector_list_[i];
-}
-
+// Class Gdb_index_scan.
 
 // Scan the pubnames and pubtypes sections and build a map of the
 // various cus and tus they refer to, so we can process the entries
@@ -1037,11 +1203,10 @@ Gdb_index::~Gdb_index()
 // Return the just-read table so it can be cached.
 
 Dwarf_pubnames_table*
-Gdb_index::map_pubtable_to_dies(unsigned int attr,
-                                Gdb_index_info_reader* dwinfo,
-                                Relobj* object,
-                                const unsigned char* symbols,
-                                off_t symbols_size)
+Gdb_index_scan::map_pubtable_to_dies(unsigned int attr,
+				     Gdb_index_info_reader* dwinfo,
+				     const unsigned char* symbols,
+				     off_t symbols_size)
 {
   uint64_t section_offset = 0;
   Dwarf_pubnames_table* table;
@@ -1059,7 +1224,7 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
     }
 
   map->clear();
-  if (!table->read_section(object, symbols, symbols_size))
+  if (!table->read_section(this->object_, symbols, symbols_size))
     return NULL;
 
   while (table->read_header(section_offset))
@@ -1074,30 +1239,26 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
 // Wrapper for map_pubtable_to_dies
 
 void
-Gdb_index::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                          Relobj* object,
-                                          const unsigned char* symbols,
-                                          off_t symbols_size)
+Gdb_index_scan::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
+					       const unsigned char* symbols,
+					       off_t symbols_size)
 {
-  // This is a new object, so reset the relevant variables.
-  this->pubnames_object_ = object;
+  this->pubtables_mapped_ = true;
   this->stmt_list_offset_ = -1;
 
-  delete this->pubnames_table_;
   this->pubnames_table_
       = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubnames, dwinfo,
-                                   object, symbols, symbols_size);
-  delete this->pubtypes_table_;
+                                   symbols, symbols_size);
   this->pubtypes_table_
       = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubtypes, dwinfo,
-                                   object, symbols, symbols_size);
+                                   symbols, symbols_size);
 }
 
 // Given a cu_offset, find the associated section of the pubnames
 // table.
 
 off_t
-Gdb_index::find_pubname_offset(off_t cu_offset)
+Gdb_index_scan::find_pubname_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubname_map_.find(cu_offset);
   if (it != this->cu_pubname_map_.end())
@@ -1109,7 +1270,7 @@ Gdb_index::find_pubname_offset(off_t cu_offset)
 // table.
 
 off_t
-Gdb_index::find_pubtype_offset(off_t cu_offset)
+Gdb_index_scan::find_pubtype_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubtype_map_.find(cu_offset);
   if (it != this->cu_pubtype_map_.end())
@@ -1119,6 +1280,161 @@ Gdb_index::find_pubtype_offset(off_t cu_offset)
 
 // Scan a .debug_info or .debug_types input section.
 
+void
+Gdb_index_scan::scan_debug_info(bool is_type_unit,
+				const unsigned char* symbols,
+				off_t symbols_size,
+				unsigned int shndx,
+				unsigned int reloc_shndx,
+				unsigned int reloc_type)
+{
+  Gdb_index_info_reader dwinfo(is_type_unit, this->object_,
+			       symbols, symbols_size,
+			       shndx, reloc_shndx,
+			       reloc_type, this);
+  if (!this->pubtables_mapped_)
+    this->map_pubnames_and_types_to_dies(&dwinfo, symbols, symbols_size);
+  dwinfo.parse();
+}
+
+// Scan the sections recorded by add_pending_section.  This runs in
+// a Gdb_index_scan_task, after the symbols read by Read_symbols have
+// been freed, so read the symbol table again; the relocations for
+// the debug info refer to it.
+
+void
+Gdb_index_scan::scan_pending_sections()
+{
+  Relobj* object = this->object_;
+  const unsigned char* symbols = NULL;
+  section_size_type symbols_size = 0;
+  for (unsigned int i = 1; i < object->shnum(); ++i)
+    {
+      if (object->section_type(i) == elfcpp::SHT_SYMTAB)
+	{
+	  symbols = object->section_contents(i, &symbols_size, false);
+	  break;
+	}
+    }
+
+  for (std::vector<Pending_section>::const_iterator p
+	 = this->pending_sections_.begin();
+       p != this->pending_sections_.end();
+       ++p)
+    this->scan_debug_info(p->is_type_unit, symbols, symbols_size,
+			  p->shndx, p->reloc_shndx, p->reloc_type);
+  this->pending_sections_.clear();
+}
+
+// Discard the entries once they have been merged.
+
+void
+Gdb_index_scan::clear_entries()
+{
+  this->comp_units_.clear();
+  this->type_units_.clear();
+  this->ranges_.clear();
+  this->symbols_.clear();
+  this->cu_count_ = 0;
+  this->cu_nopubnames_count_ = 0;
+  this->tu_count_ = 0;
+  this->tu_nopubnames_count_ = 0;
+}
+
+// A task to scan the debug info of one object for the .gdb_index
+// section.
+
+class Gdb_index_scan_task : public Task
+{
+ public:
+  Gdb_index_scan_task(Gdb_index_scan* scan, Task_token* blocker)
+    : scan_(scan), blocker_(blocker)
+  { }
+
+  // Wait until the object is unlocked.
+  Task_token*
+  is_runnable()
+  {
+    if (this->scan_->object()->is_locked())
+      return this->scan_->object()->token();
+    return NULL;
+  }
+
+  // Lock the object while we run, and unblock BLOCKER_ when done.
+  void
+  locks(Task_locker* tl)
+  {
+    tl->add(this, this->blocker_);
+    Task_token* token = this->scan_->object()->token();
+    if (token != NULL)
+      tl->add(this, token);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    this->scan_->scan_pending_sections();
+    this->scan_->object()->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Gdb_index_scan_task " + this->scan_->object()->name(); }
+
+ private:
+  Gdb_index_scan* const scan_;
+  Task_token* const blocker_;
+};
+
+// Class Gdb_index.
+
+// Total number of DWARF compilation units processed.
+unsigned int Gdb_index::dwarf_cu_count = 0;
+// Number of DWARF compilation units without pubnames/pubtypes.
+unsigned int Gdb_index::dwarf_cu_nopubnames_count = 0;
+// Total number of DWARF type units processed.
+unsigned int Gdb_index::dwarf_tu_count = 0;
+// Number of DWARF type units without pubnames/pubtypes.
+unsigned int Gdb_index::dwarf_tu_nopubnames_count = 0;
+
+// Construct the .gdb_index section.
+
+Gdb_index::Gdb_index(Output_section* gdb_index_section)
+  : Output_section_data(4),
+    gdb_index_section_(gdb_index_section),
+    comp_units_(),
+    type_units_(),
+    ranges_(),
+    cu_vector_list_(),
+    cu_vector_offsets_(NULL),
+    stringpool_(),
+    tu_offset_(0),
+    addr_offset_(0),
+    symtab_offset_(0),
+    cu_pool_offset_(0),
+    stringpool_offset_(0),
+    defer_scans_(parameters->options().threads()
+		 && !parameters->incremental()),
+    current_scan_(NULL),
+    scans_()
+{
+  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+}
+
+Gdb_index::~Gdb_index()
+{
+  // Free the memory used by the symbol table.
+  delete this->gdb_symtab_;
+  // Free the memory used by the CU vectors.
+  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
+    delete this->cu_vector_list_[i];
+  delete this->current_scan_;
+  for (unsigned int i = 0; i < this->scans_.size(); ++i)
+    delete this->scans_[i];
+}
+
+// Scan a .debug_info or .debug_types input section.
+
 void
 Gdb_index::scan_debug_info(bool is_type_unit,
 			   Relobj* object,
@@ -1128,25 +1444,111 @@ Gdb_index::scan_debug_info(bool is_type_unit,
 			   unsigned int reloc_shndx,
 			   unsigned int reloc_type)
 {
-  Gdb_index_info_reader dwinfo(is_type_unit, object,
-			       symbols, symbols_size,
-			       shndx, reloc_shndx,
-			       reloc_type, this);
-  if (object != this->pubnames_object_)
-    map_pubnames_and_types_to_dies(&dwinfo, object, symbols, symbols_size);
-  dwinfo.parse();
+  if (this->defer_scans_)
+    {
+      if (this->scans_.empty() || this->scans_.back()->object() != object)
+	this->scans_.push_back(new Gdb_index_scan(object));
+      this->scans_.back()->add_pending_section(is_type_unit, shndx,
+					       reloc_shndx, reloc_type);
+      return;
+    }
+
+  if (this->current_scan_ == NULL || this->current_scan_->object() != object)
+    {
+      delete this->current_scan_;
+      this->current_scan_ = new Gdb_index_scan(object);
+    }
+  this->current_scan_->scan_debug_info(is_type_unit, symbols, symbols_size,
+				       shndx, reloc_shndx, reloc_type);
+  this->merge_scan(this->current_scan_);
+}
+
+// Queue a task to scan the recorded sections of each object.  The
+// tasks only read their own object, and each fills in its own
+// Gdb_index_scan, so they can run in any order.  The results are
+// merged in input order by merge_scans.  Return true if any tasks
+// were queued.
+
+bool
+Gdb_index::queue_scan_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  if (this->scans_.empty())
+    return false;
+
+  blocker->add_blockers(this->scans_.size());
+  for (unsigned int i = 0; i < this->scans_.size(); ++i)
+    workqueue->queue(new Gdb_index_scan_task(this->scans_[i], blocker));
+  return true;
+}
+
+// Merge the entries found by SCAN into the index.
+
+void
+Gdb_index::merge_scan(Gdb_index_scan* scan)
+{
+  const int cu_base = this->comp_units_.size();
+  const int tu_base = this->type_units_.size();
+
+  this->comp_units_.insert(this->comp_units_.end(),
+			   scan->comp_units().begin(),
+			   scan->comp_units().end());
+  this->type_units_.insert(this->type_units_.end(),
+			   scan->type_units().begin(),
+			   scan->type_units().end());
+
+  // Only CUs have address ranges.
+  const std::vector<Per_cu_range_list>& ranges(scan->ranges());
+  for (unsigned int i = 0; i < ranges.size(); ++i)
+    this->ranges_.push_back(Per_cu_range_list(ranges[i].object,
+					      ranges[i].cu_index + cu_base,
+					      ranges[i].ranges));
+
+  // A negative index refers to a TU.
+  const std::vector<Gdb_index_scan::Symbol>& symbols(scan->symbols());
+  for (unsigned int i = 0; i < symbols.size(); ++i)
+    {
+      const Gdb_index_scan::Symbol& sym(symbols[i]);
+      int cu_index = (sym.cu_index >= 0
+		      ? sym.cu_index + cu_base
+		      : sym.cu_index - tu_base);
+      this->add_symbol(cu_index, sym.name.data(), sym.name.length(),
+		       sym.hashval, sym.hash_code, sym.flags);
+    }
+
+  Gdb_index::dwarf_cu_count += scan->cu_count();
+  Gdb_index::dwarf_cu_nopubnames_count += scan->cu_nopubnames_count();
+  Gdb_index::dwarf_tu_count += scan->tu_count();
+  Gdb_index::dwarf_tu_nopubnames_count += scan->tu_nopubnames_count();
+
+  scan->clear_entries();
+}
+
+// Merge the entries found by the scan tasks, in input order, so
+// that the index is the same as if the objects had been scanned
+// one at a time.
+
+void
+Gdb_index::merge_scans()
+{
+  for (unsigned int i = 0; i < this->scans_.size(); ++i)
+    {
+      this->merge_scan(this->scans_[i]);
+      delete this->scans_[i];
+    }
+  this->scans_.clear();
 }
 
-// Add a symbol.
+// Add a symbol.  HASHVAL is the gdb hash of SYM_NAME, and HASH_CODE
+// is its Stringpool hash code.
 
 void
-Gdb_index::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
+Gdb_index::add_symbol(int cu_index, const char* sym_name, size_t len,
+		      unsigned int hashval, size_t hash_code, uint8_t flags)
 {
-  unsigned int hash = mapped_index_string_hash(
-      reinterpret_cast<const unsigned char*>(sym_name));
   Gdb_symbol* sym = new Gdb_symbol();
-  this->stringpool_.add(sym_name, true, &sym->name_key);
-  sym->hashval = hash;
+  this->stringpool_.add_with_hash(sym_name, len, hash_code, true,
+				  &sym->name_key);
+  sym->hashval = hashval;
   sym->cu_vector_index = 0;
 
   Gdb_symbol* found = this->gdb_symtab_->add(sym);
@@ -1173,32 +1575,13 @@ Gdb_index::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
     cu_vec->push_back(std::make_pair(cu_index, flags));
 }
 
-// Return TRUE if we have already processed the pubnames associated
-// with the statement list at the given OFFSET.
-
-bool
-Gdb_index::pubnames_read(const Relobj* object, off_t offset)
-{
-  bool ret = (this->pubnames_object_ == object
-	      && this->stmt_list_offset_ == offset);
-  return ret;
-}
-
-// Record that we have processed the pubnames associated with the
-// statement list for OBJECT at the given OFFSET.
-
-void
-Gdb_index::set_pubnames_read(const Relobj* object, off_t offset)
-{
-  this->pubnames_object_ = object;
-  this->stmt_list_offset_ = offset;
-}
-
 // Set the size of the .gdb_index section.
 
 void
 Gdb_index::set_final_data_size()
 {
+  this->merge_scans();
+
   // Finalize the string pool.
   this->stringpool_.set_string_offsets();
 
@@ -1369,8 +1752,17 @@ Gdb_index::do_write(Output_file* of)
 void
 Gdb_index::print_stats()
 {
-  if (parameters->options().gdb_index())
-    Gdb_index_info_reader::print_stats();
+  if (!parameters->options().gdb_index())
+    return;
+
+  fprintf(stderr, _("%s: DWARF CUs: %u\n"),
+          program_name, Gdb_index::dwarf_cu_count);
+  fprintf(stderr, _("%s: DWARF CUs without pubnames/pubtypes: %u\n"),
+          program_name, Gdb_index::dwarf_cu_nopubnames_count);
+  fprintf(stderr, _("%s: DWARF TUs: %u\n"),
+          program_name, Gdb_index::dwarf_tu_count);
+  fprintf(stderr, _("%s: DWARF TUs without pubnames/pubtypes: %u\n"),
+          program_name, Gdb_index::dwarf_tu_nopubnames_count);
 }
 
 } // End namespace gold.
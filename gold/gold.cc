@@ -134,6 +134,44 @@ Middle_runner::run(Workqueue* workqueue, const Task* task)
 		     this->layout_, workqueue, this->mapfile_);
 }
 
+static void
+queue_middle_layout_tasks(const General_options&, const Task*,
+			  const Input_objects*, Symbol_table*, Layout*,
+			  Workqueue*, Mapfile*);
+
+// This class arranges to run the rest of the middle of the link once
+// identical code folding is done.
+
+class Middle_layout_runner : public Task_function_runner
+{
+ public:
+  Middle_layout_runner(const General_options& options,
+		       const Input_objects* input_objects,
+		       Symbol_table* symtab,
+		       Layout* layout, Mapfile* mapfile)
+    : options_(options), input_objects_(input_objects), symtab_(symtab),
+      layout_(layout), mapfile_(mapfile)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  const General_options& options_;
+  const Input_objects* input_objects_;
+  Symbol_table* symtab_;
+  Layout* layout_;
+  Mapfile* mapfile_;
+};
+
+void
+Middle_layout_runner::run(Workqueue* workqueue, const Task* task)
+{
+  queue_middle_layout_tasks(this->options_, task, this->input_objects_,
+			    this->symtab_, this->layout_, workqueue,
+			    this->mapfile_);
+}
+
 // This class arranges the tasks to process the relocs for garbage collection.
 
 class Gc_runner : public Task_function_runner
@@ -530,9 +568,35 @@ queue_middle_tasks(const General_options& options,
   // be folding sections that will be garbage.
   if (parameters->options().icf_enabled())
     {
+      // With threads, the sections are checksummed by tasks, and the
+      // rest of the middle tasks are queued once ICF is done.
+      if (parameters->options().threads())
+	{
+	  symtab->icf()->queue_find_identical_sections(
+	      input_objects, symtab, workqueue,
+	      new Middle_layout_runner(options, input_objects, symtab,
+				       layout, mapfile));
+	  return;
+	}
       symtab->icf()->find_identical_sections(input_objects, symtab);
     }
 
+  queue_middle_layout_tasks(options, task, input_objects, symtab, layout,
+			    workqueue, mapfile);
+}
+
+// Queue the rest of the middle set of tasks, once we know which
+// sections are garbage collected or folded.
+
+static void
+queue_middle_layout_tasks(const General_options& options,
+			  const Task* task,
+			  const Input_objects* input_objects,
+			  Symbol_table* symtab,
+			  Layout* layout,
+			  Workqueue* workqueue,
+			  Mapfile* mapfile)
+{
   // Call Object::layout for the second time to determine the
   // output_sections for all referenced input sections.  When
   // --gc-sections or --icf is turned on, or when certain input
@@ -777,6 +841,15 @@ queue_middle_tasks(const General_options& options,
 	}
     }
 
+  // With --threads, scan the debug info for the .gdb_index section
+  // while the relocations are read and scanned.
+  Task_token* gdb_index_blocker = new Task_token(true);
+  if (!layout->queue_gdb_index_tasks(workqueue, gdb_index_blocker))
+    {
+      delete gdb_index_blocker;
+      gdb_index_blocker = NULL;
+    }
+
   // When all those tasks are complete, we can start laying out the
   // output file.
   workqueue->queue(new Task_function(new Layout_task_runner(options,
@@ -784,7 +857,8 @@ queue_middle_tasks(const General_options& options,
 							    symtab,
 							    target,
 							    layout,
-							    mapfile),
+							    mapfile,
+							    gdb_index_blocker),
 				     this_blocker,
 				     "Task_function Layout_task_runner"));
 }
@@ -811,6 +885,11 @@ queue_final_tasks(const General_options& options,
 
   bool any_postprocessing_sections = layout->any_postprocessing_sections();
 
+  // The layout is now final, so the relocation cache can compute the
+  // part of its keys which depends on it.
+  if (layout->relocation_cache() != NULL)
+    layout->relocation_cache()->set_layout(layout);
+
   // Use a blocker to wait until all the input sections have been
   // written out.
   Task_token* input_sections_blocker = NULL;
@@ -836,6 +915,10 @@ queue_final_tasks(const General_options& options,
   if (!any_postprocessing_sections)
     final_blocker->add_blocker();
 
+  // For --build-id=tree and --stream-output-file, start processing
+  // each part of the output file as soon as it is written.
+  layout->start_output_file_chunks(input_objects, of, workqueue);
+
   // Queue a task to write out the symbol table.
   workqueue->queue(new Write_symbols_task(layout,
 					  symtab,
@@ -886,7 +969,9 @@ queue_final_tasks(const General_options& options,
     }
 
   // Create tasks for tree-style build ID computation, if necessary.
-  if (strcmp(options.build_id(), "tree") == 0)
+  // This also waits for the output file chunks, if any.
+  if (strcmp(options.build_id(), "tree") == 0
+      || layout->output_file_chunks() != NULL)
     {
       // Queue a task to compute the build id.  This will be blocked by
       // FINAL_BLOCKER, and will in turn schedule the task to close
@@ -177,52 +177,26 @@ namespace gold
 // sections has unique contents.  Such unique sections or groups can be
 // declared final and need not be processed any further.
 // Parameters :
-// ID_SECTION : Vector mapping a section index to a Section_id pair.
+// SECTION_CKSUMS : Checksums of the section contents before the first
+//                  iteration of icf, and of the section's text and relocs
+//                  to sections that cannot be folded after that.
 // IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
 //                            sections is already known to be unique.
-// SECTION_CONTENTS : Contains the section's text and relocs to sections
-//                    that cannot be folded.   SECTION_CONTENTS are NULL
-//                    implies that this function is being called for the
-//                    first time before the first iteration of icf.
 
 static void
-preprocess_for_unique_sections(const std::vector<Section_id>& id_section,
-                               std::vector<bool>* is_secn_or_group_unique,
-                               std::vector<std::string>* section_contents)
+preprocess_for_unique_sections(const std::vector<uint32_t>& section_cksums,
+                               std::vector<bool>* is_secn_or_group_unique)
 {
   Unordered_map<uint32_t, unsigned int> uniq_map;
   std::pair<Unordered_map<uint32_t, unsigned int>::iterator, bool>
     uniq_map_insert;
 
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (unsigned int i = 0; i < section_cksums.size(); i++)
     {
       if ((*is_secn_or_group_unique)[i])
         continue;
 
-      uint32_t cksum;
-      Section_id secn = id_section[i];
-      section_size_type plen;
-      if (section_contents == NULL)
-        {
-          // Lock the object so we can read from it.  This is only called
-          // single-threaded from queue_middle_tasks, so it is OK to lock.
-          // Unfortunately we have no way to pass in a Task token.
-          const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-          Task_lock_obj<Object> tl(dummy_task, secn.first);
-          const unsigned char* contents;
-          contents = secn.first->section_contents(secn.second,
-                                                  &plen,
-                                                  false);
-          cksum = xcrc32(contents, plen, 0xffffffff);
-        }
-      else
-        {
-          const unsigned char* contents_array = reinterpret_cast
-            <const unsigned char*>((*section_contents)[i].c_str());
-          cksum = xcrc32(contents_array, (*section_contents)[i].length(),
-                         0xffffffff);
-        }
-      uniq_map_insert = uniq_map.insert(std::make_pair(cksum, i));
+      uniq_map_insert = uniq_map.insert(std::make_pair(section_cksums[i], i));
       if (uniq_map_insert.second)
         {
           (*is_secn_or_group_unique)[i] = true;
@@ -274,16 +248,18 @@ get_rel_addend(const unsigned char* reloc_addend_ptr,
     }
 }
 
-// This returns the buffer containing the section's contents, both
-// text and relocs.  Relocs are differentiated as those pointing to
-// sections that could be folded and those that cannot.  Only relocs
-// pointing to sections that could be folded are recomputed on
+// This computes the section's contents, both text and relocs, as used
+// to compare sections.  Relocs are differentiated as those pointing to
+// sections that could be folded and those that cannot.  The contents
+// are the portion that does not change from iteration to iteration,
+// followed by the returned buffer, which holds the relocs pointing to
+// sections that could be folded.  Only that buffer is recomputed on
 // subsequent invocations of this function.
 // Parameters  :
 // FIRST_ITERATION    : true if it is the first invocation.
-// FIXED_CACHE        : String that stores the portion of the result that
+// FIXED_CACHE        : String that stores the portion of the contents that
 //                      does not change from iteration to iteration;
-//                      written if first_iteration is true, read if it's false.
+//                      written if first_iteration is true.
 // SECN               : Section for which contents are desired.
 // SELF_SECN          : Relocations that target this section will be
 //                      considered "relocations to self" so that recursive
@@ -617,33 +593,41 @@ get_section_contents(bool first_iteration,
        it_ext != extra_range.second; ++it_ext)
     {
       std::string external_fixed;
-      std::string external_all =
+      std::string external_relocs =
 	get_section_contents(first_iteration, &external_fixed,
 			     it_ext->second.section, self_secn,
 			     num_tracked_relocs, symtab,
 			     kept_section_id, it_ext->second.offset,
 			     it_ext->second.offset + it_ext->second.length);
       buffer.append(external_fixed);
-      icf_reloc_buffer.append(external_all, external_fixed.length(),
-			      std::string::npos);
+      icf_reloc_buffer.append(external_relocs);
     }
 
   if (first_iteration)
     {
       // Store the section contents that don't change to avoid recomputing
       // during the next call to this function.
-      *fixed_cache = buffer;
+      fixed_cache->swap(buffer);
     }
   else
-    {
-      gold_assert(buffer.empty());
+    gold_assert(buffer.empty());
 
-      // Reuse the contents computed in the previous iteration.
-      buffer.append(*fixed_cache);
-    }
+  return icf_reloc_buffer;
+}
+
+// Return whether the contents FIXED1 followed by RELOCS1 are the same
+// as FIXED2 followed by RELOCS2.
 
-  buffer.append(icf_reloc_buffer);
-  return buffer;
+static bool
+same_section_contents(const std::string& fixed1, const std::string& relocs1,
+		      const std::string& fixed2, const std::string& relocs2)
+{
+  if (fixed1.length() + relocs1.length()
+      != fixed2.length() + relocs2.length())
+    return false;
+  if (fixed1.length() == fixed2.length())
+    return fixed1 == fixed2 && relocs1 == relocs2;
+  return fixed1 + relocs1 == fixed2 + relocs2;
 }
 
 // This function computes a checksum on each section to detect and form
@@ -659,6 +643,12 @@ get_section_contents(bool first_iteration,
 // identical sections.  A section is added to a group only after its
 // contents are explicitly compared with the kept section of the group.
 //
+// The part of each section's contents that does not change between
+// iterations, and its checksum, are computed before the first iteration.
+// Each iteration only computes the relocs to sections that could be
+// folded, and continues the checksum over them.  Those relocs depend on
+// the groups formed so far, so the sections are processed in order.
+//
 // Parameters  :
 // ITERATION_NUM           : Invocation instance of this function.
 // NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
@@ -667,83 +657,61 @@ get_section_contents(bool first_iteration,
 // ID_SECTION         : Vector mapping a section to an unique integer.
 // IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
 //                            sections is already known to be unique.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
+// SECTION_CONTENTS   : The section's text and relocs to non-ICF
 //                      sections.
+// SECTION_CKSUMS     : The checksums of SECTION_CONTENTS.
 
 static bool
 match_sections(unsigned int iteration_num,
                Symbol_table* symtab,
-               std::vector<unsigned int>* num_tracked_relocs,
+               const std::vector<unsigned int>& num_tracked_relocs,
                std::vector<unsigned int>* kept_section_id,
                const std::vector<Section_id>& id_section,
 	       const std::vector<uint64_t>& section_addraligns,
                std::vector<bool>* is_secn_or_group_unique,
-               std::vector<std::string>* section_contents)
+               const std::vector<std::string>& section_contents,
+               const std::vector<uint32_t>& section_cksums)
 {
   Unordered_multimap<uint32_t, unsigned int> section_cksum;
   std::pair<Unordered_multimap<uint32_t, unsigned int>::iterator,
             Unordered_multimap<uint32_t, unsigned int>::iterator> key_range;
   bool converged = true;
 
-  if (iteration_num == 1)
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   NULL);
-  else
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   section_contents);
+  // The first iteration uses the uniqueness computed when the section
+  // contents were gathered.
+  if (iteration_num > 1)
+    preprocess_for_unique_sections(section_cksums, is_secn_or_group_unique);
 
-  std::vector<std::string> full_section_contents;
+  // The relocs to ICF sections of the kept section of each group.
+  std::vector<std::string> kept_section_relocs(id_section.size());
 
   for (unsigned int i = 0; i < id_section.size(); i++)
     {
-      full_section_contents.push_back("");
       if ((*is_secn_or_group_unique)[i])
         continue;
 
-      Section_id secn = id_section[i];
-
-      // Lock the object so we can read from it.  This is only called
-      // single-threaded from queue_middle_tasks, so it is OK to lock.
-      // Unfortunately we have no way to pass in a Task token.
-      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-      Task_lock_obj<Object> tl(dummy_task, secn.first);
-
-      std::string this_secn_contents;
-      uint32_t cksum;
-      std::string* this_secn_cache = &((*section_contents)[i]);
-      if (iteration_num == 1)
-        {
-          unsigned int num_relocs = 0;
-          this_secn_contents = get_section_contents(true, this_secn_cache,
-						    secn, secn, &num_relocs,
-						    symtab, (*kept_section_id));
-          (*num_tracked_relocs)[i] = num_relocs;
-        }
-      else
-        {
-          if ((*kept_section_id)[i] != i)
-            {
-              // This section is already folded into something.
-              continue;
-            }
-          this_secn_contents = get_section_contents(false, this_secn_cache,
-						    secn, secn, NULL,
-						    symtab, (*kept_section_id));
-        }
+      // A section already folded into something is not processed
+      // again.
+      if (iteration_num > 1 && (*kept_section_id)[i] != i)
+        continue;
 
-      const unsigned char* this_secn_contents_array =
-            reinterpret_cast<const unsigned char*>(this_secn_contents.c_str());
-      cksum = xcrc32(this_secn_contents_array, this_secn_contents.length(),
-                     0xffffffff);
+      Section_id secn = id_section[i];
+      std::string this_secn_relocs = get_section_contents(false, NULL,
+							  secn, secn, NULL,
+							  symtab,
+							  (*kept_section_id));
+
+      const unsigned char* this_secn_relocs_array =
+            reinterpret_cast<const unsigned char*>(this_secn_relocs.c_str());
+      uint32_t cksum = xcrc32(this_secn_relocs_array,
+			      this_secn_relocs.length(), section_cksums[i]);
       size_t count = section_cksum.count(cksum);
 
       if (count == 0)
         {
           // Start a group with this cksum.
           section_cksum.insert(std::make_pair(cksum, i));
-          full_section_contents[i] = this_secn_contents;
+          kept_section_relocs[i].swap(this_secn_relocs);
         }
       else
         {
@@ -753,12 +721,10 @@ match_sections(unsigned int iteration_num,
           for (it = key_range.first; it != key_range.second; ++it)
             {
               unsigned int kept_section = it->second;
-              if (full_section_contents[kept_section].length()
-                  != this_secn_contents.length())
-                  continue;
-              if (memcmp(full_section_contents[kept_section].c_str(),
-                         this_secn_contents.c_str(),
-                         this_secn_contents.length()) != 0)
+              if (!same_section_contents(section_contents[kept_section],
+					 kept_section_relocs[kept_section],
+					 section_contents[i],
+					 this_secn_relocs))
                   continue;
 
 	      // Check section alignment here.
@@ -775,8 +741,8 @@ match_sections(unsigned int iteration_num,
 		{
 		  (*kept_section_id)[kept_section] = i;
 		  it->second = i;
-		  full_section_contents[kept_section].swap(
-		      full_section_contents[i]);
+		  kept_section_relocs[i].swap(this_secn_relocs);
+		  kept_section_relocs[kept_section].clear();
 		}
 
               converged = false;
@@ -786,12 +752,12 @@ match_sections(unsigned int iteration_num,
             {
               // Create a new group for this cksum.
               section_cksum.insert(std::make_pair(cksum, i));
-              full_section_contents[i] = this_secn_contents;
+              kept_section_relocs[i].swap(this_secn_relocs);
             }
         }
       // If there are no relocs to foldable sections do not process
       // this section any further.
-      if (iteration_num == 1 && (*num_tracked_relocs)[i] == 0)
+      if (iteration_num == 1 && num_tracked_relocs[i] == 0)
         (*is_secn_or_group_unique)[i] = true;
     }
 
@@ -943,22 +909,162 @@ Icf::add_ehframe_links(Relobj* object, unsigned int ehframe_shndx,
   return true;
 }
 
-// This is the main ICF function called in gold.cc.  This does the
-// initialization and calls match_sections repeatedly (thrice by default)
-// which computes the crc checksums and detects identical functions.
+// This is the main ICF function called in gold.cc when not running
+// with threads.  This does the initialization and calls match_sections
+// repeatedly (thrice by default) which computes the crc checksums and
+// detects identical functions.
 
 void
 Icf::find_identical_sections(const Input_objects* input_objects,
                              Symbol_table* symtab)
+{
+  this->find_candidate_sections(input_objects, symtab);
+
+  unsigned int first = 0;
+  while (first < this->id_section_.size())
+    {
+      unsigned int last = this->object_sections_end(first);
+
+      // Lock the object so we can read from it.  This is only called
+      // single-threaded from queue_middle_tasks, so it is OK to lock.
+      // Unfortunately we have no way to pass in a Task token.
+      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+      Task_lock_obj<Object> tl(dummy_task, this->id_section_[first].first);
+      this->checksum_section_contents(first, last);
+      first = last;
+    }
+
+  this->gather_section_contents(symtab);
+  this->checksum_gathered_contents(0, this->id_section_.size());
+
+  this->fold_identical_sections(symtab);
+}
+
+// This runs the ICF stages of queue_find_identical_sections that must
+// run on their own, after the checksum tasks of the previous stage.
+
+class Icf_runner : public Task_function_runner
+{
+ public:
+  // GATHER is true to gather the section contents, false to fold the
+  // sections.  NEXT is run once the sections have been folded.
+  Icf_runner(Icf* icf, Symbol_table* symtab, bool gather,
+	     Task_function_runner* next)
+    : icf_(icf), symtab_(symtab), gather_(gather), next_(next)
+  { }
+
+  ~Icf_runner()
+  { delete this->next_; }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  Icf* icf_;
+  Symbol_table* symtab_;
+  bool gather_;
+  Task_function_runner* next_;
+};
+
+void
+Icf_runner::run(Workqueue* workqueue, const Task* task)
+{
+  if (this->gather_)
+    {
+      this->icf_->gather_section_contents(this->symtab_);
+
+      Task_token* blocker = new Task_token(true);
+      this->icf_->queue_checksum_tasks(workqueue, true, blocker);
+      workqueue->queue(new Task_function(new Icf_runner(this->icf_,
+							this->symtab_,
+							false,
+							this->next_),
+					 blocker,
+					 "Task_function Icf_runner fold"));
+      this->next_ = NULL;
+    }
+  else
+    {
+      this->icf_->fold_identical_sections(this->symtab_);
+      this->next_->run(workqueue, task);
+    }
+}
+
+// Like find_identical_sections, but checksum the sections in tasks on
+// the workqueue, one per object.  Which sections are folded does not
+// depend on the order in which the tasks run.  Once the groups of
+// identical sections have been formed, NEXT is run.
+
+void
+Icf::queue_find_identical_sections(const Input_objects* input_objects,
+				   Symbol_table* symtab,
+				   Workqueue* workqueue,
+				   Task_function_runner* next)
+{
+  this->find_candidate_sections(input_objects, symtab);
+
+  Task_token* blocker = new Task_token(true);
+  this->queue_checksum_tasks(workqueue, false, blocker);
+  workqueue->queue(new Task_function(new Icf_runner(this, symtab, true, next),
+				     blocker,
+				     "Task_function Icf_runner gather"));
+}
+
+// Queue an Icf_checksum_task for the candidate sections of each
+// object.  If GATHERED is true, checksum the gathered contents of the
+// sections that are not already known to be unique; otherwise
+// checksum the section contents.  The tasks unblock BLOCKER.
+
+void
+Icf::queue_checksum_tasks(Workqueue* workqueue, bool gathered,
+			  Task_token* blocker)
+{
+  unsigned int first = 0;
+  while (first < this->id_section_.size())
+    {
+      unsigned int last = this->object_sections_end(first);
+      bool any = !gathered;
+      for (unsigned int i = first; !any && i < last; ++i)
+	any = !this->is_secn_or_group_unique_[i];
+      if (any)
+	{
+	  blocker->add_blocker();
+	  workqueue->queue(new Icf_checksum_task(this,
+						 this->id_section_[first].first,
+						 first, last, gathered,
+						 blocker));
+	  ++this->stats_.checksum_tasks;
+	}
+      first = last;
+    }
+}
+
+// Candidate sections are numbered in object order.  Return the end of
+// the run of candidate sections starting at FIRST that come from the
+// same object.
+
+unsigned int
+Icf::object_sections_end(unsigned int first) const
+{
+  Relobj* object = this->id_section_[first].first;
+  unsigned int last = first + 1;
+  while (last < this->id_section_.size()
+	 && this->id_section_[last].first == object)
+    ++last;
+  return last;
+}
+
+// Decide which sections are possible candidates for folding, and
+// number them.
+
+void
+Icf::find_candidate_sections(const Input_objects* input_objects,
+			     Symbol_table* symtab)
 {
   unsigned int section_num = 0;
-  std::vector<unsigned int> num_tracked_relocs;
-  std::vector<uint64_t> section_addraligns;
-  std::vector<bool> is_secn_or_group_unique;
-  std::vector<std::string> section_contents;
   const Target& target = parameters->target();
 
-  // Decide which sections are possible candidates first.
+  this->timer_.start();
 
   for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
        p != input_objects->relobj_end();
@@ -1001,10 +1107,12 @@ Icf::find_identical_sections(const Input_objects* input_objects,
           this->id_section_.push_back(Section_id(*p, i));
           this->section_id_[Section_id(*p, i)] = section_num;
           this->kept_section_id_.push_back(section_num);
-          num_tracked_relocs.push_back(0);
-	  section_addraligns.push_back((*p)->section_addralign(i));
-          is_secn_or_group_unique.push_back(false);
-          section_contents.push_back("");
+          this->num_tracked_relocs_.push_back(0);
+	  this->section_addraligns_.push_back((*p)->section_addralign(i));
+          this->is_secn_or_group_unique_.push_back(false);
+          this->section_contents_.push_back("");
+          this->section_cksums_.push_back(0);
+	  this->stats_.contents_bytes += (*p)->section_size(i);
           section_num++;
         }
 
@@ -1034,6 +1142,85 @@ Icf::find_identical_sections(const Input_objects* input_objects,
 	}
     }
 
+  this->stats_.select_time = this->timer_.get_elapsed_time();
+}
+
+// Compute the checksums of the contents of the candidate sections
+// FIRST to LAST - 1, which all come from one object.  The caller must
+// have locked that object.
+
+void
+Icf::checksum_section_contents(unsigned int first, unsigned int last)
+{
+  for (unsigned int i = first; i < last; ++i)
+    {
+      Section_id secn = this->id_section_[i];
+      section_size_type plen;
+      const unsigned char* contents =
+	secn.first->section_contents(secn.second, &plen, false);
+      this->section_cksums_[i] = xcrc32(contents, plen, 0xffffffff);
+    }
+}
+
+// Use the checksums of the section contents to find the sections with
+// unique contents, and gather the text and relocs to sections that
+// cannot be folded of the others.
+
+void
+Icf::gather_section_contents(Symbol_table* symtab)
+{
+  this->stats_.checksum_time = this->timer_.get_elapsed_time();
+
+  preprocess_for_unique_sections(this->section_cksums_,
+				 &this->is_secn_or_group_unique_);
+
+  for (unsigned int i = 0; i < this->id_section_.size(); i++)
+    {
+      if (this->is_secn_or_group_unique_[i])
+	continue;
+
+      Section_id secn = this->id_section_[i];
+
+      // Lock the object so we can read from it.  This is only called
+      // single-threaded from queue_middle_tasks, so it is OK to lock.
+      // Unfortunately we have no way to pass in a Task token.
+      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+      Task_lock_obj<Object> tl(dummy_task, secn.first);
+
+      unsigned int num_relocs = 0;
+      get_section_contents(true, &this->section_contents_[i], secn, secn,
+			   &num_relocs, symtab, this->kept_section_id_);
+      this->num_tracked_relocs_[i] = num_relocs;
+      this->stats_.gathered_bytes += this->section_contents_[i].length();
+    }
+  this->stats_.gather_time = this->timer_.get_elapsed_time();
+}
+
+// Compute the checksums of the gathered contents of the candidate
+// sections FIRST to LAST - 1 that are not known to be unique.
+
+void
+Icf::checksum_gathered_contents(unsigned int first, unsigned int last)
+{
+  for (unsigned int i = first; i < last; ++i)
+    {
+      if (this->is_secn_or_group_unique_[i])
+	continue;
+      const std::string& contents(this->section_contents_[i]);
+      this->section_cksums_[i] =
+	xcrc32(reinterpret_cast<const unsigned char*>(contents.data()),
+	       contents.length(), 0xffffffff);
+    }
+}
+
+// Form the groups of identical sections, once the gathered contents
+// of the sections have been checksummed.
+
+void
+Icf::fold_identical_sections(Symbol_table* symtab)
+{
+  this->stats_.gathered_checksum_time = this->timer_.get_elapsed_time();
+
   unsigned int num_iterations = 0;
 
   // Default number of iterations to run ICF is 3.
@@ -1047,9 +1234,12 @@ Icf::find_identical_sections(const Input_objects* input_objects,
     {
       num_iterations++;
       converged = match_sections(num_iterations, symtab,
-                                 &num_tracked_relocs, &this->kept_section_id_,
-                                 this->id_section_, section_addraligns,
-                                 &is_secn_or_group_unique, &section_contents);
+                                 this->num_tracked_relocs_,
+                                 &this->kept_section_id_,
+                                 this->id_section_, this->section_addraligns_,
+                                 &this->is_secn_or_group_unique_,
+                                 this->section_contents_,
+                                 this->section_cksums_);
     }
 
   if (parameters->options().print_icf_sections())
@@ -1088,9 +1278,99 @@ Icf::find_identical_sections(const Input_objects* input_objects,
 
     }
 
+  this->stats_.iterations = num_iterations;
+  this->stats_.fold_time = this->timer_.get_elapsed_time();
+
   this->icf_ready();
 }
 
+
+// Print statistics about identical code folding to stderr.
+
+void
+Icf::print_stats() const
+{
+  unsigned int folded = 0;
+  for (unsigned int i = 0; i < this->kept_section_id_.size(); ++i)
+    if (this->kept_section_id_[i] != i)
+      ++folded;
+
+  fprintf(stderr, _("%s: ICF candidate sections: %zu; folded: %u; "
+		    "iterations: %u\n"),
+	  program_name, this->id_section_.size(), folded,
+	  this->stats_.iterations);
+  fprintf(stderr, _("%s: ICF bytes checksummed: %llu contents, "
+		    "%llu gathered; checksum tasks: %u\n"),
+	  program_name,
+	  static_cast<unsigned long long>(this->stats_.contents_bytes),
+	  static_cast<unsigned long long>(this->stats_.gathered_bytes),
+	  this->stats_.checksum_tasks);
+
+  const Timer::TimeStats* times[] =
+    {
+      &this->stats_.select_time,
+      &this->stats_.checksum_time,
+      &this->stats_.gather_time,
+      &this->stats_.gathered_checksum_time,
+      &this->stats_.fold_time
+    };
+  long wall[5];
+  for (int i = 0; i < 5; ++i)
+    wall[i] = times[i]->wall - (i == 0 ? 0 : times[i - 1]->wall);
+  fprintf(stderr, _("%s: ICF wall time: select %ld.%03ld, "
+		    "checksum %ld.%03ld, gather %ld.%03ld, "
+		    "checksum gathered %ld.%03ld, fold %ld.%03ld\n"),
+	  program_name,
+	  wall[0] / 1000, wall[0] % 1000,
+	  wall[1] / 1000, wall[1] % 1000,
+	  wall[2] / 1000, wall[2] % 1000,
+	  wall[3] / 1000, wall[3] % 1000,
+	  wall[4] / 1000, wall[4] % 1000);
+}
+
+// Class Icf_checksum_task.
+
+// Checksumming the section contents reads the object, so it must be
+// locked.  Checksumming the gathered contents does not.
+
+Task_token*
+Icf_checksum_task::is_runnable()
+{
+  if (!this->gathered_ && this->object_->is_locked())
+    return this->object_->token();
+  return NULL;
+}
+
+void
+Icf_checksum_task::locks(Task_locker* tl)
+{
+  tl->add(this, this->blocker_);
+  if (!this->gathered_)
+    {
+      Task_token* token = this->object_->token();
+      if (token != NULL)
+	tl->add(this, token);
+    }
+}
+
+void
+Icf_checksum_task::run(Workqueue*)
+{
+  if (this->gathered_)
+    this->icf_->checksum_gathered_contents(this->first_, this->last_);
+  else
+    {
+      this->icf_->checksum_section_contents(this->first_, this->last_);
+      this->object_->release();
+    }
+}
+
+std::string
+Icf_checksum_task::get_name() const
+{
+  return "Icf_checksum_task " + this->object_->name();
+}
+
 // Unfolds the section denoted by OBJ and SHNDX if folded.
 
 void
@@ -28,6 +28,8 @@
 #include "elfcpp.h"
 #include "symtab.h"
 #include "object.h"
+#include "timer.h"
+#include "workqueue.h"
 
 namespace gold
 {
@@ -81,7 +83,9 @@ class Icf
   : id_section_(), section_id_(), kept_section_id_(),
     fptr_section_id_(),
     icf_ready_(false),
-    reloc_info_list_()
+    reloc_info_list_(), num_tracked_relocs_(), section_addraligns_(),
+    is_secn_or_group_unique_(), section_contents_(), section_cksums_(),
+    timer_(), stats_()
   { }
 
   // Returns the kept folded identical section corresponding to
@@ -95,6 +99,40 @@ class Icf
   find_identical_sections(const Input_objects* input_objects,
                           Symbol_table* symtab);
 
+  // Like find_identical_sections, but checksum the sections in tasks
+  // on WORKQUEUE.  NEXT is run, and deleted, once the groups have
+  // been formed.
+  void
+  queue_find_identical_sections(const Input_objects* input_objects,
+				Symbol_table* symtab, Workqueue* workqueue,
+				Task_function_runner* next);
+
+  // The stages of find_identical_sections, for use by its tasks.
+
+  // Queue the tasks to checksum the candidate sections.
+  void
+  queue_checksum_tasks(Workqueue*, bool gathered, Task_token* blocker);
+
+  // Checksum the contents of candidate sections FIRST to LAST - 1.
+  void
+  checksum_section_contents(unsigned int first, unsigned int last);
+
+  // Gather the contents of the sections that might be folded.
+  void
+  gather_section_contents(Symbol_table*);
+
+  // Checksum the gathered contents of sections FIRST to LAST - 1.
+  void
+  checksum_gathered_contents(unsigned int first, unsigned int last);
+
+  // Form the groups of identical sections.
+  void
+  fold_identical_sections(Symbol_table*);
+
+  // Print statistics to stderr.
+  void
+  print_stats() const;
+
   // This is set when ICF has been run and the groups of
   // identical sections have been formed.
   void
@@ -163,6 +201,32 @@ class Icf
 
  private:
 
+  // Statistics for --stats.  The times are since ICF started.
+  struct Icf_stats
+  {
+    Icf_stats()
+      : contents_bytes(0), gathered_bytes(0), checksum_tasks(0),
+	iterations(0), select_time(), checksum_time(), gather_time(),
+	gathered_checksum_time(), fold_time()
+    { }
+
+    uint64_t contents_bytes;
+    uint64_t gathered_bytes;
+    unsigned int checksum_tasks;
+    unsigned int iterations;
+    Timer::TimeStats select_time;
+    Timer::TimeStats checksum_time;
+    Timer::TimeStats gather_time;
+    Timer::TimeStats gathered_checksum_time;
+    Timer::TimeStats fold_time;
+  };
+
+  void
+  find_candidate_sections(const Input_objects*, Symbol_table*);
+
+  unsigned int
+  object_sections_end(unsigned int first) const;
+
   bool
   add_ehframe_links(Relobj* object, unsigned int ehframe_shndx,
 		    Reloc_info& ehframe_relocs);
@@ -186,6 +250,60 @@ class Icf
   // Regions of other sections that should be considered part of
   // each section for ICF purposes.
   Extra_identity_list extra_identity_list_;
+  // The following are indexed like id_section_.
+  // The number of relocs of each section to sections that might be
+  // folded.
+  std::vector<unsigned int> num_tracked_relocs_;
+  // The alignment of each section.
+  std::vector<uint64_t> section_addraligns_;
+  // Whether each section, or its group, is known to be unique.
+  std::vector<bool> is_secn_or_group_unique_;
+  // The text and relocs to sections that cannot be folded of each
+  // section that might be folded.
+  std::vector<std::string> section_contents_;
+  // The checksum of each section's contents, and then of its
+  // section_contents_.
+  std::vector<uint32_t> section_cksums_;
+  // Measures the time spent in ICF for --stats.
+  Timer timer_;
+  Icf_stats stats_;
+};
+
+// A task to checksum candidate sections FIRST to LAST - 1, which all
+// come from OBJECT, for identical code folding.  If GATHERED is true
+// this checksums the contents gathered for the sections, otherwise
+// the section contents.  The task unblocks BLOCKER when done.
+
+class Icf_checksum_task : public Task
+{
+ public:
+  Icf_checksum_task(Icf* icf, Relobj* object, unsigned int first,
+		    unsigned int last, bool gathered, Task_token* blocker)
+    : icf_(icf), object_(object), first_(first), last_(last),
+      gathered_(gathered), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const;
+
+ private:
+  Icf* icf_;
+  Relobj* object_;
+  unsigned int first_;
+  unsigned int last_;
+  bool gathered_;
+  Task_token* blocker_;
 };
 
 // This function returns true if this section corresponds to a function that
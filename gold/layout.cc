@@ -370,6 +370,23 @@ Layout::Relaxation_debug_check::verify_sections(
 void
 Layout_task_runner::run(Workqueue* workqueue, const Task* task)
 {
+  // The size of the .gdb_index section is set when we finalize the
+  // layout, so wait for the tasks scanning the debug info.
+  if (this->gdb_index_blocker_ != NULL)
+    {
+      workqueue->queue(new Task_function(new Layout_task_runner(
+					   this->options_,
+					   this->input_objects_,
+					   this->symtab_,
+					   this->target_,
+					   this->layout_,
+					   this->mapfile_,
+					   NULL),
+					 this->gdb_index_blocker_,
+					 "Task_function Layout_task_runner"));
+      return;
+    }
+
   // See if any of the input definitions violate the One Definition Rule.
   // TODO: if this is too slow, do this as a task, rather than inline.
   this->symtab_->detect_odr_violations(task, this->options_.output_file_name());
@@ -452,6 +469,7 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     eh_frame_hdr_section_(NULL),
     gdb_index_data_(NULL),
     build_id_note_(NULL),
+    output_file_chunks_(NULL),
     debug_abbrev_(NULL),
     debug_info_(NULL),
     group_signatures_(),
@@ -468,6 +486,7 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     section_ordering_specified_(false),
     unique_segment_for_sections_specified_(false),
     incremental_inputs_(NULL),
+    relocation_cache_(NULL),
     record_output_section_data_from_script_(false),
     lto_slim_object_(false),
     script_output_section_data_list_(),
@@ -493,6 +512,10 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
   if (parameters->incremental())
     this->incremental_inputs_ = new Incremental_inputs;
 
+  if (parameters->options().relocation_cache() != NULL)
+    this->relocation_cache_ =
+      new Relocation_cache(parameters->options().relocation_cache());
+
   // The section name pool is worth optimizing in all cases, because
   // it is small, but there are often overlaps due to .rel sections.
   this->namepool_.set_optimize();
@@ -1655,6 +1678,17 @@ Layout::add_to_gdb_index(bool is_type_unit,
 					 reloc_type);
 }
 
+// Queue the tasks which scan the debug info for the .gdb_index
+// section.
+
+bool
+Layout::queue_gdb_index_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  if (this->gdb_index_data_ == NULL)
+    return false;
+  return this->gdb_index_data_->queue_scan_tasks(workqueue, blocker);
+}
+
 // Add POSD to an output section using NAME, TYPE, and FLAGS.  Return
 // the output section.
 
@@ -5910,6 +5944,34 @@ Layout::write_data(const Symbol_table* symtab, Output_file* of) const
     (*p)->write(of);
 }
 
+// Queue tasks to do the parallel part of postprocessing sections.
+// This is called by Write_after_input_sections_task, once all the
+// input sections have been written to the postprocessing buffers.
+
+bool
+Layout::queue_postprocessing_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  if (!this->any_postprocessing_sections_)
+    return false;
+
+  std::vector<Task*> tasks;
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    {
+      if ((*p)->requires_postprocessing())
+	(*p)->postprocessing_tasks(blocker, &tasks);
+    }
+
+  // Add all the blockers before queueing any of the tasks.
+  blocker->add_blockers(tasks.size());
+  for (std::vector<Task*>::const_iterator p = tasks.begin();
+       p != tasks.end();
+       ++p)
+    workqueue->queue(*p);
+  return !tasks.empty();
+}
+
 // Write out the Output_sections which can only be written after the
 // input sections are complete.
 
@@ -5948,6 +6010,192 @@ Layout::write_sections_after_input_sections(Output_file* of)
   this->section_headers_->write(of);
 }
 
+// Set up an Output_file_chunks to process each chunk of the output
+// file as soon as the tasks writing to it are done: to hash it for
+// --build-id=tree, and to write it to the file for
+// --stream-output-file.  We record every range of the file that each
+// task may write.  We don't do this if there are postprocessing
+// sections, since those may resize and remap the output file after
+// the other tasks are done, or for targets whose Relocate_tasks may
+// write outside the input sections of their object, or for link
+// modes in which they write reloc sections.
+
+void
+Layout::start_output_file_chunks(const Input_objects* input_objects,
+				 Output_file* of, Workqueue* workqueue)
+{
+  const General_options& options(parameters->options());
+  if (this->any_postprocessing_sections_
+      || options.relocatable()
+      || options.emit_relocs()
+      || parameters->incremental())
+    return;
+
+  int machine = parameters->target().machine_code();
+  if (machine != elfcpp::EM_X86_64 && machine != elfcpp::EM_386)
+    return;
+
+  const size_t filesize = (this->output_file_size() <= 0 ? 0
+			   : static_cast<size_t>(this->output_file_size()));
+  if (filesize == 0)
+    return;
+
+  bool is_hashing = (this->build_id_note_ != NULL
+		     && strcmp(options.build_id(), "tree") == 0
+		     && options.build_id_chunk_size_for_treehash() > 0
+		     && (filesize
+			 >= options.build_id_min_file_size_for_treehash()));
+  bool is_streaming = (options.stream_output_file()
+		       && of->start_streaming());
+  if (!is_hashing && !is_streaming)
+    return;
+
+  // When hashing, the chunks must be those of --build-id=tree.
+  size_t chunk_size = (is_hashing
+		       ? options.build_id_chunk_size_for_treehash()
+		       : 1 << 20);
+
+  // The memory of a chunk may be discarded once it is written unless
+  // it is read again to compute a flat build ID.
+  bool discard_written = this->build_id_note_ == NULL || is_hashing;
+
+  // The number of chunks which the Relocate_tasks may be writing to
+  // at once, for --stream-output-memory.
+  unsigned int max_open = 0;
+  if (options.stream_output_memory() > 0)
+    max_open = std::max(static_cast<uint64_t>(1),
+			std::min(options.stream_output_memory() / chunk_size,
+				 static_cast<uint64_t>(-1U)));
+
+  Output_file_chunks* chunks =
+    new Output_file_chunks(of, filesize, chunk_size, is_hashing,
+			   is_streaming, discard_written, max_open);
+
+  // Write_sections_task writes every section which is not written
+  // after the input sections, and Write_after_input_sections_task
+  // writes the rest and the section headers.
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    {
+      const Output_section* os = *p;
+      if (os->type() == elfcpp::SHT_NOBITS)
+	continue;
+      chunks->add_range((os->after_input_sections()
+			 ? Output_file_chunks::WRITE_AFTER_INPUT_SECTIONS
+			 : Output_file_chunks::WRITE_SECTIONS),
+			os->offset(), os->data_size());
+    }
+  if (this->section_headers_ != NULL)
+    chunks->add_range(Output_file_chunks::WRITE_AFTER_INPUT_SECTIONS,
+		      this->section_headers_->offset(),
+		      this->section_headers_->data_size());
+
+  // Writing .eh_frame_hdr reads .eh_frame back from the output file,
+  // so .eh_frame must not be discarded before then.
+  if (this->eh_frame_section_ != NULL)
+    chunks->add_range(Output_file_chunks::WRITE_AFTER_INPUT_SECTIONS,
+		      this->eh_frame_section_->offset(),
+		      this->eh_frame_section_->data_size());
+
+  // Write_data_task writes the section symbols and the data which is
+  // not in any section.  Write_symbols_task writes the global symbols.
+  const Output_section* symtabs[2] = { this->symtab_section_,
+				       this->dynsym_section_ };
+  for (int i = 0; i < 2; ++i)
+    {
+      if (symtabs[i] == NULL)
+	continue;
+      chunks->add_range(Output_file_chunks::WRITE_DATA,
+			symtabs[i]->offset(), symtabs[i]->data_size());
+      chunks->add_range(Output_file_chunks::WRITE_SYMBOLS,
+			symtabs[i]->offset(), symtabs[i]->data_size());
+    }
+  for (Data_list::const_iterator p = this->special_output_list_.begin();
+       p != this->special_output_list_.end();
+       ++p)
+    chunks->add_range(Output_file_chunks::WRITE_DATA, (*p)->offset(),
+		      (*p)->data_size());
+  for (Data_list::const_iterator p = this->relax_output_list_.begin();
+       p != this->relax_output_list_.end();
+       ++p)
+    chunks->add_range(Output_file_chunks::WRITE_DATA, (*p)->offset(),
+		      (*p)->data_size());
+
+  // A Relocate_task writes the input sections of its object and its
+  // local symbols.  We don't know the size of each input section
+  // without reading the section headers, so we assume that it
+  // extends to the start of the next input section in the file.
+  // Sections which need special offset handling may write anywhere
+  // in their output section.
+  struct Input_section_start
+  {
+    off_t start;
+    off_t limit;
+    const Relobj* object;
+
+    bool
+    operator<(const Input_section_start& b) const
+    { return this->start < b.start; }
+  };
+  std::vector<Input_section_start> starts;
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      const Relobj* object = *p;
+      for (int i = 0; i < 2; ++i)
+	if (symtabs[i] != NULL)
+	  chunks->add_range(object, symtabs[i]->offset(),
+			    symtabs[i]->data_size());
+
+      unsigned int shnum = object->shnum();
+      for (unsigned int shndx = 1; shndx < shnum; ++shndx)
+	{
+	  const Output_section* os = object->output_section(shndx);
+	  if (os == NULL || os->type() == elfcpp::SHT_NOBITS)
+	    continue;
+	  uint64_t off = object->output_section_offset(shndx);
+	  if (off == -1ULL)
+	    chunks->add_range(object, os->offset(), os->data_size());
+	  else
+	    {
+	      Input_section_start iss;
+	      iss.start = os->offset() + off;
+	      iss.limit = os->offset() + os->data_size();
+	      iss.object = object;
+	      starts.push_back(iss);
+	    }
+	}
+    }
+
+  std::sort(starts.begin(), starts.end());
+  size_t count = starts.size();
+  size_t next = 0;
+  for (size_t i = 0; i < count; ++i)
+    {
+      if (next <= i)
+	{
+	  next = i + 1;
+	  while (next < count && starts[next].start == starts[i].start)
+	    ++next;
+	}
+      off_t end = starts[i].limit;
+      if (next < count && starts[next].start < end)
+	end = starts[next].start;
+      chunks->add_range(starts[i].object, starts[i].start,
+			end - starts[i].start);
+    }
+
+  // The build ID note is written when the file is closed.
+  if (this->build_id_note_ != NULL)
+    chunks->defer_range(this->build_id_note_->offset(),
+			this->build_id_note_->data_size());
+
+  chunks->start(workqueue);
+  this->output_file_chunks_ = chunks;
+}
+
 // If a tree-style build ID was requested, the parallel part of that computation
 // is already done, and the final hash-of-hashes is computed here.  For other
 // types of build IDs, all the work is done here.
@@ -6070,6 +6318,12 @@ Layout::print_stats() const
        p != this->section_list_.end();
        ++p)
     (*p)->print_merge_stats();
+
+  if (this->relocation_cache_ != NULL)
+    this->relocation_cache_->print_stats();
+
+  if (this->output_file_chunks_ != NULL)
+    this->output_file_chunks_->print_stats();
 }
 
 // Write_sections_task methods.
@@ -6079,6 +6333,9 @@ Layout::print_stats() const
 Task_token*
 Write_sections_task::is_runnable()
 {
+  Output_file_chunks* chunks = this->layout_->output_file_chunks();
+  if (chunks != NULL && this->chunks_hold_ == NULL)
+    chunks->admit(Output_file_chunks::WRITE_SECTIONS, &this->chunks_hold_);
   return NULL;
 }
 
@@ -6092,14 +6349,21 @@ Write_sections_task::locks(Task_locker* tl)
   if (this->input_sections_blocker_ != NULL)
     tl->add(this, this->input_sections_blocker_);
   tl->add(this, this->final_blocker_);
+  if (this->chunks_hold_ != NULL)
+    tl->add(this, this->chunks_hold_);
 }
 
 // Run the task--write out the data.
 
 void
-Write_sections_task::run(Workqueue*)
+Write_sections_task::run(Workqueue* workqueue)
 {
   this->layout_->write_output_sections(this->of_);
+
+  Output_file_chunks* chunks = this->layout_->output_file_chunks();
+  if (chunks != NULL)
+    chunks->writer_done(workqueue, Output_file_chunks::WRITE_SECTIONS,
+			this->chunks_hold_);
 }
 
 // Write_data_task methods.
@@ -6109,6 +6373,9 @@ Write_sections_task::run(Workqueue*)
 Task_token*
 Write_data_task::is_runnable()
 {
+  Output_file_chunks* chunks = this->layout_->output_file_chunks();
+  if (chunks != NULL && this->chunks_hold_ == NULL)
+    chunks->admit(Output_file_chunks::WRITE_DATA, &this->chunks_hold_);
   return NULL;
 }
 
@@ -6118,14 +6385,21 @@ void
 Write_data_task::locks(Task_locker* tl)
 {
   tl->add(this, this->final_blocker_);
+  if (this->chunks_hold_ != NULL)
+    tl->add(this, this->chunks_hold_);
 }
 
 // Run the task--write out the data.
 
 void
-Write_data_task::run(Workqueue*)
+Write_data_task::run(Workqueue* workqueue)
 {
   this->layout_->write_data(this->symtab_, this->of_);
+
+  Output_file_chunks* chunks = this->layout_->output_file_chunks();
+  if (chunks != NULL)
+    chunks->writer_done(workqueue, Output_file_chunks::WRITE_DATA,
+			this->chunks_hold_);
 }
 
 // Write_symbols_task methods.
@@ -6135,6 +6409,9 @@ Write_data_task::run(Workqueue*)
 Task_token*
 Write_symbols_task::is_runnable()
 {
+  Output_file_chunks* chunks = this->layout_->output_file_chunks();
+  if (chunks != NULL && this->chunks_hold_ == NULL)
+    chunks->admit(Output_file_chunks::WRITE_SYMBOLS, &this->chunks_hold_);
   return NULL;
 }
 
@@ -6144,16 +6421,23 @@ void
 Write_symbols_task::locks(Task_locker* tl)
 {
   tl->add(this, this->final_blocker_);
+  if (this->chunks_hold_ != NULL)
+    tl->add(this, this->chunks_hold_);
 }
 
 // Run the task--write out the symbols.
 
 void
-Write_symbols_task::run(Workqueue*)
+Write_symbols_task::run(Workqueue* workqueue)
 {
   this->symtab_->write_globals(this->sympool_, this->dynpool_,
 			       this->layout_->symtab_xindex(),
 			       this->layout_->dynsym_xindex(), this->of_);
+
+  Output_file_chunks* chunks = this->layout_->output_file_chunks();
+  if (chunks != NULL)
+    chunks->writer_done(workqueue, Output_file_chunks::WRITE_SYMBOLS,
+			this->chunks_hold_);
 }
 
 // Write_after_input_sections_task methods.
@@ -6176,12 +6460,403 @@ Write_after_input_sections_task::locks(Task_locker* tl)
   tl->add(this, this->final_blocker_);
 }
 
-// Run the task.
+// Run the task.  If any sections have postprocessing work which can
+// be done in parallel, queue it, and then queue another
+// Write_after_input_sections_task to run when it is done; that one
+// will find nothing left to queue.
 
 void
-Write_after_input_sections_task::run(Workqueue*)
+Write_after_input_sections_task::run(Workqueue* workqueue)
 {
+  Task_token* postprocessing_blocker = new Task_token(true);
+  if (this->layout_->queue_postprocessing_tasks(workqueue,
+						postprocessing_blocker))
+    {
+      this->final_blocker_->add_blocker();
+      workqueue->queue(new Write_after_input_sections_task(
+			 this->layout_, this->of_, postprocessing_blocker,
+			 this->final_blocker_));
+      return;
+    }
+  delete postprocessing_blocker;
+
   this->layout_->write_sections_after_input_sections(this->of_);
+
+  Output_file_chunks* chunks = this->layout_->output_file_chunks();
+  if (chunks != NULL)
+    chunks->writer_done(workqueue,
+			Output_file_chunks::WRITE_AFTER_INPUT_SECTIONS, NULL);
+}
+
+// An Output_file_chunk_task hashes and writes a chunk of the output
+// file which is complete.
+
+class Output_file_chunk_task : public Task
+{
+ public:
+  Output_file_chunk_task(Output_file_chunks* chunks, unsigned int chunk,
+			 Task_token* blocker, Task_token* hold)
+    : chunks_(chunks), chunk_(chunk), blocker_(blocker), hold_(hold)
+  { }
+
+  void
+  run(Workqueue*)
+  { this->chunks_->process_chunk(this->chunk_); }
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  // Unblock BLOCKER_, and HOLD_ if it is not NULL, when done.
+  void
+  locks(Task_locker* tl)
+  {
+    tl->add(this, this->blocker_);
+    if (this->hold_ != NULL)
+      tl->add(this, this->hold_);
+  }
+
+  std::string
+  get_name() const
+  { return "Output_file_chunk_task"; }
+
+ private:
+  Output_file_chunks* chunks_;
+  unsigned int chunk_;
+  Task_token* blocker_;
+  // The token held by the task which finished the chunk.
+  Task_token* hold_;
+};
+
+// Output_file_chunks methods.
+
+Output_file_chunks::Output_file_chunks(Output_file* of, size_t filesize,
+				       size_t chunk_size, bool is_hashing,
+				       bool is_streaming, bool discard_written,
+				       unsigned int max_open)
+  : of_(of), filesize_(filesize), chunk_size_(chunk_size),
+    chunk_count_((filesize - 1) / chunk_size + 1), hashes_(NULL),
+    hashes_released_(false),
+    is_streaming_(is_streaming), discard_written_(discard_written),
+    pending_(this->chunk_count_), deferred_(this->chunk_count_),
+    max_open_(is_streaming && discard_written ? max_open : 0), state_(),
+    open_count_(0), peak_open_count_(0), wait_count_(0), throttle_(NULL),
+    old_throttles_(), relobj_chunks_(), blocker_(NULL), lock_(NULL),
+    initialize_lock_(&this->lock_)
+{
+  // Each chunk has an MD5 hash, which is 16 bytes.
+  if (is_hashing)
+    this->hashes_ = new unsigned char[this->chunk_count_ * 16];
+  if (this->max_open_ != 0)
+    this->state_.resize(this->chunk_count_, CHUNK_UNUSED);
+}
+
+Output_file_chunks::~Output_file_chunks()
+{
+  if (!this->hashes_released_)
+    delete[] this->hashes_;
+  delete this->throttle_;
+  for (std::vector<Task_token*>::const_iterator p =
+	 this->old_throttles_.begin();
+       p != this->old_throttles_.end();
+       ++p)
+    delete *p;
+}
+
+// Record that a task may write LEN bytes at OFF.
+
+void
+Output_file_chunks::add_range(Chunk_list* chunks, off_t off, off_t len)
+{
+  gold_assert(this->blocker_ == NULL);
+  if (len <= 0 || off < 0 || static_cast<size_t>(off) >= this->filesize_)
+    return;
+  size_t end = std::min(static_cast<size_t>(off + len), this->filesize_);
+  unsigned int first = static_cast<size_t>(off) / this->chunk_size_;
+  unsigned int last = (end - 1) / this->chunk_size_;
+  for (unsigned int c = first; c <= last; ++c)
+    if (chunks->empty() || chunks->back() != c)
+      chunks->push_back(c);
+}
+
+// Record that LEN bytes at OFF must not be written before finish.
+
+void
+Output_file_chunks::defer_range(off_t off, off_t len)
+{
+  Chunk_list chunks;
+  this->add_range(&chunks, off, len);
+  for (Chunk_list::const_iterator p = chunks.begin(); p != chunks.end(); ++p)
+    this->deferred_[*p] = true;
+}
+
+// Count the writers of each chunk, and queue the tasks for the chunks
+// which nothing writes.
+
+void
+Output_file_chunks::start(Workqueue* workqueue)
+{
+  for (int i = 0; i < WRITER_COUNT; ++i)
+    {
+      Chunk_list* chunks = &this->writer_chunks_[i];
+      std::sort(chunks->begin(), chunks->end());
+      chunks->erase(std::unique(chunks->begin(), chunks->end()),
+		    chunks->end());
+      for (Chunk_list::const_iterator p = chunks->begin();
+	   p != chunks->end();
+	   ++p)
+	++this->pending_[*p];
+    }
+  for (Unordered_map<const Relobj*, Chunk_list>::iterator p =
+	 this->relobj_chunks_.begin();
+       p != this->relobj_chunks_.end();
+       ++p)
+    {
+      Chunk_list* chunks = &p->second;
+      std::sort(chunks->begin(), chunks->end());
+      chunks->erase(std::unique(chunks->begin(), chunks->end()),
+		    chunks->end());
+      for (Chunk_list::const_iterator pc = chunks->begin();
+	   pc != chunks->end();
+	   ++pc)
+	++this->pending_[*pc];
+    }
+
+  // Add all the blockers before queueing any of the tasks.
+  this->blocker_ = new Task_token(true);
+  this->blocker_->add_blockers(this->chunk_count_);
+  for (unsigned int c = 0; c < this->chunk_count_; ++c)
+    if (this->pending_[c] == 0)
+      this->queue_chunk_task(workqueue, c, NULL);
+}
+
+// Add a holder to the token held by the tasks which may release
+// chunks, and return it.  This is called with the workqueue lock
+// held.
+
+Task_token*
+Output_file_chunks::hold_throttle()
+{
+  // When the token is released, the workqueue queues the tasks
+  // waiting for it again, and those may have to wait again.  They
+  // must wait for a new token, rather than be added back to the
+  // list which the workqueue is emptying.
+  if (this->throttle_ == NULL || !this->throttle_->is_blocked())
+    {
+      if (this->throttle_ != NULL)
+	this->old_throttles_.push_back(this->throttle_);
+      this->throttle_ = new Task_token(true);
+    }
+  this->throttle_->add_blocker();
+  return this->throttle_;
+}
+
+// Admit the task WRITER.  Only the Relocate_tasks are held back, but
+// the other writers may release chunks too.
+
+void
+Output_file_chunks::admit(Writer, Task_token** hold)
+{
+  if (this->max_open_ == 0)
+    *hold = NULL;
+  else
+    *hold = this->hold_throttle();
+}
+
+// Admit the Relocate_task for OBJECT, or hold it back if the chunks
+// it would start writing to would go over the limit.
+
+Task_token*
+Output_file_chunks::admit(const Relobj* object, Task_token** hold)
+{
+  *hold = NULL;
+  if (this->max_open_ == 0)
+    return NULL;
+
+  Unordered_map<const Relobj*, Chunk_list>::const_iterator p =
+    this->relobj_chunks_.find(object);
+  if (p == this->relobj_chunks_.end() || p->second.empty())
+    return NULL;
+  const Chunk_list& chunks(p->second);
+
+  Hold_optional_lock hl(this->initialize_lock_.initialize()
+			? this->lock_
+			: NULL);
+
+  unsigned int new_count = 0;
+  for (Chunk_list::const_iterator pc = chunks.begin();
+       pc != chunks.end();
+       ++pc)
+    if (this->state_[*pc] == CHUNK_UNUSED)
+      ++new_count;
+
+  // If no task holds the token, nothing will release the open
+  // chunks until this task runs.
+  if (new_count > 0
+      && this->open_count_ + new_count > this->max_open_
+      && this->throttle_ != NULL
+      && this->throttle_->is_blocked())
+    {
+      ++this->wait_count_;
+      return this->throttle_;
+    }
+
+  for (Chunk_list::const_iterator pc = chunks.begin();
+       pc != chunks.end();
+       ++pc)
+    if (this->state_[*pc] == CHUNK_UNUSED)
+      this->state_[*pc] = CHUNK_OPEN;
+  this->open_count_ += new_count;
+  this->peak_open_count_ = std::max(this->peak_open_count_,
+				    this->open_count_);
+
+  *hold = this->hold_throttle();
+  return NULL;
+}
+
+// Called when the Relocate_task for OBJECT has finished.
+
+void
+Output_file_chunks::writer_done(Workqueue* workqueue, const Relobj* object,
+				Task_token* hold)
+{
+  Unordered_map<const Relobj*, Chunk_list>::iterator p =
+    this->relobj_chunks_.find(object);
+  if (p != this->relobj_chunks_.end())
+    this->writer_done(workqueue, &p->second, hold);
+}
+
+// Called when a task which writes CHUNKS has finished.  Queue a task
+// for each chunk which has no more writers.  The chunk tasks hold
+// HOLD, if it is not NULL, until they have released their chunks.
+
+void
+Output_file_chunks::writer_done(Workqueue* workqueue, Chunk_list* chunks,
+				Task_token* hold)
+{
+  Chunk_list ready;
+  {
+    Hold_optional_lock hl(this->initialize_lock_.initialize()
+			  ? this->lock_
+			  : NULL);
+    for (Chunk_list::const_iterator p = chunks->begin();
+	 p != chunks->end();
+	 ++p)
+      {
+	gold_assert(this->pending_[*p] > 0);
+	if (--this->pending_[*p] == 0)
+	  ready.push_back(*p);
+      }
+  }
+  chunks->clear();
+
+  for (Chunk_list::const_iterator p = ready.begin(); p != ready.end(); ++p)
+    this->queue_chunk_task(workqueue, *p, hold);
+}
+
+// Queue a task to process CHUNK.  We run it ahead of the remaining
+// writers, while the chunk is likely to still be in the cache.  If
+// HOLD is not NULL, the task holds it.  HOLD is held by the task
+// calling this, so it can't be released before the new holder is
+// added.
+
+void
+Output_file_chunks::queue_chunk_task(Workqueue* workqueue, unsigned int chunk,
+				     Task_token* hold)
+{
+  if (hold != NULL)
+    workqueue->add_blocker(hold);
+  workqueue->queue_soon(new Output_file_chunk_task(this, chunk,
+						   this->blocker_, hold));
+}
+
+// Return the offset and size of CHUNK.
+
+void
+Output_file_chunks::chunk_range(unsigned int chunk, off_t* off,
+				size_t* size) const
+{
+  size_t offset = static_cast<size_t>(chunk) * this->chunk_size_;
+  *off = offset;
+  *size = std::min(this->chunk_size_, this->filesize_ - offset);
+}
+
+// Hash CHUNK, and write it to the file unless it is deferred.
+
+void
+Output_file_chunks::process_chunk(unsigned int chunk)
+{
+  off_t off;
+  size_t size;
+  this->chunk_range(chunk, &off, &size);
+
+  if (this->hashes_ != NULL)
+    {
+      const unsigned char* iv = this->of_->get_input_view(off, size);
+      md5_buffer(reinterpret_cast<const char*>(iv), size,
+		 this->hashes_ + chunk * 16);
+      this->of_->free_input_view(off, size, iv);
+    }
+
+  if (this->is_streaming_ && !this->deferred_[chunk])
+    {
+      this->of_->write_range(off, size, this->discard_written_);
+
+      if (this->max_open_ != 0)
+	{
+	  Hold_optional_lock hl(this->initialize_lock_.initialize()
+				? this->lock_
+				: NULL);
+	  if (this->state_[chunk] == CHUNK_OPEN)
+	    --this->open_count_;
+	  this->state_[chunk] = CHUNK_RELEASED;
+	}
+    }
+}
+
+// Return the array of hashes.
+
+unsigned char*
+Output_file_chunks::release_hashes(size_t* size)
+{
+  // The chunk tasks may still be filling in the array, so we keep
+  // using it.
+  *size = this->hashes_ == NULL ? 0 : this->chunk_count_ * 16;
+  this->hashes_released_ = true;
+  return this->hashes_;
+}
+
+// Write the deferred chunks.
+
+void
+Output_file_chunks::finish()
+{
+  if (!this->is_streaming_)
+    return;
+  for (unsigned int c = 0; c < this->chunk_count_; ++c)
+    {
+      if (this->deferred_[c])
+	{
+	  off_t off;
+	  size_t size;
+	  this->chunk_range(c, &off, &size);
+	  this->of_->write_range(off, size, false);
+	}
+    }
+}
+
+// Print statistics about holding back the Relocate_tasks.
+
+void
+Output_file_chunks::print_stats() const
+{
+  if (this->max_open_ == 0)
+    return;
+  fprintf(stderr, _("%s: output file chunks in memory at once: %u "
+		    "(limit %u)\n"),
+	  program_name, this->peak_open_count_, this->max_open_);
+  fprintf(stderr, _("%s: relocation tasks held back: %u\n"),
+	  program_name, this->wait_count_);
 }
 
 // Build IDs can be computed as a "flat" sha1 or md5 of a string of bytes,
@@ -6192,15 +6867,27 @@ Write_after_input_sections_task::run(Workqueue*)
 void
 Build_id_task_runner::run(Workqueue* workqueue, const Task*)
 {
-  Task_token* post_hash_tasks_blocker = new Task_token(true);
   const Layout* layout = this->layout_;
   Output_file* of = this->of_;
   const size_t filesize = (layout->output_file_size() <= 0 ? 0
 			   : static_cast<size_t>(layout->output_file_size()));
+  Task_token* post_hash_tasks_blocker;
   unsigned char* array_of_hashes = NULL;
   size_t size_of_hashes = 0;
 
-  if (strcmp(this->options_->build_id(), "tree") == 0
+  Output_file_chunks* chunks = layout->output_file_chunks();
+  if (chunks != NULL)
+    {
+      // The chunks have been processed, or are being processed, as
+      // they were written.
+      post_hash_tasks_blocker = chunks->blocker();
+      array_of_hashes = chunks->release_hashes(&size_of_hashes);
+    }
+  else
+    post_hash_tasks_blocker = new Task_token(true);
+
+  if (chunks == NULL
+      && strcmp(this->options_->build_id(), "tree") == 0
       && this->options_->build_id_chunk_size_for_treehash() > 0
       && filesize > 0
       && (filesize >= this->options_->build_id_min_file_size_for_treehash()))
@@ -6248,6 +6935,11 @@ Close_task_runner::run(Workqueue*, const Task*)
   this->layout_->write_build_id(this->of_, this->array_of_hashes_,
 				this->size_of_hashes_);
 
+  // Write out whatever --stream-output-file held back.
+  Output_file_chunks* chunks = this->layout_->output_file_chunks();
+  if (chunks != NULL)
+    chunks->finish();
+
   // If we've been asked to create a binary file, we do so here.
   if (this->options_->oformat_enum() != General_options::OBJECT_FORMAT_ELF)
     this->layout_->write_binary(this->of_);
@@ -59,6 +59,8 @@ class Output_reduced_debug_abbrev_section;
 class Output_reduced_debug_info_section;
 class Eh_frame;
 class Gdb_index;
+class Relocation_cache;
+class Output_file_chunks;
 class Target;
 struct Timespec;
 
@@ -171,15 +173,19 @@ class Layout_task_runner : public Task_function_runner
  public:
   // OPTIONS is the command line options, INPUT_OBJECTS is the list of
   // input objects, SYMTAB is the symbol table, LAYOUT is the layout
-  // object.
+  // object.  If GDB_INDEX_BLOCKER is not NULL, the layout also waits
+  // for the tasks scanning the debug info for the .gdb_index section,
+  // which unblock it.
   Layout_task_runner(const General_options& options,
 		     const Input_objects* input_objects,
 		     Symbol_table* symtab,
 		     Target* target,
 		     Layout* layout,
-		     Mapfile* mapfile)
+		     Mapfile* mapfile,
+		     Task_token* gdb_index_blocker)
     : options_(options), input_objects_(input_objects), symtab_(symtab),
-      target_(target), layout_(layout), mapfile_(mapfile)
+      target_(target), layout_(layout), mapfile_(mapfile),
+      gdb_index_blocker_(gdb_index_blocker)
   { }
 
   // Run the operation.
@@ -196,6 +202,7 @@ class Layout_task_runner : public Task_function_runner
   Target* target_;
   Layout* layout_;
   Mapfile* mapfile_;
+  Task_token* gdb_index_blocker_;
 };
 
 // This class holds information about the comdat group or
@@ -696,6 +703,12 @@ class Layout
 		   unsigned int reloc_shndx,
 		   unsigned int reloc_type);
 
+  // With --threads, queue the tasks which scan the .debug_info and
+  // .debug_types sections for the .gdb_index section.  Return true if
+  // any tasks were queued; they will unblock BLOCKER when done.
+  bool
+  queue_gdb_index_tasks(Workqueue* workqueue, Task_token* blocker);
+
   // Handle a GNU stack note.  This is called once per input object
   // file.  SEEN_GNU_STACK is true if the object file has a
   // .note.GNU-stack section.  GNU_STACK_FLAGS is the section flags
@@ -900,6 +913,12 @@ class Layout
   void
   write_data(const Symbol_table*, Output_file*) const;
 
+  // Queue tasks to do the parallel part of postprocessing sections,
+  // such as compressing debug sections.  Return true if any tasks
+  // were queued; they will unblock BLOCKER when done.
+  bool
+  queue_postprocessing_tasks(Workqueue* workqueue, Task_token* blocker);
+
   // Write out output sections which can not be written until all the
   // input sections are complete.
   void
@@ -944,6 +963,26 @@ class Layout
   incremental_inputs() const
   { return this->incremental_inputs_; }
 
+  // Set up the processing of the output file in chunks while it is
+  // being written, for --build-id=tree and --stream-output-file, if
+  // possible.  This is called before queueing the tasks which write
+  // the output file.
+  void
+  start_output_file_chunks(const Input_objects*, Output_file*, Workqueue*);
+
+  // Return the object processing the output file in chunks as it is
+  // written, or NULL if the output file is handled only after it is
+  // completely written.
+  Output_file_chunks*
+  output_file_chunks() const
+  { return this->output_file_chunks_; }
+
+  // Return the cache used by --relocation-cache, or NULL if the
+  // option was not used.
+  Relocation_cache*
+  relocation_cache() const
+  { return this->relocation_cache_; }
+
   // For the target-specific code to add dynamic tags which are common
   // to most targets.
   void
@@ -1458,6 +1497,8 @@ class Layout
   Gdb_index* gdb_index_data_;
   // The space for the build ID checksum if there is one.
   Output_section_data* build_id_note_;
+  // Processes the output file in chunks while it is written.
+  Output_file_chunks* output_file_chunks_;
   // The space for the package metadata JSON if there is one.
   Output_section_data* package_metadata_note_;
   // The output section containing dwarf abbreviations
@@ -1498,6 +1539,8 @@ class Layout
   // In incremental build, holds information check the inputs and build the
   // .gnu_incremental_inputs section.
   Incremental_inputs* incremental_inputs_;
+  // The cache used by --relocation-cache.
+  Relocation_cache* relocation_cache_;
   // Whether we record output section data created in script
   bool record_output_section_data_from_script_;
   // Set if this is a slim LTO object not loaded with a compiler plugin
@@ -1543,7 +1586,7 @@ class Write_sections_task : public Task
     : layout_(layout), of_(of),
       output_sections_blocker_(output_sections_blocker),
       input_sections_blocker_(input_sections_blocker),
-      final_blocker_(final_blocker)
+      final_blocker_(final_blocker), chunks_hold_(NULL)
   { }
 
   // The standard Task methods.
@@ -1569,6 +1612,8 @@ class Write_sections_task : public Task
   Task_token* output_sections_blocker_;
   Task_token* input_sections_blocker_;
   Task_token* final_blocker_;
+  // Set by Output_file_chunks::admit.
+  Task_token* chunks_hold_;
 };
 
 // This task handles writing out data which is not part of a section
@@ -1579,7 +1624,8 @@ class Write_data_task : public Task
  public:
   Write_data_task(const Layout* layout, const Symbol_table* symtab,
 		  Output_file* of, Task_token* final_blocker)
-    : layout_(layout), symtab_(symtab), of_(of), final_blocker_(final_blocker)
+    : layout_(layout), symtab_(symtab), of_(of), final_blocker_(final_blocker),
+      chunks_hold_(NULL)
   { }
 
   // The standard Task methods.
@@ -1602,6 +1648,8 @@ class Write_data_task : public Task
   const Symbol_table* symtab_;
   Output_file* of_;
   Task_token* final_blocker_;
+  // Set by Output_file_chunks::admit.
+  Task_token* chunks_hold_;
 };
 
 // This task handles writing out the global symbols.
@@ -1615,7 +1663,7 @@ class Write_symbols_task : public Task
 		     Output_file* of, Task_token* final_blocker)
     : layout_(layout), symtab_(symtab),
       sympool_(sympool), dynpool_(dynpool), of_(of),
-      final_blocker_(final_blocker)
+      final_blocker_(final_blocker), chunks_hold_(NULL)
   { }
 
   // The standard Task methods.
@@ -1640,6 +1688,8 @@ class Write_symbols_task : public Task
   const Stringpool* dynpool_;
   Output_file* of_;
   Task_token* final_blocker_;
+  // Set by Output_file_chunks::admit.
+  Task_token* chunks_hold_;
 };
 
 // This task handles writing out data in output sections which can't
@@ -1680,11 +1730,211 @@ class Write_after_input_sections_task : public Task
   Task_token* final_blocker_;
 };
 
+// This class tracks when each chunk of the output file has been
+// completely written, by recording in advance the chunks to which
+// each task which writes the output file may write.  As soon as
+// every such task has finished with a chunk, the chunk is hashed for
+// --build-id=tree and, with --stream-output-file, written to the
+// file.  That work thus overlaps with writing the rest of the output.
+// The chunks and their hashes are the same as those computed by
+// Build_id_task_runner, so the build ID does not change.
+
+// When the chunks are discarded from memory once written, the
+// Relocate_tasks, which write the contents of the input sections,
+// can be held back so that only a limited number of chunks are
+// written to and not yet discarded at any time.  A Relocate_task
+// which would go over the limit waits until the tasks which may
+// release chunks are done.  If none are running, it starts anyway,
+// since otherwise nothing would ever release the chunks it waits
+// for.
+
+class Output_file_chunks
+{
+ public:
+  // The tasks which write to the output file, other than the
+  // Relocate_tasks, which are identified by their object.
+  enum Writer
+  {
+    WRITE_SYMBOLS,
+    WRITE_SECTIONS,
+    WRITE_DATA,
+    WRITE_AFTER_INPUT_SECTIONS,
+    WRITER_COUNT
+  };
+
+  // Hash the chunks if IS_HASHING.  Write them to the file if
+  // IS_STREAMING, and then discard them from memory if
+  // DISCARD_WRITTEN.  In that case, if MAX_OPEN is not zero, hold
+  // back the Relocate_tasks so that at most MAX_OPEN chunks which
+  // they write are in memory at once.
+  Output_file_chunks(Output_file* of, size_t filesize, size_t chunk_size,
+		     bool is_hashing, bool is_streaming,
+		     bool discard_written, unsigned int max_open);
+
+  ~Output_file_chunks();
+
+  // Record that the task WRITER may write LEN bytes at file offset
+  // OFF.  This must be called for every range which is written
+  // before calling start.
+  void
+  add_range(Writer writer, off_t off, off_t len)
+  { this->add_range(&this->writer_chunks_[writer], off, len); }
+
+  // Likewise for the Relocate_task for OBJECT.
+  void
+  add_range(const Relobj* object, off_t off, off_t len)
+  { this->add_range(&this->relobj_chunks_[object], off, len); }
+
+  // Record that LEN bytes at OFF are changed after all the tasks have
+  // finished, so they must not be written to the file until finish
+  // is called.
+  void
+  defer_range(off_t off, off_t len);
+
+  // Queue the tasks for the chunks which nothing writes.  The others
+  // are queued by writer_done.
+  void
+  start(Workqueue*);
+
+  // Called by the is_runnable method of the task WRITER, with the
+  // workqueue lock held, once it is otherwise ready to run.  Set
+  // *HOLD to a token which the task must hold with its other locks
+  // and pass to writer_done, or to NULL.  Once *HOLD is set, this
+  // must not be called again.
+  void
+  admit(Writer, Task_token** hold);
+
+  // Likewise for the Relocate_task for OBJECT, except that if the
+  // task must be held back, this returns a token to wait for and
+  // does not set *HOLD.  Otherwise it returns NULL.
+  Task_token*
+  admit(const Relobj* object, Task_token** hold);
+
+  // Called by the task WRITER when it has finished writing.  HOLD is
+  // the token set by admit, or NULL.
+  void
+  writer_done(Workqueue* workqueue, Writer writer, Task_token* hold)
+  { this->writer_done(workqueue, &this->writer_chunks_[writer], hold); }
+
+  // Likewise for the Relocate_task for OBJECT.
+  void
+  writer_done(Workqueue*, const Relobj* object, Task_token* hold);
+
+  // Hash and write chunk CHUNK.  This is called by the task queued
+  // when the chunk is complete.
+  void
+  process_chunk(unsigned int chunk);
+
+  // Return a blocker which is released when every chunk has been
+  // processed.  This is only called once; the caller takes
+  // ownership.
+  Task_token*
+  blocker() const
+  { return this->blocker_; }
+
+  // Return the array of hashes, and set *SIZE to its size, or return
+  // NULL if we are not hashing.  This is only called once; the
+  // caller takes ownership, but must not use the array until the
+  // blocker is released.
+  unsigned char*
+  release_hashes(size_t* size);
+
+  // Write the deferred chunks to the file.  This is called after the
+  // blocker is released and the deferred ranges have been changed.
+  void
+  finish();
+
+  // Print statistics about holding back the Relocate_tasks to stderr.
+  void
+  print_stats() const;
+
+ private:
+  // The chunks written by one task.
+  typedef std::vector<unsigned int> Chunk_list;
+
+  // Whether a Relocate_task has started writing to a chunk.
+  enum Chunk_state
+  {
+    // No Relocate_task has been admitted to write to the chunk.
+    CHUNK_UNUSED,
+    // The chunk is in memory and counts against the limit.
+    CHUNK_OPEN,
+    // The chunk has been written and discarded.
+    CHUNK_RELEASED
+  };
+
+  void
+  add_range(Chunk_list*, off_t off, off_t len);
+
+  void
+  writer_done(Workqueue*, Chunk_list*, Task_token* hold);
+
+  Task_token*
+  hold_throttle();
+
+  void
+  queue_chunk_task(Workqueue*, unsigned int chunk, Task_token* hold);
+
+  // Return the offset and size of chunk CHUNK.
+  void
+  chunk_range(unsigned int chunk, off_t* off, size_t* size) const;
+
+  // The output file.
+  Output_file* of_;
+  // The size of the output file.
+  size_t filesize_;
+  // The size of a chunk.
+  size_t chunk_size_;
+  // The number of chunks.
+  unsigned int chunk_count_;
+  // The hashes, one for each chunk, or NULL if we are not hashing.
+  unsigned char* hashes_;
+  // Whether release_hashes has passed ownership of hashes_.
+  bool hashes_released_;
+  // Whether we are writing the chunks to the file.
+  bool is_streaming_;
+  // Whether to discard the chunks from memory after writing them.
+  bool discard_written_;
+  // For each chunk, the number of tasks which have not yet finished
+  // writing to it.
+  std::vector<unsigned int> pending_;
+  // For each chunk, whether writing it is deferred until finish.
+  std::vector<bool> deferred_;
+  // The most chunks which the Relocate_tasks may have open at once,
+  // or 0 if they are not held back.
+  unsigned int max_open_;
+  // For each chunk, its Chunk_state, if max_open_ is not zero.
+  std::vector<unsigned char> state_;
+  // The number of chunks which are CHUNK_OPEN, and the most there
+  // have been.
+  unsigned int open_count_;
+  unsigned int peak_open_count_;
+  // The number of times a Relocate_task was held back.
+  unsigned int wait_count_;
+  // Held by the admitted tasks, and by the chunk tasks they queue,
+  // and waited for by the tasks which are held back.  Once it is
+  // released, it is replaced by a new token for the next tasks to
+  // hold; the old ones are kept here.
+  Task_token* throttle_;
+  std::vector<Task_token*> old_throttles_;
+  // The chunks written by each Writer.
+  Chunk_list writer_chunks_[WRITER_COUNT];
+  // The chunks written by each Relocate_task.
+  Unordered_map<const Relobj*, Chunk_list> relobj_chunks_;
+  // Released by the chunk tasks.
+  Task_token* blocker_;
+  // Protects pending_ and state_.
+  Lock* lock_;
+  Initialize_lock initialize_lock_;
+};
+
 // This task function handles computation of the build id.
 // When using --build-id=tree, it schedules the tasks that
 // compute the hashes for each chunk of the file. This task
 // cannot run until we have finalized the size of the output
 // file, after the completion of Write_after_input_sections_task.
+// If the output file is processed in chunks as it is written, this
+// instead waits for those chunks.
 
 class Build_id_task_runner : public Task_function_runner
 {
@@ -43,6 +43,7 @@
 #include "archive.h"
 #include "symtab.h"
 #include "layout.h"
+#include "reloc.h"
 #include "plugin.h"
 #include "gc.h"
 #include "icf.h"
@@ -251,6 +252,13 @@ main(int argc, char** argv)
   // Run the main task processing loop.
   workqueue.process(0);
 
+  // Write the task trace, if requested.
+  workqueue.write_trace();
+
+  // Keep the relocation cache within its size limit.
+  if (layout.relocation_cache() != NULL)
+    layout.relocation_cache()->trim();
+
   if (command_line.options().print_output_format())
     print_output_format();
 
@@ -306,6 +314,8 @@ main(int argc, char** argv)
       fprintf(stderr, _("%s: output file size: %lld bytes\n"),
 	      program_name, static_cast<long long>(layout.output_file_size()));
       symtab.print_stats();
+      if (command_line.options().icf_enabled())
+	icf.print_stats();
       layout.print_stats();
       Gdb_index::print_stats();
       Free_list::print_stats();
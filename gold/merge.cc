@@ -475,18 +475,35 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
   this->merged_strings_lists_.push_back(merged_strings_list);
   Merged_strings& merged_strings = merged_strings_list->merged_strings;
 
+  // With threads, Read_symbols may already have found the length and
+  // hash code of each string.
+  Merge_string_hashes hashes;
+  bool have_hashes = object->take_merge_string_hashes(shndx, &hashes);
+  gold_assert(!have_hashes || (sizeof(Char_type) == 1 && pend0 == pend));
+
   // Count the number of non-null strings in the section and size the list.
   size_t count = 0;
-  const Char_type* pt = p;
-  while (pt < pend0)
+  if (have_hashes)
+    {
+      for (Merge_string_hashes::const_iterator ph = hashes.begin();
+	   ph != hashes.end();
+	   ++ph)
+	if (ph->length != 0)
+	  ++count;
+    }
+  else
     {
-      size_t len = string_length(pt);
-      if (len != 0)
+      const Char_type* pt = p;
+      while (pt < pend0)
+	{
+	  size_t len = string_length(pt);
+	  if (len != 0)
+	    ++count;
+	  pt += len + 1;
+	}
+      if (pend0 < pend)
 	++count;
-      pt += len + 1;
     }
-  if (pend0 < pend)
-    ++count;
   merged_strings.reserve(count + 1);
 
   // The index I is in bytes, not characters.
@@ -499,9 +516,17 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 				 & (addralign - 1));
   bool has_misaligned_strings = false;
 
+  Merge_string_hashes::const_iterator ph = hashes.begin();
   while (p < pend)
     {
-      size_t len = p < pend0 ? string_length(p) : pend - p;
+      size_t len;
+      if (have_hashes)
+	{
+	  gold_assert(ph != hashes.end());
+	  len = ph->length;
+	}
+      else
+	len = p < pend0 ? string_length(p) : pend - p;
 
       // Within merge input section each string must be aligned.
       if (len != 0
@@ -510,7 +535,13 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 	  has_misaligned_strings = true;
 
       Stringpool::Key key;
-      this->stringpool_.add_with_length(p, len, true, &key);
+      if (have_hashes)
+	{
+	  this->stringpool_.add_with_hash(p, len, ph->hash_code, true, &key);
+	  ++ph;
+	}
+      else
+	this->stringpool_.add_with_length(p, len, true, &key);
 
       merged_strings.push_back(Merged_string(i, key));
       p += len + 1;
@@ -632,14 +663,14 @@ Output_merge_string<char>::string_name()
 
 template<>
 const char*
-Output_merge_string<uint16_t>::string_name()
+Output_merge_string<char16_t>::string_name()
 {
   return "16-bit strings";
 }
 
 template<>
 const char*
-Output_merge_string<uint32_t>::string_name()
+Output_merge_string<char32_t>::string_name()
 {
   return "32-bit strings";
 }
@@ -847,6 +847,19 @@ Sized_relobj_file<size, big_endian>::base_read_symbols(Read_symbols_data* sd)
 
   bool need_local_symbols = this->do_find_special_sections(sd);
 
+  // With threads, hash the strings of the mergeable string sections
+  // now, in parallel, rather than when Add_symbols lays out the
+  // sections one object at a time.  That is not done until after
+  // relocation scanning when garbage collecting or folding sections.
+  if (parameters->options().threads()
+      && !parameters->incremental()
+      && !parameters->options().gc_sections()
+      && !parameters->options().icf_enabled())
+    this->hash_merge_strings(pshdrs,
+			     reinterpret_cast<const char*>(
+			       sd->section_names->data()),
+			     sd->section_names_size);
+
   sd->symbols = NULL;
   sd->symbols_size = 0;
   sd->external_symbols_offset = 0;
@@ -920,6 +933,119 @@ Sized_relobj_file<size, big_endian>::base_read_symbols(Read_symbols_data* sd)
   sd->symbol_names = fvstrtab;
   sd->symbol_names_size =
     convert_to_section_size_type(strtabshdr.get_sh_size());
+
+  // With threads, Read_symbols tasks run in parallel but Add_symbols
+  // tasks run one at a time in command line order.  Hashing the
+  // symbol names is independent of that order, so do it now.
+  if (parameters->options().threads())
+    this->hash_symbol_names(sd);
+}
+
+// Record the length and hash code of each external symbol name in
+// SD, as Symbol_table::add_from_relobj will use them.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::hash_symbol_names(Read_symbols_data* sd)
+{
+  const int sym_size = This::sym_size;
+  size_t symcount = ((sd->symbols_size - sd->external_symbols_offset)
+		     / sym_size);
+  const unsigned char* p = (sd->symbols->data()
+			    + sd->external_symbols_offset);
+  const char* sym_names =
+    reinterpret_cast<const char*>(sd->symbol_names->data());
+
+  sd->symbol_name_hashes.resize(symcount);
+  for (size_t i = 0; i < symcount; ++i, p += sym_size)
+    {
+      elfcpp::Sym<size, big_endian> sym(p);
+      Symbol_name_hash* hash = &sd->symbol_name_hashes[i];
+      unsigned int st_name = sym.get_st_name();
+      if (st_name >= sd->symbol_names_size)
+	{
+	  // add_from_relobj will report the bad offset.
+	  hash->length = 0;
+	  hash->hash_code = 0;
+	  continue;
+	}
+      const char* name = sym_names + st_name;
+      hash->length = strcspn(name, "@");
+      hash->hash_code = string_hash<char>(name, hash->length);
+    }
+}
+
+// Record the length and hash code of each string in the mergeable
+// string sections, as Output_merge_string::do_add_input_section will
+// use them.  Only sections of single byte characters are handled.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::hash_merge_strings(
+    const unsigned char* pshdrs,
+    const char* names,
+    section_size_type names_size)
+{
+  const elfcpp::Elf_Xword merge_strings = (elfcpp::SHF_MERGE
+					   | elfcpp::SHF_STRINGS);
+  Merge_string_hash_map* merge_string_hashes = NULL;
+  const unsigned int shnum = this->shnum();
+  const unsigned char* p = pshdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
+    {
+      typename This::Shdr shdr(p);
+      if (shdr.get_sh_type() != elfcpp::SHT_PROGBITS
+	  || shdr.get_sh_size() == 0
+	  || shdr.get_sh_name() >= names_size)
+	continue;
+
+      // Output_section::add_input_section treats .debug_str as
+      // mergeable whatever its flags.
+      const char* name = names + shdr.get_sh_name();
+      if (((shdr.get_sh_flags() & merge_strings) != merge_strings
+	   || shdr.get_sh_entsize() != 1)
+	  && strcmp(name, ".debug_str") != 0
+	  && strcmp(name, ".zdebug_str") != 0)
+	continue;
+
+      // Don't decompress a section here unless
+      // build_compressed_section_map already has.
+      if (this->section_is_compressed(i, NULL))
+	{
+	  Compressed_section_map::const_iterator pc =
+	    this->compressed_sections()->find(i);
+	  if (pc->second.contents == NULL)
+	    continue;
+	}
+
+      section_size_type len;
+      bool is_new;
+      const unsigned char* contents =
+	this->decompressed_section_contents(i, &len, &is_new);
+      gold_assert(!is_new);
+
+      // Leave a section which is not null terminated to
+      // do_add_input_section, which will warn about it.
+      if (len == 0 || contents[len - 1] != '\0')
+	continue;
+
+      if (merge_string_hashes == NULL)
+	merge_string_hashes = new Merge_string_hash_map();
+      Merge_string_hashes& hashes((*merge_string_hashes)[i]);
+      const char* s = reinterpret_cast<const char*>(contents);
+      const char* send = s + len;
+      while (s < send)
+	{
+	  Merge_string_hash hash;
+	  hash.length = strlen(s);
+	  hash.hash_code = string_hash<char>(s, hash.length);
+	  hashes.push_back(hash);
+	  s += hash.length + 1;
+	}
+    }
+
+  if (merge_string_hashes != NULL)
+    this->set_merge_string_hashes(merge_string_hashes);
 }
 
 // Return the section index of symbol SYM.  Set *VALUE to its value in
@@ -2144,10 +2270,13 @@ Sized_relobj_file<size, big_endian>::do_add_symbols(Symbol_table* symtab,
 
   const char* sym_names =
     reinterpret_cast<const char*>(sd->symbol_names->data());
+  const Symbol_name_hash* name_hashes = NULL;
+  if (symcount > 0 && sd->symbol_name_hashes.size() == symcount)
+    name_hashes = &sd->symbol_name_hashes[0];
   symtab->add_from_relobj(this,
 			  sd->symbols->data() + sd->external_symbols_offset,
 			  symcount, this->local_symbol_count_,
-			  sym_names, sd->symbol_names_size,
+			  sym_names, sd->symbol_names_size, name_hashes,
 			  &this->symbols_,
 			  &this->defined_count_);
 
@@ -3197,12 +3326,39 @@ Object::decompressed_section_contents(
   return uncompressed_data;
 }
 
-// Discard any buffers of uncompressed sections.  This is done
-// at the end of the Add_symbols task.
+// If the lengths and hash codes of the strings in the mergeable
+// string section SHNDX were computed when reading symbols, move them
+// into *HASHES and return true.
+
+bool
+Object::take_merge_string_hashes(unsigned int shndx,
+				 Merge_string_hashes* hashes)
+{
+  if (this->merge_string_hashes_ == NULL)
+    return false;
+
+  Merge_string_hash_map::iterator p = this->merge_string_hashes_->find(shndx);
+  if (p == this->merge_string_hashes_->end())
+    return false;
+
+  hashes->swap(p->second);
+  this->merge_string_hashes_->erase(p);
+  return true;
+}
+
+// Discard any buffers of uncompressed sections, and any merge string
+// hashes which were not used.  This is done at the end of the
+// Add_symbols task.
 
 void
 Object::discard_decompressed_sections()
 {
+  if (this->merge_string_hashes_ != NULL)
+    {
+      delete this->merge_string_hashes_;
+      this->merge_string_hashes_ = NULL;
+    }
+
   if (this->compressed_sections_ == NULL)
     return;
 
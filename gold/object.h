@@ -54,6 +54,16 @@ struct Symbols_data;
 template<typename Stringpool_char>
 class Stringpool_template;
 
+// The name of an external symbol, as seen by the symbol table: its
+// length up to any '@' version separator, and the hash code of that
+// much of the name.
+
+struct Symbol_name_hash
+{
+  size_t length;
+  size_t hash_code;
+};
+
 // Data to pass from read_symbols() to add_symbols().
 
 struct Read_symbols_data
@@ -83,6 +93,10 @@ struct Read_symbols_data
   File_view* symbol_names;
   // Size of symbol name data in bytes.
   section_size_type symbol_names_size;
+  // The names of the external symbols, hashed while reading symbols
+  // so that the serialized Add_symbols task need not do it.  This is
+  // empty if the names were not hashed in advance.
+  std::vector<Symbol_name_hash> symbol_name_hashes;
 
   // Version information.  This is only used on dynamic objects.
   // Version symbol data (from SHT_GNU_versym section).
@@ -380,6 +394,17 @@ struct Compressed_section_info
 };
 typedef std::map<unsigned int, Compressed_section_info> Compressed_section_map;
 
+// The length in characters and the hash code of a string in a
+// mergeable string section.
+
+struct Merge_string_hash
+{
+  size_t length;
+  size_t hash_code;
+};
+typedef std::vector<Merge_string_hash> Merge_string_hashes;
+typedef std::map<unsigned int, Merge_string_hashes> Merge_string_hash_map;
+
 template<int size, bool big_endian>
 Compressed_section_map*
 build_compressed_section_map(const unsigned char* pshdrs, unsigned int shnum,
@@ -446,7 +471,7 @@ class Object
       is_dynamic_(is_dynamic), is_needed_(false), uses_split_stack_(false),
       has_no_split_stack_(false), no_export_(false),
       is_in_system_directory_(false), as_needed_(false), xindex_(NULL),
-      compressed_sections_(NULL)
+      compressed_sections_(NULL), merge_string_hashes_(NULL)
   {
     if (input_file != NULL)
       {
@@ -877,8 +902,15 @@ class Object
   decompressed_section_contents(unsigned int shndx, section_size_type* plen,
 				bool* is_cached, uint64_t* palign = NULL);
 
-  // Discard any buffers of decompressed sections.  This is done
-  // at the end of the Add_symbols task.
+  // If the lengths and hash codes of the strings in the mergeable
+  // string section SHNDX were computed when reading symbols, move
+  // them into *HASHES and return true.
+  bool
+  take_merge_string_hashes(unsigned int shndx, Merge_string_hashes* hashes);
+
+  // Discard any buffers of decompressed sections, and any unused
+  // merge string hashes.  This is done at the end of the Add_symbols
+  // task.
   void
   discard_decompressed_sections();
 
@@ -1095,6 +1127,10 @@ class Object
   compressed_sections()
   { return this->compressed_sections_; }
 
+  void
+  set_merge_string_hashes(Merge_string_hash_map* merge_string_hashes)
+  { this->merge_string_hashes_ = merge_string_hashes; }
+
  private:
   // This class may not be copied.
   Object(const Object&);
@@ -1132,6 +1168,9 @@ class Object
   // For compressed debug sections, map section index to uncompressed size
   // and contents.
   Compressed_section_map* compressed_sections_;
+  // For mergeable string sections, map section index to the lengths
+  // and hash codes of the strings, if computed by Read_symbols.
+  Merge_string_hash_map* merge_string_hashes_;
 };
 
 // A regular object (ET_REL).  This is an abstract base class itself.
@@ -2069,6 +2108,19 @@ class Sized_relobj : public Relobj
   void
   do_for_all_local_got_entries(Got_offset_list::Visitor* v) const;
 
+  // Return the list of GOT offsets of the local symbol SYMNDX, or
+  // NULL if it has none.
+  const Got_offset_list*
+  local_got_offset_list(unsigned int symndx) const
+  {
+    Local_got_entry_key key(symndx);
+    Local_got_offsets::const_iterator p =
+        this->local_got_offsets_.find(key);
+    if (p == this->local_got_offsets_.end())
+      return NULL;
+    return p->second->get_list();
+  }
+
  protected:
   typedef Relobj::Output_sections Output_sections;
 
@@ -2659,6 +2711,15 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   find_symtab(const unsigned char* pshdrs);
 
+  // Hash the names of the external symbols read into SD.
+  void
+  hash_symbol_names(Read_symbols_data* sd);
+
+  // Hash the strings in the mergeable string sections.
+  void
+  hash_merge_strings(const unsigned char* pshdrs, const char* names,
+		     section_size_type names_size);
+
   // Return whether SHDR has the right flags for a GNU style exception
   // frame section.
   bool
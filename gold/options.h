@@ -1057,6 +1057,16 @@ class General_options
 	      N_("Map the output file for writing"),
 	      N_("Do not map the output file for writing"));
 
+  DEFINE_bool(stream_output_file, options::TWO_DASHES, '\0', false,
+	      N_("Write each part of the output file as soon as it is "
+		 "complete"),
+	      N_("Write the output file when the link is done (default)"));
+
+  DEFINE_uint64(stream_output_memory, options::TWO_DASHES, '\0', 64 << 20,
+		N_("Limit the output file held in memory by "
+		   "--stream-output-file to SIZE bytes (0 for no limit)"),
+		N_("SIZE"));
+
   DEFINE_bool(print_map, options::TWO_DASHES, 'M', false,
 	      N_("Write map file on standard output"), NULL);
 
@@ -1204,6 +1214,14 @@ class General_options
 	      N_("Relax branches on certain targets"),
 	      N_("Do not relax branches"));
 
+  DEFINE_string(relocation_cache, options::TWO_DASHES, '\0', NULL,
+		N_("Reuse relocated section contents cached in DIR"),
+		N_("DIR"));
+
+  DEFINE_uint64(relocation_cache_size, options::TWO_DASHES, '\0', 1 << 30,
+		N_("Remove old --relocation-cache entries beyond SIZE bytes"),
+		N_("SIZE"));
+
   DEFINE_string(retain_symbols_file, options::TWO_DASHES, '\0', NULL,
 		N_("keep only symbols listed in this file"), N_("FILE"));
 
@@ -1302,6 +1320,10 @@ class General_options
   DEFINE_bool(trace, options::TWO_DASHES, 't', false,
 	      N_("Print the name of each input file"), NULL);
 
+  DEFINE_string(trace_tasks, options::TWO_DASHES, '\0', NULL,
+		N_("Write a Chrome trace of the linker's tasks to FILENAME"),
+		N_("FILENAME"));
+
   DEFINE_bool(target1_abs, options::TWO_DASHES, '\0', false,
 	      N_("(ARM only) Force R_ARM_TARGET1 type to R_ARM_ABS32"),
 	      NULL);
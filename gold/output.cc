@@ -4946,7 +4946,8 @@ Output_file::Output_file(const char* name)
     base_(NULL),
     map_is_anonymous_(false),
     map_is_allocated_(false),
-    is_temporary_(false)
+    is_temporary_(false),
+    is_streaming_(false)
 {
 }
 
@@ -5214,7 +5215,10 @@ Output_file::map_no_anonymous(bool writable)
 void
 Output_file::map()
 {
+  // With --stream-output-file we build the output in memory, and
+  // write it as it is completed.
   if (parameters->options().mmap_output_file()
+      && !parameters->options().stream_output_file()
       && this->map_no_anonymous(true))
     return;
 
@@ -5249,13 +5253,87 @@ Output_file::unmap()
   this->base_ = NULL;
 }
 
+// Arrange to write the file in parts with write_range.
+
+bool
+Output_file::start_streaming()
+{
+  struct stat statbuf;
+  if (!this->map_is_anonymous_
+      || this->is_temporary_
+      || this->o_ == STDOUT_FILENO
+      || this->o_ == STDERR_FILENO
+      || ::fstat(this->o_, &statbuf) != 0
+      || !S_ISREG(statbuf.st_mode))
+    return false;
+
+  // As in map_no_anonymous, make sure that the disk space is
+  // available now rather than discovering that it isn't after we
+  // have exited.
+  int err = gold_fallocate(this->o_, 0, this->file_size_);
+  if (err != 0)
+    gold_fatal(_("%s: %s"), this->name_, strerror(err));
+
+  this->is_streaming_ = true;
+  return true;
+}
+
+// Write SIZE bytes at START to the file, and give back the memory of
+// the range if DISCARD.  Output_file_chunks limits how much of the
+// file is in memory at once.
+
+void
+Output_file::write_range(off_t start, size_t size, bool discard)
+{
+  gold_assert(this->is_streaming_
+	      && start >= 0
+	      && start + static_cast<off_t>(size) <= this->file_size_);
+
+  size_t bytes_to_write = size;
+  off_t offset = start;
+  while (bytes_to_write > 0)
+    {
+      ssize_t bytes_written = ::pwrite(this->o_, this->base_ + offset,
+				       bytes_to_write, offset);
+      if (bytes_written <= 0)
+	{
+	  if (bytes_written == 0)
+	    gold_error(_("%s: write: unexpected 0 return-value"),
+		       this->name_);
+	  else
+	    gold_error(_("%s: write: %s"), this->name_, strerror(errno));
+	  return;
+	}
+      bytes_to_write -= bytes_written;
+      offset += bytes_written;
+    }
+
+#if defined(HAVE_SYS_MMAN_H) && defined(MADV_DONTNEED)
+  // Give back the pages which lie entirely within the range.
+  if (discard && !this->map_is_allocated_)
+    {
+      uintptr_t page_size = ::sysconf(_SC_PAGESIZE);
+      uintptr_t first = reinterpret_cast<uintptr_t>(this->base_ + start);
+      uintptr_t last = first + size;
+      first = (first + page_size - 1) & ~(page_size - 1);
+      last &= ~(page_size - 1);
+      if (first < last)
+	::madvise(reinterpret_cast<void*>(first), last - first,
+		  MADV_DONTNEED);
+    }
+#else
+  (void) discard;
+#endif
+}
+
 // Close the output file.
 
 void
 Output_file::close()
 {
-  // If the map isn't file-backed, we need to write it now.
-  if (this->map_is_anonymous_ && !this->is_temporary_)
+  // If the map isn't file-backed, we need to write it now, unless it
+  // has already been written with write_range.
+  if (this->map_is_anonymous_ && !this->is_temporary_ && !this->is_streaming_)
     {
       size_t bytes_to_write = this->file_size_;
       size_t offset = 0;
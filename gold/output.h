@@ -84,6 +84,22 @@ class Output_file
   void
   close();
 
+  // For --stream-output-file: arrange to write parts of the output
+  // file with write_range before it is closed.  This is only possible
+  // if the output is being built in memory and written to a regular
+  // file.  Return whether streaming is possible.  This method is
+  // thread-unsafe.
+  bool
+  start_streaming();
+
+  // Write SIZE bytes at START from memory to the file.  After
+  // start_streaming, every part of the file must be written this way
+  // before it is closed.  If DISCARD, the memory may be released, in
+  // which case it must not be read or written again.  This may be
+  // called from several threads for disjoint ranges.
+  void
+  write_range(off_t start, size_t size, bool discard);
+
   // Return the size of this file.
   off_t
   filesize()
@@ -172,6 +188,9 @@ class Output_file
   bool map_is_allocated_;
   // True if this is a temporary file which should not be output.
   bool is_temporary_;
+  // True if the file is written with write_range rather than when it
+  // is closed.
+  bool is_streaming_;
 };
 
 // An abtract class for data which has to go into the output file.
@@ -3613,6 +3632,14 @@ class Output_section : public Output_data
   void
   create_postprocessing_buffer();
 
+  // If a section requires postprocessing, add to TASKS any tasks
+  // which can do part of it in parallel once all the input sections
+  // have been written, before set_final_data_size is called.  Each
+  // task unblocks BLOCKER when it is done.
+  void
+  postprocessing_tasks(Task_token* blocker, std::vector<Task*>* tasks)
+  { this->do_postprocessing_tasks(blocker, tasks); }
+
   // If a section requires postprocessing, this is the size of the
   // buffer to which relocations should be applied.
   off_t
@@ -4222,6 +4249,11 @@ class Output_section : public Output_data
   do_finalize_name(Layout*)
   { }
 
+  // This may be implemented by a child class.
+  virtual void
+  do_postprocessing_tasks(Task_token*, std::vector<Task*>*)
+  { }
+
   // Print to the map file.
   virtual void
   do_print_to_mapfile(Mapfile*) const;
@@ -23,6 +23,13 @@
 #include "gold.h"
 
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "workqueue.h"
 #include "layout.h"
@@ -201,7 +208,9 @@ Scan_relocs::get_name() const
 
 // Relocate_task methods.
 
-// We may have to wait for the output sections to be written.
+// We may have to wait for the output sections to be written, and
+// for chunks of the output file to be written with
+// --stream-output-file.
 
 Task_token*
 Relocate_task::is_runnable()
@@ -213,6 +222,10 @@ Relocate_task::is_runnable()
   if (this->object_->is_locked())
     return this->object_->token();
 
+  Output_file_chunks* chunks = this->layout_->output_file_chunks();
+  if (chunks != NULL && this->chunks_hold_ == NULL)
+    return chunks->admit(this->object_, &this->chunks_hold_);
+
   return NULL;
 }
 
@@ -229,15 +242,21 @@ Relocate_task::locks(Task_locker* tl)
   Task_token* token = this->object_->token();
   if (token != NULL)
     tl->add(this, token);
+  if (this->chunks_hold_ != NULL)
+    tl->add(this, this->chunks_hold_);
 }
 
 // Run the task.
 
 void
-Relocate_task::run(Workqueue*)
+Relocate_task::run(Workqueue* workqueue)
 {
   this->object_->relocate(this->symtab_, this->layout_, this->of_);
 
+  Output_file_chunks* chunks = this->layout_->output_file_chunks();
+  if (chunks != NULL)
+    chunks->writer_done(workqueue, this->object_, this->chunks_hold_);
+
   // This is normally the last thing we will do with an object, so
   // uncache all views.
   this->object_->clear_view_cache_marks();
@@ -253,6 +272,312 @@ Relocate_task::get_name() const
   return "Relocate_task " + this->object_->name();
 }
 
+// Relocation_cache::Hash methods.
+
+// Add LEN bytes at P.
+
+void
+Relocation_cache::Hash::add(const void* p, size_t len)
+{
+  const unsigned char* pc = static_cast<const unsigned char*>(p);
+  size_t left = len;
+  while (left >= 8)
+    {
+      uint64_t v;
+      memcpy(&v, pc, 8);
+      this->add(v);
+      pc += 8;
+      left -= 8;
+    }
+  uint64_t v = 0;
+  for (size_t i = 0; i < left; ++i)
+    v = (v << 8) | pc[i];
+  this->add(v);
+  this->add(static_cast<uint64_t>(len));
+}
+
+// Return the key.
+
+Relocation_cache::Key
+Relocation_cache::Hash::finish() const
+{
+  uint64_t h[2] = { this->h1_, this->h2_ };
+  h[0] += h[1];
+  h[1] += h[0];
+  for (int i = 0; i < 2; ++i)
+    {
+      h[i] ^= h[i] >> 33;
+      h[i] *= 0xff51afd7ed558ccdULL;
+      h[i] ^= h[i] >> 33;
+      h[i] *= 0xc4ceb9fe1a85ec53ULL;
+      h[i] ^= h[i] >> 33;
+    }
+  Key key;
+  key.h1 = h[0] + h[1];
+  key.h2 = h[1] + key.h1;
+  return key;
+}
+
+// Relocation_cache methods.
+
+Relocation_cache::Relocation_cache(const char* dirname)
+  : dirname_(dirname), is_enabled_(false), layout_key_(), lock_(NULL),
+    initialize_lock_(&this->lock_), lookups_(0), hits_(0), stores_(0),
+    evictions_(0)
+{
+  if (::mkdir(dirname, 0777) < 0 && errno != EEXIST)
+    gold_warning(_("cannot create relocation cache directory %s: %s"),
+		 dirname, strerror(errno));
+}
+
+// Record the output layout.  Relocating a section can depend on the
+// address and size of any output section, for example through the
+// size of the GOT, and on the TLS segment.  It also depends on the
+// kind of output file.
+
+void
+Relocation_cache::set_layout(const Layout* layout)
+{
+  const Target& target(parameters->target());
+  if (target.machine_code() != elfcpp::EM_X86_64)
+    {
+      gold_warning(_("--relocation-cache is only supported for x86-64; "
+		     "ignoring"));
+      return;
+    }
+  if (parameters->options().relocatable()
+      || parameters->options().emit_relocs()
+      || parameters->incremental())
+    {
+      gold_warning(_("--relocation-cache can not be used with "
+		     "-r, --emit-relocs, or --incremental; ignoring"));
+      return;
+    }
+
+  Hash h;
+  h.add(get_version_string());
+  h.add(target.machine_code());
+  h.add(parameters->target().get_size());
+  h.add(parameters->target().is_big_endian());
+  h.add(parameters->options().shared());
+  h.add(parameters->options().pie());
+  h.add(parameters->options().output_is_executable());
+  h.add(parameters->options().output_is_position_independent());
+  h.add(parameters->doing_static_link());
+
+  const Layout::Section_list& sections(layout->section_list());
+  for (Layout::Section_list::const_iterator p = sections.begin();
+       p != sections.end();
+       ++p)
+    {
+      const Output_section* os = *p;
+      h.add(os->name());
+      h.add(os->type());
+      h.add(os->flags());
+      if ((os->flags() & elfcpp::SHF_ALLOC) != 0)
+	{
+	  h.add(os->address());
+	  h.add(os->data_size());
+	}
+    }
+
+  const Output_segment* tls_segment = layout->tls_segment();
+  if (tls_segment != NULL)
+    {
+      h.add(tls_segment->vaddr());
+      h.add(tls_segment->memsz());
+    }
+
+  this->layout_key_ = h.finish();
+  this->is_enabled_ = true;
+}
+
+// Return the file name for the entry KEY.
+
+std::string
+Relocation_cache::filename(const Key& key) const
+{
+  char buf[40];
+  snprintf(buf, sizeof buf, "/%016llx%016llx",
+	   static_cast<unsigned long long>(key.h1),
+	   static_cast<unsigned long long>(key.h2));
+  return this->dirname_ + buf;
+}
+
+// Increment a counter, holding the lock if there is one.
+
+void
+Relocation_cache::increment_counter(unsigned int* counter)
+{
+  if (!this->initialize_lock_.initialize())
+    ++*counter;
+  else
+    {
+      Hold_lock h(*this->lock_);
+      ++*counter;
+    }
+}
+
+// Look for the entry KEY.  Entries are only ever created by renaming
+// a complete file into place, and only ever removed by unlinking, so
+// once the size matches the contents can be read straight into VIEW.
+
+bool
+Relocation_cache::lookup(const Key& key, unsigned char* view,
+			 section_size_type view_size)
+{
+  this->increment_counter(&this->lookups_);
+
+  std::string name(this->filename(key));
+  int fd = ::open(name.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (::fstat(fd, &st) < 0
+      || static_cast<section_size_type>(st.st_size) != view_size)
+    {
+      ::close(fd);
+      return false;
+    }
+
+  // VIEW is overwritten as we go, so a short read from here on can
+  // not fall back to relocating the section.
+  section_size_type got = 0;
+  while (got < view_size)
+    {
+      ssize_t r = ::read(fd, view + got, view_size - got);
+      if (r < 0 && errno == EINTR)
+	continue;
+      if (r <= 0)
+	gold_fatal(_("%s: cannot read relocation cache entry: %s"),
+		   name.c_str(), r < 0 ? strerror(errno) : _("file too short"));
+      got += r;
+    }
+  ::close(fd);
+
+  this->increment_counter(&this->hits_);
+  return true;
+}
+
+// Store the entry KEY.  We write to a temporary file and rename it,
+// so that a concurrent link never sees a partial entry.  The cache is
+// only an optimization, so failures are silently ignored.
+
+void
+Relocation_cache::store(const Key& key, const unsigned char* view,
+			section_size_type view_size)
+{
+  unsigned int seq;
+  if (!this->initialize_lock_.initialize())
+    seq = this->stores_++;
+  else
+    {
+      Hold_lock h(*this->lock_);
+      seq = this->stores_++;
+    }
+
+  std::string name(this->filename(key));
+  char suffix[40];
+  snprintf(suffix, sizeof suffix, ".%ld.%u", static_cast<long>(getpid()),
+	   seq);
+  std::string tmpname(name + suffix);
+
+  int fd = ::open(tmpname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    return;
+  section_size_type written = 0;
+  while (written < view_size)
+    {
+      ssize_t r = ::write(fd, view + written, view_size - written);
+      if (r <= 0)
+	break;
+      written += r;
+    }
+  if (::close(fd) < 0
+      || written != view_size
+      || ::rename(tmpname.c_str(), name.c_str()) < 0)
+    ::unlink(tmpname.c_str());
+}
+
+// Keep the cache directory within --relocation-cache-size by
+// removing the entries which were least recently used.  An entry is
+// used when it is written or read, and reading it updates its access
+// time unless the file system is mounted with noatime, in which case
+// this falls back to removing the oldest entries first.  Only a link
+// which stored new entries can have grown the directory, so other
+// links do not scan it.
+
+void
+Relocation_cache::trim()
+{
+  if (this->stores_ == 0)
+    return;
+
+  DIR* d = ::opendir(this->dirname_.c_str());
+  if (d == NULL)
+    return;
+
+  struct Entry
+  {
+    time_t time;
+    off_t size;
+    std::string name;
+
+    bool
+    operator<(const Entry& e) const
+    { return this->time < e.time; }
+  };
+
+  std::vector<Entry> entries;
+  uint64_t total = 0;
+  dirent* de;
+  while ((de = ::readdir(d)) != NULL)
+    {
+      if (de->d_name[0] == '.')
+	continue;
+      Entry e;
+      e.name = this->dirname_ + '/' + de->d_name;
+      struct stat st;
+      if (::stat(e.name.c_str(), &st) < 0 || !S_ISREG(st.st_mode))
+	continue;
+      e.time = std::max(st.st_atime, st.st_mtime);
+      e.size = st.st_size;
+      total += e.size;
+      entries.push_back(e);
+    }
+  ::closedir(d);
+
+  uint64_t limit = parameters->options().relocation_cache_size();
+  if (total <= limit)
+    return;
+
+  std::sort(entries.begin(), entries.end());
+  for (std::vector<Entry>::const_iterator p = entries.begin();
+       p != entries.end() && total > limit;
+       ++p)
+    {
+      if (::unlink(p->name.c_str()) == 0)
+	++this->evictions_;
+      total -= p->size;
+    }
+}
+
+// Print statistics.
+
+void
+Relocation_cache::print_stats() const
+{
+  fprintf(stderr, _("%s: relocation cache lookups: %u\n"),
+	  program_name, this->lookups_);
+  fprintf(stderr, _("%s: relocation cache hits: %u\n"),
+	  program_name, this->hits_);
+  fprintf(stderr, _("%s: relocation cache entries stored: %u\n"),
+	  program_name, this->stores_);
+  fprintf(stderr, _("%s: relocation cache entries removed: %u\n"),
+	  program_name, this->evictions_);
+}
+
 // Read the relocs and local symbols from the object file and store
 // the information in RD.
 
@@ -875,6 +1200,139 @@ Sized_relobj_file<size, big_endian>::do_relocate_sections(
 			       1, this->shnum() - 1);
 }
 
+// Add the GOT offsets of a symbol to a relocation cache key.
+
+class Relocation_cache_got_visitor : public Got_offset_list::Visitor
+{
+ public:
+  Relocation_cache_got_visitor(Relocation_cache::Hash* hash)
+    : hash_(hash)
+  { }
+
+  void
+  visit(unsigned int got_type, unsigned int got_offset, uint64_t addend)
+  {
+    this->hash_->add(got_type);
+    this->hash_->add(got_offset);
+    this->hash_->add(addend);
+  }
+
+ private:
+  Relocation_cache::Hash* hash_;
+};
+
+// Compute the --relocation-cache key for section DATA_SHNDX of
+// OBJECT, which has RELOC_COUNT RELA relocations at PRELOCS.  The key
+// covers the output layout, the address of the section, its contents
+// before relocation, the relocations themselves, and for each
+// relocation everything that the target's relocate function consults
+// about its symbol: the final value, the GOT and PLT offsets, and the
+// properties which decide whether the GOT or PLT is used.  Return
+// false if the section must not be cached, because relocating it may
+// issue a diagnostic that a cache hit would lose.
+
+template<int size, bool big_endian>
+static bool
+relocation_cache_key(const Relocation_cache* rc, const Symbol_table* symtab,
+		     Sized_relobj_file<size, big_endian>* object,
+		     unsigned int data_shndx, const unsigned char* prelocs,
+		     size_t reloc_count, const unsigned char* view,
+		     typename elfcpp::Elf_types<size>::Elf_Addr address,
+		     section_size_type view_size,
+		     Relocation_cache::Key* key)
+{
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+  const int reloc_size = elfcpp::Elf_sizes<size>::rela_size;
+
+  Relocation_cache::Hash h(rc->layout_key());
+  h.add(address);
+  h.add(view, view_size);
+  h.add(prelocs, reloc_count * reloc_size);
+
+  Relocation_cache_got_visitor got_visitor(&h);
+  unsigned int local_count = object->local_symbol_count();
+  std::string section_name;
+  for (size_t i = 0; i < reloc_count; ++i, prelocs += reloc_size)
+    {
+      elfcpp::Rela<size, big_endian> reloc(prelocs);
+      unsigned int r_sym = elfcpp::elf_r_sym<size>(reloc.get_r_info());
+
+      if (r_sym < local_count)
+	{
+	  const Symbol_value<size>* psymval = object->local_symbol(r_sym);
+	  bool is_ordinary;
+	  unsigned int shndx = psymval->input_shndx(&is_ordinary);
+	  if (is_ordinary
+	      && shndx != elfcpp::SHN_UNDEF
+	      && !object->is_section_included(shndx)
+	      && !symtab->is_section_folded(object, shndx))
+	    {
+	      // relocate_section maps these to the kept section, if
+	      // there is one, or to zero.
+	      if (section_name.empty())
+		section_name = object->section_name(data_shndx);
+	      bool found;
+	      Address value = object->map_to_kept_section(shndx, section_name,
+							  &found);
+	      h.add(found ? value + psymval->input_value() : 1);
+	      continue;
+	    }
+
+	  h.add(psymval->value(object, reloc.get_r_addend()));
+	  h.add((psymval->is_tls_symbol() ? 1 : 0)
+		| (psymval->is_ifunc_symbol() ? 2 : 0));
+	  if (object->local_has_plt_offset(r_sym))
+	    h.add(object->local_plt_offset(r_sym));
+	  const Got_offset_list* got = object->local_got_offset_list(r_sym);
+	  if (got != NULL)
+	    got->for_all_got_offsets(&got_visitor);
+	}
+      else
+	{
+	  const Symbol* gsym = object->global_symbol(r_sym);
+	  gold_assert(gsym != NULL);
+	  if (gsym->is_forwarder())
+	    gsym = symtab->resolve_forwards(gsym);
+
+	  if ((gsym->is_undefined() && !gsym->is_weak_undefined())
+	      || gsym->has_warning())
+	    return false;
+
+	  const Sized_symbol<size>* ssym =
+	    static_cast<const Sized_symbol<size>*>(gsym);
+	  h.add(gsym->name());
+	  h.add(ssym->value());
+	  bool is_defined = gsym->is_defined();
+	  bool is_from_dynobj = gsym->is_from_dynobj();
+	  uint64_t flags =
+	    (static_cast<uint64_t>(gsym->type())
+	     | (static_cast<uint64_t>(gsym->binding()) << 8)
+	     | (static_cast<uint64_t>(gsym->visibility()) << 16)
+	     | (static_cast<uint64_t>(gsym->source()) << 24)
+	     | (static_cast<uint64_t>(is_defined) << 32)
+	     | (static_cast<uint64_t>(is_from_dynobj) << 33)
+	     | (static_cast<uint64_t>(gsym->is_weak_undefined()) << 34)
+	     | (static_cast<uint64_t>(is_defined
+				      && !is_from_dynobj
+				      && gsym->is_preemptible()) << 35)
+	     | (static_cast<uint64_t>(gsym->final_value_is_known()) << 36)
+	     | (static_cast<uint64_t>(gsym->needs_dynsym_value()) << 37)
+	     | (static_cast<uint64_t>(gsym->is_defined_in_discarded_section())
+		<< 38));
+	  h.add(flags);
+	  h.add(gsym->has_plt_offset() ? gsym->plt_offset() : -1U);
+	  h.add(gsym->has_symtab_index() ? gsym->symtab_index() : -1U);
+	  h.add(gsym->has_dynsym_index() ? gsym->dynsym_index() : -1U);
+	  const Got_offset_list* got = gsym->got_offset_list();
+	  if (got != NULL)
+	    got->for_all_got_offsets(&got_visitor);
+	}
+    }
+
+  *key = h.finish();
+  return true;
+}
+
 // Relocate section data for the range of sections START_SHNDX through
 // END_SHNDX.
 
@@ -1002,9 +1460,35 @@ Sized_relobj_file<size, big_endian>::relocate_section_range(
 
       if (!parameters->options().relocatable())
 	{
+	  // With --relocation-cache, try to reuse the contents of this
+	  // section from an earlier link.  We store the section only if
+	  // relocating it issued no diagnostics.
+	  Relocation_cache* rc = layout->relocation_cache();
+	  Relocation_cache::Key key;
+	  bool use_cache = (rc != NULL
+			    && rc->is_enabled()
+			    && sh_type == elfcpp::SHT_RELA
+			    && output_offset != invalid_address
+			    && !this->uses_split_stack()
+			    && relocation_cache_key(rc, symtab, this, index,
+						    prelocs, reloc_count,
+						    view, address, view_size,
+						    &key));
+	  if (use_cache && rc->lookup(key, view, view_size))
+	    continue;
+
+	  int error_count = parameters->errors()->error_count();
+	  int warning_count = parameters->errors()->warning_count();
+
 	  target->relocate_section(&relinfo, sh_type, prelocs, reloc_count, os,
 				   output_offset == invalid_address,
 				   view, address, view_size, reloc_map);
+
+	  if (use_cache
+	      && parameters->errors()->error_count() == error_count
+	      && parameters->errors()->warning_count() == warning_count)
+	    rc->store(key, view, view_size);
+
 	  if (parameters->options().emit_relocs())
 	    target->relocate_relocs(&relinfo, sh_type, prelocs, reloc_count,
 				    os, output_offset,
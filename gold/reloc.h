@@ -187,7 +187,7 @@ class Relocate_task : public Task
     : symtab_(symtab), layout_(layout), object_(object), of_(of),
       input_sections_blocker_(input_sections_blocker),
       output_sections_blocker_(output_sections_blocker),
-      final_blocker_(final_blocker)
+      final_blocker_(final_blocker), chunks_hold_(NULL)
   { }
 
   // The standard Task methods.
@@ -212,6 +212,144 @@ class Relocate_task : public Task
   Task_token* input_sections_blocker_;
   Task_token* output_sections_blocker_;
   Task_token* final_blocker_;
+  // Set by Output_file_chunks::admit.
+  Task_token* chunks_hold_;
+};
+
+// This class implements --relocation-cache.  It stores the contents
+// of input sections after relocation in files in a directory, named
+// by a hash of everything the relocated contents depend on, and a
+// later link which finds a matching file copies it into the output
+// instead of applying the relocations again.  This is only useful
+// when relinking with the same layout, since any change in the
+// address of an output section changes every key which depends on it.
+
+class Relocation_cache
+{
+ public:
+  // A key naming a cache entry.
+  struct Key
+  {
+    uint64_t h1;
+    uint64_t h2;
+  };
+
+  // A fast non-cryptographic 128-bit hash, used to build keys.  This
+  // is MurmurHash3 with each 64-bit word fed to both halves.  Words
+  // are read in host byte order, so keys are not portable between
+  // hosts of different endianness.
+  class Hash
+  {
+   public:
+    Hash()
+      : h1_(0x9e3779b97f4a7c15ULL), h2_(0xc2b2ae3d27d4eb4fULL)
+    { }
+
+    // Start from a key computed earlier.
+    Hash(const Key& key)
+      : h1_(key.h1), h2_(key.h2)
+    { }
+
+    // Add a word.
+    void
+    add(uint64_t v)
+    {
+      uint64_t k1 = rotl(v * c1, 31) * c2;
+      this->h1_ = rotl(this->h1_ ^ k1, 27) + this->h2_;
+      this->h1_ = this->h1_ * 5 + 0x52dce729;
+      uint64_t k2 = rotl(v * c2, 33) * c1;
+      this->h2_ = rotl(this->h2_ ^ k2, 31) + this->h1_;
+      this->h2_ = this->h2_ * 5 + 0x38495ab5;
+    }
+
+    // Add LEN bytes at P.
+    void
+    add(const void* p, size_t len);
+
+    // Add a string, including its length.
+    void
+    add(const char* s)
+    { this->add(s, strlen(s)); }
+
+    // Return the key.
+    Key
+    finish() const;
+
+   private:
+    static const uint64_t c1 = 0x87c37b91114253d5ULL;
+    static const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+    static uint64_t
+    rotl(uint64_t v, int r)
+    { return (v << r) | (v >> (64 - r)); }
+
+    uint64_t h1_;
+    uint64_t h2_;
+  };
+
+  Relocation_cache(const char* dirname);
+
+  // Record the output layout, which every key depends on.  This is
+  // called once, after the layout is final and before any section is
+  // relocated.  It disables the cache if it can not be used for this
+  // link.
+  void
+  set_layout(const Layout*);
+
+  // Whether to use the cache.
+  bool
+  is_enabled() const
+  { return this->is_enabled_; }
+
+  // The hash of the output layout, which starts every key.
+  const Key&
+  layout_key() const
+  { return this->layout_key_; }
+
+  // Look for the entry KEY.  If it exists and is VIEW_SIZE bytes
+  // long, copy it to VIEW and return true.
+  bool
+  lookup(const Key& key, unsigned char* view, section_size_type view_size);
+
+  // Store VIEW_SIZE bytes at VIEW as the entry KEY.
+  void
+  store(const Key& key, const unsigned char* view,
+	section_size_type view_size);
+
+  // Remove old entries until the cache is no larger than
+  // --relocation-cache-size.  This is called once, after the link.
+  void
+  trim();
+
+  // Print statistics to stderr.
+  void
+  print_stats() const;
+
+ private:
+  // Return the file name for the entry KEY.
+  std::string
+  filename(const Key& key) const;
+
+  // Increment a counter, holding the lock if there is one.
+  void
+  increment_counter(unsigned int* counter);
+
+  // The cache directory.
+  std::string dirname_;
+  // Whether to use the cache.
+  bool is_enabled_;
+  // The hash of the output layout.
+  Key layout_key_;
+  // Protects the counters below.
+  Lock* lock_;
+  Initialize_lock initialize_lock_;
+  // The number of lookups and hits.
+  unsigned int lookups_;
+  unsigned int hits_;
+  // The number of entries stored; also used to name temporary files.
+  unsigned int stores_;
+  // The number of entries removed by trim.
+  unsigned int evictions_;
 };
 
 // During a relocatable link, this class records how relocations
@@ -1245,6 +1245,7 @@ Symbol_table::add_from_relobj(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
     typename Sized_relobj_file<size, big_endian>::Symbols* sympointers,
     size_t* defined)
 {
@@ -1306,9 +1307,16 @@ Symbol_table::add_from_relobj(
       // In an object file, an '@' in the name separates the symbol
       // name from the version name.  If there are two '@' characters,
       // this is the default version.
-      const char* ver = strchr(name, '@');
+      const char* ver;
       Stringpool::Key ver_key = 0;
       int namelen = 0;
+      if (name_hashes != NULL)
+	{
+	  namelen = name_hashes[i].length;
+	  ver = name[namelen] == '@' ? name + namelen : NULL;
+	}
+      else
+	ver = strchr(name, '@');
       // IS_DEFAULT_VERSION: is the version default?
       // IS_FORCED_LOCAL: is the symbol forced local?
       bool is_default_version = false;
@@ -1339,7 +1347,8 @@ Symbol_table::add_from_relobj(
       // about a common symbol?
       else
 	{
-	  namelen = strlen(name);
+	  if (name_hashes == NULL)
+	    namelen = strlen(name);
 	  if (!this->version_script_.empty()
 	      && st_shndx != elfcpp::SHN_UNDEF)
 	    {
@@ -1411,8 +1420,13 @@ Symbol_table::add_from_relobj(
         }
 
       Stringpool::Key name_key;
-      name = this->namepool_.add_with_length(name, namelen, true,
-					     &name_key);
+      if (name_hashes != NULL)
+	name = this->namepool_.add_with_hash(name, namelen,
+					     name_hashes[i].hash_code,
+					     true, &name_key);
+      else
+	name = this->namepool_.add_with_length(name, namelen, true,
+					       &name_key);
 
       Sized_symbol<size>* res;
       res = this->add_from_object(relobj, name, name_key, ver, ver_key,
@@ -3799,6 +3813,7 @@ Symbol_table::add_from_relobj<32, false>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
     Sized_relobj_file<32, false>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3813,6 +3828,7 @@ Symbol_table::add_from_relobj<32, true>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
     Sized_relobj_file<32, true>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3827,6 +3843,7 @@ Symbol_table::add_from_relobj<64, false>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
     Sized_relobj_file<64, false>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3841,6 +3858,7 @@ Symbol_table::add_from_relobj<64, true>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
     Sized_relobj_file<64, true>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -1472,15 +1472,17 @@ class Symbol_table
   // Add COUNT external symbols from the relocatable object RELOBJ to
   // the symbol table.  SYMS is the symbols, SYMNDX_OFFSET is the
   // offset in the symbol table of the first symbol, SYM_NAMES is
-  // their names, SYM_NAME_SIZE is the size of SYM_NAMES.  This sets
-  // SYMPOINTERS to point to the symbols in the symbol table.  It sets
-  // *DEFINED to the number of defined symbols.
+  // their names, SYM_NAME_SIZE is the size of SYM_NAMES.  NAME_HASHES
+  // is either NULL or the COUNT names already hashed by
+  // Sized_relobj_file::hash_symbol_names.  This sets SYMPOINTERS to
+  // point to the symbols in the symbol table.  It sets *DEFINED to
+  // the number of defined symbols.
   template<int size, bool big_endian>
   void
   add_from_relobj(Sized_relobj_file<size, big_endian>* relobj,
 		  const unsigned char* syms, size_t count,
 		  size_t symndx_offset, const char* sym_names,
-		  size_t sym_name_size,
+		  size_t sym_name_size, const Symbol_name_hash* name_hashes,
 		  typename Sized_relobj_file<size, big_endian>::Symbols*,
 		  size_t* defined);
 
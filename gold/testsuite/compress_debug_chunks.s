@@ -0,0 +1,12 @@
+# compress_debug_chunks.s -- a debug section larger than one
+# compression chunk, for --compress-debug-sections with --threads.
+
+	.text
+	.globl	_start
+_start:
+
+	.section	.debug_gold_test
+1:
+	.rept	700000
+	.long	. - 1b
+	.endr
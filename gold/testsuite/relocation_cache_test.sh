@@ -0,0 +1,86 @@
+#!/bin/sh
+
+# relocation_cache_test.sh -- test --relocation-cache.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The test links the same objects without the cache, with a cold
+# cache and with a warm cache, and then links a changed version of one
+# object using the warm cache.  Every link using the cache must give
+# the same output as the corresponding link without it.
+
+check_cmp()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$1 and $2 differ"
+	exit 1
+    fi
+}
+
+# Print the relocation cache statistic $2 from the --stats output $1.
+stat_value()
+{
+    sed -n "s/.*relocation cache $2: //p" "$1"
+}
+
+check_cmp relocation_cache_test_nocache relocation_cache_test_cold
+check_cmp relocation_cache_test_nocache relocation_cache_test_warm
+check_cmp relocation_cache_test_v1_nocache relocation_cache_test_v1
+
+lookups=`stat_value relocation_cache_test_cold.stats lookups`
+hits=`stat_value relocation_cache_test_cold.stats hits`
+stored=`stat_value relocation_cache_test_cold.stats "entries stored"`
+if test "$lookups" -eq 0 || test "$hits" -ne 0 || test "$stored" -ne "$lookups"
+then
+    echo "unexpected cold cache statistics:"
+    cat relocation_cache_test_cold.stats
+    exit 1
+fi
+
+lookups=`stat_value relocation_cache_test_warm.stats lookups`
+hits=`stat_value relocation_cache_test_warm.stats hits`
+if test "$lookups" -eq 0 || test "$hits" -ne "$lookups"
+then
+    echo "unexpected warm cache statistics:"
+    cat relocation_cache_test_warm.stats
+    exit 1
+fi
+
+# Changing one object changes the keys of some sections but not all.
+lookups=`stat_value relocation_cache_test_v1.stats lookups`
+hits=`stat_value relocation_cache_test_v1.stats hits`
+if test "$hits" -eq 0 || test "$hits" -eq "$lookups"
+then
+    echo "unexpected changed input statistics:"
+    cat relocation_cache_test_v1.stats
+    exit 1
+fi
+
+# A cache limited to 0 bytes is emptied at the end of each link.
+removed=`stat_value relocation_cache_test_trim.stats "entries removed"`
+if test "$removed" -eq 0 || test -n "`ls relocation_cache_test_trim.dir`"
+then
+    echo "--relocation-cache-size=0 did not empty the cache"
+    cat relocation_cache_test_trim.stats
+    exit 1
+fi
+
+exit 0
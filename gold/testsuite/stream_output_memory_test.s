@@ -0,0 +1,8 @@
+# stream_output_memory_test.s -- input for stream_output_memory_test.sh.
+
+# Each object made from this file has 8K of data, so that each one
+# writes to several 4K chunks of the output file.  N is defined on
+# the assembler command line.
+
+	.data
+	.fill	8192, 1, N
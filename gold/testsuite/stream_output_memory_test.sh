@@ -0,0 +1,62 @@
+#!/bin/sh
+
+# stream_output_memory_test.sh -- test --stream-output-memory.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The test links four objects of 8K of data each, with 4K
+# --build-id=tree chunks, and with --stream-output-memory set to 16K
+# and to 1G.  With the 16K limit, relocation must be held back so
+# that at most four chunks are in memory at once, which is fewer than
+# without the limit.  Both links must give the same output as a link
+# without --stream-output-file.
+
+check_cmp()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$1 and $2 differ"
+	exit 1
+    fi
+}
+
+# Print the statistic $2 from the --stats output $1.
+stat_value()
+{
+    sed -n "s/.*: $2: \([0-9]*\).*/\1/p" "$1"
+}
+
+check_cmp stream_output_memory_test_nostream stream_output_memory_test
+check_cmp stream_output_memory_test_nostream stream_output_memory_test_nolimit
+
+peak=`stat_value stream_output_memory_test.stats "output file chunks in memory at once"`
+waits=`stat_value stream_output_memory_test.stats "relocation tasks held back"`
+peak_nolimit=`stat_value stream_output_memory_test_nolimit.stats "output file chunks in memory at once"`
+if test -z "$peak" || test -z "$peak_nolimit" \
+   || test "$peak" -gt 4 || test "$waits" -eq 0 \
+   || test "$peak_nolimit" -le 4
+then
+    echo "unexpected --stream-output-memory statistics:"
+    cat stream_output_memory_test.stats
+    cat stream_output_memory_test_nolimit.stats
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,55 @@
+#!/bin/sh
+
+# trace_tasks_test.sh -- test --trace-tasks.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# This script checks that --trace-tasks writes a Chrome trace event
+# file with an event for the tasks of the link, and that it does not
+# change the output file.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+if ! cmp -s trace_tasks_test trace_tasks_test_notrace
+then
+    echo "--trace-tasks changed the output file"
+    exit 1
+fi
+
+check trace_tasks_test.json '^{"displayTimeUnit":"ms","traceEvents":\['
+check trace_tasks_test.json '"name":"thread_name",.*"args":{"name":"main"}'
+check trace_tasks_test.json '"ph":"X","cat":"task","name":"Read_symbols basic_test.o"'
+check trace_tasks_test.json '"ph":"X","cat":"task","name":"Relocate_task basic_test.o"'
+check trace_tasks_test.json '"ph":"X","cat":"task","name":"Task_function Close_task_runner"'
+check trace_tasks_test.json '"ph":"s",.*"cat":"unblock"'
+check trace_tasks_test.json '^]}$'
+
+exit 0
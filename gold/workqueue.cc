@@ -22,6 +22,11 @@
 
 #include "gold.h"
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/time.h>
+
 #include "debug.h"
 #include "options.h"
 #include "timer.h"
@@ -114,6 +119,292 @@ class Workqueue_threader_single : public Workqueue_threader
   { return false; }
 };
 
+// Class Workqueue_trace.  For --trace-tasks, this records when each
+// Task runs and on which thread, how long it waited before running,
+// and when each thread was idle.  It writes the result in the Chrome
+// trace event format, which can be viewed with chrome://tracing or
+// Perfetto.  Except for now, the methods are called with the
+// Workqueue lock held.
+
+class Workqueue_trace
+{
+ public:
+  Workqueue_trace(const char* filename)
+    : filename_(filename), start_time_(this->now()), next_id_(1),
+      pending_(), events_()
+  { }
+
+  // Return the current time in microseconds.
+  uint64_t
+  now() const
+  {
+    struct timeval tv;
+    ::gettimeofday(&tv, NULL);
+    return static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+  }
+
+  // Record that T has been added to the Workqueue.
+  void
+  queued(const Task* t);
+
+  // Record that T is waiting for a Task_token.
+  void
+  blocked(const Task* t);
+
+  // Record that T is no longer waiting for a Task_token, because
+  // RELEASER released it.
+  void
+  unblocked(const Task* t, const Task* releaser);
+
+  // Record that T ran on thread THREAD_NUMBER from START to END.
+  // This must be called after the locks of T are released.
+  void
+  ran(Task* t, int thread_number, uint64_t start, uint64_t end);
+
+  // Record that thread THREAD_NUMBER had nothing to do from START to
+  // END.
+  void
+  idle(int thread_number, uint64_t start, uint64_t end);
+
+  // Write out the trace.
+  void
+  write() const;
+
+ private:
+  // What we know about a Task which has not yet run.
+  struct Pending
+  {
+    // A number identifying the Task in the trace.
+    unsigned int id;
+    // When it was queued.
+    uint64_t queued;
+    // When it started to wait for a Task_token, or 0.
+    uint64_t blocked_since;
+    // The total time it has waited for Task_tokens.
+    uint64_t blocked;
+    // The id of the Task which last made it runnable, or 0.
+    unsigned int unblocked_by;
+  };
+
+  // A Task which has run, or an idle period if ID is 0.
+  struct Event
+  {
+    std::string name;
+    unsigned int id;
+    int thread_number;
+    uint64_t start;
+    uint64_t end;
+    uint64_t queued;
+    uint64_t blocked;
+    unsigned int unblocked_by;
+  };
+
+  static void
+  write_string(FILE*, const std::string&);
+
+  // The file to write.
+  const char* filename_;
+  // When the trace started.
+  uint64_t start_time_;
+  // The id to give the next Task.
+  unsigned int next_id_;
+  // The Tasks which have not yet run.
+  Unordered_map<const Task*, Pending> pending_;
+  // The recorded events, in the order in which they ended.
+  std::vector<Event> events_;
+};
+
+void
+Workqueue_trace::queued(const Task* t)
+{
+  Pending p;
+  p.id = this->next_id_++;
+  p.queued = this->now();
+  p.blocked_since = 0;
+  p.blocked = 0;
+  p.unblocked_by = 0;
+  this->pending_[t] = p;
+}
+
+void
+Workqueue_trace::blocked(const Task* t)
+{
+  Unordered_map<const Task*, Pending>::iterator p = this->pending_.find(t);
+  if (p != this->pending_.end() && p->second.blocked_since == 0)
+    p->second.blocked_since = this->now();
+}
+
+void
+Workqueue_trace::unblocked(const Task* t, const Task* releaser)
+{
+  Unordered_map<const Task*, Pending>::iterator p = this->pending_.find(t);
+  if (p == this->pending_.end())
+    return;
+  if (p->second.blocked_since != 0)
+    {
+      p->second.blocked += this->now() - p->second.blocked_since;
+      p->second.blocked_since = 0;
+    }
+  Unordered_map<const Task*, Pending>::const_iterator r =
+    this->pending_.find(releaser);
+  if (r != this->pending_.end())
+    p->second.unblocked_by = r->second.id;
+}
+
+void
+Workqueue_trace::ran(Task* t, int thread_number, uint64_t start,
+		     uint64_t end)
+{
+  Unordered_map<const Task*, Pending>::iterator p = this->pending_.find(t);
+  if (p == this->pending_.end())
+    return;
+
+  Event e;
+  e.name = t->name();
+  e.id = p->second.id;
+  e.thread_number = thread_number;
+  e.start = start;
+  e.end = end;
+  e.queued = p->second.queued;
+  e.blocked = p->second.blocked;
+  e.unblocked_by = p->second.unblocked_by;
+  this->events_.push_back(e);
+
+  this->pending_.erase(p);
+}
+
+void
+Workqueue_trace::idle(int thread_number, uint64_t start, uint64_t end)
+{
+  Event e;
+  e.name = "idle";
+  e.id = 0;
+  e.thread_number = thread_number;
+  e.start = start;
+  e.end = end;
+  e.queued = start;
+  e.blocked = 0;
+  e.unblocked_by = 0;
+  this->events_.push_back(e);
+}
+
+// Write S as a JSON string.
+
+void
+Workqueue_trace::write_string(FILE* f, const std::string& s)
+{
+  putc('"', f);
+  for (std::string::const_iterator p = s.begin(); p != s.end(); ++p)
+    {
+      unsigned char c = *p;
+      if (c == '"' || c == '\\')
+	fprintf(f, "\\%c", c);
+      else if (c < 0x20)
+	fprintf(f, "\\u%04x", c);
+      else
+	putc(c, f);
+    }
+  putc('"', f);
+}
+
+// Write the trace.  Each Task is a complete event on its thread, with
+// the time it spent queued and waiting for Task_tokens as arguments.
+// A flow event connects it to the Task which made it runnable, so
+// that the critical path can be followed through the trace.
+
+void
+Workqueue_trace::write() const
+{
+  FILE* f = fopen(this->filename_, "w");
+  if (f == NULL)
+    {
+      gold_error(_("cannot open task trace file %s: %s"),
+		 this->filename_, strerror(errno));
+      return;
+    }
+
+  Unordered_map<unsigned int, const Event*> by_id;
+  int max_thread = 0;
+  for (std::vector<Event>::const_iterator p = this->events_.begin();
+       p != this->events_.end();
+       ++p)
+    {
+      if (p->id != 0)
+	by_id[p->id] = &*p;
+      max_thread = std::max(max_thread, p->thread_number);
+    }
+
+  fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (int i = 0; i <= max_thread; ++i)
+    {
+      if (i == 0)
+	fprintf(f, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+		"\"tid\":0,\"args\":{\"name\":\"main\"}},\n");
+      else
+	fprintf(f, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+		"\"tid\":%d,\"args\":{\"name\":\"worker %d\"}},\n", i, i);
+    }
+
+  const uint64_t base = this->start_time_;
+  for (std::vector<Event>::const_iterator p = this->events_.begin();
+       p != this->events_.end();
+       ++p)
+    {
+      fprintf(f, "{\"ph\":\"X\",\"cat\":\"%s\",\"name\":",
+	      p->id == 0 ? "idle" : "task");
+      write_string(f, p->name);
+      fprintf(f, ",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu",
+	      p->thread_number,
+	      static_cast<unsigned long long>(p->start - base),
+	      static_cast<unsigned long long>(p->end - p->start));
+      if (p->id == 0)
+	{
+	  fprintf(f, "},\n");
+	  continue;
+	}
+
+      fprintf(f, ",\"args\":{\"id\":%u,\"queued_us\":%llu,"
+	      "\"blocked_us\":%llu",
+	      p->id,
+	      static_cast<unsigned long long>(p->start - p->queued),
+	      static_cast<unsigned long long>(p->blocked));
+      const Event* r = NULL;
+      if (p->unblocked_by != 0)
+	{
+	  Unordered_map<unsigned int, const Event*>::const_iterator pr =
+	    by_id.find(p->unblocked_by);
+	  if (pr != by_id.end())
+	    r = pr->second;
+	}
+      if (r != NULL)
+	{
+	  fprintf(f, ",\"unblocked_by\":");
+	  write_string(f, r->name);
+	}
+      fprintf(f, "}},\n");
+
+      if (r != NULL)
+	{
+	  fprintf(f, "{\"ph\":\"s\",\"cat\":\"unblock\",\"name\":\"unblock\","
+		  "\"id\":%u,\"pid\":1,\"tid\":%d,\"ts\":%llu},\n",
+		  p->id, r->thread_number,
+		  static_cast<unsigned long long>(r->end - base));
+	  fprintf(f, "{\"ph\":\"f\",\"bp\":\"e\",\"cat\":\"unblock\","
+		  "\"name\":\"unblock\",\"id\":%u,\"pid\":1,\"tid\":%d,"
+		  "\"ts\":%llu},\n",
+		  p->id, p->thread_number,
+		  static_cast<unsigned long long>(p->start - base));
+	}
+    }
+  // JSON does not permit a trailing comma, so end with an empty
+  // metadata event.
+  fprintf(f, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,"
+	  "\"args\":{\"name\":\"gold\"}}\n]}\n");
+
+  if (fclose(f) != 0)
+    gold_error(_("%s: close: %s"), this->filename_, strerror(errno));
+}
+
 // Workqueue methods.
 
 Workqueue::Workqueue(const General_options& options)
@@ -123,7 +414,8 @@ Workqueue::Workqueue(const General_options& options)
     running_(0),
     waiting_(0),
     condvar_(this->lock_),
-    threader_(NULL)
+    threader_(NULL),
+    trace_(NULL)
 {
   bool threads = options.threads();
 #ifndef ENABLE_THREADS
@@ -139,6 +431,9 @@ Workqueue::Workqueue(const General_options& options)
       gold_unreachable();
 #endif
     }
+
+  if (options.user_set_trace_tasks())
+    this->trace_ = new Workqueue_trace(options.trace_tasks());
 }
 
 Workqueue::~Workqueue()
@@ -153,9 +448,14 @@ Workqueue::add_to_queue(Task_list* queue, Task* t, bool front)
 {
   Hold_lock hl(this->lock_);
 
+  if (this->trace_ != NULL)
+    this->trace_->queued(t);
+
   Task_token* token = t->is_runnable();
   if (token != NULL)
     {
+      if (this->trace_ != NULL)
+	this->trace_->blocked(t);
       if (front)
 	token->add_waiting_front(t);
       else
@@ -222,6 +522,8 @@ Workqueue::find_runnable_in_list(Task_list* tasks)
       if (token == NULL)
 	return t;
 
+      if (this->trace_ != NULL)
+	this->trace_->blocked(t);
       token->add_waiting(t);
       ++this->waiting_;
     }
@@ -269,8 +571,15 @@ Workqueue::find_runnable_or_wait(int thread_number)
 
       gold_debug(DEBUG_TASK, "%3d sleeping", thread_number);
 
+      uint64_t sleep_time = 0;
+      if (this->trace_ != NULL)
+	sleep_time = this->trace_->now();
+
       this->condvar_.wait();
 
+      if (this->trace_ != NULL)
+	this->trace_->idle(thread_number, sleep_time, this->trace_->now());
+
       gold_debug(DEBUG_TASK, "%3d awake", thread_number);
 
       t = this->find_runnable();
@@ -316,8 +625,21 @@ Workqueue::find_and_run_task(int thread_number)
       if (is_debugging_enabled(DEBUG_TASK))
         timer.start();
 
+      // Some tasks can only be named before they run, so we get the
+      // name now; Task::name caches it.
+      uint64_t start_time = 0;
+      if (this->trace_ != NULL)
+	{
+	  t->name();
+	  start_time = this->trace_->now();
+	}
+
       t->run(this);
 
+      uint64_t end_time = 0;
+      if (this->trace_ != NULL)
+	end_time = this->trace_->now();
+
       if (is_debugging_enabled(DEBUG_TASK))
         {
           Timer::TimeStats elapsed = timer.get_elapsed_time();
@@ -341,6 +663,9 @@ Workqueue::find_and_run_task(int thread_number)
 	// workqueue lock held.  Get the next Task to run if any.
 	next = this->release_locks(t, &tl);
 
+	if (this->trace_ != NULL)
+	  this->trace_->ran(t, thread_number, start_time, end_time);
+
 	if (next == NULL)
 	  next = this->find_runnable();
 
@@ -400,6 +725,8 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
 
   if (token != NULL)
     {
+      if (this->trace_ != NULL)
+	this->trace_->blocked(t);
       token->add_waiting(t);
       ++this->waiting_;
       return false;
@@ -456,11 +783,13 @@ Workqueue::release_locks(Task* t, Task_locker* tl)
 	    {
 	      // The token has been unblocked.  Every waiting Task may
 	      // now be runnable.
-	      Task* t;
-	      while ((t = token->remove_first_waiting()) != NULL)
+	      Task* w;
+	      while ((w = token->remove_first_waiting()) != NULL)
 		{
 		  --this->waiting_;
-		  this->return_or_queue(t, true, &ret);
+		  if (this->trace_ != NULL)
+		    this->trace_->unblocked(w, t);
+		  this->return_or_queue(w, true, &ret);
 		}
 	    }
 	}
@@ -473,11 +802,13 @@ Workqueue::release_locks(Task* t, Task_locker* tl)
 	  // move all the Tasks to the runnable queue, to avoid a
 	  // potential deadlock if the locking status changes before
 	  // we run the next thread.
-	  Task* t;
-	  while ((t = token->remove_first_waiting()) != NULL)
+	  Task* w;
+	  while ((w = token->remove_first_waiting()) != NULL)
 	    {
 	      --this->waiting_;
-	      if (this->return_or_queue(t, false, &ret))
+	      if (this->trace_ != NULL)
+		this->trace_->unblocked(w, t);
+	      if (this->return_or_queue(w, false, &ret))
 		break;
 	    }
 	}
@@ -518,4 +849,14 @@ Workqueue::add_blocker(Task_token* token)
   token->add_blocker();
 }
 
+// Write the file requested by --trace-tasks.
+
+void
+Workqueue::write_trace()
+{
+  Hold_lock hl(this->lock_);
+  if (this->trace_ != NULL)
+    this->trace_->write();
+}
+
 } // End namespace gold.
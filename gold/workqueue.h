@@ -194,6 +194,7 @@ class Task_function : public Task
 // The workqueue itself.
 
 class Workqueue_threader;
+class Workqueue_trace;
 
 class Workqueue
 {
@@ -233,6 +234,11 @@ class Workqueue
   void
   add_blocker(Task_token*);
 
+  // Write the file requested by --trace-tasks, if any.  This is
+  // called after process has returned.
+  void
+  write_trace();
+
  private:
   // This class can not be copied.
   Workqueue(const Workqueue&);
@@ -288,6 +294,10 @@ class Workqueue
   // The threading implementation.  This is set at construction time
   // and not changed thereafter.
   Workqueue_threader* threader_;
+  // The record of the tasks for --trace-tasks, or NULL.  This is set
+  // at construction time; the records are only changed with lock_
+  // held.
+  Workqueue_trace* trace_;
 };
 
 } // End namespace gold.